@@ -0,0 +1,192 @@
+/*  DisplaySolidBatchCheck.cpp
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*  Compares DisplaySolidBatch against the per-solid DisplaySolid methods.
+
+    Sets up random views of the globe and of a flat map, with one to three view
+    matrices, and evaluates the tiles of a level both ways.  Importance has to
+    match to within a small relative tolerance (the batch combines the view and
+    projection matrices, so it rounds a little differently) and the on screen
+    checks have to match exactly.  Also reports the time each way took.
+
+    This isn't part of the library build.  Compile it with the library's
+    header search paths (see the podspec), link it against the library and
+    run it with an optional trial count and random seed.  Build it with and
+    without SSE2 (or on arm64 for NEON) to cover each projection path.
+    It exits with an error on any mismatch.
+
+        ./solidBatchCheck 200 7
+  */
+
+#import "ScreenImportance.h"
+#import "SphericalMercator.h"
+#import "GlobeMath.h"
+#import "FlatMath.h"
+#import <chrono>
+#import <cstdio>
+#import <cstdlib>
+#import <random>
+
+using namespace WhirlyKit;
+using namespace Eigen;
+
+namespace
+{
+
+// Importance can differ by this much, relative to the larger of it and 1
+static const double MaxRelativeDiff = 1e-9;
+
+// Look from eye to at, adding offset copies of the view for the extra matrices (as for wrapping)
+static void SetupViewState(ViewState &viewState,CoordSystemDisplayAdapter *adapter,
+                           const Point3d &eye,const Point3d &at,int numViews,std::mt19937 &rng)
+{
+    viewState.coordAdapter = adapter;
+    viewState.eyePos = eye;
+
+    const Vector3d forward = (at - eye).normalized();
+    Vector3d up(0,0,1);
+    if (std::abs(forward.dot(up)) > 0.99)
+        up = Vector3d(0,1,0);
+    const Vector3d side = forward.cross(up).normalized();
+    const Vector3d realUp = side.cross(forward);
+    Matrix4d viewMat = Matrix4d::Identity();
+    viewMat.block<1,3>(0,0) = side.transpose();
+    viewMat.block<1,3>(1,0) = realUp.transpose();
+    viewMat.block<1,3>(2,0) = -forward.transpose();
+    viewMat(0,3) = -side.dot(eye);
+    viewMat(1,3) = -realUp.dot(eye);
+    viewMat(2,3) = forward.dot(eye);
+
+    const double near = 0.0001, far = 10.0;
+    const double top = near * std::tan(0.5), right = top * 1.3;
+    Matrix4d proj = Matrix4d::Zero();
+    proj(0,0) = near / right;
+    proj(1,1) = near / top;
+    proj(2,2) = -(far + near) / (far - near);
+    proj(2,3) = -2.0 * far * near / (far - near);
+    proj(3,2) = -1.0;
+    viewState.projMatrix = proj;
+    viewState.invProjMatrix = proj.inverse();
+
+    viewState.viewMatrices.clear();
+    viewState.fullMatrices.clear();
+    viewState.invFullMatrices.clear();
+    std::uniform_real_distribution<double> offset(-0.3,0.3);
+    for (int ii=0;ii<numViews;ii++)
+    {
+        Matrix4d offsetMat = Matrix4d::Identity();
+        if (ii > 0)
+            offsetMat(0,3) = offset(rng);
+        const Matrix4d fullMat = viewMat * offsetMat;
+        viewState.viewMatrices.push_back(fullMat);
+        viewState.fullMatrices.push_back(fullMat);
+        viewState.invFullMatrices.push_back(fullMat.inverse());
+    }
+}
+
+static double secondsSince(const std::chrono::steady_clock::time_point &start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+}
+
+int main(int argc,char *argv[])
+{
+    const int numTrials = (argc > 1) ? atoi(argv[1]) : 200;
+    std::mt19937 rng((argc > 2) ? (unsigned)atoi(argv[2]) : 7);
+
+    SphericalMercatorCoordSystem coordSys;
+    FakeGeocentricDisplayAdapter globeAdapter;
+    SphericalMercatorDisplayAdapter flatAdapter(0.0,GeoCoord::CoordFromDegrees(-180,-85.05),GeoCoord::CoordFromDegrees(180,85.05));
+    std::uniform_real_distribution<double> uni(0.0,1.0);
+    const Point2f frameSize(1024,768);
+
+    int numChecked = 0, importMismatch = 0, onScreenMismatch = 0;
+    double worstDiff = 0.0, solidTime = 0.0, batchTime = 0.0;
+    DisplaySolidBatch batch;
+    for (int trial=0;trial<numTrials;trial++)
+    {
+        // Alternate between looking at the globe from outside and down at a flat map
+        const bool isGlobe = trial % 2 == 0;
+        Point3d eye,at;
+        if (isGlobe)
+        {
+            const Vector3d dir = Vector3d(uni(rng)-0.5,uni(rng)-0.5,uni(rng)-0.5).normalized();
+            eye = dir * (1.0 + 0.5*uni(rng));
+            at = Vector3d(uni(rng)-0.5,uni(rng)-0.5,uni(rng)-0.5) * 0.5;
+        } else {
+            eye = Point3d(uni(rng)-0.5,uni(rng)-0.5,0.05+0.5*uni(rng));
+            at = Point3d(uni(rng)-0.5,uni(rng)-0.5,0.0);
+        }
+        CoordSystemDisplayAdapter *adapter = isGlobe ? (CoordSystemDisplayAdapter *)&globeAdapter : &flatAdapter;
+        ViewState viewState;
+        SetupViewState(viewState,adapter,eye,at,1 + trial%3,rng);
+
+        // Every tile of a level, up to a couple thousand of them
+        const int level = trial % 8;
+        const int numTiles = 1<<level;
+        std::vector<DisplaySolidRef> solids;
+        for (int y=0;y<numTiles && solids.size() < 2048;y++)
+            for (int x=0;x<numTiles && solids.size() < 2048;x++)
+            {
+                const double spanX = 2*M_PI/numTiles, spanY = 6.0/numTiles;
+                const Mbr mbr(Point2f(-M_PI + x*spanX,-3.0 + y*spanY),Point2f(-M_PI + (x+1)*spanX,-3.0 + (y+1)*spanY));
+                solids.push_back(std::make_shared<DisplaySolid>(QuadTreeIdentifier(x,y,level),mbr,0,0,&coordSys,adapter));
+            }
+
+        auto start = std::chrono::steady_clock::now();
+        std::vector<double> solidImport(solids.size());
+        std::vector<bool> solidOnScreen(solids.size());
+        for (size_t ii=0;ii<solids.size();ii++)
+        {
+            solidImport[ii] = solids[ii]->importanceForViewState(&viewState,frameSize);
+            solidOnScreen[ii] = solids[ii]->isOnScreenForViewState(&viewState,frameSize);
+        }
+        solidTime += secondsSince(start);
+
+        start = std::chrono::steady_clock::now();
+        batch.clear();
+        for (const auto &solid : solids)
+            batch.addSolid(solid);
+        std::vector<double> batchImport;
+        std::vector<bool> batchOnScreen;
+        batch.importanceForViewState(&viewState,frameSize,batchImport);
+        batch.isOnScreenForViewState(&viewState,frameSize,batchOnScreen);
+        batchTime += secondsSince(start);
+
+        for (size_t ii=0;ii<solids.size();ii++)
+        {
+            numChecked++;
+            const double diff = std::abs(solidImport[ii] - batchImport[ii]) / std::max(1.0,std::abs(solidImport[ii]));
+            worstDiff = std::max(worstDiff,diff);
+            if (diff > MaxRelativeDiff)
+            {
+                if (importMismatch++ < 5)
+                    printf("Trial %d tile %zu: importance %g vs batch %g\n",trial,ii,solidImport[ii],batchImport[ii]);
+            }
+            if (solidOnScreen[ii] != batchOnScreen[ii])
+                onScreenMismatch++;
+        }
+    }
+
+    printf("%d tiles: %d importance mismatches (worst relative difference %g), %d on screen mismatches\n",
+           numChecked,importMismatch,worstDiff,onScreenMismatch);
+    printf("per solid %.1f ms, batch %.1f ms\n",solidTime*1e3,batchTime*1e3);
+
+    return (importMismatch || onScreenMismatch) ? 1 : 0;
+}
@@ -0,0 +1,224 @@
+/*  DynamicTextureAtlasBench.cpp
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*  Benchmark for the dynamic texture cell allocator.
+
+    Runs label-like churn (mostly small glyph sized regions, some larger ones,
+    released in random order and half of them through the renderer's deferred
+    clear list) against DynamicTexture::findRegion and against the cell by cell
+    scan it replaced.  Both see the same operations, so besides the time per
+    allocation it reports any place they disagree on where a region goes, and
+    checks the bitmask against the scan's grid at the end.
+
+    This isn't part of the library build.  Compile it with the library's
+    header search paths (see the podspec), link it against the library and
+    run it with an optional iteration count and random seed.  It exits with
+    an error if the two allocators ever disagree.
+
+        ./atlasBench 200000 42
+  */
+
+#import "DynamicTextureAtlas.h"
+#import <chrono>
+#import <cstdio>
+#import <cstdlib>
+#import <random>
+
+using namespace WhirlyKit;
+
+typedef DynamicTexture::Region Region;
+
+namespace
+{
+
+// A dynamic texture with nothing behind it but the layout grid
+class BenchTexture : public DynamicTexture
+{
+public:
+    BenchTexture() : TextureBase("bench"), DynamicTexture(std::string("bench")) { }
+
+    bool createInRenderer(const RenderSetupInfo *) override { return true; }
+    void destroyInRenderer(const RenderSetupInfo *,Scene *) override { }
+    void addTextureData(int,int,int,int,RawDataRef) override { }
+    void clearTextureData(int,int,int,int,ChangeSet &,bool,unsigned char *) override { }
+
+    int getNumCell() const { return numCell; }
+
+    bool isCellUsed(int x,int y) const
+    {
+        return (layoutGrid[y * wordsPerRow + x / 64] >> (x % 64)) & 1;
+    }
+};
+
+// The allocator as it was before the bitmask: one flag per cell, scanned top left first
+class ScanAllocator
+{
+public:
+    explicit ScanAllocator(int numCell) : numCell(numCell), cells(numCell * numCell, false) { }
+
+    bool findRegion(int sizeX,int sizeY,Region &region) const
+    {
+        for (int iy=0;iy<=numCell-sizeY;iy++)
+            for (int ix=0;ix<=numCell-sizeX;ix++)
+            {
+                bool clear = true;
+                for (int ty=0;ty<sizeY && clear;ty++)
+                    for (int tx=0;tx<sizeX && clear;tx++)
+                        if (cells[(iy+ty)*numCell + ix+tx])
+                            clear = false;
+                if (clear)
+                {
+                    region.sx = ix;  region.sy = iy;
+                    region.ex = ix+sizeX-1;  region.ey = iy+sizeY-1;
+                    return true;
+                }
+            }
+        return false;
+    }
+
+    void setRegion(const Region &region,bool enable)
+    {
+        for (int iy=region.sy;iy<=region.ey;iy++)
+            for (int ix=region.sx;ix<=region.ex;ix++)
+                cells[iy*numCell + ix] = enable;
+    }
+
+    bool isCellUsed(int x,int y) const { return cells[y*numCell + x]; }
+
+protected:
+    int numCell;
+    std::vector<bool> cells;
+};
+
+struct BenchResult
+{
+    int allocs = 0;
+    int failed = 0;
+    double bitmaskTime = 0.0;
+    double scanTime = 0.0;
+    int disagreements = 0;
+};
+
+static double secondsSince(const std::chrono::steady_clock::time_point &start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Allocate until the texture is about targetFill full, then alternate allocating and releasing
+static BenchResult runChurn(int texSize,int cellSize,double targetFill,int iterations,unsigned seed)
+{
+    BenchTexture tex;
+    tex.setup(texSize,cellSize,TexTypeUnsignedByte,false);
+    const int numCell = tex.getNumCell();
+    ScanAllocator scan(numCell);
+
+    std::mt19937 rng(seed);
+    std::vector<Region> live;
+    // Released through the renderer, which the texture only applies on the next findRegion
+    std::vector<Region> deferred;
+    int usedCells = 0;
+
+    BenchResult result;
+    for (int ii=0;ii<iterations;ii++)
+    {
+        if (live.empty() || usedCells < targetFill * numCell * numCell)
+        {
+            const bool glyph = rng() % 4 != 0;
+            const int sizeX = glyph ? 1 + rng() % 3 : 2 + rng() % 5;
+            const int sizeY = glyph ? 1 + rng() % 3 : 2 + rng() % 5;
+
+            for (const auto &region : deferred)
+                scan.setRegion(region,false);
+            deferred.clear();
+
+            Region scanRegion,region;
+            auto start = std::chrono::steady_clock::now();
+            const bool scanFound = scan.findRegion(sizeX,sizeY,scanRegion);
+            result.scanTime += secondsSince(start);
+
+            start = std::chrono::steady_clock::now();
+            const bool found = tex.findRegion(sizeX,sizeY,region);
+            result.bitmaskTime += secondsSince(start);
+
+            result.allocs++;
+            if (found != scanFound || (found && (region.sx != scanRegion.sx || region.sy != scanRegion.sy)))
+                result.disagreements++;
+            if (!found)
+            {
+                result.failed++;
+                continue;
+            }
+            tex.setRegion(region,true);
+            scan.setRegion(region,true);
+            live.push_back(region);
+            usedCells += sizeX * sizeY;
+        } else {
+            const size_t which = rng() % live.size();
+            const Region region = live[which];
+            live[which] = live.back();
+            live.pop_back();
+            usedCells -= (region.ex-region.sx+1) * (region.ey-region.sy+1);
+            if (rng() % 2)
+            {
+                tex.addRegionToClear(region);
+                deferred.push_back(region);
+            } else {
+                tex.setRegion(region,false);
+                scan.setRegion(region,false);
+            }
+        }
+    }
+
+    // Flush the deferred releases with a search that can't succeed, then compare the grids
+    Region unused;
+    tex.findRegion(numCell+1,numCell+1,unused);
+    for (const auto &region : deferred)
+        scan.setRegion(region,false);
+    for (int iy=0;iy<numCell;iy++)
+        for (int ix=0;ix<numCell;ix++)
+            if (tex.isCellUsed(ix,iy) != scan.isCellUsed(ix,iy))
+                result.disagreements++;
+
+    return result;
+}
+
+}
+
+int main(int argc,char *argv[])
+{
+    const int iterations = (argc > 1) ? atoi(argv[1]) : 200000;
+    const unsigned seed = (argc > 2) ? (unsigned)atoi(argv[2]) : 42;
+
+    // 1600 texels doesn't fill out its last 64 bit word, the others do
+    const int cellSize = 16;
+    int disagreements = 0;
+    for (int texSize : {1024,1600,2048})
+    {
+        for (double fill : {0.7,0.8,0.9,0.95})
+        {
+            const BenchResult result = runChurn(texSize,cellSize,fill,iterations,seed);
+            const double bitmaskUs = 1e6 * result.bitmaskTime / result.allocs;
+            const double scanUs = 1e6 * result.scanTime / result.allocs;
+            printf("%d texels, %2.0f%% full: %7d allocs (%6d failed)  bitmask %6.3f us  scan %8.3f us  (%5.1fx)  disagreements %d\n",
+                   texSize,fill*100,result.allocs,result.failed,bitmaskUs,scanUs,
+                   bitmaskUs > 0.0 ? scanUs / bitmaskUs : 0.0,result.disagreements);
+            disagreements += result.disagreements;
+        }
+    }
+
+    return disagreements ? 1 : 0;
+}
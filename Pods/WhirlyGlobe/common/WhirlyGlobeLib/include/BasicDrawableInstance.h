@@ -132,7 +132,8 @@ public:
     /// Set a block of uniforms (Metal only, at the moment)
     virtual void setUniBlock(const BasicDrawable::UniformBlock &uniBlock);
 
-    /// Return the translation matrix if there is one
+    /// Return the translation matrix if there is one.
+    /// That's our own if it's been set, otherwise the master's.
     const Eigen::Matrix4d *getMatrix() const;
     
     // Single geometry instance when we're doing multiple instance
@@ -224,6 +225,11 @@ protected:
     // Uniforms to be passed into a shader (just Metal for now)
     std::vector<BasicDrawable::UniformBlock> uniBlocks;
     SimpleIdentity renderTargetID;
+    // If set, these override the master's so one piece of geometry can be placed in different spots
+    bool hasMatrix = false;
+    Eigen::Matrix4d mat;
+    bool hasLocalMbr = false;
+    Mbr localMbr;
 
     std::vector<TexInfo> texInfo;
 
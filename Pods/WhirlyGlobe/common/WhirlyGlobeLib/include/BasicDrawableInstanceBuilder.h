@@ -129,6 +129,12 @@ public:
     
     /// Set the shader program
     void setProgram(SimpleIdentity progID);
+
+    /// Transform the master's geometry with this matrix instead of its own
+    void setMatrix(const Eigen::Matrix4d &mat);
+
+    /// Set the local bounding box, for when the geometry has been moved from where the master is
+    void setLocalMbr(const Mbr &localMbr);
     
     /// For Metal, we can set instance data in one big chunk
     virtual void setInstanceData(int numInstance,RawDataRef data);
@@ -73,6 +73,13 @@ struct CoordSystem : public DelayedDeletable
     /// Convert from display coordinates to geocentric
     virtual Point3f geocentricToLocal(const Point3f&) const = 0;
     virtual Point3d geocentricToLocal(const Point3d&) const = 0;
+
+    /// Convert whole arrays of points at once.  Input and output may be the same array.
+    /// These call the single point versions, subclasses can do better.
+    virtual void localToGeographicArray(const Point3d *pts,Point2d *outPts,size_t numPts) const;
+    virtual void geographicToLocalArray(const Point2d *pts,Point3d *outPts,size_t numPts) const;
+    virtual void localToGeocentricArray(const Point3d *pts,Point3d *outPts,size_t numPts) const;
+    virtual void geocentricToLocalArray(const Point3d *pts,Point3d *outPts,size_t numPts) const;
     
     /// Return true if the given coordinate system is the same as the one passed in
     virtual bool isSameAs(const CoordSystem *coordSys) const { return false; }
@@ -95,6 +102,8 @@ typedef std::shared_ptr<CoordSystem> CoordSystemRef;
 /// Convert a point from one coordinate system to another
 Point3f CoordSystemConvert(const CoordSystem *inSystem,const CoordSystem *outSystem,const Point3f &inCoord);
 Point3d CoordSystemConvert3d(const CoordSystem *inSystem,const CoordSystem *outSystem,const Point3d &inCoord);
+/// Convert an array of points from one coordinate system to another.  Input and output may be the same array.
+void CoordSystemConvert3d(const CoordSystem *inSystem,const CoordSystem *outSystem,const Point3d *inPts,Point3d *outPts,size_t numPts);
     
 /** The Coordinate System Display Adapter handles the task of
     converting coordinates in the native system to data values we
@@ -155,6 +164,10 @@ struct CoordSystemDisplayAdapter : public DelayedDeletable
     /// Convert from display coordinates to the local system's coordinates
     virtual Point3f displayToLocal(const Point3f&) const = 0;
     virtual Point3d displayToLocal(const Point3d&) const = 0;
+
+    /// Convert whole arrays of points at once.  Input and output may be the same array.
+    virtual void localToDisplayArray(const Point3d *pts,Point3d *outPts,size_t numPts) const;
+    virtual void displayToLocalArray(const Point3d *pts,Point3d *outPts,size_t numPts) const;
     
     /// For flat systems the normal is Z up.  For the globe, it's based on the location.
     virtual Point3f normalForLocal(const Point3f&) const = 0;
@@ -207,6 +220,10 @@ struct GeneralCoordSystemDisplayAdapter : public CoordSystemDisplayAdapter
     /// Convert from display coordinates to the local system's coordinates
     virtual Point3f displayToLocal(const Point3f&) const override;
     virtual Point3d displayToLocal(const Point3d&) const override;
+
+    /// Convert whole arrays of points at once
+    virtual void localToDisplayArray(const Point3d *pts,Point3d *outPts,size_t numPts) const override;
+    virtual void displayToLocalArray(const Point3d *pts,Point3d *outPts,size_t numPts) const override;
     
     /// For flat systems the normal is Z up.
     virtual Point3f normalForLocal(const Point3f&) const override { return {0,0,1 }; }
@@ -110,8 +110,17 @@ protected:
     /// Texture memory format
     TextureType type = TextureType::TexTypeUnsignedByte;
 
-    // Use to track where sub textures are
-    bool *layoutGrid = nullptr;
+    /// Cells in use, one bit per cell, a row at a time
+    std::vector<uint64_t> layoutGrid;
+    /// 64 bit words in a row of the layout grid
+    int wordsPerRow = 0;
+    /// Number of cells in use
+    int usedCells = 0;
+    /// Number of cells in use in each row, to skip past the full ones
+    std::vector<int> rowUsedCells;
+
+    /// Look for a run of open cells in a row of the layout grid
+    bool findOpenRun(const uint64_t *rowUsed,int cellsX,int &startX) const;
     
     mutable std::mutex regionLock;
     /// These regions have been released by the renderer
@@ -41,12 +41,18 @@ struct PlateCarreeCoordSystem : public CoordSystem
     virtual Point3d geographicToLocal(const Point2d &c) const override { return {c.x(),c.y(),0.0}; }
     virtual Point2d geographicToLocal2(const Point2d &c) const override { return {c.x(),c.y()}; }
 
+    /// Convert whole arrays of points between local and lat/lon
+    virtual void localToGeographicArray(const Point3d *pts,Point2d *outPts,size_t numPts) const override;
+    virtual void geographicToLocalArray(const Point2d *pts,Point3d *outPts,size_t numPts) const override;
+
     /// Convert from local coordinates to WGS84 geocentric
     virtual Point3f localToGeocentric(const Point3f&) const override;
     virtual Point3d localToGeocentric(const Point3d&) const override;
+    virtual void localToGeocentricArray(const Point3d *pts,Point3d *outPts,size_t numPts) const override;
     /// Convert from WGS84 geocentric to local coordinates
     virtual Point3f geocentricToLocal(const Point3f&) const override;
     virtual Point3d geocentricToLocal(const Point3d&) const override;
+    virtual void geocentricToLocalArray(const Point3d *pts,Point3d *outPts,size_t numPts) const override;
         
     /// Return true if the other coordinate system is also Plate Carree
     virtual bool isSameAs(const CoordSystem *coordSys) const override;
@@ -40,11 +40,19 @@ public:
 
     virtual bool isUserMotion() const { return false; }
 
+    /// Where we'll have rotated the globe to at a given time
+    virtual WhirlyKit::ViewPredictor makePredictor(const WhirlyKit::Point2f &frameSize) const override;
+
     /// Set the velocity while this is running (for auto-rotate)
     void setVelocity(double newVel) { velocity = newVel; }
 
 protected:
     Eigen::Quaterniond rotForTime(GlobeView *globeView,WhirlyKit::TimeInterval sinceStart);
+
+    // Where the rotation is at a given time, from just the values that describe it
+    static Eigen::Quaterniond RotForTime(const Eigen::Quaterniond &startQuat,const Eigen::Vector3d &axis,
+                                         double velocity,double acceleration,bool northUp,
+                                         WhirlyKit::TimeInterval sinceStart);
     
     double velocity,acceleration;
     bool northUp = false;
@@ -40,19 +40,29 @@ struct GeoCoordSystem : public CoordSystem
     virtual Point3d geographicToLocal(const Point2d &p) const override { return {p.x(),p.y(),0.0}; }
     virtual Point2d geographicToLocal2(const Point2d &p) const override { return {p.x(),p.y()}; }
 
+    /// Convert whole arrays of points between local and lat/lon
+    virtual void localToGeographicArray(const Point3d *pts,Point2d *outPts,size_t numPts) const override;
+    virtual void geographicToLocalArray(const Point2d *pts,Point3d *outPts,size_t numPts) const override;
+
     /// Convert from local coordinates to WGS84 geocentric
     virtual Point3f localToGeocentric(const Point3f &p) const override { return LocalToGeocentric(p); }
     virtual Point3d localToGeocentric(const Point3d &p) const override { return LocalToGeocentric(p); }
+    virtual void localToGeocentricArray(const Point3d *pts,Point3d *outPts,size_t numPts) const override { LocalToGeocentric(pts,outPts,numPts); }
     /// Static version for convenience
     static Point3f LocalToGeocentric(const Point3f &);
     static Point3d LocalToGeocentric(const Point3d &);
+    /// Static version for a whole array, converted in one go.  Input and output may be the same.
+    static void LocalToGeocentric(const Point3d *pts,Point3d *outPts,size_t numPts);
     
     /// Convert from WGS84 geocentric to local coordinates
     virtual Point3f geocentricToLocal(const Point3f &p) const override { return GeocentricToLocal(p); }
     virtual Point3d geocentricToLocal(const Point3d &p) const override { return GeocentricToLocal(p); }
+    virtual void geocentricToLocalArray(const Point3d *pts,Point3d *outPts,size_t numPts) const override { GeocentricToLocal(pts,outPts,numPts); }
     /// Static version for convenience
     static Point3f GeocentricToLocal(const Point3f &);
     static Point3d GeocentricToLocal(const Point3d &);
+    /// Static version for a whole array, converted in one go.  Input and output may be the same.
+    static void GeocentricToLocal(const Point3d *pts,Point3d *outPts,size_t numPts);
     
     /// Convenience routine to convert a whole MBR to local coordinates
     static Mbr GeographicMbrToLocal(const GeoMbr &);
@@ -90,6 +100,10 @@ struct FakeGeocentricDisplayAdapter : public CoordSystemDisplayAdapter
     /// Static version
     static Point3f DisplayToLocal(const Point3f&);
     static Point3d DisplayToLocal(const Point3d&);
+
+    /// Convert whole arrays of points at once
+    virtual void localToDisplayArray(const Point3d *pts,Point3d *outPts,size_t numPts) const override;
+    virtual void displayToLocalArray(const Point3d *pts,Point3d *outPts,size_t numPts) const override;
     
     /// Return a normal for the given point
     virtual Point3f normalForLocal(const Point3f &p) const override { return LocalToDisplay(p); }
@@ -145,6 +145,9 @@ public:
 
     /// Make a globe view state from the current globe view
     virtual WhirlyKit::ViewStateRef makeViewState(WhirlyKit::SceneRenderer *renderer) override;
+
+    /// Predict where we'll be from the animation delegate, if there is one
+    virtual WhirlyKit::ViewStatePredictor makeViewStatePredictor(const WhirlyKit::Point2f &frameSize) const override;
     
     /// Set the change delegate
     virtual void setDelegate(GlobeViewAnimationDelegateRef delegate);
@@ -196,6 +199,7 @@ public:
     EIGEN_MAKE_ALIGNED_OPERATOR_NEW;
     
     GlobeViewState(GlobeView *globeView,WhirlyKit::SceneRenderer *renderer);
+    GlobeViewState(GlobeView *globeView,const WhirlyKit::Point2f &frameSize);
     virtual ~GlobeViewState() = default;
     
     /// Rotation, etc, at this view state
@@ -308,6 +308,9 @@ public:
 
     virtual void teardown() override;
 
+    /// Timings for the layout passes, safe to read from any thread
+    ConcurrentPerformanceTimer &getPerfTimer() { return perfTimer; }
+
 protected:
     using UnorderedIDSetbyUID = std::unordered_map<std::string,SimpleIDUnorderedSet>;
     using UnorderedUIDSet = std::unordered_set<std::string>;          
@@ -458,6 +461,12 @@ protected:
     
     // Mapping of object unique IDs to drawables from the previous run
     UnorderedIDSetbyUID uniqueDrawableIDs;
+
+    ConcurrentPerformanceTimer perfTimer;
+    ConcurrentPerformanceTimer::Handle layoutUpdateHandle;
+    ConcurrentPerformanceTimer::Handle layoutRulesHandle;
+    ConcurrentPerformanceTimer::Handle layoutClusteringHandle;
+    ConcurrentPerformanceTimer::Handle layoutObjectsHandle;
 };
 typedef std::shared_ptr<LayoutManager> LayoutManagerRef;
 
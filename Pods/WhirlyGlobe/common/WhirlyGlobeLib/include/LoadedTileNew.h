@@ -63,6 +63,9 @@ struct TileGeomSettings
     bool enableGeom = true;
     // If set, we're building single level geometry, so no parent logic
     bool singleLevel = false;
+    // If set, tiles on a flat map share one mesh per tessellation and place it with a matrix.
+    // Tiles that don't line up with the display (clipped, reprojected, etc) still get their own.
+    bool useTemplateMeshes = false;
 };
 
 struct TileGeomManager;
@@ -94,6 +97,14 @@ public:
 
     // Generate commands to remove the associated drawables
     void removeDrawables(ChangeSet &changes);
+
+protected:
+    // Place a shared template mesh for this tile, if its geometry allows for it
+    bool makeTemplateDrawables(SceneRenderer *sceneRender,TileGeomManager *geomManage,
+                               const TileGeomSettings &geomSettings,const MbrD &theMbr,
+                               int tessX,int tessY,const Mbr &geoMbr,ChangeSet &changes);
+
+public:
     
     // Information about a particular drawable that's useful for instancing it.
     typedef enum { DrawableGeom, DrawableSkirt, DrawablePole } DrawableKind;
@@ -106,6 +117,16 @@ public:
         SimpleIdentity drawID;  // ID corresponding to the drawable created
         int drawPriority;       // Draw priority we gave it
         int64_t drawOrder;
+
+        // If the geometry is a shared template mesh, that's the one to instance
+        //  and this is where it goes.  The mesh covers (0,0) to (1,1).
+        SimpleIdentity templateID = EmptyIdentity;
+        Point3d templateOrigin = Point3d(0,0,0);
+        Point3d templateScale = Point3d(1,1,1);
+        Mbr localMbr;
+
+        // Matrix to place the template mesh for this tile
+        Eigen::Matrix4d templateMatrix() const;
     };
     bool enabled = false;
     QuadTreeNew::ImportantNode ident;
@@ -141,8 +162,8 @@ struct TileGeomManager
         LoadedTileVec disabledTiles;
     };
     
-    // Add the tiles list in the node set
-    NodeChanges addRemoveTiles(const QuadTreeNew::ImportantNodeSet &addTiles,const QuadTreeNew::NodeSet &removeTiles,ChangeSet &changes);
+    // Add the tiles list in the node set.  The added tiles come back least important first.
+    NodeChanges addRemoveTiles(const QuadTreeNew::CoverageSet &addTiles,const QuadTreeNew::CoverageSet &removeTiles,ChangeSet &changes);
     
     // Return a list of tiles corresponding to the IDs
     std::vector<LoadedTileNewRef> getTiles(const QuadTreeNew::NodeSet &tiles);
@@ -162,6 +183,9 @@ struct TileGeomManager
     // Remove all the various geometry
     void cleanup(ChangeSet &changes);
 
+    // Return the shared mesh for a given tessellation, building it if needed
+    SimpleIdentity getTemplateMesh(int tessX,int tessY,ChangeSet &changes);
+
 protected:
     TileGeomSettings settings;
 
@@ -191,6 +215,9 @@ public:
     
 protected:
     std::map<QuadTreeNew::Node,LoadedTileNewRef> tileMap;
+
+    // Shared tile meshes by tessellation
+    std::map<std::pair<int,int>,SimpleIdentity> templateMeshes;
 };
 
 }
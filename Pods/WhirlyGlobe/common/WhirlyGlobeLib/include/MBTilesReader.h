@@ -0,0 +1,126 @@
+/*  MBTilesReader.h
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#import <mutex>
+#import <condition_variable>
+#import "WhirlyVector.h"
+#import "QuadTreeNew.h"
+#import "RawData.h"
+
+struct sqlite3;
+struct sqlite3_stmt;
+struct sqlite3_blob;
+
+namespace WhirlyKit
+{
+
+/** Platform neutral reader for a single MBTiles file.
+
+    Opens a fixed number of read-only connections, each with its own set of
+    prepared statements.  Tile lookups check out a connection for the duration
+    of the query, so any number of threads can read at once, up to the size of the pool.
+  */
+class MBTilesReader
+{
+public:
+    /// Open the given file with the given number of connections.
+    /// If numConnections is zero or less we'll pick something based on the hardware.
+    /// If cacheSize is non-negative, each connection's page cache is set to (roughly) that many bytes.
+    /// If mmapSize is positive, SQLite reads up to that many bytes of the file through a memory map
+    ///  and tiles are read directly into reusable pooled buffers rather than a new allocation each.
+    MBTilesReader(const std::string &fileName,int numConnections = 0,int cacheSize = -1,int64_t mmapSize = 0);
+    virtual ~MBTilesReader();
+
+    /// False if we failed to open the file or make sense of the metadata
+    bool isValid() const { return valid; }
+
+    /// Bounding box from the metadata, or the whole earth if there wasn't one
+    const GeoMbr &getGeoMbr() const { return geoMbr; }
+
+    /// Min/max zoom levels from the metadata or the tiles table
+    int getMinZoom() const { return minZoom; }
+    int getMaxZoom() const { return maxZoom; }
+
+    /// Format directly from the metadata (e.g. "png" or "pbf").  May be empty.
+    const std::string &getFormat() const { return format; }
+
+    /// True if the file uses a plain `tiles` table, false for the `map`/`images` layout
+    bool hasTilesTable() const { return tilesStyle; }
+
+    /// Number of connections in the pool
+    int getNumConnections() const { return (int)conns.size(); }
+
+    /// Buffers used for tile data in mapped mode, null otherwise
+    const RawDataPoolRef &getBufferPool() const { return bufferPool; }
+
+    /// Fetch the data for a single tile.  Returns null if the tile isn't there.
+    /// Thread safe.  Blocks if all the connections are in use.
+    RawDataRef fetchTile(const QuadTreeIdentifier &ident);
+
+    /// Fetch a group of tiles with one range query per level, walking the tile index in order.
+    /// Returns one entry per tile, in the same order, with null for tiles that aren't there.
+    /// Thread safe.
+    RawDataRefVec fetchTiles(const std::vector<QuadTreeIdentifier> &idents);
+
+    /// Close all the connections.  Waits for any lookups in progress.
+    void close();
+
+protected:
+    // A single database connection and the statements prepared on it
+    struct Connection
+    {
+        sqlite3 *db = nullptr;
+        sqlite3_stmt *tileStmt = nullptr;
+        sqlite3_stmt *mapStmt = nullptr;
+        sqlite3_stmt *imageStmt = nullptr;
+        sqlite3_stmt *rangeStmt = nullptr;
+        sqlite3_blob *blob = nullptr;
+    };
+    typedef std::shared_ptr<Connection> ConnectionRef;
+
+    bool readMetadata(sqlite3 *db);
+    bool setupConnection(Connection &conn,int cacheSize,bool logCache);
+    void closeConnection(Connection &conn);
+
+    // Wait for a free connection and take it
+    ConnectionRef acquireConnection();
+    // Return a connection to the pool
+    void releaseConnection(ConnectionRef conn);
+
+    RawDataRef fetchTile(Connection &conn,const QuadTreeIdentifier &ident);
+    // Pull the tile data out of the given column of the current row
+    RawDataRef readTileData(Connection &conn,sqlite3_stmt *stmt,int col);
+    void fetchTileRange(Connection &conn,int level,const std::vector<std::pair<QuadTreeIdentifier,int>> &idents,RawDataRefVec &ret);
+
+    bool valid = false;
+    bool tilesStyle = false;
+    int minZoom = 0;
+    int maxZoom = 8;
+    int64_t mmapSize = 0;
+    GeoMbr geoMbr;
+    std::string fileName;
+    std::string format;
+    RawDataPoolRef bufferPool;
+
+    std::mutex lock;
+    std::condition_variable connCond;
+    std::vector<ConnectionRef> conns;
+    std::vector<ConnectionRef> freeConns;
+};
+typedef std::shared_ptr<MBTilesReader> MBTilesReaderRef;
+
+}
@@ -20,7 +20,10 @@
 
 #import "Dictionary.h"
 #import "QuadTreeNew.h"
+#import "VectorTileAttributes.h"
+#import <map>
 #import <string>
+#import <string_view>
 
 namespace WhirlyKit
 {
@@ -37,18 +40,103 @@ typedef std::shared_ptr<MapboxVectorStyleSetImpl> MapboxVectorStyleSetImplRef;
 class MapboxVectorFilter;
 typedef std::shared_ptr<MapboxVectorFilter> MapboxVectorFilterRef;
 
+/// @brief Attribute names used by the filters in a style set, each with a small integer ID
+class MapboxVectorFilterKeys
+{
+public:
+    /// @brief Return the ID for the given name, adding it if it's new
+    int intern(const std::string &name);
+
+    /// @brief Return the ID for the given name, or -1 if no filter uses it
+    int find(std::string_view name) const;
+
+    /// @brief Name for the given ID
+    const std::string &getName(int keyID) const { return names[keyID]; }
+
+    /// @brief Set if the given ID is one of the fields vector tile attributes fill in from their layer
+    bool isLayerField(int keyID) const { return layerFields[keyID]; }
+
+    size_t size() const { return names.size(); }
+
+protected:
+    std::map<std::string,int,std::less<>> ids;
+    std::vector<std::string> names;
+    std::vector<bool> layerFields;
+};
+
+/// @brief A feature's attributes, as seen by compiled filters.
+/// @details Set this up once per feature and run any number of filters against it.
+/// If the attributes came from a vector tile whose layer has key IDs from the same
+///  set of keys, values are looked up by index in the layer tables.
+class MapboxVectorFilterInput
+{
+public:
+    MapboxVectorFilterInput(const Dictionary &attrs,const MapboxVectorFilterKeys &keys);
+
+    /// @brief A value pulled out of the attributes for comparison
+    struct Value
+    {
+        Value() = default;
+        Value(const VectorTileValue &tileVal);
+
+        enum Kind {None,String,Number,Other};
+        Kind kind = None;
+        std::string_view str;
+        double num = 0.0;
+
+        /// @brief The value as a dictionary entry, for comparisons between different types
+        DictionaryEntryRef getEntry() const { return entry ? entry : tileVal.makeEntry(); }
+
+        VectorTileValue tileVal;
+        DictionaryEntryRef entry;
+    };
+
+    /// @brief Look up an attribute by key ID.  Strings are valid until the next call.
+    Value getValue(int keyID) const;
+
+    /// @brief Check if the attribute is there at all
+    bool hasValue(int keyID) const;
+
+    /// @brief If we're looking at a vector tile layer, this is it
+    const VectorTileLayerTable *getTileLayer() const;
+
+    /// @brief Find a value in the tile layer tables, not including the layer fields
+    const VectorTileValue *findTileValue(int keyID) const;
+
+    const Dictionary &attrs;
+    const MapboxVectorFilterKeys &keys;
+
+protected:
+    const VectorTileAttributes *tileAttrs;
+    mutable std::string strValue;
+};
+
 /// @brief Filter is used to match data in a layer to styles
 class MapboxVectorFilter
 {
 public:
     MapboxVectorFilter();
     
-    /// @brief Parse the filter info out of the style entry
+    /// @brief Parse the filter info out of the style entry and compile it
     bool parse(const std::vector<DictionaryEntryRef> &styleEntry,MapboxVectorStyleSetImpl *styleSet);
 
     /// @brief Test a feature's attributes against the filter
     bool testFeature(Dictionary const& attrs,const QuadTreeIdentifier &tileID);
 
+    /// @brief Test a feature against the compiled filter
+    bool testFeature(const MapboxVectorFilterInput &input,const QuadTreeIdentifier &tileID) const;
+
+    /// @brief Number the comparisons that only look at a single attribute value.
+    /// @details These can be run once for each distinct value in a vector tile layer.
+    ///  Numbering starts at the given index and the next free index is returned.
+    ///  The group identifies the set of predicates being numbered.
+    int assignPredicates(int first,const void *group);
+
+    /// @brief Run each of the predicates against the values the tile layer has for its key
+    void evaluatePredicates(VectorTileLayerTable &layer,
+                            const std::vector<std::vector<uint32_t>> &valuesByKey,
+                            const QuadTreeIdentifier &tileID) const;
+
     /// @brief The comparison type for this filter
     MapboxVectorFilterType filterType;
 
@@ -66,6 +154,46 @@ public:
 
     /// @brief For All and Any these are the MapboxVectorFilters to evaluate
     std::vector<MapboxVectorFilterRef> subFilters;
+
+protected:
+    bool parseFilter(const std::vector<DictionaryEntryRef> &styleEntry,MapboxVectorStyleSetImpl *styleSet);
+    bool testFeatureTree(Dictionary const& attrs,const QuadTreeIdentifier &tileID) const;
+
+    /// Constant operand, converted to the type we'll compare it as
+    struct Constant
+    {
+        MapboxVectorFilterInput::Value::Kind kind;
+        std::string str;
+        double num = 0.0;
+        bool isInt = false;
+        DictionaryEntryRef entry;
+    };
+
+    /// One step of a compiled filter.  All and Any are followed by their sub-filters.
+    struct Instruction
+    {
+        MapboxVectorFilterType op;
+        MapboxVectorGeometryType geomType;
+        int keyID;
+        // Constants used by the comparison
+        uint32_t constStart;
+        uint32_t constCount;
+        // For All and Any, the instruction just past the sub-filters
+        uint32_t end;
+        // Index of the result for each value, if this only depends on a single value
+        int predicate;
+    };
+
+    // Flatten this filter and its sub-filters into a program
+    void compile(MapboxVectorFilterKeys &keys,std::vector<Instruction> &prog,std::vector<Constant> &consts) const;
+    bool evaluate(const MapboxVectorFilterInput &input,uint32_t &pc,const QuadTreeIdentifier &tileID) const;
+    // Run a comparison or inclusion instruction against a value
+    bool testValue(const Instruction &instr,const MapboxVectorFilterInput::Value &val,const QuadTreeIdentifier &tileID) const;
+
+    const MapboxVectorFilterKeys *keys = nullptr;
+    const void *predicateGroup = nullptr;
+    std::vector<Instruction> program;
+    std::vector<Constant> constants;
 };
 
 }
@@ -23,6 +23,7 @@
 #import "ComponentManager.h"
 #import "MapboxVectorTileParser.h"
 #import "MaplyVectorStyleC.h"
+#import "MapboxVectorFilter.h"
 #import "MapboxVectorStyleSpritesImpl.h"
 #import <set>
 
@@ -308,6 +309,9 @@ public:
                                     const std::string &name,
                                     const QuadTreeNew::Node &tileID) override;
 
+    /// Assign our filter key IDs to the layer's keys and run the simple filter predicates on its values
+    virtual void prepareLayer(PlatformThreadInfo *inst,VectorTileLayerTable &layer,const QuadTreeIdentifier &tileID) override;
+
     /// Return the style associated with the given UUID.
     virtual VectorStyleImplRef styleForUUID(PlatformThreadInfo *inst,long long uuid) override;
 
@@ -384,6 +388,12 @@ public:
     /// @brief Layers sorted by source layer name
     std::unordered_multimap<std::string, MapboxVectorStyleLayerRef> layersBySource;
 
+    /// @brief Attribute names used by the layer filters
+    MapboxVectorFilterKeys filterKeys;
+
+    /// @brief Number of single value filter predicates for each source layer
+    std::unordered_map<std::string, int> filterPredicateCounts;
+
     VectorManagerRef vecManage;
     WideVectorManagerRef wideVecManage;
     MarkerManagerRef markerManage;
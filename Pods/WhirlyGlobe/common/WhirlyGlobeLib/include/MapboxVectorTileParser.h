@@ -16,11 +16,13 @@
  *  limitations under the License.
  */
 
+#import <atomic>
 #import "vector_tile.pb.h"
 #import "VectorObject.h"
 #import "QuadTreeNew.h"
 #import "ImageTile.h"
 #import "ComponentManager.h"
+#import "WorkStealingPool.h"
 
 namespace WhirlyKit
 {
@@ -152,8 +154,39 @@ public:
     /// If set, we'll put an outline around the tile
     void setDebugOutline(bool b = true) { debugOutline = b; }
 
+    /// If set (the default), gzip/zlib/zstd compressed tiles are decompressed before parsing
+    void setDecompress(bool b = true) { decompress = b; }
+
+    /// If set, styles that don't share any features are built in parallel on the pool.
+    /// The results are merged in the same order as they would be otherwise.
+    /// buildForStyle will be called on the pool's threads with the PlatformThreadInfo
+    ///  passed to parse, so only use this where that's not tied to the calling thread.
+    void setBuildPool(WorkStealingPoolRef pool) { buildPool = std::move(pool); }
+
+    /// Accumulated timing for the tiles this parser has handled
+    struct Stats
+    {
+        int numTiles = 0;
+        int numCompressed = 0;
+        double decompressTime = 0.0;
+        double parseTime = 0.0;
+        double buildTime = 0.0;
+        /// Layer data skipped over because nothing was styled for it, vs. actually decoded
+        int64_t skippedLayerBytes = 0;
+        int64_t decodedLayerBytes = 0;
+    };
+    Stats getStats() const;
+
     const VectorStyleDelegateImplRef &getStyleDelegate() const { return styleDelegate; }
 protected:
+    // Run the styles on the build pool and merge the results into the tile data
+    bool buildStylesParallel(PlatformThreadInfo *styleInst,
+                             VectorTileData *tileData,
+                             const CancelFunction &cancelFn);
+
+    // Sort the results of one style into categories and merge them into the tile data
+    void mergeStyleData(VectorTileData *tileData,long long styleID,VectorTileData *styleData);
+
     /// If set, we'll parse into local coordinates as specified by the bounding box, rather than geo coords
     bool localCoords = false;
 
@@ -169,6 +202,12 @@ protected:
     /// If set, we'll put an outline around the tile
     bool debugOutline = false;
 
+    /// Decompress tiles before parsing
+    bool decompress = true;
+
+    /// Build styles in parallel on this, if set
+    WorkStealingPoolRef buildPool;
+
     std::string uuidName;
 
     // Used for feature inclusion.  Only keep the features that have this attribute and one of the values.
@@ -177,6 +216,15 @@ protected:
 
     VectorStyleDelegateImplRef styleDelegate;
     std::map<long long,std::string> styleCategories;
+
+    // Parsing happens on multiple threads at once
+    std::atomic<int> numTiles = {0};
+    std::atomic<int> numCompressed = {0};
+    std::atomic<int64_t> decompressNanos = {0};
+    std::atomic<int64_t> parseNanos = {0};
+    std::atomic<int64_t> buildNanos = {0};
+    std::atomic<int64_t> skippedLayerBytes = {0};
+    std::atomic<int64_t> decodedLayerBytes = {0};
 };
 
 typedef std::shared_ptr<MapboxVectorTileParser> MapboxVectorTileParserRef;
@@ -43,6 +43,9 @@ public:
 
     virtual bool isUserMotion() const { return userMotion; }
 
+    /// Where we'll have moved the map to at a given time
+    virtual WhirlyKit::ViewPredictor makePredictor(const WhirlyKit::Point2f &frameSize) const override;
+
 protected:
     bool withinBounds(const WhirlyKit::Point3d &loc,
                       MapView * testMapView,
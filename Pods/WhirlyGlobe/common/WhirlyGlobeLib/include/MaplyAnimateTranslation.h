@@ -31,6 +31,13 @@ bool MaplyGestureWithinBounds(const WhirlyKit::Point2dVector &bounds,
                               MapView *testMapView,
                               WhirlyKit::Point3d *newCenter);
 
+// Same bounds check for a given frame size
+bool MaplyGestureWithinBounds(const WhirlyKit::Point2dVector &bounds,
+                              const WhirlyKit::Point3d &loc,
+                              const WhirlyKit::Point2f &frameSize,
+                              MapView *testMapView,
+                              WhirlyKit::Point3d *newCenter);
+
 /// Maply translation from one location to another.
 class AnimateViewTranslation : public MapViewAnimationDelegate
 {
@@ -63,6 +63,10 @@ public:
     
     /// Screen size in display coordinates
     virtual WhirlyKit::Point2d screenSizeInDisplayCoords(const WhirlyKit::Point2f &frameSize) override;
+
+    /// We're moved around from outside, so there's no telling where we're going
+    virtual WhirlyKit::ViewStatePredictor makeViewStatePredictor(const WhirlyKit::Point2f &) const override
+        { return WhirlyKit::ViewStatePredictor(); }
     
 protected:
     /// This view tries to display the given extents in display space
@@ -118,6 +118,8 @@ typedef std::shared_ptr<VectorStyleSettingsImpl> VectorStyleSettingsImplRef;
 class VectorStyleImpl;
 typedef std::shared_ptr<VectorStyleImpl> VectorStyleImplRef;
 
+struct VectorTileLayerTable;
+
 /**
     Base class for styling vectors.  This is set up to manage the styles.
 */
@@ -138,6 +140,9 @@ public:
                                     const std::string &name,
                                     const QuadTreeNew::Node &tileID) = 0;
 
+    /// Called with the keys and values of each vector tile layer before its features are styled
+    virtual void prepareLayer(PlatformThreadInfo *inst,VectorTileLayerTable &layer,const QuadTreeIdentifier &tileID) { }
+
     /// Return the style associated with the given UUID.
     virtual VectorStyleImplRef styleForUUID(PlatformThreadInfo *inst,long long uuid) = 0;
 
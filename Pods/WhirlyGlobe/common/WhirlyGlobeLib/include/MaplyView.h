@@ -123,6 +123,9 @@ public:
     /// Make a map view state from the current globe view
     virtual WhirlyKit::ViewStateRef makeViewState(WhirlyKit::SceneRenderer *renderer) override;
 
+    /// Predict where we'll be from the animation delegate, if there is one
+    virtual WhirlyKit::ViewStatePredictor makeViewStatePredictor(const WhirlyKit::Point2f &frameSize) const override;
+
     /// Set the change delegate
     virtual void setDelegate(MapViewAnimationDelegateRef delegate);
     
@@ -164,6 +167,7 @@ public:
     EIGEN_MAKE_ALIGNED_OPERATOR_NEW;
     
     MapViewState(MapView *mapView,WhirlyKit::SceneRenderer *renderer);
+    MapViewState(MapView *mapView,const WhirlyKit::Point2f &frameSize);
     
     /// Height above globe at this view state
     double heightAboveSurface;
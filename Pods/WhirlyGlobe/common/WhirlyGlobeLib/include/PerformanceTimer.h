@@ -20,7 +20,12 @@
 
 #import <string>
 #import <map>
+#import <atomic>
+#import <memory>
+#import <mutex>
+#import <vector>
 #import "WhirlyTypes.h"
+#import "QuadTreeIdentifier.h"
 
 namespace WhirlyKit
 {
@@ -86,6 +91,248 @@ protected:
     std::map<std::string,TimeEntry> timeEntries;
     std::map<std::string,CountEntry> countEntries;
 };
-    
+
+/** Performance timer that's safe to use from any thread and cheap enough to leave on.
+
+    Register each name once to get a handle, then time and count with that.
+    Each thread adds into its own slots, so there's no locking or map lookups
+    along the way.  Readers add up the slots from all the threads as they go,
+    so the results can be read at any time without stopping anything.
+  */
+class ConcurrentPerformanceTimer
+{
+public:
+    typedef int Handle;
+    static constexpr Handle InvalidHandle = -1;
+
+    /// Allow up to the given number of distinct names
+    ConcurrentPerformanceTimer(int maxHandles = 128);
+    ~ConcurrentPerformanceTimer();
+
+    ConcurrentPerformanceTimer(const ConcurrentPerformanceTimer &) = delete;
+    ConcurrentPerformanceTimer &operator = (const ConcurrentPerformanceTimer &) = delete;
+
+    /// Register a name to time and return its handle.  Registering a name again returns the same handle.
+    /// Returns InvalidHandle if we're out of room.
+    Handle registerTiming(const std::string &name);
+
+    /// Register a name to count and return its handle
+    Handle registerCount(const std::string &name);
+
+    /// Start timing on the calling thread
+    void startTiming(Handle handle);
+
+    /// Stop timing on the calling thread and add the time since the start
+    void stopTiming(Handle handle);
+
+    /// Add a duration measured some other way
+    void addTime(Handle handle,TimeInterval dur);
+
+    /// Add a count for a particular instance
+    void addCount(Handle handle,int count);
+
+    /// Times from construction to destruction
+    class Scope
+    {
+    public:
+        Scope(ConcurrentPerformanceTimer &timer,Handle handle) : timer(timer), handle(handle) { timer.startTiming(handle); }
+        ~Scope() { timer.stopTiming(handle); }
+
+        Scope(const Scope &) = delete;
+        Scope &operator = (const Scope &) = delete;
+
+    protected:
+        ConcurrentPerformanceTimer &timer;
+        Handle handle;
+    };
+
+    /// Timing so far, across all threads.  Fine to call while timing is going on.
+    PerformanceTimer::TimeEntry getTiming(Handle handle) const;
+
+    /// Counts so far, across all threads
+    PerformanceTimer::CountEntry getCount(Handle handle) const;
+
+    /// Start over.  Handles stay valid.
+    void clear();
+
+    /// Write out the timings to the log, as PerformanceTimer does
+    void log(double min = 0.0) const;
+
+protected:
+    // Accumulated values for one handle on one thread.  Only the owning thread writes.
+    struct Slot
+    {
+        // Values from before the last clear() are ignored
+        std::atomic<uint32_t> generation = {0};
+        std::atomic<int64_t> num = {0};
+        std::atomic<int64_t> total = {0};
+        std::atomic<int64_t> minVal = {0};
+        std::atomic<int64_t> maxVal = {0};
+        // Start of the current timing, 0 if we're not timing
+        int64_t start = 0;
+    };
+
+    // Slots for the calling thread, making them the first time through
+    Slot *threadSlots();
+    Slot *slotFor(Handle handle);
+    void addValue(Handle handle,int64_t val);
+    Handle registerName(const std::string &name,bool isCount);
+
+    // Add up one handle over all the threads
+    void gather(Handle handle,int64_t &num,int64_t &total,int64_t &minVal,int64_t &maxVal) const;
+
+    const int maxHandles;
+    // Unique across timers, so threads can tell them apart
+    const uint64_t timerID;
+    std::atomic<uint32_t> generation = {1};
+
+    // Protects the names and the list of per-thread slots
+    mutable std::mutex lock;
+    std::vector<std::string> names;
+    std::vector<bool> isCount;
+    std::map<std::string,Handle> handlesByName;
+    std::vector<std::unique_ptr<Slot[]>> allThreadSlots;
+};
+
+/// Stages of the tile loading pipeline the tracer follows
+typedef enum {
+    TileLoadStageFetchQueue = 0,   // Waiting in the fetcher's queue
+    TileLoadStageFetch,            // Reading the data, such as from an MBTiles file
+    TileLoadStageDecompress,       // Unpacking gzip/zlib/zstd data
+    TileLoadStageParse,            // Vector tile protobuf parsing
+    TileLoadStageBuildStyle,       // A single style's buildObjects
+    TileLoadStageMerge,            // Merging a loaded tile on the layer thread
+    TileLoadStageSceneChanges,     // Scene::processChanges, not tied to any one tile
+    TileLoadStageMax
+} TileLoadStage;
+
+/** Follows tiles through the loading pipeline.
+
+    Each stage records when it started and stopped for a given tile and frame.
+    The records go into a fixed size ring buffer without any locking, so
+    recording is safe from any thread and the oldest records are overwritten
+    once it fills up.  From there we can work out latency percentiles for
+    each stage or write a trace for chrome://tracing.
+
+    The shared tracer is off until enabled.  Until then, each stage costs a
+    single atomic load.
+  */
+class TileLoadTracer
+{
+public:
+    /// A single stage for a single tile
+    struct Record
+    {
+        /// Level is -1 for work that isn't tied to a tile
+        QuadTreeIdentifier ident;
+        /// Frame index, or -1 if it isn't known
+        int frame;
+        TileLoadStage stage;
+        /// Small number for the recording thread, starting at 1
+        int thread;
+        /// Monotonic times, from TileLoadTracer::now()
+        int64_t startNanos,endNanos;
+    };
+
+    /// Latency for one stage over the records in the buffer
+    struct StageStats
+    {
+        TileLoadStage stage;
+        int count = 0;
+        TimeInterval p50 = 0.0, p95 = 0.0, p99 = 0.0;
+        TimeInterval maxDur = 0.0, avgDur = 0.0;
+    };
+
+    /// Times a stage from construction to destruction, if the shared tracer was enabled at the start
+    class Span
+    {
+    public:
+        Span(TileLoadStage stage,const QuadTreeIdentifier &ident,int frame = -1);
+        /// For work not tied to a single tile
+        Span(TileLoadStage stage);
+        ~Span();
+
+        Span(const Span &) = delete;
+        Span &operator = (const Span &) = delete;
+
+    protected:
+        TileLoadStage stage;
+        QuadTreeIdentifier ident;
+        int frame;
+        int64_t startNanos;
+    };
+
+    /// Keep the given number of records, rounded up to a power of two
+    TileLoadTracer(size_t capacity = 1<<16);
+
+    /// The tracer the pipeline stages record into
+    static TileLoadTracer &shared();
+
+    /// Turn recording on or off.  Existing records are kept.
+    void setEnabled(bool newVal) { enabled.store(newVal, std::memory_order_relaxed); }
+    bool isEnabled() const { return enabled.load(std::memory_order_relaxed); }
+
+    /// Current time in nanoseconds on the clock the records use
+    static int64_t now();
+
+    /// Record a stage that ran between the given times.  Thread safe.
+    void record(TileLoadStage stage,const QuadTreeIdentifier &ident,int frame,int64_t startNanos,int64_t endNanos);
+
+    /// Copy out the records that haven't been overwritten, oldest first.
+    /// Safe to call while others are recording.
+    std::vector<Record> getRecords() const;
+
+    /// Latency percentiles for each stage with records
+    std::vector<StageStats> getStageStats() const;
+
+    /// The records in Chrome trace event format (JSON)
+    std::string getChromeTrace() const;
+
+    /// Write out the stage stats to the log
+    void log() const;
+
+    /// Forget the records so far
+    void clear();
+
+    /// Readable name for the stage
+    static const char *stageName(TileLoadStage stage);
+
+protected:
+    // Each slot has a sequence number so readers can tell if it was overwritten under them
+    struct Slot
+    {
+        std::atomic<uint64_t> seq = {0};
+        std::atomic<uint64_t> ident = {0};
+        std::atomic<uint64_t> info = {0};
+        std::atomic<int64_t> startNanos = {0};
+        std::atomic<int64_t> endNanos = {0};
+    };
+
+    std::unique_ptr<Slot[]> slots;
+    size_t capacity;
+    std::atomic<uint64_t> next = {0};
+    std::atomic<uint64_t> cleared = {0};
+    std::atomic<bool> enabled = {false};
+};
+
+inline TileLoadTracer::Span::Span(TileLoadStage stage,const QuadTreeIdentifier &ident,int frame) :
+    stage(stage), ident(ident), frame(frame),
+    startNanos(TileLoadTracer::shared().isEnabled() ? TileLoadTracer::now() : 0)
+{
+}
+
+inline TileLoadTracer::Span::Span(TileLoadStage stage) :
+    Span(stage, QuadTreeIdentifier(0,0,-1))
+{
+}
+
+inline TileLoadTracer::Span::~Span()
+{
+    if (startNanos)
+    {
+        TileLoadTracer::shared().record(stage, ident, frame, startNanos, TileLoadTracer::now());
+    }
+}
+
 }
 
@@ -48,6 +48,12 @@ struct Proj4CoordSystem : public CoordSystem
     /// Convert from display coordinates to geocentric
     virtual Point3f geocentricToLocal(const Point3f&) const override;
     virtual Point3d geocentricToLocal(const Point3d&) const override;
+
+    /// Convert whole arrays of points with a single call into proj.4
+    virtual void localToGeographicArray(const Point3d *pts,Point2d *outPts,size_t numPts) const override;
+    virtual void geographicToLocalArray(const Point2d *pts,Point3d *outPts,size_t numPts) const override;
+    virtual void localToGeocentricArray(const Point3d *pts,Point3d *outPts,size_t numPts) const override;
+    virtual void geocentricToLocalArray(const Point3d *pts,Point3d *outPts,size_t numPts) const override;
     
     /// True if the other system is Spherical Mercator with the same origin
     virtual bool isSameAs(const CoordSystem *coordSys) const override;
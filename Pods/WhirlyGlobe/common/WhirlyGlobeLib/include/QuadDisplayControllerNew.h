@@ -64,7 +64,33 @@ public:
                                      const Mbr &mbr,
                                      const ViewStateRef &viewState,
                                      const Point2f &frameSize) = 0;
+
+    /// Return importance values for several tiles at once.  By default this calls importanceForTile for each.
+    virtual void importanceForTiles(const std::vector<QuadTreeIdentifier> &idents,
+                                    const std::vector<Mbr> &mbrs,
+                                    const ViewStateRef &viewState,
+                                    const Point2f &frameSize,
+                                    std::vector<double> &importance)
+    {
+        importance.resize(idents.size());
+        for (size_t ii=0;ii<idents.size();ii++)
+        {
+            importance[ii] = importanceForTile(idents[ii], mbrs[ii], viewState, frameSize);
+        }
+    }
     
+    /// Figure out which tiles have the same importance in the new view as in the old one,
+    ///  so the values calculated for the old view can be kept.  By default, none of them.
+    virtual void importanceUnchanged(const std::vector<QuadTreeIdentifier> &idents,
+                                     const std::vector<Mbr> &mbrs,
+                                     const ViewStateRef &oldViewState,
+                                     const ViewStateRef &newViewState,
+                                     const Point2f &frameSize,
+                                     std::vector<bool> &unchanged)
+    {
+        unchanged.assign(idents.size(), false);
+    }
+
     /// Called when the view state changes.  If you're caching info, do it here.
     virtual void newViewState(ViewStateRef viewState) = 0;
     
@@ -90,12 +116,30 @@ public:
     /// Load some tiles, unload others, and the rest had their importance values change
     /// Return the nodes we wanted to keep rather than delete
     virtual QuadTreeNew::NodeSet quadLoaderUpdate(PlatformThreadInfo *threadInfo,
-                                                  const WhirlyKit::QuadTreeNew::ImportantNodeSet &loadTiles,
-                                                  const WhirlyKit::QuadTreeNew::NodeSet &unloadTiles,
-                                                  const WhirlyKit::QuadTreeNew::ImportantNodeSet &updateTiles,
+                                                  const WhirlyKit::QuadTreeNew::CoverageSet &loadTiles,
+                                                  const WhirlyKit::QuadTreeNew::CoverageSet &unloadTiles,
+                                                  const WhirlyKit::QuadTreeNew::CoverageSet &updateTiles,
                                                   int targetLevel,
                                                   ChangeSet &changes) = 0;
+
+    /// Same as above, for those working with node sets
+    QuadTreeNew::NodeSet quadLoaderUpdate(PlatformThreadInfo *threadInfo,
+                                          const WhirlyKit::QuadTreeNew::ImportantNodeSet &loadTiles,
+                                          const WhirlyKit::QuadTreeNew::NodeSet &unloadTiles,
+                                          const WhirlyKit::QuadTreeNew::ImportantNodeSet &updateTiles,
+                                          int targetLevel,
+                                          ChangeSet &changes)
+    {
+        return quadLoaderUpdate(threadInfo, QuadTreeNew::CoverageSet(loadTiles), QuadTreeNew::CoverageSet(unloadTiles),
+                                QuadTreeNew::CoverageSet(updateTiles), targetLevel, changes);
+    }
     
+    /// Tiles we expect to need shortly that aren't part of the display.
+    /// Fetch their data ahead at the lowest priority if that helps, but don't show them.
+    /// Each call replaces the tiles from the last one.
+    virtual void quadLoaderPrefetch(PlatformThreadInfo *threadInfo,
+                                    const WhirlyKit::QuadTreeNew::ImportantNodeSet &tiles) { }
+
     /// Called right before the layer thread flushes its change requests
     virtual void quadLoaderPreSceenFlush(ChangeSet &changes) = 0;
     
@@ -151,6 +195,21 @@ public:
 
     /// Set the MBR scale factor
     void setMBRScaling(double newScale);
+
+    /// Only send importance updates for tiles whose importance has changed by more
+    /// than both the fraction of the last value sent and the absolute amount
+    void setImportanceHysteresis(double relative,double absolute);
+
+    /// Look ahead this far along the current view animation and fetch the tiles we'll need there,
+    /// up to the given number.  They go to the loader separately, see quadLoaderPrefetch.
+    void setPrefetch(TimeInterval lookAhead,int maxTiles);
+
+    /// Number of tiles we were fetching ahead of the view on the last update
+    int getLastPrefetchTiles() const { return lastPrefetchTiles; }
+
+    /// Importance updates sent and held back on the last view update
+    int getLastUpdatesSent() const { return lastUpdatesSent; }
+    int getLastUpdatesSuppressed() const { return lastUpdatesSuppressed; }
     
     /// Return the allocated zoom slot (for tracking continuous zoom)
     int getZoomSlot() const;
@@ -177,7 +236,20 @@ public:
 protected:
     // QuadTreeNew overrides
     virtual double importance(const Node &node) override;
+    virtual void importanceForNodes(const std::vector<Node> &nodes,std::vector<double> &results) override;
     virtual bool visible(const Node &node) override;
+
+    // Bounding box we evaluate importance with, returning false for invalid tiles
+    bool importanceMbrForNode(const Node &node,Mbr &nodeMbr) const;
+
+    // The view moved, so toss the importance values that don't still hold for the new one
+    void keepUnchangedImportance(const ViewStateRef &oldViewState,const Point2f &frameSize);
+
+    // Tiles for where the view is going that we're not already covering
+    QuadTreeNew::ImportantNodeSet calcPrefetchNodes(const QuadTreeNew::CoverageSet &coverage,bool localKeepMinLevel);
+
+    // Have the view state say where it's going, but only while we want to know
+    void updatePredictions();
     
     QuadDataStructure *dataStructure;
     QuadLoaderNew *loader;
@@ -196,14 +268,27 @@ protected:
     double keepMinLevelHeight = 0.0;
     bool singleLevel = false;
     std::vector<int> levelLoads;
+    double importanceChangeRelative = 0.0;
+    double importanceChangeAbsolute = 0.0;
+    int lastUpdatesSent = 0;
+    int lastUpdatesSuppressed = 0;
+    TimeInterval prefetchTime = 0.0;
+    int prefetchMaxTiles = 0;
+    int lastPrefetchTiles = 0;
+    View *predictionView = nullptr;
 
-    QuadTreeNew::ImportantNodeSet currentNodes;
+    // The importance values are the ones we last told the loader about
+    QuadTreeNew::CoverageSet currentNodes;
     
     float lastTargetLevel = 1.0f;   // For tracking continuous zoom
     float lastTargetDecimal = -1.0f;
     int zoomSlot = -1;
 
     ViewStateRef viewState;
+
+    // View and frame size the memoized importance values were calculated for
+    ViewStateRef importanceViewState;
+    Point2f importanceFrameSize = {0,0};
 };
     
 typedef std::shared_ptr<QuadDisplayControllerNew> QuadDisplayControllerNewRef;
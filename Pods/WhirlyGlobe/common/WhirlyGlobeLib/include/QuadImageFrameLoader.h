@@ -18,6 +18,7 @@
 
 #import "QuadSamplingController.h"
 #import "QuadLoaderReturn.h"
+#import "QuadLoaderDecodeQueue.h"
 #import "ComponentManager.h"
 
 namespace WhirlyKit
@@ -373,6 +374,18 @@ public:
     // Calculate the load priority for a given tile, respecting the rules
     int calcLoadPriority(const QuadTreeNew::ImportantNode &ident,int frame);
 
+    // Priority for fetching ahead, behind anything calcLoadPriority hands out
+    int calcPrefetchPriority() const;
+
+    // Priority and importance for decoding a loader return, as with calcLoadPriority.
+    // Returns false if the tile is gone.
+    bool calcDecodePriority(const QuadLoaderReturn *loadReturn,int &priority,double &importance);
+
+    /// Decode stage for returns on their way to mergeLoadedTile, if the platform side uses one.
+    /// Cancelled fetches and unloaded tiles drop their waiting decodes.
+    void setDecodeQueue(QuadLoaderDecodeQueueRef queue) { decodeQueue = std::move(queue); }
+    const QuadLoaderDecodeQueueRef &getDecodeQueue() const { return decodeQueue; }
+
     /// Recalculate the loading default priorities
     void updatePriorityDefaults();
 
@@ -468,8 +481,8 @@ public:
     /// Before we tell the delegate to unload tiles, see if they want to keep them around
     /// Returns the tiles we want to preserve after all
     virtual QuadTreeNew::NodeSet builderUnloadCheck(QuadTileBuilder *inBuilder,
-                                                    const QuadTreeNew::ImportantNodeSet &loadTiles,
-                                                    const QuadTreeNew::NodeSet &unloadTiles,
+                                                    const QuadTreeNew::CoverageSet &loadTiles,
+                                                    const QuadTreeNew::CoverageSet &unloadTiles,
                                                     int inTargetLevel) override;
     
     /// Load the given group of tiles.  If you don't load them immediately, up to you to cancel any requests
@@ -676,6 +689,9 @@ protected:
     
     // Information about each frame.  Subclasses do more interesting things with this
     std::vector<QuadFrameInfoRef> frames;
+
+    // Decodes returns before they're merged, if set
+    QuadLoaderDecodeQueueRef decodeQueue;
     
     std::map<SimpleIdentity,LoadingDelegate> loadingDelegates;
 };
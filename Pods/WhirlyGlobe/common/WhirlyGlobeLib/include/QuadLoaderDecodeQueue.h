@@ -0,0 +1,117 @@
+/*  QuadLoaderDecodeQueue.h
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#import "QuadLoaderReturn.h"
+#import <atomic>
+#import <condition_variable>
+#import <functional>
+#import <memory>
+#import <mutex>
+#import <thread>
+#import <vector>
+
+namespace WhirlyKit
+{
+
+/** Decode stage for loader returns on their way to being merged.
+
+    A fixed set of workers runs the decode tasks, most urgent first.  The order
+    is the same one the tile fetchers use: lower priority values first, then
+    higher importance, then whatever came in first.
+
+    Two limits keep memory down when tiles come in faster than we can use them.
+    Once maxQueued tasks are waiting, addTask() blocks until a worker takes one.
+    Once maxUnmerged returns have been decoded but not yet merged, the workers
+    stop taking new work until the layer thread catches up.  Each decoded return
+    holds a slot in its decodeSlot, which is let go when it's merged or discarded.
+
+    Returns cancelled while they wait are handed to the next free worker right
+    away.  Their tasks are expected to check the cancel flag, skip the decode,
+    and pass the return along for cleanup.
+  */
+class QuadLoaderDecodeQueue
+{
+public:
+    typedef std::function<void()> Task;
+
+    /// Start the given number of workers, or one less than the number of cores if 0
+    QuadLoaderDecodeQueue(int numThreads = 0,int maxQueued = 64,int maxUnmerged = 16);
+    ~QuadLoaderDecodeQueue();
+
+    int getNumThreads() const { return (int)workers.size(); }
+
+    /// Queue up the decode for the given loader return.
+    /// Blocks while the queue is full, so don't call this on the layer thread.
+    void addTask(const QuadLoaderReturnRef &loadReturn,int priority,double importance,Task task);
+
+    /// Change the ordering of a return that's still waiting
+    void updatePriority(const QuadLoaderReturn *loadReturn,int priority,double importance);
+
+    /// The return was cancelled, so run its task next if it's still waiting
+    void cancel(const QuadLoaderReturn *loadReturn);
+
+    /// Cancel everything waiting and run any tasks added after this on the caller's thread
+    void shutdown();
+
+    /// Number of tasks waiting for a worker
+    int getNumQueued() const;
+
+    /// Number of decoded returns that haven't been merged yet
+    int getNumUnmerged() const;
+
+    /// Number of waiting tasks that were cancelled before they were decoded
+    int64_t getNumCancelled() const { return numCancelled; }
+
+protected:
+    struct Entry
+    {
+        // True if this one should go before the other
+        bool operator < (const Entry &that) const;
+
+        QuadLoaderReturnRef loadReturn;
+        int priority;
+        double importance;
+        uint64_t order;
+        Task task;
+    };
+
+    // Everything the workers and the unmerged slots share.
+    // The slots may outlive the queue, so this does too.
+    struct State
+    {
+        std::mutex lock;
+        std::condition_variable workReady;
+        std::condition_variable spaceReady;
+        std::vector<Entry> waiting;
+        std::vector<Entry> cancelled;
+        int numUnmerged = 0;
+        uint64_t nextOrder = 0;
+        bool stopping = false;
+    };
+    typedef std::shared_ptr<State> StateRef;
+
+    void workerMain();
+
+    int maxQueued;
+    int maxUnmerged;
+    StateRef state;
+    std::atomic<int64_t> numCancelled;
+    std::vector<std::thread> workers;
+};
+typedef std::shared_ptr<QuadLoaderDecodeQueue> QuadLoaderDecodeQueueRef;
+
+}
@@ -88,6 +88,9 @@ public:
     
     // Set by the loader if we've canceled a tile we're currently building objects for
     bool cancel = false;
+
+    // Held from the decode until the merge, see QuadLoaderDecodeQueue
+    std::shared_ptr<void> decodeSlot;
     
     // Clean out references to everything
     virtual void clear();
@@ -89,6 +89,21 @@ public:
                                      const Mbr &mbr,
                                      const ViewStateRef &viewState,
                                      const Point2f &frameSize) override;
+
+    /// Return importance values for several tiles, evaluating their display solids together
+    virtual void importanceForTiles(const std::vector<QuadTreeIdentifier> &idents,
+                                    const std::vector<Mbr> &mbrs,
+                                    const ViewStateRef &viewState,
+                                    const Point2f &frameSize,
+                                    std::vector<double> &importance) override;
+
+    /// Tiles entirely on screen in both views keep their importance when a flat map is panned
+    virtual void importanceUnchanged(const std::vector<QuadTreeIdentifier> &idents,
+                                     const std::vector<Mbr> &mbrs,
+                                     const ViewStateRef &oldViewState,
+                                     const ViewStateRef &newViewState,
+                                     const Point2f &frameSize,
+                                     std::vector<bool> &unchanged) override;
     
     /// Called when the view state changes.  If you're caching info, do it here.
     virtual void newViewState(ViewStateRef viewState) override;
@@ -107,8 +122,8 @@ public:
     /// Before we tell the delegate to unload tiles, see if they want to keep them around
     /// Returns the tiles we want to preserve after all
     virtual QuadTreeNew::NodeSet builderUnloadCheck(QuadTileBuilder *inBuilder,
-                                                    const WhirlyKit::QuadTreeNew::ImportantNodeSet &loadTiles,
-                                                    const WhirlyKit::QuadTreeNew::NodeSet &unloadTiles,
+                                                    const WhirlyKit::QuadTreeNew::CoverageSet &loadTiles,
+                                                    const WhirlyKit::QuadTreeNew::CoverageSet &unloadTiles,
                                                     int targetLevel) override;
     
     /// Load the given group of tiles.  If you don't load them immediately, up to you to cancel any requests
@@ -119,6 +134,11 @@ public:
     
     /// Called right before the layer thread flushes all its current changes
     virtual void builderPreSceneFlush(QuadTileBuilder *inBuilder, ChangeSet &changes) override;
+
+    /// Pass the tiles to fetch ahead along to the delegates
+    virtual void builderPrefetch(PlatformThreadInfo *threadInfo,
+                                 QuadTileBuilder *inBuilder,
+                                 const WhirlyKit::QuadTreeNew::ImportantNodeSet &tiles) override;
     
     /// Shutdown called on the layer thread if you have stuff to clean up
     virtual void builderShutdown(PlatformThreadInfo *threadInfo, QuadTileBuilder *inBuilder, ChangeSet &changes) override;
@@ -126,6 +146,9 @@ public:
     /// Quick loading status check
     virtual bool builderIsLoading() const override;
 
+    /// Display solids shared by the importance and visibility checks
+    const DisplaySolidCache &getDisplaySolidCache() const { return displaySolids; }
+
 protected:
     bool debugMode = false;
 
@@ -134,6 +157,12 @@ protected:
     SamplingParams params;
     QuadDisplayControllerNewRef displayControl;
 
+    // Tile display solids, reused across view updates until the parameters change
+    DisplaySolidCache displaySolids;
+
+    // Shared with the other samplers doing parallel coverage
+    WorkStealingPoolRef coveragePool;
+
     WhirlyKit::Scene *scene = nullptr;
     SceneRenderer *renderer = nullptr;
 
@@ -96,6 +96,22 @@ public:
     
     /// Do we need globe geometry for this sampling set or nah?
     bool generateGeom = true;
+
+    /// Tiles we already have only get an importance update if it has changed by more
+    /// than both of these.  The relative one is a fraction of the last value we sent.
+    double importanceChangeRelative = 0.0;
+    double importanceChangeAbsolute = 0.0;
+
+    /// If set, we'll look this far ahead (in seconds) along the current view animation
+    /// and fetch the tiles we'll need there at the lowest priority, up to prefetchMaxTiles
+    double prefetchTime = 0.0;
+    int prefetchMaxTiles = 32;
+
+    /// If set, evaluate the quad tree on a pool of threads shared by all the samplers
+    bool parallelCoverage = false;
+
+    /// If set, tiles on flat maps share a mesh for each tessellation rather than building their own
+    bool templateMeshes = false;
     
     /**
      Detail the levels you want loaded in target level mode.
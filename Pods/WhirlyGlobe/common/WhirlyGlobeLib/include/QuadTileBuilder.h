@@ -58,9 +58,9 @@ struct TileBuilderDelegateInfo
 
     int targetLevel = -1;
     LoadedTileVec loadTiles;
-    QuadTreeNew::NodeSet unloadTiles;
+    QuadTreeNew::CoverageSet unloadTiles;
     LoadedTileVec enableTiles,disableTiles;
-    QuadTreeNew::ImportantNodeSet changeTiles;
+    QuadTreeNew::CoverageSet changeTiles;
 };
 
 /// Protocol used by the tile builder to notify an interested party about what's
@@ -77,8 +77,8 @@ public:
     /// Before we tell the delegate to unload tiles, see if they want to keep them around
     /// Returns the tiles we want to preserve after all
     virtual QuadTreeNew::NodeSet builderUnloadCheck(QuadTileBuilder *builder,
-                                                  const WhirlyKit::QuadTreeNew::ImportantNodeSet &loadTiles,
-                                                  const WhirlyKit::QuadTreeNew::NodeSet &unloadTiles,
+                                                  const WhirlyKit::QuadTreeNew::CoverageSet &loadTiles,
+                                                  const WhirlyKit::QuadTreeNew::CoverageSet &unloadTiles,
                                                   int targetLevel) = 0;
     
     /// Load the given group of tiles.  If you don't load them immediately, up to you to cancel any requests
@@ -87,6 +87,11 @@ public:
                              const WhirlyKit::TileBuilderDelegateInfo &updates,
                              ChangeSet &changes) = 0;
     
+    /// Fetch ahead for tiles we'll probably need soon.  These don't get loaded or displayed.
+    virtual void builderPrefetch(PlatformThreadInfo *threadInfo,
+                                 QuadTileBuilder *builder,
+                                 const WhirlyKit::QuadTreeNew::ImportantNodeSet &tiles) { }
+
     /// Called right before the layer thread flushes all its current changes
     virtual void builderPreSceneFlush(QuadTileBuilder *builder,ChangeSet &changes) = 0;
 
@@ -141,6 +146,10 @@ public:
     // Set if we're using single level loading logic
     void setSingleLevel(bool);
     bool getSingleLevel() const;
+
+    // If set, flat map tiles share template meshes instead of building their own
+    void setTemplateMeshes(bool);
+    bool getTemplateMeshes() const;
     
     // Set the color for the underlying geometry
     void setColor(const RGBAColor &color);
@@ -161,11 +170,16 @@ protected:
     /// Load some tiles, unload others, and the rest had their importance values change
     /// Return the nodes we wanted to keep rather than delete
     virtual QuadTreeNew::NodeSet quadLoaderUpdate(PlatformThreadInfo *threadInfo,
-                                                  const WhirlyKit::QuadTreeNew::ImportantNodeSet &loadTiles,
-                                                  const WhirlyKit::QuadTreeNew::NodeSet &unloadTiles,
-                                                  const WhirlyKit::QuadTreeNew::ImportantNodeSet &updateTiles,
+                                                  const WhirlyKit::QuadTreeNew::CoverageSet &loadTiles,
+                                                  const WhirlyKit::QuadTreeNew::CoverageSet &unloadTiles,
+                                                  const WhirlyKit::QuadTreeNew::CoverageSet &updateTiles,
                                                   int targetLevel,
-                                                  ChangeSet &changes);
+                                                  ChangeSet &changes) override;
+    using QuadLoaderNew::quadLoaderUpdate;
+
+    /// Pass tiles to fetch ahead along to the delegate
+    virtual void quadLoaderPrefetch(PlatformThreadInfo *threadInfo,
+                                    const WhirlyKit::QuadTreeNew::ImportantNodeSet &tiles) override;
     
     /// Called right before the layer thread flushes its change requests
     virtual void quadLoaderPreSceenFlush(ChangeSet &changes);
@@ -46,6 +46,19 @@ struct QuadTreeIdentifier
     }
     int64_t NodeNumber() const { return NodeNumber(x,y,level); }
 
+    /// Reverse of NodeNumber
+    static QuadTreeIdentifier FromNodeNumber(int64_t nodeNum)
+    {
+        int level = 0;
+        while ((((int64_t)1 << (2*(level+1))) - 1) / 3 <= nodeNum)
+            level++;
+
+        const int64_t twoToZ = (int64_t)1 << level;
+        const int64_t tileNumber = nodeNum - (twoToZ * twoToZ - 1) / 3;
+
+        return QuadTreeIdentifier((int)(tileNumber % twoToZ), (int)(tileNumber / twoToZ), level);
+    }
+
     /// Comparison based on x,y,level.  Used for sorting
     bool operator < (const QuadTreeIdentifier &that) const;
     
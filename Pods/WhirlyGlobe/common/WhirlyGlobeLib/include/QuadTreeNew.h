@@ -20,7 +20,10 @@
 
 #import "WhirlyVector.h"
 #import "QuadTreeIdentifier.h"
+#import "WorkStealingPool.h"
 #import <set>
+#import <vector>
+#import <unordered_map>
 
 namespace WhirlyKit
 {
@@ -86,6 +89,53 @@ public:
     };
     typedef std::set<ImportantNode> ImportantNodeSet;
 
+    /** Nodes with importance, kept in a flat vector sorted by node.
+        That's level, then y, then x, which is also node number order.
+        Much cheaper to build, search, and compare than the sets for
+        the hundreds of tiles we may be looking at on every view update.
+      */
+    class CoverageSet
+    {
+    public:
+        typedef std::vector<ImportantNode>::const_iterator const_iterator;
+
+        CoverageSet() = default;
+        explicit CoverageSet(const ImportantNodeSet &);
+        explicit CoverageSet(const NodeSet &);
+
+        /// Add a node.  Call finish() once you're done adding them.
+        void add(const ImportantNode &node) { nodes.push_back(node); }
+        /// Sort what was added and remove duplicates, keeping the highest importance
+        void finish();
+
+        void reserve(size_t size) { nodes.reserve(size); }
+        void clear() { nodes.clear(); }
+
+        /// Look for the given node, returning null if it's not there
+        const ImportantNode *find(const Node &node) const;
+        bool contains(const Node &node) const { return find(node) != nullptr; }
+
+        size_t size() const { return nodes.size(); }
+        bool empty() const { return nodes.empty(); }
+        const_iterator begin() const { return nodes.begin(); }
+        const_iterator end() const { return nodes.end(); }
+
+        /// The nodes least important first, which is the order an ImportantNodeSet keeps
+        std::vector<ImportantNode> byImportance() const;
+
+        /// Copy into the sets, for those that want them
+        ImportantNodeSet toImportantNodeSet() const;
+        NodeSet toNodeSet() const;
+
+        /// Sort out the nodes that are only in the old set, only in the new set, or in both.
+        /// The ones in both have the new importance.
+        static void diff(const CoverageSet &oldNodes,const CoverageSet &newNodes,
+                         CoverageSet &added,CoverageSet &removed,CoverageSet &kept);
+
+    protected:
+        std::vector<ImportantNode> nodes;
+    };
+
     // Calculate a set of nodes to load based on importance, but only up to the maximum
     // siblingNodes forces us to load all four children of a given parent
     ImportantNodeSet calcCoverageImportance(const std::vector<double> &minImportance,int maxNodes,
@@ -107,11 +157,22 @@ public:
     // Filled in by the subclass
     virtual double importance(const Node &node) = 0;
     virtual bool visible(const Node &node) = 0;
+
+    /// Importance for several nodes at once.  By default this calls importance() for each.
+    virtual void importanceForNodes(const std::vector<Node> &nodes,std::vector<double> &results);
     
     // Recursively visit the quad tree evaluating as we go
     void evalNodeImportance(ImportantNode &node,const std::vector<double> &minImportance,
                             ImportantNodeSet &importSet,std::vector<double> &maxRejectedImport);
 
+    /** Evaluate the tree in parallel on the given pool, or serially if it's null.
+        We work down from the top until there are enough nodes to go around and
+        then hand out their subtrees.  The results are the same either way, but
+        importance() will be called from several threads at once.
+      */
+    void setEvalPool(WorkStealingPoolRef pool) { evalPool = std::move(pool); }
+    const WorkStealingPoolRef &getEvalPool() const { return evalPool; }
+
     // This version uses pure visibility and goes down to a predefined level
     bool evalNodeVisible(ImportantNode node,const std::vector<double> &minImportance,int maxNodes,
                          const std::set<int> &levelsToLoad,int maxLevel,ImportantNodeSet &visibleSet);
@@ -120,6 +181,10 @@ public:
         shutdown = true;
     }
 
+    /// Forget the importance values calculated so far.
+    /// Subclasses that keep them across coverage calculations call this when the view changes.
+    void clearImportanceMemo() { importanceMemo.clear(); }
+
     /// Bounding box
     MbrD mbr;
     
@@ -127,7 +192,36 @@ public:
     int minLevel,maxLevel;
 
 protected:
+    typedef std::unordered_map<int64_t,double> ImportanceMemo;
+
+    // Importance for the node, only calling importance() the first time we see it.
+    // With a local memo the shared one is only read and new values go in the local one.
+    double memoImportance(const Node &node,ImportanceMemo *localMemo = nullptr);
+
+    // Memoize the importance of any of these nodes we haven't seen, all in one go
+    void memoImportance(const std::vector<ImportantNode> &nodes,ImportanceMemo *localMemo = nullptr);
+
+    // Fill in the node's importance and return true if it passes, otherwise note the rejection
+    bool evalNode(ImportantNode &node,const std::vector<double> &minImportance,
+                  std::vector<double> &maxRejectedImport,ImportanceMemo *localMemo = nullptr);
+
+    // evalNodeImportance, possibly with a local memo
+    void evalSubtree(ImportantNode &node,const std::vector<double> &minImportance,ImportantNodeSet &importSet,
+                     std::vector<double> &maxRejectedImport,ImportanceMemo *localMemo);
+
+    // Run evalNodeImportance on each of the given nodes, on the pool if we have one
+    void evalNodes(const std::vector<ImportantNode> &nodes,const std::vector<double> &minImportance,
+                   ImportantNodeSet &importSet,std::vector<double> &maxRejectedImport);
+
     volatile bool shutdown = false;
+
+    // Importance values by node number.  Normally these only last for one coverage
+    //  calculation, which may visit the same nodes more than once.
+    std::unordered_map<int64_t,double> importanceMemo;
+    // If set, the subclass is responsible for clearing the importance values
+    bool keepImportanceMemo = false;
+
+    WorkStealingPoolRef evalPool;
 };
 
 }
@@ -20,6 +20,8 @@
 #import <vector>
 #import <string>
 #import <memory>
+#import <mutex>
+#import <atomic>
 #import "WhirlyTypes.h"
 
 namespace WhirlyKit
@@ -140,7 +142,80 @@ struct MutableRawData : public ImmutableRawData
     virtual void addDouble(double dVal);
     // Add a string
     virtual void addString(const std::string &str);
+
+    // Writable access to the data
+    unsigned char *getMutableRawData() { return data.empty() ? nullptr : &data[0]; }
+
+    // Change the size of the data.  Shrinking keeps the allocation around for reuse.
+    void resize(unsigned long size) { data.resize(size); }
 };
 typedef std::shared_ptr<MutableRawData> MutableRawDataRef;
 
+class RawDataPool;
+typedef std::shared_ptr<RawDataPool> RawDataPoolRef;
+template <typename T> struct PooledRawDataAllocator;
+
+// A buffer borrowed from a RawDataPool.
+// It goes back to the pool when the last reference is released.
+class PooledRawData : public RawData
+{
+public:
+    PooledRawData(std::vector<unsigned char> &&buf,unsigned long len,const RawDataPoolRef &pool);
+    PooledRawData(const PooledRawData &) = delete;
+    virtual ~PooledRawData();
+
+    // Return a pointer to the raw data we're keeping
+    virtual const unsigned char *getRawData() const override { return len ? &buf[0] : nullptr; }
+
+    // Length of the valid data, which may be less than the buffer size
+    virtual unsigned long getLen() const override { return len; }
+
+    // Writable version for whoever is filling in the buffer
+    unsigned char *getMutableData() { return len ? &buf[0] : nullptr; }
+
+    // Change the valid length, growing the buffer if needed
+    void setLen(unsigned long newLen);
+
+protected:
+    std::vector<unsigned char> buf;
+    unsigned long len;
+    std::weak_ptr<RawDataPool> pool;
+};
+typedef std::shared_ptr<PooledRawData> PooledRawDataRef;
+
+// Keeps a limited number of released buffers around for reuse,
+// so a steady stream of similar-sized data doesn't hit the heap every time.
+// The PooledRawData objects themselves (and their reference counts) are recycled too.
+// Thread safe.
+class RawDataPool : public std::enable_shared_from_this<RawDataPool>
+{
+public:
+    // Keep up to maxBuffers around, ignoring any larger than maxBufferSize (if non-zero)
+    RawDataPool(int maxBuffers,unsigned long maxBufferSize = 0);
+    virtual ~RawDataPool() = default;
+
+    // Get a buffer with room for at least the given length
+    PooledRawDataRef getBuffer(unsigned long len);
+
+    // Number of buffers handed out that had to be allocated, and the number reused
+    int getNumAllocated() const { return numAllocated; }
+    int getNumReused() const { return numReused; }
+
+protected:
+    friend class PooledRawData;
+    template <typename T> friend struct PooledRawDataAllocator;
+    void returnBuffer(std::vector<unsigned char> &&buf);
+
+    // Released PooledRawData allocations, shared with the allocator that hands them out
+    struct WrapperCache;
+    std::shared_ptr<WrapperCache> wrappers;
+
+    std::mutex lock;
+    std::vector<std::vector<unsigned char>> buffers;
+    int maxBuffers;
+    unsigned long maxBufferSize;
+    std::atomic<int> numAllocated;
+    std::atomic<int> numReused;
+};
+
 }
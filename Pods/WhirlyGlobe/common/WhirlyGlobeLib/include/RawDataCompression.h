@@ -0,0 +1,55 @@
+/*  RawDataCompression.h
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#import "RawData.h"
+
+// Define WK_USE_ZSTD=1 (and link libzstd) to decompress zstd data
+#if !defined(WK_USE_ZSTD)
+# define WK_USE_ZSTD 0
+#endif
+
+namespace WhirlyKit
+{
+
+// Compression schemes we can recognize
+typedef enum {
+    RawDataCompressionNone = 0,
+    RawDataCompressionGZip,
+    RawDataCompressionZLib,
+    RawDataCompressionZStd,
+} RawDataCompressionType;
+
+/// Figure out how the data is compressed, if at all, from the magic bytes at the start
+extern RawDataCompressionType RawDataCompression(const unsigned char *data,unsigned long len);
+extern RawDataCompressionType RawDataCompression(const RawData *rawData);
+
+/**
+    Decompress the data into the given buffer, which is resized to fit.
+    The buffer's existing allocation is reused when it's big enough.
+    Returns false if the data is corrupt or the compression type isn't supported.
+  */
+extern bool RawDataDecompress(const unsigned char *data,unsigned long len,
+                              RawDataCompressionType type,MutableRawData &outData);
+
+/**
+    Return a per-thread buffer to decompress into.
+    If the last one handed out is still referenced elsewhere, a new one replaces it,
+    so it's safe to hang on to the data after parsing.
+  */
+extern const MutableRawDataRef &RawDataDecompressBuffer();
+
+}
@@ -19,10 +19,21 @@
  */
 
 #import <vector>
+#import <string>
+#import "RawData.h"
 
 namespace WhirlyKit
 {
 
+/// Pixel layouts the PNG decoder can write directly
+typedef enum RawPNGPixelFormat_t {
+    RawPNGNative,       // Samples as stored in the image, 16 bit values in native byte order
+    RawPNGSingle8,      // One byte per pixel: the grey value, or the average of RGB for color images
+    RawPNGRGBA8,        // Four bytes per pixel
+    RawPNGRGB565,       // Packed into 16 bits, laid out like ConvertRGBATo565
+    RawPNGRGBA4444      // Packed into 16 bits, laid out like ConvertRGBATo4444
+} RawPNGPixelFormat;
+
 /**
  Pulls the raw data out of a PNG image.
  Returns NULL on failure, check the err value.
@@ -37,4 +48,52 @@ extern unsigned char *RawPNGImageLoaderInterpreter(unsigned int &width,
                                                    unsigned int *outErr,
                                                    std::string *outErrStr);
 
+/**
+ Size in bytes of the given PNG once decoded to the given format.
+ Returns 0 if it's not a PNG we can decode that way.
+ */
+extern size_t RawPNGImageDecodedSize(const unsigned char *data,
+                                     size_t length,
+                                     RawPNGPixelFormat format,
+                                     unsigned int *outWidth,
+                                     unsigned int *outHeight);
+
+/**
+ Decode a PNG straight into the caller's buffer, converting to the given format as we go.
+ Non-interlaced images are inflated, unfiltered and converted a row at a time,
+ so nothing image-sized is allocated along the way.  Interlaced images fall back to
+ a full decode and a copy.
+ The value map, if present, remaps 8 bit single channel values in place.
+ Output depth and components describe the decoded layout, e.g. 16 and 1 for RGB565.
+ Returns 0 on success, otherwise an error code.
+ */
+extern unsigned RawPNGImageDecodeInto(const unsigned char *data,
+                                      size_t length,
+                                      RawPNGPixelFormat format,
+                                      const int valueMap[256],
+                                      unsigned char *outData,
+                                      size_t outLength,
+                                      unsigned int &width,
+                                      unsigned int &height,
+                                      unsigned *outDepth,
+                                      unsigned *outComponents,
+                                      std::string *outErrStr);
+
+/**
+ Decode a PNG into a buffer borrowed from the pool, as with RawPNGImageDecodeInto.
+ The buffer goes back to the pool once the returned data is released.
+ Returns NULL on failure, check the err value.
+ */
+extern PooledRawDataRef RawPNGImageDecodeToPool(const RawDataPoolRef &pool,
+                                                const unsigned char *data,
+                                                size_t length,
+                                                RawPNGPixelFormat format,
+                                                const int valueMap[256],
+                                                unsigned int &width,
+                                                unsigned int &height,
+                                                unsigned *outDepth,
+                                                unsigned *outComponents,
+                                                unsigned int *outErr,
+                                                std::string *outErrStr);
+
 }
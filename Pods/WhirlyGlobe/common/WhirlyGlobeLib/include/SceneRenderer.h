@@ -168,6 +168,9 @@ public:
     std::string name;
     GroupType groupType;
 
+    /// Handle for timing this work group, registered the first time it's needed
+    int perfHandle = -1;
+
     std::vector<RenderTargetContainerRef> renderTargetContainers;
 
     virtual RenderTargetContainerRef makeRenderTargetContainer(RenderTargetRef) = 0;
@@ -406,7 +409,23 @@ protected:
     unsigned int frameCount = 0;
     unsigned int frameCountLastChanged = 0;
     TimeInterval frameCountStart = 0.0;
-    PerformanceTimer perfTimer;
+    ConcurrentPerformanceTimer perfTimer;
+
+    /// Handles for the things we time every frame, registered in init()
+    struct PerfHandles
+    {
+        ConcurrentPerformanceTimer::Handle renderFrame = -1;
+        ConcurrentPerformanceTimer::Handle renderSetup = -1;
+        ConcurrentPerformanceTimer::Handle scenePreprocess = -1;
+        ConcurrentPerformanceTimer::Handle preprocessChanges = -1;
+        ConcurrentPerformanceTimer::Handle activeModelRuns = -1;
+        ConcurrentPerformanceTimer::Handle activeModels = -1;
+        ConcurrentPerformanceTimer::Handle sceneChanges = -1;
+        ConcurrentPerformanceTimer::Handle sceneProcessing = -1;
+    } perfHandles;
+
+    /// Timer for the renderer, which other threads may add to
+    ConcurrentPerformanceTimer &getPerfTimer() { return perfTimer; }
     
     /// Last time we rendered
     TimeInterval lastDraw = 0.0;
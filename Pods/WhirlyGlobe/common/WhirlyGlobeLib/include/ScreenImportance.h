@@ -27,6 +27,10 @@
 #import "GlobeMath.h"
 #import "QuadTreeNew.h"
 #import "SceneRenderer.h"
+#import <atomic>
+#import <list>
+#import <mutex>
+#import <unordered_map>
 
 
 namespace WhirlyKit
@@ -57,6 +61,9 @@ public:
     /// See if this display solid is current in the viewing frustum
     bool isOnScreenForViewState(ViewState *viewState,const Point2f &frameSize);
     
+    /// True if all of the display solid is inside the viewing frustum for one of the view matrices
+    bool isEntirelyOnScreenForViewState(ViewState *viewState);
+
     /// Set by the constructor
     bool valid;
     
@@ -72,6 +79,114 @@ public:
     
 typedef std::shared_ptr<DisplaySolid> DisplaySolidRef;
 
+/** A bounded cache of display solids for tiles.
+    Building a display solid samples the tile through the coordinate systems,
+    which is a waste when the same tiles are evaluated on every view update.
+    The least recently used ones are discarded once we're full.
+  */
+class DisplaySolidCache
+{
+public:
+    DisplaySolidCache(size_t maxEntries = 4096);
+
+    /// Return the display solid for the given tile, building it if needed
+    DisplaySolidRef getSolid(const QuadTreeIdentifier &nodeIdent,const Mbr &nodeMbr,
+                             const CoordSystem *srcSystem,const CoordSystemDisplayAdapter *coordAdapter);
+
+    /// Discard everything, such as when the tile bounds change
+    void clear();
+
+    /// Change the maximum number of display solids we keep
+    void setMaxEntries(size_t maxEntries);
+
+    size_t getNumEntries() const;
+    int64_t getHits() const { return hits; }
+    int64_t getMisses() const { return misses; }
+
+protected:
+    struct Key
+    {
+        bool operator == (const Key &that) const;
+
+        int64_t nodeNumber;
+        Point2f ll,ur;
+        const CoordSystem *srcSystem;
+        const CoordSystemDisplayAdapter *coordAdapter;
+    };
+    struct KeyHash
+    {
+        size_t operator () (const Key &key) const;
+    };
+    typedef std::list<std::pair<Key,DisplaySolidRef>> EntryList;
+
+    mutable std::mutex lock;
+    size_t maxEntries;
+    // Most recently used at the front
+    EntryList entries;
+    std::unordered_map<Key,EntryList::iterator,KeyHash> entriesByKey;
+    std::atomic<int64_t> hits = {0};
+    std::atomic<int64_t> misses = {0};
+};
+
+/** Display solids for a batch of tiles, laid out to be evaluated all at once.
+    The polygon corners are kept in separate coordinate arrays so they can go
+    through the view matrices several at a time.  Polygons entirely inside or
+    outside the frustum are settled right there.  Only the ones crossing it
+    fall back to clipping, so the results match DisplaySolid.
+  */
+class DisplaySolidBatch
+{
+public:
+    /// Add a display solid (which may be null) and return its index in the results
+    int addSolid(const DisplaySolidRef &dispSolid);
+
+    /// Number of solids added so far
+    size_t getNumSolids() const { return entries.size(); }
+
+    /// Remove all the solids, keeping the memory around for the next batch
+    void clear();
+
+    /// Calculate importance for each solid, as in DisplaySolid::importanceForViewState.  Null solids get 0.
+    void importanceForViewState(ViewState *viewState,const Point2f &frameSize,std::vector<double> &importance);
+
+    /// Check if each solid is on screen, as in DisplaySolid::isOnScreenForViewState
+    void isOnScreenForViewState(ViewState *viewState,const Point2f &frameSize,std::vector<bool> &onScreen);
+
+protected:
+    struct Entry
+    {
+        DisplaySolidRef dispSolid;
+        // Range of our polygons in the corner arrays, if they're there
+        int polyStart,numPolys;
+        bool batched;
+    };
+
+    // Run all the corners through the given view matrix
+    void projectCorners(ViewState *viewState,int offi,const Point2f &frameSize);
+
+    std::vector<Entry> entries;
+    // Solid each polygon came from
+    std::vector<int> polyEntry;
+    // Four corners per polygon
+    std::vector<double> cornerX,cornerY,cornerZ;
+    // One normal per polygon
+    std::vector<double> normX,normY,normZ;
+    // Model space area of each polygon
+    std::vector<double> polyArea;
+
+    // Working space for a single view
+    std::vector<uint8_t> cornerOutside;
+    std::vector<double> screenX,screenY;
+    std::vector<double> polyImport;
+    Vector4dVector clipCorners;
+};
+
+/** True if a tile entirely on screen in both views has the same importance in each.
+    That's the case for a flat map moved without tilting, rotating or zooming, where
+    the screen area of a tile doesn't depend on where it is.
+  */
+bool ScreenScaleUnchanged(WhirlyKit::ViewState *oldViewState,WhirlyKit::ViewState *newViewState);
+
 /// Check if any part of the given tile is on screen
 bool TileIsOnScreen(WhirlyKit::ViewState *viewState,const WhirlyKit::Point2f &frameSize,WhirlyKit::CoordSystem *srcSystem,WhirlyKit::CoordSystemDisplayAdapter *coordAdapter,const WhirlyKit::Mbr &nodeMbr,const QuadTreeIdentifier &nodeIdent,DisplaySolidRef &dispSold);
 
@@ -47,12 +47,18 @@ struct SphericalMercatorCoordSystem : public CoordSystem
     virtual Point3d geographicToLocal(const Point2d&) const override;
     virtual Point2d geographicToLocal2(const Point2d&) const override;
 
+    /// Convert whole arrays of points between local and lat/lon
+    virtual void localToGeographicArray(const Point3d *pts,Point2d *outPts,size_t numPts) const override;
+    virtual void geographicToLocalArray(const Point2d *pts,Point3d *outPts,size_t numPts) const override;
+
     /// Convert from the local coordinate system to geocentric
     virtual Point3f localToGeocentric(const Point3f&) const override;
     virtual Point3d localToGeocentric(const Point3d&) const override;
+    virtual void localToGeocentricArray(const Point3d *pts,Point3d *outPts,size_t numPts) const override;
     /// Convert from display coordinates to geocentric
     virtual Point3f geocentricToLocal(const Point3f&) const override;
     virtual Point3d geocentricToLocal(const Point3d&) const override;
+    virtual void geocentricToLocalArray(const Point3d *pts,Point3d *outPts,size_t numPts) const override;
     
     /// True if the other system is Spherical Mercator with the same origin
     virtual bool isSameAs(const CoordSystem *coordSys) const override;
@@ -97,6 +103,10 @@ struct SphericalMercatorDisplayAdapter : public CoordSystemDisplayAdapter
     /// Convert from display coordinates to the local system's coordinates
     virtual Point3f displayToLocal(const Point3f&) const override;
     virtual Point3d displayToLocal(const Point3d&) const override;
+
+    /// Convert whole arrays of points at once
+    virtual void localToDisplayArray(const Point3d *pts,Point3d *outPts,size_t numPts) const override;
+    virtual void displayToLocalArray(const Point3d *pts,Point3d *outPts,size_t numPts) const override;
     
     /// For flat systems the normal is Z up.  For the globe, it's based on the location.
     virtual Point3f normalForLocal(const Point3f&) const override { return {0,0,1 }; }
@@ -18,6 +18,8 @@
  *
  */
 
+#import <mutex>
+#import <atomic>
 #import "VectorData.h"
 #import "WhirlyKitView.h"
 
@@ -37,6 +39,36 @@ typedef enum {
 class VectorObject;
 typedef std::shared_ptr<VectorObject> VectorObjectRef;
 
+/** Builds the shapes for a VectorObject the first time they're asked for.
+    Until then it can answer questions about type and attributes without doing the work.
+    A source fills in the shapes for a single VectorObject.
+  */
+class VectorShapeSource
+{
+public:
+    virtual ~VectorShapeSource() = default;
+
+    /// The type of vector the shapes will be
+    virtual VectorObjectType getVectorType() const = 0;
+
+    /// The attributes the shapes will have
+    virtual MutableDictionaryRef getAttributes() const = 0;
+
+    /// Build the shapes into the given set, if that hasn't happened already.  Thread safe.
+    void resolve(ShapeSet &shapes);
+
+    /// True once the shapes have been built
+    bool isResolved() const { return resolved; }
+
+protected:
+    /// Fill in the shapes.  Called once.
+    virtual void buildShapes(ShapeSet &shapes) = 0;
+
+    std::once_flag once;
+    std::atomic<bool> resolved = { false };
+};
+typedef std::shared_ptr<VectorShapeSource> VectorShapeSourceRef;
+
 /** @brief The C++ object we use to wrap a group of vectors and consolidate the various methods for manipulating vectors.
     @details The VectorObject stores a list of reference counted VectorShape objects.
   */
@@ -54,6 +86,17 @@ public:
 
     /// @brief Return the type of vector
     VectorObjectType getVectorType() const;
+
+    /// Build the shapes from the given source when they're first needed, rather than now
+    void setShapeSource(VectorShapeSourceRef source);
+
+    /// True if the shapes come from a source that hasn't been asked for them yet
+    bool shapesPending() const { return shapeSource && !shapeSource->isResolved(); }
+
+    /// The shapes, after building them from the source if need be.
+    /// Use this rather than the shapes member for objects that may have a source.
+    ShapeSet &getShapes() { ensureShapes(); return shapes; }
+    const ShapeSet &getShapes() const { ensureShapes(); return shapes; }
     
     /// Set if the data is selectable
     bool isSelectable() const;
@@ -235,6 +278,12 @@ public:
 
     bool selectable = true;
     ShapeSet shapes;
+
+protected:
+    // Fill in the shapes from the source, if there is one
+    void ensureShapes() const;
+
+    VectorShapeSourceRef shapeSource;
 };
 
 // Sample a great circle and throw in an interpolated height at each point
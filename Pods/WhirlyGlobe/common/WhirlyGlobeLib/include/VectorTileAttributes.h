@@ -0,0 +1,205 @@
+/*  VectorTileAttributes.h
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#import <deque>
+#import <string_view>
+#import "DictionaryC.h"
+
+namespace WhirlyKit
+{
+
+/// A single entry in a vector tile layer's value table.
+/// Strings point into the layer's own copy of the string bytes.
+struct VectorTileValue
+{
+    enum ValueType : int8_t {
+        ValNone,
+        ValString,
+        ValFloat,
+        ValDouble,
+        ValInt,
+        ValUInt,
+        ValSInt,
+        ValBool,
+    };
+    union {
+        std::string_view stringValue;
+        float floatValue;
+        double doubleValue;
+        int64_t intValue;
+        uint64_t uintValue;
+        int64_t sintValue;
+        bool boolValue;
+    };
+    ValueType type;
+
+    VectorTileValue() : intValue(0), type(ValNone) { }
+
+    /// The type this looks like from the Dictionary interface
+    DictionaryType dictType() const;
+
+    /// Numeric conversions, as used by the Dictionary interface
+    int64_t getInt64() const;
+    double getDouble() const;
+
+    /// A dictionary entry with the same value
+    DictionaryEntryRef makeEntry() const;
+};
+
+/// Keys, values, feature tags and geometry for one layer of a tile
+struct VectorTileLayerTable
+{
+    /// Copy the bytes of the keys and string values out of the tile data and point them at the copy
+    void copyStrings();
+
+    std::string layerName;
+    int layerOrder = 0;
+    std::vector<std::string_view> keys;
+    std::vector<VectorTileValue> values;
+    // Key/value index pairs for all the features in the layer, back to back
+    std::vector<uint32_t> tags;
+    // Geometry command streams for all the features in the layer, back to back
+    std::vector<uint32_t> geometry;
+    // Backing store for the keys and string values, once they're copied out of the tile
+    std::vector<char> strings;
+    // Key IDs the style delegate assigned to each of the keys, -1 for those it doesn't care about
+    std::vector<int> keyIDs;
+    // Who assigned the key IDs, so we don't mix up two sets of them
+    const void *keyIDOwner = nullptr;
+
+    /// Set up room for the results of the given number of predicates on each of the values
+    void setupPredicates(const void *group,uint32_t count);
+    /// Record the result of a predicate for a value
+    void setPredicate(uint32_t which,uint32_t valueIndex,bool result);
+    /// Result of a predicate for a value, or -1 if it wasn't checked
+    int getPredicate(uint32_t which,uint32_t valueIndex) const
+    {
+        const size_t stride = (values.size() + 63) / 64;
+        const size_t word = (size_t)which * 2 * stride + valueIndex / 64;
+        const uint64_t bit = (uint64_t)1 << (valueIndex % 64);
+        return (predicateBits[word] & bit) ? ((predicateBits[word + stride] & bit) ? 1 : 0) : -1;
+    }
+
+    // The style delegate's filter predicates, run once per distinct value rather than per feature.
+    // For each one there's a bitset of which values were checked, followed by one with the results.
+    std::vector<uint64_t> predicateBits;
+    uint32_t predicateCount = 0;
+    // Which set of predicates these are for
+    const void *predicateGroup = nullptr;
+};
+
+/** Attributes for a single vector tile feature.
+
+    Rather than copying every key and value into a dictionary of its own,
+    this refers back to its layer's key and value tables by index.  The
+    layer_name, geometry_type, and layer_order fields are filled in from the layer.
+
+    These are allocated in bulk by a VectorTileAttributeArena along with the
+    layer tables.  If someone modifies one, the contents are copied into a
+    regular dictionary first.
+  */
+class VectorTileAttributes : public MutableDictionary
+{
+public:
+    VectorTileAttributes(const VectorTileLayerTable *layer,uint32_t tagStart,uint32_t tagEnd,int geomType);
+    virtual ~VectorTileAttributes() = default;
+
+    /// The layer tables we're looking into
+    const VectorTileLayerTable *getLayer() const { return layer; }
+
+    /// Find the value for a given key without any conversion.
+    /// Returns false if it's not there (or we've been modified).
+    bool findValue(const std::string &name,VectorTileValue &val) const;
+
+    /// Find the value for a key by the ID assigned in the layer's keyIDs.
+    /// This doesn't include the fields filled in from the layer.
+    const VectorTileValue *findValue(int keyID) const;
+
+    /// True if we've been modified and are no longer looking at the layer tables
+    bool isModified() const { return (bool)overlay; }
+
+    /// True for the field names that come from the layer rather than the feature
+    static bool isLayerField(const std::string &name);
+
+    virtual MutableDictionaryRef copy() const override;
+
+    virtual int count() const override;
+    virtual bool empty() const override { return count() == 0; }
+    virtual bool hasField(const std::string &name) const override;
+    virtual DictionaryType getType(const std::string &name) const override;
+    virtual int getInt(const std::string &name,int defVal=0) const override;
+    virtual int64_t getInt64(const std::string &name,int64_t defVal=0) const override;
+    virtual SimpleIdentity getIdentity(const std::string &name) const override;
+    virtual bool getBool(const std::string &name,bool defVal=false) const override;
+    virtual RGBAColor getColor(const std::string &name,const RGBAColor &defVal) const override;
+    virtual double getDouble(const std::string &name,double defVal=0.0) const override;
+    virtual std::string getString(const std::string &name) const override;
+    virtual std::string getString(const std::string &name,const std::string &defVal) const override;
+    virtual DictionaryRef getDict(const std::string &name) const override;
+    virtual DictionaryEntryRef getEntry(const std::string &name) const override;
+    virtual std::vector<DictionaryEntryRef> getArray(const std::string &name) const override;
+    virtual std::vector<std::string> getKeys() const override;
+
+    // Any of these switch us over to a regular dictionary
+    virtual void clear() override;
+    virtual void removeField(const std::string &name) override;
+    virtual void setInt(const std::string &name,int val) override;
+    virtual void setInt64(const std::string &name,int64_t val) override;
+    virtual void setIdentifiable(const std::string &name,SimpleIdentity val) override;
+    virtual void setDouble(const std::string &name,double val) override;
+    virtual void setString(const std::string &name,const std::string &val) override;
+    virtual void addEntries(const Dictionary *other) override;
+
+protected:
+    // Copy everything into a regular dictionary for modification
+    MutableDictionaryC &makeMutable();
+    void copyInto(MutableDictionaryC &dict) const;
+
+    const VectorTileLayerTable *layer;
+    uint32_t tagStart;
+    uint32_t tagEnd;
+    int geomType;
+    MutableDictionaryCRef overlay;
+};
+
+class VectorTileAttributeArena;
+typedef std::shared_ptr<VectorTileAttributeArena> VectorTileAttributeArenaRef;
+
+/** Holds the attributes for all the features of a tile, along with the layer
+    tables they refer to.  The tables have their own copies of the strings, so
+    the tile data can be released or reused once it's parsed.  Features hand out
+    references that share ownership of the whole arena, so it goes away with the
+    last of them.
+  */
+class VectorTileAttributeArena : public std::enable_shared_from_this<VectorTileAttributeArena>
+{
+public:
+    /// Add an empty layer to be filled in.  The result stays put as more are added.
+    VectorTileLayerTable &addLayer();
+
+    /// Allocate attributes for a feature in the given layer
+    MutableDictionaryRef addFeature(const VectorTileLayerTable *layer,uint32_t tagStart,uint32_t tagEnd,int geomType);
+
+    size_t getNumLayers() const { return layers.size(); }
+    size_t getNumFeatures() const { return features.size(); }
+
+protected:
+    std::deque<VectorTileLayerTable> layers;
+    std::deque<VectorTileAttributes> features;
+};
+
+}
@@ -11,8 +11,10 @@
 
 #include <Identifiable.h>
 #include <VectorData.h>
+#include <VectorObject.h>
 #include <WhirlyVector.h>
 #include <MapboxVectorTileParser.h>
+#include <VectorTileAttributes.h>
 
 #include <functional>
 #include <map>
@@ -31,15 +33,60 @@ typedef struct _vector_tile_Tile_Value vector_tile_Tile_Value;
 namespace WhirlyKit
 {
 
-class MutableDictionaryC;
 struct PlatformThreadInfo;
 class VectorTileData;
 class VectorStyleDelegateImpl;
 class VectorObject;
 
-typedef std::shared_ptr<MutableDictionaryC> MutableDictionaryCRef;
 typedef std::shared_ptr<VectorObject> VectorObjectRef;
 
+/// Decodes a feature's geometry from the layer's command stream the first time the shapes are needed
+class VectorTileShapeSource : public VectorShapeSource
+{
+public:
+    // How to get from tile coordinates to the output coordinates
+    struct Transform
+    {
+        double layerScale;
+        double tileOriginX;
+        double tileOriginY;
+        double sx;
+        double sy;
+        bool localCoords;
+    };
+
+    /// The attributes keep the layer, and so the geometry, alive
+    VectorTileShapeSource(MutableDictionaryRef attributes,
+                          const uint32_t *geometry,
+                          size_t geomCount,
+                          MapnikGeometryType geomType,
+                          const Transform &transform);
+
+    virtual VectorObjectType getVectorType() const override;
+    virtual MutableDictionaryRef getAttributes() const override { return attributes; }
+
+    static constexpr int TileSize = 256;
+
+protected:
+    virtual void buildShapes(ShapeSet &shapes) override;
+
+    static inline int32_t decodeParamInt(int32_t p);
+    static inline std::pair<uint8_t, int32_t> decodeCommand(int32_t c);
+
+    inline void parseLineString(ShapeSet& shapes) const;
+    inline bool parsePolygon(VectorAreal& shape) const;
+    inline bool parsePoints(VectorPoints& shape) const;
+
+    MutableDictionaryRef attributes;
+    const uint32_t *geometry;
+    size_t geomCount;
+    MapnikGeometryType geomType;
+    Transform transform;
+
+    static constexpr uint32_t CmdBits = 3U;
+    static constexpr double MAX_EXTENT = 20037508.342789244;
+};
+
 class VectorTilePBFParser
 {
 public:
@@ -57,6 +104,7 @@ public:
         std::vector<VectorObjectRef>* keepVectors = nullptr,
         CancelFunction isCancelled = [](auto){return false;});
 
+    // Feature attributes keep copies of what they need, the data is only used during the call
     bool parse(const uint8_t* data, size_t length);
 
     unsigned getLayerCount() const { return _layerCount; }
@@ -64,6 +112,11 @@ public:
     
     unsigned getSkippedLayerCount() const { return _skippedLayerCount; }
     unsigned getSkippedFeatureCount() const { return _skippedFeatureCount; }
+
+    // Bytes of layer data passed over without decoding, because nothing was styled for it
+    size_t getSkippedLayerBytes() const { return _skippedLayerBytes; }
+    // Bytes of layer data fully decoded
+    size_t getDecodedLayerBytes() const { return _decodedLayerBytes; }
     
     unsigned getParseErrorCount() const { return _parseErrors; }
     unsigned getBadAttributeCount() const { return _badAttributes; }
@@ -96,31 +149,6 @@ private:
 
     typedef std::unordered_set<SimpleIdentity> SimpleIDUSet;
 
-    // This holds a tile value in less space than the one generated by nanopb
-    struct SmallValue
-    {
-        enum SmallValueType : int8_t {
-            SmallValNone,
-            SmallValString,
-            SmallValFloat,
-            SmallValDouble,
-            SmallValInt,
-            SmallValUInt,
-            SmallValSInt,
-            SmallValBool,
-        };
-        union {
-            std::string_view stringValue;
-            float floatValue;
-            double doubleValue;
-            int64_t intValue;
-            uint64_t uintValue;
-            int64_t sintValue;
-            bool boolValue;
-        };
-        SmallValueType type;
-    };
-
     struct Feature
     {
         uint32_t tagIndex;
@@ -132,9 +160,6 @@ private:
     };
 
 private:
-    static inline int32_t decodeParamInt(int32_t p);
-    static inline std::pair<uint8_t, int32_t> decodeCommand(int32_t c);
-
     // nanopb callbacks
     static bool layerDecode(pb_istream_t *stream, const pb_field_iter_t *field, void **arg);
     static bool featureDecode(pb_istream_t *stream, const pb_field_iter_t *field, void **arg);
@@ -148,11 +173,10 @@ private:
     inline bool featureDecode(pb_istream_t *stream, const pb_field_iter_t *field);
 
     // Parsing methods
-    inline bool processTags(const MutableDictionaryCRef &attributes, size_t tagIdx, size_t geomIdx, const Feature &feature);
-    inline bool checkStyles(SimpleIDUSet& styleIDs, const MutableDictionaryCRef &attributes, const std::string &layerName);
-    inline void parseLineString(const uint32_t *geometry, size_t geomCount, ShapeSet& shapes) const;
-    inline bool parsePolygon(const uint32_t *geometry, size_t geomCount, VectorAreal& shape);
-    inline bool parsePoints(const uint32_t *geometry, size_t geomCount, VectorPoints& shape);
+    static bool peekLayerName(const pb_istream_t *stream, std::string_view &name);
+    inline bool layerWanted(std::string &layerName);
+    inline bool processTags(const VectorTileLayerTable &layer, size_t tagIdx, const Feature &feature);
+    inline bool checkStyles(SimpleIDUSet& styleIDs, const Dictionary &attributes, const std::string &layerName);
     inline void addFeature(const VectorObjectRef &vecObj, const SimpleIDUSet &styleIDs);
     inline void layerElement();
     inline bool layerStart();
@@ -180,7 +204,7 @@ private:
     std::vector<uint32_t> _featureGeometry;
     std::vector<Feature> _features;
     std::vector<std::string_view> _layerKeys;
-    std::vector<SmallValue> _layerValues;
+    std::vector<VectorTileValue> _layerValues;
     std::string _parseError;
 
 private:
@@ -196,8 +220,8 @@ private:
     std::vector<VectorObjectRef>* _keepVectors = nullptr;
     CancelFunction _checkCancelled;
 
-    // Reused storage
-    VectorRing tempRing;
+    // Where feature attributes live, along with the tile data they refer to
+    VectorTileAttributeArenaRef _attrArena;
 
     // State used during parsing
     const MbrD _bbox;
@@ -213,6 +237,8 @@ private:
     unsigned _featureCount = 0;
     unsigned _skippedFeatureCount = 0;
     unsigned _skippedLayerCount = 0;
+    size_t _skippedLayerBytes = 0;
+    size_t _decodedLayerBytes = 0;
     unsigned _unknownValueTypes = 0;
     unsigned _badAttributes = 0;
     unsigned _unknownCommands = 0;
@@ -221,9 +247,7 @@ private:
     bool _wasCancelled = false;
 
     // Constants
-    static constexpr uint32_t CmdBits = 3U;
-    static constexpr int TileSize = 256;
-    static constexpr double MAX_EXTENT = 20037508.342789244;
+    static constexpr int TileSize = VectorTileShapeSource::TileSize;
 };
 
 } // namespace WhirlyKit
@@ -38,6 +38,7 @@
 #import "LabelRenderer.h"
 #import "Lighting.h"
 #import "LoadedTileNew.h"
+#import "MBTilesReader.h"
 #import "MaplyAnimateTranslateMomentum.h"
 #import "MaplyAnimateTranslation.h"
 #import "MaplyFlatView.h"
@@ -50,11 +51,13 @@
 #import "QuadDisplayControllerNew.h"
 #import "QuadImageFrameLoader.h"
 #import "QuadLoaderReturn.h"
+#import "QuadLoaderDecodeQueue.h"
 #import "QuadSamplingController.h"
 #import "QuadSamplingParams.h"
 #import "QuadTileBuilder.h"
 #import "QuadTreeNew.h"
 #import "RawData.h"
+#import "RawDataCompression.h"
 #import "RawPNGImage.h"
 #import "RenderTarget.h"
 #import "Scene.h"
@@ -83,6 +86,7 @@
 #import "WhirlyVector.h"
 #import "WideVectorDrawableBuilder.h"
 #import "WideVectorManager.h"
+#import "WorkStealingPool.h"
 
 #if !MAPLY_MINIMAL
 # import "BillboardDrawableBuilder.h"
@@ -98,6 +102,7 @@
 # import "LoftManager.h"
 # import "IntersectionManager.h"
 # import "MapboxVectorTileParser.h"
+# import "VectorTileAttributes.h"
 # import "MapboxVectorStyleSetC.h"
 # import "MapboxVectorStyleBackground.h"
 # import "MapboxVectorStyleCircle.h"
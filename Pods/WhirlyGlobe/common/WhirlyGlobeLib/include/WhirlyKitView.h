@@ -21,6 +21,8 @@
 #import "WhirlyVector.h"
 #import "CoordSystem.h"
 
+#import <atomic>
+#import <functional>
 #import <memory>
 #import <mutex>
 #import <set>
@@ -44,12 +46,24 @@ struct ViewWatcher
 using ViewWatcherRef = std::shared_ptr<ViewWatcher>;
 using ViewWatcherWeakRef = std::weak_ptr<ViewWatcher>;
 
+/// Moves a view to where an animation will have put it at the given time.
+/// Returns false if there's no telling.
+typedef std::function<bool(View *,TimeInterval)> ViewPredictor;
+
+/// Makes a view state for where the view will be at the given time, or null if there's no telling
+typedef std::function<ViewStateRef(TimeInterval)> ViewStatePredictor;
+
 struct ViewAnimationDelegate
 {
     virtual bool isUserMotion() const = 0;
 
     /// Called every tick to update the view position
     virtual void updateView(WhirlyKit::View *) = 0;
+
+    /// Capture the values needed to say where the animation will put the view later on.
+    /// The result may be run on any thread, so it can't refer back to the delegate,
+    /// the renderer or anything else that might go away.
+    virtual ViewPredictor makePredictor(const Point2f &frameSize) const { return ViewPredictor(); }
 };
 
 /** Whirly Kit View is the base class for the views
@@ -130,6 +144,16 @@ public:
     /// Generate a ViewState corresponding to this view
     virtual ViewStateRef makeViewState(SceneRenderer *renderer) = 0;
 
+    /// If we're animating in a predictable way, make something to tell where we'll be.
+    /// Filled in by subclass.
+    virtual ViewStatePredictor makeViewStatePredictor(const Point2f &frameSize) const { return ViewStatePredictor(); }
+
+    /// Ask for the view states we make to carry a predictor.  Each retain needs a release.
+    /// Copies of the view start out without any.
+    void retainPredictions() { predictionUsers++; }
+    void releasePredictions() { predictionUsers--; }
+    bool wantsPredictions() const { return predictionUsers > 0; }
+
     /// Add a watcher delegate.  Call this on the main thread.
     virtual void addWatcher(const ViewWatcherRef &);
     
@@ -237,6 +261,9 @@ protected:
     // should never be huge numbers of watchers, or rapid adds/removes.
     std::vector<ViewWatcherWeakRef> watchers;
     std::mutex watcherLock;
+
+    /// Number of users who want view states to say where the view is going
+    std::atomic<int> predictionUsers = {0};
 };
     
 typedef std::shared_ptr<View> ViewRef;
@@ -250,6 +277,7 @@ class ViewState
 public:
     ViewState() : near(0), far(0) { }
     ViewState(View *view,WhirlyKit::SceneRenderer *renderer);
+    ViewState(View *view,const Point2f &frameSize);
     virtual ~ViewState() = default;
     
     EIGEN_MAKE_ALIGNED_OPERATOR_NEW;
@@ -290,6 +318,9 @@ public:
     
     /// Calculate where the eye is in model coordinates
     Point3d eyePos;
+
+    /// Where the view is going, if it was animating in a predictable way
+    ViewStatePredictor predictor;
 };
 
 }
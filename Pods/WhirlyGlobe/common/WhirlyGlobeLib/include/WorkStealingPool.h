@@ -0,0 +1,76 @@
+/*  WorkStealingPool.h
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#import <condition_variable>
+#import <deque>
+#import <functional>
+#import <memory>
+#import <mutex>
+#import <thread>
+#import <vector>
+
+namespace WhirlyKit
+{
+
+/** A fixed set of worker threads for running batches of independent tasks.
+
+    Each worker has its own queue.  The tasks in a batch are dealt out across
+    the queues and workers that run dry take tasks from the others.  Whoever
+    submits a batch pitches in while waiting for it, so several threads can
+    share one pool without tying each other up.
+  */
+class WorkStealingPool
+{
+public:
+    typedef std::function<void()> Task;
+    /// Wraps each task, for setup the platform needs around it (e.g. an autorelease pool)
+    typedef std::function<void(const Task &)> TaskRunner;
+
+    /// Start the given number of workers, or one less than the number of cores if 0
+    WorkStealingPool(int numThreads = 0,TaskRunner runner = TaskRunner());
+    ~WorkStealingPool();
+
+    int getNumThreads() const { return (int)workers.size(); }
+
+    /// Run all the tasks and return when they've finished
+    void run(std::vector<Task> &tasks);
+
+protected:
+    struct Queue
+    {
+        std::mutex lock;
+        std::deque<Task> tasks;
+    };
+
+    // Take a task from the given queue, or any of the others
+    bool runOne(size_t which);
+    void workerMain(size_t which);
+
+    TaskRunner runner;
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread> workers;
+
+    // Protects the queued count and wakes up idle workers
+    std::mutex lock;
+    std::condition_variable wake;
+    size_t queued = 0;
+    size_t nextQueue = 0;
+    bool shutdown = false;
+};
+typedef std::shared_ptr<WorkStealingPool> WorkStealingPoolRef;
+
+}
@@ -67,7 +67,7 @@ void BasicDrawableInstance::setInstMaster(BasicDrawableRef newInstMaster)
     
 Mbr BasicDrawableInstance::getLocalMbr() const
 {
-    return basicDraw->getLocalMbr();
+    return hasLocalMbr ? localMbr : basicDraw->getLocalMbr();
 }
 
 int64_t BasicDrawableInstance::getDrawOrder() const
@@ -306,7 +306,7 @@ void BasicDrawableInstance::setUniBlock(const BasicDrawable::UniformBlock &uniBl
 
 const Eigen::Matrix4d *BasicDrawableInstance::getMatrix() const
 {
-    return basicDraw->getMatrix();
+    return hasMatrix ? &mat : basicDraw->getMatrix();
 }
     
 SimpleIdentity BasicDrawableInstance::getRenderTarget() const
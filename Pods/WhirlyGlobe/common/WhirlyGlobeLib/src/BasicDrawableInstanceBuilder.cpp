@@ -222,6 +222,18 @@ void BasicDrawableInstanceBuilder::setProgram(SimpleIdentity progID)
 {
     drawInst->setProgram(progID);
 }
+
+void BasicDrawableInstanceBuilder::setMatrix(const Eigen::Matrix4d &mat)
+{
+    drawInst->hasMatrix = true;
+    drawInst->mat = mat;
+}
+
+void BasicDrawableInstanceBuilder::setLocalMbr(const Mbr &localMbr)
+{
+    drawInst->hasLocalMbr = true;
+    drawInst->localMbr = localMbr;
+}
     
 SimpleIdentity BasicDrawableInstanceBuilder::getDrawableID() const
 {
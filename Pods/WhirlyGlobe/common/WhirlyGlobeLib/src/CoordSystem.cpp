@@ -18,12 +18,37 @@
 
 #import "Platform.h"
 #import "CoordSystem.h"
+#import <algorithm>
 
 using namespace Eigen;
 
 namespace WhirlyKit
 {
 
+void CoordSystem::localToGeographicArray(const Point3d *pts,Point2d *outPts,size_t numPts) const
+{
+    for (size_t ii=0;ii<numPts;ii++)
+        outPts[ii] = localToGeographicD(pts[ii]);
+}
+
+void CoordSystem::geographicToLocalArray(const Point2d *pts,Point3d *outPts,size_t numPts) const
+{
+    for (size_t ii=0;ii<numPts;ii++)
+        outPts[ii] = geographicToLocal(pts[ii]);
+}
+
+void CoordSystem::localToGeocentricArray(const Point3d *pts,Point3d *outPts,size_t numPts) const
+{
+    for (size_t ii=0;ii<numPts;ii++)
+        outPts[ii] = localToGeocentric(pts[ii]);
+}
+
+void CoordSystem::geocentricToLocalArray(const Point3d *pts,Point3d *outPts,size_t numPts) const
+{
+    for (size_t ii=0;ii<numPts;ii++)
+        outPts[ii] = geocentricToLocal(pts[ii]);
+}
+
 Point3f CoordSystemConvert(const CoordSystem *inSystem,const CoordSystem *outSystem,const Point3f &inCoord)
 {
     // Easy if the coordinate systems are the same
@@ -44,6 +69,32 @@ Point3d CoordSystemConvert3d(const CoordSystem *inSystem,const CoordSystem *outS
     return outSystem->geocentricToLocal(inSystem->localToGeocentric(inCoord));
 }
 
+void CoordSystemConvert3d(const CoordSystem *inSystem,const CoordSystem *outSystem,const Point3d *inPts,Point3d *outPts,size_t numPts)
+{
+    if (inSystem->isSameAs(outSystem))
+    {
+        if (inPts != outPts)
+            std::copy(inPts, inPts + numPts, outPts);
+        return;
+    }
+
+    // Same trip through geocentric as the single point version, but the whole array at each step
+    inSystem->localToGeocentricArray(inPts, outPts, numPts);
+    outSystem->geocentricToLocalArray(outPts, outPts, numPts);
+}
+
+void CoordSystemDisplayAdapter::localToDisplayArray(const Point3d *pts,Point3d *outPts,size_t numPts) const
+{
+    for (size_t ii=0;ii<numPts;ii++)
+        outPts[ii] = localToDisplay(pts[ii]);
+}
+
+void CoordSystemDisplayAdapter::displayToLocalArray(const Point3d *pts,Point3d *outPts,size_t numPts) const
+{
+    for (size_t ii=0;ii<numPts;ii++)
+        outPts[ii] = displayToLocal(pts[ii]);
+}
+
 GeneralCoordSystemDisplayAdapter::GeneralCoordSystemDisplayAdapter(CoordSystem *coordSys,const Point3d &ll,const Point3d &ur,
                                                                    const Point3d &inCenter,const Point3d &inScale) :
     CoordSystemDisplayAdapter(coordSys,inCenter),
@@ -99,4 +150,16 @@ Point3d GeneralCoordSystemDisplayAdapter::displayToLocal(const Point3d &dispPt)
     return dispPt.cwiseQuotient(scale) + center;
 }
 
+void GeneralCoordSystemDisplayAdapter::localToDisplayArray(const Point3d *pts,Point3d *outPts,size_t numPts) const
+{
+    for (size_t ii=0;ii<numPts;ii++)
+        outPts[ii] = pts[ii].cwiseProduct(scale) - center;
+}
+
+void GeneralCoordSystemDisplayAdapter::displayToLocalArray(const Point3d *pts,Point3d *outPts,size_t numPts) const
+{
+    for (size_t ii=0;ii<numPts;ii++)
+        outPts[ii] = pts[ii].cwiseQuotient(scale) + center;
+}
+
 }
@@ -40,15 +40,14 @@ void DynamicTexture::setup(int inTexSize,int inCellSize,TextureType inType,bool
     type = inType;
     clearTextures = inClearTextures;
     numCell = texSize/cellSize;
-    layoutGrid = new bool[numCell * numCell];
-    for (unsigned int ii=0;ii<numCell * numCell;ii++)
-        layoutGrid[ii] = false;
+    wordsPerRow = (numCell + 63) / 64;
+    layoutGrid.assign(numCell * wordsPerRow, 0);
+    rowUsedCells.assign(numCell, 0);
+    usedCells = 0;
 }
 
 DynamicTexture::~DynamicTexture()
 {
-    delete [] layoutGrid;
-    layoutGrid = nullptr;
 }
     
 void DynamicTexture::addTexture(Texture *tex,const Region &region)
@@ -62,16 +61,104 @@ void DynamicTexture::addTexture(Texture *tex,const Region &region)
     addTextureData(startX,startY,width,height,data);
 }
 
+// Bits sx through ex (inclusive) of the given word
+static inline uint64_t CellBits(int word,int sx,int ex)
+{
+    const int lo = std::max(sx - word*64, 0);
+    const int hi = std::min(ex - word*64, 63);
+    if (lo > hi)
+        return 0;
+    const uint64_t upTo = (hi == 63) ? ~(uint64_t)0 : (((uint64_t)1 << (hi+1)) - 1);
+    return upTo & ~(((uint64_t)1 << lo) - 1);
+}
+
+static inline int CountBits(uint64_t bits)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_popcountll(bits);
+#else
+    int count = 0;
+    for (;bits;bits &= bits-1)
+        count++;
+    return count;
+#endif
+}
+
+static inline int LowestBit(uint64_t bits)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctzll(bits);
+#else
+    int which = 0;
+    while (!(bits & 1))
+    {
+        bits >>= 1;
+        which++;
+    }
+    return which;
+#endif
+}
+
 void DynamicTexture::setRegion(const Region &region, bool enable)
 {
     const int sx = std::max(region.sx,0), sy = std::max(region.sy,0);
     const int ex = std::min(region.ex,numCell-1), ey = std::min(region.ey,numCell-1);
-    
-    for (unsigned int ix=sx;ix<=ex;ix++)
-        for (unsigned int iy=sy;iy<=ey;iy++)
+    if (sx > ex || sy > ey)
+        return;
+
+    const int startWord = sx / 64, endWord = ex / 64;
+    for (int iy=sy;iy<=ey;iy++)
+    {
+        uint64_t *row = &layoutGrid[iy*wordsPerRow];
+        for (int iw=startWord;iw<=endWord;iw++)
         {
-            layoutGrid[iy*numCell+ix] = enable;
+            const uint64_t bits = CellBits(iw,sx,ex);
+            // Only count the cells that actually change
+            const int changed = CountBits(enable ? (bits & ~row[iw]) : (bits & row[iw]));
+            if (enable)
+                row[iw] |= bits;
+            else
+                row[iw] &= ~bits;
+            rowUsedCells[iy] += enable ? changed : -changed;
+            usedCells += enable ? changed : -changed;
         }
+    }
+}
+
+bool DynamicTexture::findOpenRun(const uint64_t *rowUsed,int sizeX,int &startX) const
+{
+    // Hop from the start of each open run to the end of it, so we only
+    //  look at each run of open or used cells once
+    int ix = 0;
+    while (ix <= numCell-sizeX)
+    {
+        // Next open cell
+        int iw = ix / 64;
+        uint64_t open = ~rowUsed[iw] & ~(((uint64_t)1 << (ix % 64)) - 1);
+        while (!open && ++iw < wordsPerRow)
+            open = ~rowUsed[iw];
+        if (!open)
+            return false;
+        const int runStart = iw*64 + LowestBit(open);
+        if (runStart > numCell-sizeX)
+            return false;
+
+        // Next used cell after that, or the edge
+        iw = runStart / 64;
+        uint64_t used = rowUsed[iw] & ~(((uint64_t)1 << (runStart % 64)) - 1);
+        while (!used && ++iw < wordsPerRow)
+            used = rowUsed[iw];
+        const int runEnd = used ? std::min(iw*64 + LowestBit(used), numCell) : numCell;
+
+        if (runEnd - runStart >= sizeX)
+        {
+            startX = runStart;
+            return true;
+        }
+        ix = runEnd;
+    }
+
+    return false;
 }
     
 void DynamicTexture::clearRegion(const Region &clearRegion,ChangeSet &changes,bool mainThreadMerge,unsigned char *emptyData)
@@ -110,27 +197,36 @@ bool DynamicTexture::findRegion(int sizeX,int sizeY,Region &region)
         setRegion(ii, false);
     }
     
-    // Now look for a region that'll fit
-    // Look for a spot big enough
+    // Look for a spot big enough, top to bottom and then left to right.
+    // Combining the rows a region would cover gives us all the cells
+    //  in use across it, so we just need a wide enough gap in that.
     bool found = false;
     int foundX=0,foundY=0;
-    for (int iy=0;iy<=numCell-sizeY && !found;iy++)
-        for (int ix=0;ix<=numCell-sizeX && !found;ix++)
+    if (sizeX > 0 && sizeY > 0 && sizeX <= numCell)
+    {
+        std::vector<uint64_t> rowsUsed(wordsPerRow);
+        for (int iy=0;iy<=numCell-sizeY && !found;iy++)
         {
-            bool clear = true;
-            for (int testY=0;testY<sizeY && clear;testY++)
-                for (int testX=0;testX<sizeX && clear;testX++)
-                {
-                    if (layoutGrid[(testY+iy)*numCell+(testX+ix)])
-                        clear = false;
-                }
-            if (clear)
+            bool roomy = true;
+            for (int testY=0;testY<sizeY && roomy;testY++)
+                roomy = numCell - rowUsedCells[iy+testY] >= sizeX;
+            if (!roomy)
+                continue;
+
+            std::fill(rowsUsed.begin(),rowsUsed.end(),0);
+            for (int testY=0;testY<sizeY;testY++)
+            {
+                const uint64_t *row = &layoutGrid[(iy+testY)*wordsPerRow];
+                for (int iw=0;iw<wordsPerRow;iw++)
+                    rowsUsed[iw] |= row[iw];
+            }
+            if (findOpenRun(&rowsUsed[0],sizeX,foundX))
             {
-                foundX = ix;
                 foundY = iy;
                 found = true;
             }
         }
+    }
     
     if (!found)
         return false;
@@ -151,12 +247,7 @@ void DynamicTexture::addRegionToClear(const Region &region)
 void DynamicTexture::getUtilization(int &outNumCell,int &usedCell)
 {
     outNumCell = numCell*numCell;
-    usedCell = 0;
-    for (unsigned int ii=0;ii<numCell*numCell;ii++)
-    {
-        if (layoutGrid[ii])
-            usedCell++;
-    }
+    usedCell = usedCells;
 }
     
 void DynamicTextureClearRegion::execute(Scene *scene,SceneRenderer *renderer,View *view)
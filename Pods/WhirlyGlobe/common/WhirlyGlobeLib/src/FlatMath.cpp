@@ -43,6 +43,28 @@ Point3d PlateCarreeCoordSystem::geocentricToLocal(const Point3d &geocPt) const
     return GeoCoordSystem::GeocentricToLocal(geocPt);
 }
     
+void PlateCarreeCoordSystem::localToGeographicArray(const Point3d *pts,Point2d *outPts,size_t numPts) const
+{
+    for (size_t ii=0;ii<numPts;ii++)
+        outPts[ii] = Point2d(pts[ii].x(),pts[ii].y());
+}
+
+void PlateCarreeCoordSystem::geographicToLocalArray(const Point2d *pts,Point3d *outPts,size_t numPts) const
+{
+    for (size_t ii=0;ii<numPts;ii++)
+        outPts[ii] = Point3d(pts[ii].x(),pts[ii].y(),0.0);
+}
+
+void PlateCarreeCoordSystem::localToGeocentricArray(const Point3d *pts,Point3d *outPts,size_t numPts) const
+{
+    GeoCoordSystem::LocalToGeocentric(pts,outPts,numPts);
+}
+
+void PlateCarreeCoordSystem::geocentricToLocalArray(const Point3d *pts,Point3d *outPts,size_t numPts) const
+{
+    GeoCoordSystem::GeocentricToLocal(pts,outPts,numPts);
+}
+
 bool PlateCarreeCoordSystem::isSameAs(const CoordSystem *coordSys) const
 {
     const auto other = dynamic_cast<const PlateCarreeCoordSystem *>(coordSys);
@@ -48,6 +48,13 @@ AnimateViewMomentum::AnimateViewMomentum(const GlobeViewRef &globeView,double in
 }
 
 Quaterniond AnimateViewMomentum::rotForTime(GlobeView *,TimeInterval sinceStart)
+{
+    return RotForTime(startQuat, axis, velocity, acceleration, northUp, sinceStart);
+}
+
+Quaterniond AnimateViewMomentum::RotForTime(const Quaterniond &startQuat,const Vector3d &axis,
+                                            double velocity,double acceleration,bool northUp,
+                                            TimeInterval sinceStart)
 {
     // Calculate the offset based on angle
     const auto totalAng = (velocity + 0.5 * acceleration * sinceStart) * sinceStart;
@@ -84,6 +91,34 @@ Quaterniond AnimateViewMomentum::rotForTime(GlobeView *,TimeInterval sinceStart)
     return newQuat;
 }
 
+ViewPredictor AnimateViewMomentum::makePredictor(const Point2f &) const
+{
+    if (startDate == 0.0)
+    {
+        return ViewPredictor();
+    }
+
+    // Copy what we need, we may be gone (or changed) by the time this runs
+    const Quaterniond theStartQuat = startQuat;
+    const Vector3d theAxis = axis;
+    const double theVelocity = velocity, theAcceleration = acceleration;
+    const double theMaxTime = maxTime;
+    const TimeInterval theStartDate = startDate;
+    const bool theNorthUp = northUp;
+    return [=](View *view, TimeInterval when)
+    {
+        const auto globeView = dynamic_cast<GlobeView *>(view);
+        if (!globeView)
+        {
+            return false;
+        }
+
+        const double sinceStart = std::min(theMaxTime, std::max(0.0, when - theStartDate));
+        globeView->setRotQuat(RotForTime(theStartQuat, theAxis, theVelocity, theAcceleration, theNorthUp, sinceStart), false);
+        return true;
+    };
+}
+
 // Called by the view when it's time to update
 void AnimateViewMomentum::updateView(WhirlyKit::View *view)
 {
@@ -82,6 +82,43 @@ Point3d GeoCoordSystem::GeocentricToLocal(const Point3d &geocPt)
     return { x, y, z };
 }
 
+// proj.4 takes a stride between coordinates, so it can work on an array of Point3d in place
+static_assert(sizeof(Point3d) == 3 * sizeof(double), "Point3d arrays must be tightly packed");
+
+void GeoCoordSystem::LocalToGeocentric(const Point3d *pts,Point3d *outPts,size_t numPts)
+{
+    if (numPts == 0)
+        return;
+    InitProj4();
+
+    if (pts != outPts)
+        std::copy(pts, pts + numPts, outPts);
+    pj_transform(pj_latlon, pj_geocentric, (long)numPts, 3, &outPts[0].x(), &outPts[0].y(), &outPts[0].z());
+}
+
+void GeoCoordSystem::GeocentricToLocal(const Point3d *pts,Point3d *outPts,size_t numPts)
+{
+    if (numPts == 0)
+        return;
+    InitProj4();
+
+    if (pts != outPts)
+        std::copy(pts, pts + numPts, outPts);
+    pj_transform(pj_geocentric, pj_latlon, (long)numPts, 3, &outPts[0].x(), &outPts[0].y(), &outPts[0].z());
+}
+
+void GeoCoordSystem::localToGeographicArray(const Point3d *pts,Point2d *outPts,size_t numPts) const
+{
+    for (size_t ii=0;ii<numPts;ii++)
+        outPts[ii] = Point2d(pts[ii].x(),pts[ii].y());
+}
+
+void GeoCoordSystem::geographicToLocalArray(const Point2d *pts,Point3d *outPts,size_t numPts) const
+{
+    for (size_t ii=0;ii<numPts;ii++)
+        outPts[ii] = Point3d(pts[ii].x(),pts[ii].y(),0.0);
+}
+
 Mbr GeoCoordSystem::GeographicMbrToLocal(const GeoMbr &geoMbr)
 {
     Mbr localMbr;
@@ -153,6 +190,18 @@ Point3d FakeGeocentricDisplayAdapter::DisplayToLocal(const Point3d &pt)
     return { geoCoord.x(), geoCoord.y(), 0.0 };
 }
 
+void FakeGeocentricDisplayAdapter::localToDisplayArray(const Point3d *pts,Point3d *outPts,size_t numPts) const
+{
+    for (size_t ii=0;ii<numPts;ii++)
+        outPts[ii] = LocalToDisplay(pts[ii]);
+}
+
+void FakeGeocentricDisplayAdapter::displayToLocalArray(const Point3d *pts,Point3d *outPts,size_t numPts) const
+{
+    for (size_t ii=0;ii<numPts;ii++)
+        outPts[ii] = DisplayToLocal(pts[ii]);
+}
+
 Point3f GeocentricDisplayAdapter::LocalToDisplay(const Point3f &geoPt)
 {
     return GeoCoordSystem::LocalToGeocentric(geoPt) / EarthRadius;
@@ -21,6 +21,7 @@
 #import "GlobeView.h"
 #import "WhirlyGeometry.h"
 #import "GlobeMath.h"
+#import "SceneRenderer.h"
 #import "WhirlyKitLog.h"
 
 using namespace WhirlyKit;
@@ -436,8 +437,37 @@ ViewStateRef GlobeView::makeViewState(SceneRenderer *renderer)
     return std::make_shared<GlobeViewState>(this,renderer);
 }
 
+ViewStatePredictor GlobeView::makeViewStatePredictor(const Point2f &frameSize) const
+{
+    const auto theDelegate = delegate;
+    ViewPredictor predictor = theDelegate ? theDelegate->makePredictor(frameSize) : ViewPredictor();
+    if (!predictor)
+    {
+        return ViewStatePredictor();
+    }
+
+    // Work from a copy as we are now, without the animation or anyone watching.
+    // The copy doesn't want predictions, so the view states it makes won't have one.
+    const auto viewCopy = std::make_shared<GlobeView>(*this);
+    viewCopy->setDelegate(nullptr);
+    return [viewCopy,predictor,frameSize](TimeInterval when) -> ViewStateRef
+    {
+        GlobeView predictView(*viewCopy);
+        if (!predictor(&predictView, when))
+        {
+            return ViewStateRef();
+        }
+        return std::make_shared<GlobeViewState>(&predictView,frameSize);
+    };
+}
+
 GlobeViewState::GlobeViewState(WhirlyGlobe::GlobeView *globeView,WhirlyKit::SceneRenderer *renderer)
-: ViewState(globeView,renderer)
+: GlobeViewState(globeView,renderer->getFramebufferSize())
+{
+}
+
+GlobeViewState::GlobeViewState(WhirlyGlobe::GlobeView *globeView,const Point2f &frameSize)
+: ViewState(globeView,frameSize)
 {
     heightAboveGlobe = globeView->heightAboveSurface();
     rotQuat = globeView->getRotQuat();
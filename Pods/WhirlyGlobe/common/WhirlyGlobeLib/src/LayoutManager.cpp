@@ -147,6 +147,10 @@ LayoutManager::LayoutManager() :
     SceneManager(),
     minLayoutTime(0.0)
 {
+    layoutUpdateHandle = perfTimer.registerTiming("Layout Update");
+    layoutRulesHandle = perfTimer.registerTiming("Layout Rules");
+    layoutClusteringHandle = perfTimer.registerTiming("Layout Clustering");
+    layoutObjectsHandle = perfTimer.registerCount("Layout Objects");
 }
 
 LayoutManager::~LayoutManager()
@@ -625,6 +629,9 @@ bool LayoutManager::runLayoutRules(PlatformThreadInfo *threadInfo,
     if (localLayoutObjects.empty())
         return false;
 
+    ConcurrentPerformanceTimer::Scope timeScope(perfTimer, layoutRulesHandle);
+    perfTimer.addCount(layoutObjectsHandle, (int)localLayoutObjects.size());
+
     bool hadChanges = false;
 
     ClusteredObjectsSet clusterGroups;
@@ -1020,6 +1027,8 @@ void LayoutManager::runLayoutClustering(PlatformThreadInfo *threadInfo,
                                         const Matrix4d &modelTrans,
                                         const Matrix4d &normalMat)
 {
+    ConcurrentPerformanceTimer::Scope timeScope(perfTimer, layoutClusteringHandle);
+
     const float resScale = renderer->getScale();
 
     clusterGen->startLayoutObjects(threadInfo);
@@ -1813,6 +1822,8 @@ void LayoutManager::updateLayout(PlatformThreadInfo *threadInfo,const ViewStateR
         return;
     }
 
+    ConcurrentPerformanceTimer::Scope timeScope(perfTimer, layoutUpdateHandle);
+
     // Locking may have taken some time, check for cancellation again
     if (cancelLayout)
     {
@@ -18,6 +18,7 @@
 
 #import "LoadedTileNew.h"
 #import "BasicDrawableBuilder.h"
+#import "BasicDrawableInstanceBuilder.h"
 #import "WhirlyKitLog.h"
 
 using namespace Eigen;
@@ -84,25 +85,10 @@ void LoadedTileNew::makeDrawables(SceneRenderer *sceneRender,TileGeomManager *ge
     //          texScale.x(), texScale.y(), texOffset.x(), texOffset.y());
     //}
 
-    // Calculate a center for the tile
     const CoordSystemDisplayAdapter *sceneAdapter = geomManage->coordAdapter;
     const CoordSystem *sceneCoordSys = sceneAdapter->getCoordSystem();
     const CoordSystemRef &geomCoordSys = geomManage->coordSys;
 
-    const Point3d ll = sceneAdapter->localToDisplay(sceneCoordSys->geocentricToLocal(geomCoordSys->localToGeocentric(Pad(theMbr.ll()))));
-    const Point3d ur = sceneAdapter->localToDisplay(sceneCoordSys->geocentricToLocal(geomCoordSys->localToGeocentric(Pad(theMbr.ur()))));
-    // This clips the center to something 32 bit floating point can represent.
-    const Point3d dispCenter = ((ll + ur) / 2.0).cast<float>().cast<double>();
-
-    // Translation for the middle.  The drawable stores floats which isn't high res enough zoomed way in
-    const Point3d chunkMidDisp = (geomSettings.useTileCenters ? dispCenter : Point3d(0,0,0));
-//        wkLogLevel(Debug,"id = %d: (%d,%d),mid = (%f,%f,%f)",ident.level,ident.x,ident.y,chunkMidDisp.x(),chunkMidDisp.y(),chunkMidDisp.z());
-    const Eigen::Affine3d trans(Eigen::Translation3d(chunkMidDisp.x(),chunkMidDisp.y(),chunkMidDisp.z()));
-    const Matrix4d &transMat = trans.matrix();
-
-    // Size of each chunk
-    const Point2d chunkSize = theMbr.ur() - theMbr.ll();
-    
     int sphereTessX = geomSettings.sampleX,sphereTessY = geomSettings.sampleY;
     if (ident.level == 0)
     {
@@ -119,6 +105,39 @@ void LoadedTileNew::makeDrawables(SceneRenderer *sceneRender,TileGeomManager *ge
         sphereTessY = 1;
     }
     
+    // We need the corners in geographic for the cullable
+    const Point2d chunkLL = theMbr.ll();
+    const Point2d chunkUR = theMbr.ur();
+    const GeoCoord geoLL(geomCoordSys->localToGeographic(Pad(chunkLL)));
+    const GeoCoord geoUR(geomCoordSys->localToGeographic(Pad(chunkUR)));
+
+    // Flat tiles that line up with the display can share their geometry
+    if (geomSettings.useTemplateMeshes && !geomSettings.lineMode &&
+        texScale == Point2d(1,1) && texOffset == Point2d(0,0))
+    {
+        const Mbr geoMbr(Point2f(geoLL.x(),geoLL.y()),Point2f(geoUR.x(),geoUR.y()));
+        if (makeTemplateDrawables(sceneRender,geomManage,geomSettings,theMbr,
+                                  sphereTessX,sphereTessY,geoMbr,changes))
+        {
+            return;
+        }
+    }
+
+    // Calculate a center for the tile
+    const Point3d ll = sceneAdapter->localToDisplay(sceneCoordSys->geocentricToLocal(geomCoordSys->localToGeocentric(Pad(theMbr.ll()))));
+    const Point3d ur = sceneAdapter->localToDisplay(sceneCoordSys->geocentricToLocal(geomCoordSys->localToGeocentric(Pad(theMbr.ur()))));
+    // This clips the center to something 32 bit floating point can represent.
+    const Point3d dispCenter = ((ll + ur) / 2.0).cast<float>().cast<double>();
+
+    // Translation for the middle.  The drawable stores floats which isn't high res enough zoomed way in
+    const Point3d chunkMidDisp = (geomSettings.useTileCenters ? dispCenter : Point3d(0,0,0));
+//        wkLogLevel(Debug,"id = %d: (%d,%d),mid = (%f,%f,%f)",ident.level,ident.x,ident.y,chunkMidDisp.x(),chunkMidDisp.y(),chunkMidDisp.z());
+    const Eigen::Affine3d trans(Eigen::Translation3d(chunkMidDisp.x(),chunkMidDisp.y(),chunkMidDisp.z()));
+    const Matrix4d &transMat = trans.matrix();
+
+    // Size of each chunk
+    const Point2d chunkSize = theMbr.ur() - theMbr.ll();
+    
     // Unit size of each tessellation in spherical mercator
     const Point2d sphereTess = Point2d(1.0 / sphereTessX, 1.0 / sphereTessY);
     const Point2d incr = chunkSize.cwiseProduct(sphereTess);
@@ -126,12 +145,6 @@ void LoadedTileNew::makeDrawables(SceneRenderer *sceneRender,TileGeomManager *ge
     // Texture increment for each tessellation
     const Point2d texIncr = sphereTess.cwiseProduct(texScale);
 
-    // We need the corners in geographic for the cullable
-    const Point2d chunkLL = theMbr.ll();
-    const Point2d chunkUR = theMbr.ur();
-    const GeoCoord geoLL(geomCoordSys->localToGeographic(Pad(chunkLL)));
-    const GeoCoord geoUR(geomCoordSys->localToGeographic(Pad(chunkUR)));
-
     BasicDrawableBuilderRef chunk = sceneRender->makeBasicDrawableBuilder("LoadedTileNew chunk");
     chunk->reserve((sphereTessX+1)*(sphereTessY+1),2*sphereTessX*sphereTessY);
     // Note: Make this flexible
@@ -227,22 +240,24 @@ void LoadedTileNew::makeDrawables(SceneRenderer *sceneRender,TileGeomManager *ge
             for (unsigned int ix=0;ix<sphereTessX+1;ix++)
             {
                 constexpr auto locZ = 0.0;
-                auto &loc = locs[iy*(sphereTessX+1)+ix];
-
-                loc = Point3d(chunkLL.x() + ix * incr.x(),
-                              chunkLL.y() + iy * incr.y(),
-                              locZ);
-                if (!sameCS)
+                locs[iy*(sphereTessX+1)+ix] = Point3d(chunkLL.x() + ix * incr.x(),
+                                                      chunkLL.y() + iy * incr.y(),
+                                                      locZ);
+            }
+        }
+        if (!sameCS)
+        {
+            // Convert the whole grid at once
+            CoordSystemConvert3d(cs, sceneCoordSys, locs.data(), locs.data(), locs.size());
+            if (enableWrap)
+            {
+                for (const auto &loc : locs)
                 {
-                    loc = CoordSystemConvert3d(cs, sceneCoordSys, loc);
-                    if (enableWrap)
-                    {
-                        minLoc = minLoc.cwiseMin(loc);
-                        maxLoc = maxLoc.cwiseMax(loc);
-                        sgnLoc += Point3d(std::copysign(1.0, loc.x()),
-                                          std::copysign(1.0, loc.y()),
-                                          std::copysign(1.0, loc.z()));
-                    }
+                    minLoc = minLoc.cwiseMin(loc);
+                    maxLoc = maxLoc.cwiseMax(loc);
+                    sgnLoc += Point3d(std::copysign(1.0, loc.x()),
+                                      std::copysign(1.0, loc.y()),
+                                      std::copysign(1.0, loc.z()));
                 }
             }
         }
@@ -276,6 +291,9 @@ void LoadedTileNew::makeDrawables(SceneRenderer *sceneRender,TileGeomManager *ge
             }
         }
 
+        geomManage->coordAdapter->localToDisplayArray(locs.data(), locs.data(), locs.size());
+        const bool isFlat = geomManage->coordAdapter->isFlat();
+
         std::vector<TexCoord, Eigen::aligned_allocator<TexCoord>> texCoords((sphereTessX+1)*(sphereTessY+1));
         for (unsigned int iy=0;iy<sphereTessY+1;iy++)
         {
@@ -283,11 +301,9 @@ void LoadedTileNew::makeDrawables(SceneRenderer *sceneRender,TileGeomManager *ge
             {
                 constexpr auto locZ = 0.0;
 
-                auto &loc = locs[iy*(sphereTessX+1)+ix];
-                loc = geomManage->coordAdapter->localToDisplay(loc);
-                if (geomManage->coordAdapter->isFlat())
+                if (isFlat)
                 {
-                    loc.z() = locZ;
+                    locs[iy*(sphereTessX+1)+ix].z() = locZ;
                 }
                 
                 // Use Z priority to sort the levels
@@ -500,6 +516,69 @@ void LoadedTileNew::makeDrawables(SceneRenderer *sceneRender,TileGeomManager *ge
     }
 }
     
+Eigen::Matrix4d LoadedTileNew::DrawableInfo::templateMatrix() const
+{
+    Eigen::Matrix4d mat = Eigen::Matrix4d::Identity();
+    mat.diagonal().head<3>() = templateScale;
+    mat.block<3,1>(0,3) = templateOrigin;
+    return mat;
+}
+
+bool LoadedTileNew::makeTemplateDrawables(SceneRenderer *sceneRender,TileGeomManager *geomManage,
+                                          const TileGeomSettings &geomSettings,const MbrD &theMbr,
+                                          int tessX,int tessY,const Mbr &geoMbr,ChangeSet &changes)
+{
+    // The tile has to map onto the display with just a scale and offset
+    const CoordSystemDisplayAdapter *sceneAdapter = geomManage->coordAdapter;
+    if (!sceneAdapter->isFlat() || !geomManage->coordSys->isSameAs(sceneAdapter->getCoordSystem()))
+    {
+        return false;
+    }
+
+    // The corners are rounded to what the renderer can represent first.  The size
+    //  between them is then exact, so neighboring tiles meet on exactly the same edge.
+    const Point3d ll = sceneAdapter->localToDisplay(Pad(theMbr.ll())).cast<float>().cast<double>();
+    const Point3d ur = sceneAdapter->localToDisplay(Pad(theMbr.ur())).cast<float>().cast<double>();
+    const Point3d size = ur - ll;
+    if (size.x() <= 0.0 || size.y() <= 0.0)
+    {
+        // Flipped would turn the triangles around
+        return false;
+    }
+
+    const SimpleIdentity templateID = geomManage->getTemplateMesh(tessX,tessY,changes);
+    if (templateID == EmptyIdentity)
+    {
+        return false;
+    }
+
+    drawPriority = geomSettings.baseDrawPriority + ident.level * geomSettings.drawPriorityPerLevel;
+    const auto drawOrder = BaseInfo::DrawOrderTiles;
+
+    DrawableInfo info(DrawableGeom,EmptyIdentity,drawPriority,drawOrder);
+    info.templateID = templateID;
+    info.templateOrigin = Point3d(ll.x(),ll.y(),0.0);
+    info.templateScale = Point3d(size.x(),size.y(),1.0);
+    info.localMbr = geoMbr;
+
+    // Our own copy is just a reference to the template
+    const auto inst = sceneRender->makeBasicDrawableInstanceBuilder("LoadedTileNew template chunk");
+    inst->setMasterID(templateID,BasicDrawableInstance::ReuseStyle);
+    inst->setMatrix(info.templateMatrix());
+    inst->setLocalMbr(geoMbr);
+    inst->setDrawOrder(drawOrder);
+    inst->setDrawPriority(drawPriority);
+    inst->setVisibleRange(geomSettings.minVis, geomSettings.maxVis);
+    inst->setProgram(geomSettings.programID);
+    inst->setOnOff(false);
+    info.drawID = inst->getDrawableID();
+    drawInfo.push_back(info);
+
+    changes.push_back(new AddDrawableReq(inst->getDrawable()));
+
+    return true;
+}
+
 void LoadedTileNew::buildSkirt(const BasicDrawableBuilderRef &draw,const Point3dVector &pts,
                                const std::vector<TexCoord> &texCoords,double skirtFactor,
                                bool haveElev,const Point3d &theCenter)
@@ -586,8 +665,8 @@ void TileGeomManager::setup(SceneRenderer *inSceneRender,TileGeomSettings &geomS
 }
     
 TileGeomManager::NodeChanges TileGeomManager::addRemoveTiles(
-        const QuadTreeNew::ImportantNodeSet &addTiles,
-        const QuadTreeNew::NodeSet &removeTiles,ChangeSet &changes)
+        const QuadTreeNew::CoverageSet &addTiles,
+        const QuadTreeNew::CoverageSet &removeTiles,ChangeSet &changes)
 {
     NodeChanges nodeChanges;
 
@@ -600,7 +679,7 @@ TileGeomManager::NodeChanges TileGeomManager::addRemoveTiles(
         }
     }
 
-    for (const auto &ident: addTiles) {
+    for (const auto &ident: addTiles.byImportance()) {
         // Look for an existing tile
         const auto it = tileMap.find(ident);
         if (it == tileMap.end()) {
@@ -629,6 +708,71 @@ void TileGeomManager::cleanup(ChangeSet &changes)
     }
     
     tileMap.clear();
+
+    for (const auto &templateMesh : templateMeshes)
+    {
+        changes.push_back(new RemDrawableReq(templateMesh.second));
+    }
+    templateMeshes.clear();
+}
+
+SimpleIdentity TileGeomManager::getTemplateMesh(int tessX,int tessY,ChangeSet &changes)
+{
+    const auto key = std::make_pair(tessX,tessY);
+    const auto it = templateMeshes.find(key);
+    if (it != templateMeshes.end())
+    {
+        return it->second;
+    }
+    if (!sceneRender || tessX < 1 || tessY < 1)
+    {
+        return EmptyIdentity;
+    }
+
+    // A grid over the unit square that tiles scale and move into place.
+    // This is never drawn directly, only instanced.
+    BasicDrawableBuilderRef mesh = sceneRender->makeBasicDrawableBuilder("LoadedTileNew template");
+    mesh->reserve((tessX+1)*(tessY+1),2*tessX*tessY);
+    mesh->setupTexCoordEntry(0, 0);
+    mesh->setType(Triangles);
+    mesh->setDrawOrder(BaseInfo::DrawOrderTiles);
+    mesh->setProgram(settings.programID);
+    mesh->setOnOff(false);
+
+    const Point3d norm = coordAdapter->normalForLocal(Point3d(0,0,0));
+    for (int iy=0;iy<tessY+1;iy++)
+    {
+        for (int ix=0;ix<tessX+1;ix++)
+        {
+            const double u = (double)ix / tessX, v = (double)iy / tessY;
+            mesh->addPoint(Point3d(u,v,0.0));
+            mesh->addNormal(norm);
+            mesh->addTexCoord(-1,TexCoord(u,1.0-v));
+        }
+    }
+
+    // Two triangles per cell, as with the regular tiles
+    for (int iy=0;iy<tessY;iy++)
+    {
+        for (int ix=0;ix<tessX;ix++)
+        {
+            BasicDrawable::Triangle triA,triB;
+            triA.verts[0] = (iy+1)*(tessX+1)+ix;
+            triA.verts[1] = iy*(tessX+1)+ix;
+            triA.verts[2] = (iy+1)*(tessX+1)+(ix+1);
+            triB.verts[0] = triA.verts[2];
+            triB.verts[1] = triA.verts[1];
+            triB.verts[2] = iy*(tessX+1)+(ix+1);
+            mesh->addTriangle(triA);
+            mesh->addTriangle(triB);
+        }
+    }
+
+    const SimpleIdentity meshID = mesh->getDrawableID();
+    changes.push_back(new AddDrawableReq(mesh->getDrawable()));
+    templateMeshes[key] = meshID;
+
+    return meshID;
 }
     
 std::vector<LoadedTileNewRef> TileGeomManager::getTiles(const QuadTreeNew::NodeSet &tiles)
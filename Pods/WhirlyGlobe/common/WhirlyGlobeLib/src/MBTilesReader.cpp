@@ -0,0 +1,549 @@
+/*  MBTilesReader.cpp
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#import <thread>
+#import <map>
+#import <sqlite3.h>
+#import "MBTilesReader.h"
+#import "PerformanceTimer.h"
+#import "WhirlyKitLog.h"
+
+namespace WhirlyKit
+{
+
+// Beyond this ratio of range area to requested tiles, individual lookups are cheaper than a range scan
+static constexpr int MaxRangeSparseness = 4;
+
+// Buffer pool limits for mapped mode
+static constexpr int PooledBuffersPerConnection = 16;
+static constexpr unsigned long MaxPooledBufferSize = 1024 * 1024;
+
+// Run a query expected to return a single text value
+static bool QueryString(sqlite3 *db,const char *sql,std::string &ret)
+{
+    sqlite3_stmt *stmt = nullptr;
+    if (sqlite3_prepare_v2(db,sql,-1,&stmt,nullptr) != SQLITE_OK)
+        return false;
+
+    bool found = false;
+    if (sqlite3_step(stmt) == SQLITE_ROW)
+    {
+        if (const auto str = (const char *)sqlite3_column_text(stmt,0))
+        {
+            ret = str;
+            found = true;
+        }
+    }
+    sqlite3_finalize(stmt);
+
+    return found;
+}
+
+// Run a query expected to return a single integer value
+static bool QueryInt(sqlite3 *db,const char *sql,int &ret)
+{
+    sqlite3_stmt *stmt = nullptr;
+    if (sqlite3_prepare_v2(db,sql,-1,&stmt,nullptr) != SQLITE_OK)
+        return false;
+
+    bool found = false;
+    if (sqlite3_step(stmt) == SQLITE_ROW && sqlite3_column_type(stmt,0) != SQLITE_NULL)
+    {
+        ret = sqlite3_column_int(stmt,0);
+        found = true;
+    }
+    sqlite3_finalize(stmt);
+
+    return found;
+}
+
+// Parse "ll_lon,ll_lat,ur_lon,ur_lat", allowing commas and/or spaces between them
+static bool ParseBounds(const std::string &str,double vals[4])
+{
+    const char *pos = str.c_str();
+    for (int ii=0;ii<4;ii++)
+    {
+        while (*pos == ',' || *pos == ' ')
+            pos++;
+        char *end = nullptr;
+        vals[ii] = strtod(pos,&end);
+        if (end == pos)
+            return false;
+        pos = end;
+    }
+    return true;
+}
+
+MBTilesReader::MBTilesReader(const std::string &inFileName,int numConnections,int cacheSize,int64_t inMmapSize) :
+    mmapSize(inMmapSize),
+    fileName(inFileName)
+{
+    if (fileName.empty())
+        return;
+
+    if (numConnections <= 0)
+    {
+        numConnections = std::max(1U,std::min(8U,std::thread::hardware_concurrency()));
+    }
+
+    if (mmapSize > 0)
+    {
+        // Enough to cover a batch in flight on each connection, skip anything unusually large
+        bufferPool = std::make_shared<RawDataPool>(numConnections * PooledBuffersPerConnection,MaxPooledBufferSize);
+    }
+
+    for (int ii=0;ii<numConnections;ii++)
+    {
+        const auto conn = std::make_shared<Connection>();
+        // Disable writes, eliminating the need for locking.
+        // Each connection is only ever used by one thread at a time.
+        const int flags = SQLITE_OPEN_READONLY | SQLITE_OPEN_NOMUTEX;
+        const int openRes = sqlite3_open_v2(fileName.c_str(), &conn->db, flags, nullptr);
+        if (openRes != SQLITE_OK)
+        {
+            const char* const err = sqlite3_errstr(openRes);
+            wkLogLevel(Error, "SQLite failed to open '%s' - %d: %s", fileName.c_str(), openRes, err ? err : "?");
+            closeConnection(*conn);
+            close();
+            return;
+        }
+
+        // The metadata only needs to be read once
+        if (ii == 0 && !readMetadata(conn->db))
+        {
+            closeConnection(*conn);
+            close();
+            return;
+        }
+
+        if (!setupConnection(*conn,cacheSize,ii == 0))
+        {
+            closeConnection(*conn);
+            close();
+            return;
+        }
+
+        conns.push_back(conn);
+        freeConns.push_back(conn);
+    }
+
+    valid = true;
+}
+
+MBTilesReader::~MBTilesReader()
+{
+    try
+    {
+        close();
+    }
+    WK_STD_DTOR_CATCH()
+}
+
+bool MBTilesReader::readMetadata(sqlite3 *db)
+{
+    std::string bounds;
+    if (QueryString(db,"select value from metadata where name='bounds';",bounds))
+    {
+        double vals[4];
+        if (!ParseBounds(bounds,vals))
+        {
+            wkLogLevel(Error, "Failed to parse MBTiles bounds '%s'", bounds.c_str());
+            return false;
+        }
+        geoMbr.ll() = GeoCoord::CoordFromDegrees(vals[0],vals[1]);
+        geoMbr.ur() = GeoCoord::CoordFromDegrees(vals[2],vals[3]);
+    } else {
+        // No bounds implies it covers the whole earth
+        geoMbr.ll() = GeoCoord::CoordFromDegrees(-180, -85.0511);
+        geoMbr.ur() = GeoCoord::CoordFromDegrees(180, 85.0511);
+    }
+
+    minZoom = 0;  maxZoom = 8;
+    std::string zoomStr;
+    if (QueryString(db,"select value from metadata where name='minzoom';",zoomStr))
+        minZoom = atoi(zoomStr.c_str());
+    else
+        // Read it the hard way
+        QueryInt(db,"select min(zoom_level) from tiles;",minZoom);
+    if (QueryString(db,"select value from metadata where name='maxzoom';",zoomStr))
+        maxZoom = atoi(zoomStr.c_str());
+    else
+        // Read it the hard way
+        QueryInt(db,"select max(zoom_level) from tiles;",maxZoom);
+
+    QueryString(db,"select value from metadata where name='format';",format);
+
+    // See if there's a tiles table or it's the older(?) style
+    std::string tableName;
+    tilesStyle = QueryString(db,"SELECT name FROM sqlite_master WHERE type='table' AND name='tiles';",tableName);
+
+    return true;
+}
+
+bool MBTilesReader::setupConnection(Connection &conn,int cacheSize,bool logCache)
+{
+    if (cacheSize >= 0)
+    {
+        int pageSize = 0;
+        if (QueryInt(conn.db,"PRAGMA page_size",pageSize) && pageSize > 0)
+        {
+            const int cachePages = (cacheSize + pageSize - 1) / pageSize;
+            const auto sql = "PRAGMA cache_size=" + std::to_string(cachePages);
+            char *errMsg = nullptr;
+            if (sqlite3_exec(conn.db,sql.c_str(),nullptr,nullptr,&errMsg) != SQLITE_OK)
+            {
+                wkLogLevel(Warn, "Failed to set SQLite cache (%d): %s", sqlite3_errcode(conn.db), errMsg ? errMsg : "?");
+            }
+            else if (logCache)
+            {
+                int actualCachePages = 0;
+                if (QueryInt(conn.db,"PRAGMA cache_size",actualCachePages))
+                {
+                    wkLogLevel(Info, "SQLite cache size set to %d pages = %d bytes",
+                               actualCachePages, actualCachePages * pageSize);
+                }
+            }
+            sqlite3_free(errMsg);
+        }
+    }
+
+    if (mmapSize > 0)
+    {
+        const auto sql = "PRAGMA mmap_size=" + std::to_string(mmapSize);
+        char *errMsg = nullptr;
+        if (sqlite3_exec(conn.db,sql.c_str(),nullptr,nullptr,&errMsg) != SQLITE_OK)
+        {
+            wkLogLevel(Warn, "Failed to set SQLite mmap size (%d): %s", sqlite3_errcode(conn.db), errMsg ? errMsg : "?");
+        }
+        sqlite3_free(errMsg);
+    }
+
+    // In mapped mode we look up the row and read the blob straight into a pooled buffer.
+    // Otherwise SQLite assembles any overflow pages into its own allocation and we copy that.
+    const std::string dataCol = bufferPool ? "rowid" : "tile_data";
+
+    // Prepare the lookups once, we'll just rebind them for each tile
+    int res;
+    if (tilesStyle)
+    {
+        const auto tileSql = "SELECT " + dataCol + " from tiles where zoom_level=? AND tile_column=? AND tile_row=?;";
+        res = sqlite3_prepare_v2(conn.db,tileSql.c_str(),-1,&conn.tileStmt,nullptr);
+        if (res == SQLITE_OK)
+        {
+            // Ordered to match the (zoom_level,tile_column,tile_row) index
+            const auto rangeSql = "SELECT tile_column,tile_row," + dataCol + " from tiles where zoom_level=? AND "
+                                  "tile_column BETWEEN ? AND ? AND tile_row BETWEEN ? AND ? ORDER BY tile_column,tile_row;";
+            res = sqlite3_prepare_v2(conn.db,rangeSql.c_str(),-1,&conn.rangeStmt,nullptr);
+        }
+    } else {
+        res = sqlite3_prepare_v2(conn.db,"SELECT tile_id from map where zoom_level=? AND tile_column=? AND tile_row=?;",-1,&conn.mapStmt,nullptr);
+        if (res == SQLITE_OK)
+        {
+            const auto imageSql = "SELECT " + dataCol + " from images where tile_id=?;";
+            res = sqlite3_prepare_v2(conn.db,imageSql.c_str(),-1,&conn.imageStmt,nullptr);
+        }
+        if (res == SQLITE_OK)
+        {
+            const auto rangeSql = "SELECT map.tile_column,map.tile_row,images." + dataCol + " from map "
+                                  "JOIN images ON images.tile_id=map.tile_id where map.zoom_level=? AND "
+                                  "map.tile_column BETWEEN ? AND ? AND map.tile_row BETWEEN ? AND ? "
+                                  "ORDER BY map.tile_column,map.tile_row;";
+            res = sqlite3_prepare_v2(conn.db,rangeSql.c_str(),-1,&conn.rangeStmt,nullptr);
+        }
+    }
+    if (res != SQLITE_OK)
+    {
+        wkLogLevel(Error, "Failed to prepare MBTiles queries (%d): %s", res, sqlite3_errmsg(conn.db));
+        return false;
+    }
+
+    return true;
+}
+
+void MBTilesReader::closeConnection(Connection &conn)
+{
+    sqlite3_finalize(conn.tileStmt);
+    sqlite3_finalize(conn.mapStmt);
+    sqlite3_finalize(conn.imageStmt);
+    sqlite3_finalize(conn.rangeStmt);
+    conn.tileStmt = conn.mapStmt = conn.imageStmt = conn.rangeStmt = nullptr;
+    if (conn.blob)
+    {
+        sqlite3_blob_close(conn.blob);
+        conn.blob = nullptr;
+    }
+    if (conn.db)
+    {
+        sqlite3_close(conn.db);
+        conn.db = nullptr;
+    }
+}
+
+void MBTilesReader::close()
+{
+    std::unique_lock<std::mutex> lockGuard(lock);
+    valid = false;
+
+    // Wait for the outstanding lookups to hand their connections back
+    connCond.wait(lockGuard, [this]{ return freeConns.size() == conns.size(); });
+
+    for (const auto &conn : conns)
+    {
+        closeConnection(*conn);
+    }
+    conns.clear();
+    freeConns.clear();
+}
+
+MBTilesReader::ConnectionRef MBTilesReader::acquireConnection()
+{
+    std::unique_lock<std::mutex> lockGuard(lock);
+    connCond.wait(lockGuard, [this]{ return !valid || !freeConns.empty(); });
+    if (!valid)
+        return nullptr;
+
+    auto conn = freeConns.back();
+    freeConns.pop_back();
+    return conn;
+}
+
+void MBTilesReader::releaseConnection(ConnectionRef conn)
+{
+    // An open blob handle keeps a read transaction going, don't hold it between requests
+    if (conn->blob)
+    {
+        sqlite3_blob_close(conn->blob);
+        conn->blob = nullptr;
+    }
+
+    {
+        std::lock_guard<std::mutex> lockGuard(lock);
+        freeConns.push_back(std::move(conn));
+    }
+    connCond.notify_all();
+}
+
+RawDataRef MBTilesReader::fetchTile(const QuadTreeIdentifier &ident)
+{
+    TileLoadTracer::Span traceSpan(TileLoadStageFetch, ident);
+
+    auto conn = acquireConnection();
+    if (!conn)
+        return nullptr;
+
+    RawDataRef data;
+    try
+    {
+        data = fetchTile(*conn,ident);
+    }
+    catch (...)
+    {
+        releaseConnection(std::move(conn));
+        throw;
+    }
+    releaseConnection(std::move(conn));
+
+    return data;
+}
+
+RawDataRef MBTilesReader::fetchTile(Connection &conn,const QuadTreeIdentifier &ident)
+{
+    RawDataRef data;
+
+    sqlite3_stmt *stmt = tilesStyle ? conn.tileStmt : conn.mapStmt;
+    sqlite3_bind_int(stmt,1,ident.level);
+    sqlite3_bind_int(stmt,2,ident.x);
+    sqlite3_bind_int(stmt,3,ident.y);
+
+    int res = sqlite3_step(stmt);
+    if (res == SQLITE_ROW && !tilesStyle)
+    {
+        // Look up the image by its ID in the second table
+        sqlite3_bind_value(conn.imageStmt,1,sqlite3_column_value(stmt,0));
+        sqlite3_reset(stmt);
+        stmt = conn.imageStmt;
+        res = sqlite3_step(stmt);
+    }
+
+    if (res == SQLITE_ROW)
+    {
+        data = readTileData(conn,stmt,0);
+    }
+    else if (res != SQLITE_DONE)
+    {
+        wkLogLevel(Warn, "MBTiles lookup failed for %d: (%d,%d) - %d: %s",
+                   ident.level, ident.x, ident.y, res, sqlite3_errmsg(conn.db));
+    }
+
+    sqlite3_reset(stmt);
+    sqlite3_clear_bindings(stmt);
+
+    return data;
+}
+
+RawDataRef MBTilesReader::readTileData(Connection &conn,sqlite3_stmt *stmt,int col)
+{
+    if (!bufferPool)
+    {
+        const void *blob = sqlite3_column_blob(stmt,col);
+        const int blobSize = sqlite3_column_bytes(stmt,col);
+        return std::make_shared<ImmutableRawData>(blob,blobSize);
+    }
+
+    // Point the connection's blob handle at the row, reusing it if we can
+    const sqlite3_int64 rowId = sqlite3_column_int64(stmt,col);
+    int res = conn.blob ? sqlite3_blob_reopen(conn.blob,rowId) : SQLITE_ERROR;
+    if (res != SQLITE_OK)
+    {
+        if (conn.blob)
+        {
+            sqlite3_blob_close(conn.blob);
+            conn.blob = nullptr;
+        }
+        res = sqlite3_blob_open(conn.db,"main",tilesStyle ? "tiles" : "images","tile_data",rowId,0,&conn.blob);
+    }
+    if (res != SQLITE_OK)
+    {
+        wkLogLevel(Warn, "MBTiles failed to open blob for row %lld - %d: %s",
+                   (long long)rowId, res, sqlite3_errmsg(conn.db));
+        return nullptr;
+    }
+
+    const int blobSize = sqlite3_blob_bytes(conn.blob);
+    auto data = bufferPool->getBuffer(blobSize);
+    if (blobSize > 0)
+    {
+        res = sqlite3_blob_read(conn.blob,data->getMutableData(),blobSize,0);
+        if (res != SQLITE_OK)
+        {
+            wkLogLevel(Warn, "MBTiles failed to read blob for row %lld - %d: %s",
+                       (long long)rowId, res, sqlite3_errmsg(conn.db));
+            return nullptr;
+        }
+    }
+
+    return data;
+}
+
+RawDataRefVec MBTilesReader::fetchTiles(const std::vector<QuadTreeIdentifier> &idents)
+{
+    RawDataRefVec ret(idents.size());
+    if (idents.empty())
+        return ret;
+
+    TileLoadTracer::Span traceSpan(TileLoadStageFetch);
+
+    // Sort out the tiles by level, remembering where each one goes in the result
+    std::map<int,std::vector<std::pair<QuadTreeIdentifier,int>>> identsByLevel;
+    for (int ii=0;ii<idents.size();ii++)
+    {
+        identsByLevel[idents[ii].level].emplace_back(idents[ii],ii);
+    }
+
+    auto conn = acquireConnection();
+    if (!conn)
+        return ret;
+
+    try
+    {
+        for (const auto &kvp : identsByLevel)
+        {
+            fetchTileRange(*conn,kvp.first,kvp.second,ret);
+        }
+    }
+    catch (...)
+    {
+        releaseConnection(std::move(conn));
+        throw;
+    }
+    releaseConnection(std::move(conn));
+
+    return ret;
+}
+
+void MBTilesReader::fetchTileRange(Connection &conn,int level,
+                                   const std::vector<std::pair<QuadTreeIdentifier,int>> &idents,
+                                   RawDataRefVec &ret)
+{
+    int minX = idents[0].first.x, maxX = minX;
+    int minY = idents[0].first.y, maxY = minY;
+    for (const auto &ident : idents)
+    {
+        minX = std::min(minX,ident.first.x);  maxX = std::max(maxX,ident.first.x);
+        minY = std::min(minY,ident.first.y);  maxY = std::max(maxY,ident.first.y);
+    }
+    const int64_t sizeX = maxX - minX + 1;
+    const int64_t sizeY = maxY - minY + 1;
+
+    // Scattered tiles would have us reading a lot of rows we don't want
+    if (idents.size() == 1 || sizeX * sizeY > MaxRangeSparseness * (int64_t)idents.size())
+    {
+        for (const auto &ident : idents)
+        {
+            ret[ident.second] = fetchTile(conn,ident.first);
+        }
+        return;
+    }
+
+    // Map from cell in the range to the (first) result slot that wants it
+    std::vector<int> slots(sizeX * sizeY,-1);
+    std::vector<std::pair<int,int>> dups;
+    for (const auto &ident : idents)
+    {
+        int &slot = slots[(ident.first.y - minY) * sizeX + (ident.first.x - minX)];
+        if (slot < 0)
+            slot = ident.second;
+        else
+            dups.emplace_back(ident.second,slot);
+    }
+
+    sqlite3_stmt *stmt = conn.rangeStmt;
+    sqlite3_bind_int(stmt,1,level);
+    sqlite3_bind_int(stmt,2,minX);
+    sqlite3_bind_int(stmt,3,maxX);
+    sqlite3_bind_int(stmt,4,minY);
+    sqlite3_bind_int(stmt,5,maxY);
+
+    int res;
+    while ((res = sqlite3_step(stmt)) == SQLITE_ROW)
+    {
+        const int x = sqlite3_column_int(stmt,0);
+        const int y = sqlite3_column_int(stmt,1);
+        if (x < minX || x > maxX || y < minY || y > maxY)
+            continue;
+        const int slot = slots[(y - minY) * sizeX + (x - minX)];
+        if (slot < 0)
+            continue;
+
+        ret[slot] = readTileData(conn,stmt,2);
+    }
+    if (res != SQLITE_DONE)
+    {
+        wkLogLevel(Warn, "MBTiles range lookup failed for level %d: (%d,%d)-(%d,%d) - %d: %s",
+                   level, minX, minY, maxX, maxY, res, sqlite3_errmsg(conn.db));
+    }
+
+    sqlite3_reset(stmt);
+    sqlite3_clear_bindings(stmt);
+
+    for (const auto &dup : dups)
+    {
+        ret[dup.first] = ret[dup.second];
+    }
+}
+
+}
@@ -20,11 +20,124 @@
 
 #import "MapboxVectorFilter.h"
 #import "MapboxVectorStyleSetC.h"
+#import "VectorTileAttributes.h"
 #import "WhirlyKitLog.h"
 
 namespace WhirlyKit
 {
 
+int MapboxVectorFilterKeys::intern(const std::string &name)
+{
+    const auto it = ids.find(name);
+    if (it != ids.end())
+    {
+        return it->second;
+    }
+
+    const int keyID = (int)names.size();
+    ids.emplace(name, keyID);
+    names.push_back(name);
+    layerFields.push_back(VectorTileAttributes::isLayerField(name));
+    return keyID;
+}
+
+int MapboxVectorFilterKeys::find(std::string_view name) const
+{
+    const auto it = ids.find(name);
+    return (it == ids.end()) ? -1 : it->second;
+}
+
+MapboxVectorFilterInput::MapboxVectorFilterInput(const Dictionary &attrs,const MapboxVectorFilterKeys &keys)
+    : attrs(attrs), keys(keys), tileAttrs(dynamic_cast<const VectorTileAttributes*>(&attrs))
+{
+    // We can only go through the layer tables if they've been set up with our key IDs
+    if (tileAttrs && (tileAttrs->isModified() || tileAttrs->getLayer()->keyIDOwner != &keys))
+    {
+        tileAttrs = nullptr;
+    }
+}
+
+MapboxVectorFilterInput::Value::Value(const VectorTileValue &val)
+    : tileVal(val)
+{
+    // Convert the same way the dictionary entries would
+    switch (val.dictType())
+    {
+        case DictTypeString:
+            kind = String;
+            str = val.stringValue;
+            break;
+        case DictTypeInt:
+            kind = Number;
+            num = (int)val.getInt64();
+            break;
+        case DictTypeDouble:
+            kind = Number;
+            num = val.getDouble();
+            break;
+        default:
+            break;
+    }
+}
+
+MapboxVectorFilterInput::Value MapboxVectorFilterInput::getValue(int keyID) const
+{
+    if (tileAttrs)
+    {
+        if (const VectorTileValue *tileVal = tileAttrs->findValue(keyID))
+        {
+            return Value(*tileVal);
+        }
+        VectorTileValue layerVal;
+        if (keys.isLayerField(keyID) && tileAttrs->findValue(keys.getName(keyID), layerVal))
+        {
+            return Value(layerVal);
+        }
+        return Value();
+    }
+
+    Value val;
+    if ((val.entry = attrs.getEntry(keys.getName(keyID))))
+    {
+        switch (val.entry->getType())
+        {
+            case DictTypeString:
+                strValue = val.entry->getString();
+                val.kind = Value::String;
+                val.str = strValue;
+                break;
+            case DictTypeInt:
+            case DictTypeDouble:
+                val.kind = Value::Number;
+                val.num = val.entry->getDouble();
+                break;
+            default:
+                val.kind = Value::Other;
+                break;
+        }
+    }
+    return val;
+}
+
+bool MapboxVectorFilterInput::hasValue(int keyID) const
+{
+    if (tileAttrs)
+    {
+        return tileAttrs->findValue(keyID) || (keys.isLayerField(keyID) && attrs.hasField(keys.getName(keyID)));
+    }
+    return attrs.hasField(keys.getName(keyID));
+}
+
+const VectorTileLayerTable *MapboxVectorFilterInput::getTileLayer() const
+{
+    return tileAttrs ? tileAttrs->getLayer() : nullptr;
+}
+
+const VectorTileValue *MapboxVectorFilterInput::findTileValue(int keyID) const
+{
+    return tileAttrs ? tileAttrs->findValue(keyID) : nullptr;
+}
+
 MapboxVectorFilter::MapboxVectorFilter()
 {
 }
@@ -33,6 +146,24 @@ static const char * const filterTypes[] = {"==","!=",">",">=","<","<=","in","!in
 static const char * const geomTypes[] = {"Point","LineString","Polygon"};
 
 bool MapboxVectorFilter::parse(const std::vector<DictionaryEntryRef> &filterArray,MapboxVectorStyleSetImpl *styleSet)
+{
+    program.clear();
+    constants.clear();
+    keys = nullptr;
+
+    if (!parseFilter(filterArray, styleSet))
+    {
+        return false;
+    }
+
+    // Flatten the whole thing out so we're not chasing sub-filters and looking up names for every feature
+    compile(styleSet->filterKeys, program, constants);
+    keys = &styleSet->filterKeys;
+
+    return true;
+}
+
+bool MapboxVectorFilter::parseFilter(const std::vector<DictionaryEntryRef> &filterArray,MapboxVectorStyleSetImpl *styleSet)
 {
     if (filterArray.empty()) {
         wkLogLevel(Warn, "Expecting array for filter");
@@ -102,7 +233,7 @@ bool MapboxVectorFilter::parse(const std::vector<DictionaryEntryRef> &filterArra
         for (unsigned int ii=1;ii<filterArray.size();ii++)
         {
             const auto subFilter = std::make_shared<MapboxVectorFilter>();
-            if (!subFilter->parse(filterArray[ii]->getArray(), styleSet))
+            if (!subFilter->parseFilter(filterArray[ii]->getArray(), styleSet))
                 return false;
             subFilters.push_back(subFilter);
         }
@@ -115,7 +246,303 @@ namespace {
     const static std::string geometryType("geometry_type");
 }
 
+void MapboxVectorFilter::compile(MapboxVectorFilterKeys &filterKeys,std::vector<Instruction> &prog,std::vector<Constant> &consts) const
+{
+    const auto addConstant = [&consts](const DictionaryEntryRef &entry)
+    {
+        Constant c;
+        c.entry = entry;
+        switch (entry->getType())
+        {
+            case DictTypeString:
+                c.kind = MapboxVectorFilterInput::Value::String;
+                c.str = entry->getString();
+                break;
+            case DictTypeInt:
+                c.isInt = true;
+                // fall through
+            case DictTypeDouble:
+                c.kind = MapboxVectorFilterInput::Value::Number;
+                c.num = entry->getDouble();
+                break;
+            default:
+                c.kind = MapboxVectorFilterInput::Value::Other;
+                break;
+        }
+        consts.push_back(std::move(c));
+    };
+
+    const auto index = prog.size();
+    prog.push_back(Instruction { filterType, MBGeomNone, -1, (uint32_t)consts.size(), 0, 0, -1 });
+    auto &instr = prog.back();
+
+    switch (filterType)
+    {
+        case MBFilterNone:
+            break;
+        case MBFilterAll:
+        case MBFilterAny:
+            for (const auto &subFilter : subFilters)
+            {
+                subFilter->compile(filterKeys, prog, consts);
+            }
+            prog[index].end = (uint32_t)prog.size();
+            break;
+        case MBFilterIn:
+        case MBFilterNotIn:
+            instr.keyID = filterKeys.intern(attrName);
+            for (const auto &val : attrVals)
+            {
+                addConstant(val);
+            }
+            instr.constCount = (uint32_t)attrVals.size();
+            break;
+        case MBFilterHas:
+        case MBFilterNotHas:
+            instr.keyID = filterKeys.intern(attrName);
+            break;
+        default:
+            // Only equality works on the geometry type, the rest compare against the "$type" attribute
+            if (geomType != MBGeomNone && (filterType == MBFilterEqual || filterType == MBFilterNotEqual))
+            {
+                instr.geomType = geomType;
+                instr.keyID = filterKeys.intern(geometryType);
+            }
+            else
+            {
+                instr.keyID = filterKeys.intern(attrName);
+                addConstant(attrVal);
+                instr.constCount = 1;
+            }
+            break;
+    }
+}
+
+bool MapboxVectorFilter::evaluate(const MapboxVectorFilterInput &input,uint32_t &pc,const QuadTreeIdentifier &tileID) const
+{
+    typedef MapboxVectorFilterInput::Value Value;
+
+    const auto &instr = program[pc++];
+    switch (instr.op)
+    {
+        case MBFilterNone:
+            // Empty or unrecognized filter
+            return false;
+        case MBFilterAll:
+            while (pc < instr.end)
+            {
+                if (!evaluate(input, pc, tileID))
+                {
+                    pc = instr.end;
+                    return false;
+                }
+            }
+            return true;
+        case MBFilterAny:
+            while (pc < instr.end)
+            {
+                if (evaluate(input, pc, tileID))
+                {
+                    pc = instr.end;
+                    return true;
+                }
+            }
+            return false;
+        case MBFilterHas:
+            return input.hasValue(instr.keyID);
+        case MBFilterNotHas:
+            return !input.hasValue(instr.keyID);
+        default:
+            break;
+    }
+
+    // Compare geometry type
+    if (instr.geomType != MBGeomNone)
+    {
+        const auto val = input.getValue(instr.keyID);
+        const int attrGeomType = ((val.kind == Value::Number) ? (int)val.num :
+                                  (val.kind == Value::None) ? 0 : input.attrs.getInt(geometryType)) - 1;
+        return (instr.op == MBFilterEqual) ? (attrGeomType == instr.geomType) : (attrGeomType != instr.geomType);
+    }
+
+    // See if this was worked out ahead of time for each of the layer's values
+    if (instr.predicate >= 0)
+    {
+        const auto layer = input.getTileLayer();
+        if (layer && layer->predicateGroup == predicateGroup && (uint32_t)instr.predicate < layer->predicateCount)
+        {
+            if (const auto tileVal = input.findTileValue(instr.keyID))
+            {
+                const int result = layer->getPredicate(instr.predicate, (uint32_t)(tileVal - layer->values.data()));
+                return (result >= 0) ? (bool)result : testValue(instr, Value(*tileVal), tileID);
+            }
+            return testValue(instr, Value(), tileID);
+        }
+    }
+
+    return testValue(instr, input.getValue(instr.keyID), tileID);
+}
+
+bool MapboxVectorFilter::testValue(const Instruction &instr,const MapboxVectorFilterInput::Value &val,const QuadTreeIdentifier &tileID) const
+{
+    typedef MapboxVectorFilterInput::Value Value;
+
+    if (instr.op == MBFilterIn || instr.op == MBFilterNotIn)
+    {
+        const bool isIn = (instr.op == MBFilterIn);
+        if (val.kind == Value::None)
+        {
+            return !isIn;
+        }
+        DictionaryEntryRef entry;
+        for (uint32_t ii = instr.constStart; ii < instr.constStart + instr.constCount; ii++)
+        {
+            const auto &c = constants[ii];
+            bool match;
+            if (c.kind == Value::String && val.kind == Value::String)
+            {
+                match = (val.str == c.str);
+            }
+            else if (c.kind == Value::Number && val.kind == Value::Number)
+            {
+                match = c.isInt ? ((int)val.num == (int)c.num) : (val.num == c.num);
+            }
+            else
+            {
+                // Mixed types compare the way the entries do
+                if (!entry)
+                {
+                    entry = val.getEntry();
+                }
+                match = entry && c.entry->isEqual(entry);
+            }
+            if (match)
+            {
+                return isIn;
+            }
+        }
+        return !isIn;
+    }
+
+    // Equality related operators
+    const auto &c = constants[instr.constStart];
+    switch (val.kind)
+    {
+        case Value::None:
+            // No attribute means no pass
+            // A missing value and != is valid
+            return (instr.op == MBFilterNotEqual);
+        case Value::String:
+        {
+            if (instr.op != MBFilterEqual && instr.op != MBFilterNotEqual)
+            {
+                return true;  // Note: Not expecting other comparisons to strings
+            }
+            bool equal;
+            if (c.kind == Value::String)
+            {
+                equal = (val.str == c.str);
+            }
+            else
+            {
+                const auto entry = val.getEntry();
+                equal = entry && entry->isEqual(c.entry);
+            }
+            return (instr.op == MBFilterEqual) ? equal : !equal;
+        }
+        case Value::Number:
+        {
+            const double val1 = val.num;
+            const double val2 = (c.kind == Value::Number) ? c.num : c.entry->getDouble();
+            switch (instr.op)
+            {
+                case MBFilterEqual:            return val1 == val2;
+                case MBFilterNotEqual:         return val1 != val2;
+                case MBFilterGreaterThan:      return val1 > val2;
+                case MBFilterGreaterThanEqual: return val1 >= val2;
+                case MBFilterLessThan:         return val1 < val2;
+                case MBFilterLessThanEqual:    return val1 <= val2;
+                default: return true;
+            }
+        }
+        default:
+            wkLogLevel(Warn,"MapboxVectorFilter: Found numeric comparison that doesn't use numbers - '%s', %d/%d/%d",
+                       keys->getName(instr.keyID).c_str(), tileID.level, tileID.x, tileID.y);
+            return true;
+    }
+}
+
+int MapboxVectorFilter::assignPredicates(int first,const void *group)
+{
+    predicateGroup = group;
+    for (auto &instr : program)
+    {
+        instr.predicate = -1;
+        switch (instr.op)
+        {
+            case MBFilterIn:
+            case MBFilterNotIn:
+                break;
+            default:
+                if (instr.op > MBFilterLessThanEqual || instr.geomType != MBGeomNone)
+                {
+                    continue;
+                }
+                break;
+        }
+        // The layer fields can be missing from the tags and still be there
+        if (!keys || keys->isLayerField(instr.keyID))
+        {
+            continue;
+        }
+        instr.predicate = first++;
+    }
+    return first;
+}
+
+void MapboxVectorFilter::evaluatePredicates(VectorTileLayerTable &layer,
+                                            const std::vector<std::vector<uint32_t>> &valuesByKey,
+                                            const QuadTreeIdentifier &tileID) const
+{
+    for (const auto &instr : program)
+    {
+        if (instr.predicate < 0 || (uint32_t)instr.predicate >= layer.predicateCount ||
+            (size_t)instr.keyID >= valuesByKey.size())
+        {
+            continue;
+        }
+        for (const auto valueIndex : valuesByKey[instr.keyID])
+        {
+            const bool result = testValue(instr, MapboxVectorFilterInput::Value(layer.values[valueIndex]), tileID);
+            layer.setPredicate(instr.predicate, valueIndex, result);
+        }
+    }
+}
+
+bool MapboxVectorFilter::testFeature(const MapboxVectorFilterInput &input,const QuadTreeIdentifier &tileID) const
+{
+    if (program.empty() || keys != &input.keys)
+    {
+        return testFeatureTree(input.attrs, tileID);
+    }
+
+    uint32_t pc = 0;
+    return evaluate(input, pc, tileID);
+}
+
 bool MapboxVectorFilter::testFeature(const Dictionary &attrs,const QuadTreeIdentifier &tileID)
+{
+    if (program.empty() || !keys)
+    {
+        return testFeatureTree(attrs, tileID);
+    }
+
+    const MapboxVectorFilterInput input(attrs, *keys);
+    uint32_t pc = 0;
+    return evaluate(input, pc, tileID);
+}
+
+bool MapboxVectorFilter::testFeatureTree(const Dictionary &attrs,const QuadTreeIdentifier &tileID) const
 {
     // Compare geometry type
     if (geomType != MBGeomNone)
@@ -133,14 +560,14 @@ bool MapboxVectorFilter::testFeature(const Dictionary &attrs,const QuadTreeIdent
     // Run each of the rules as either AND or OR
     case MBFilterAll:
         for (const auto &filter : subFilters) {
-            if (!filter->testFeature(attrs, tileID)) {
+            if (!filter->testFeatureTree(attrs, tileID)) {
                 return false;
             }
         }
         return true;
     case MBFilterAny:
         for (const auto &filter : subFilters) {
-            if (filter->testFeature(attrs, tileID)) {
+            if (filter->testFeatureTree(attrs, tileID)) {
                 return true;
             }
         }
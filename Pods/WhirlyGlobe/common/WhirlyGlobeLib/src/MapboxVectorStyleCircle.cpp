@@ -153,7 +153,7 @@ void MapboxVectorLayerCircle::buildObjects(PlatformThreadInfo *inst,
         const auto attrs = vecObj->getAttributes();
         const auto &settings = *styleSet->tileStyleSettings;
 
-        for (const VectorShapeRef &shape : vecObj->shapes)
+        for (const VectorShapeRef &shape : vecObj->getShapes())
         {
             VectorRing* pts;
             if (const auto vecPts = dynamic_cast<VectorPoints*>(shape.get()))
@@ -183,7 +183,7 @@ void MapboxVectorLayerCircle::buildObjects(PlatformThreadInfo *inst,
             {
                 if (markerOwner.empty())
                 {
-                    markerOwner.reserve(pts->size() * vecObj->shapes.size());
+                    markerOwner.reserve(pts->size() * vecObj->getShapes().size());
                 }
 
                 // Add a marker per point
@@ -119,7 +119,7 @@ void MapboxVectorLayerFill::buildObjects(PlatformThreadInfo *inst,
             {
                 shapes.reserve(vecObjs.size() * 20);
             }
-            std::copy(vecObj->shapes.begin(),vecObj->shapes.end(),std::back_inserter(shapes));
+            std::copy(vecObj->getShapes().begin(),vecObj->getShapes().end(),std::back_inserter(shapes));
         }
     }
 
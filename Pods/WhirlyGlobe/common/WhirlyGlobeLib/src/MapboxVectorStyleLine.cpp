@@ -329,8 +329,8 @@ void MapboxVectorLayerLine::buildObjects(PlatformThreadInfo *inst,
         auto &shapes = result.first->second;
 
         if (shapes.empty())
-            shapes.reserve(shapes.size() + vecObj->shapes.size());
-        std::copy(vecObj->shapes.begin(),vecObj->shapes.end(),std::back_inserter(shapes));
+            shapes.reserve(shapes.size() + vecObj->getShapes().size());
+        std::copy(vecObj->getShapes().begin(),vecObj->getShapes().end(),std::back_inserter(shapes));
 
         // If individual vector objects aren't allowed to override colors, drop the color attribute.
         if (!colorOverride)
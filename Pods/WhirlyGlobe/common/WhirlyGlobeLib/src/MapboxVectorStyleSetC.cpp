@@ -23,6 +23,8 @@
 #import "MapboxVectorStyleBackground.h"
 #import "MapboxVectorStyleLine.h"
 #import "MapboxVectorStyleSymbol.h"
+#import "VectorTileAttributes.h"
+#import <algorithm>
 #import <regex>
 
 namespace WhirlyKit
@@ -524,6 +526,12 @@ void MapboxVectorStyleSetImpl::addLayer(PlatformThreadInfo *inst, MapboxVectorSt
     layersByUUID[layer->getUuid(inst)] = layer;
     if (!layer->sourceLayer.empty())
     {
+        if (layer->filter)
+        {
+            // Predicates are numbered within each source layer, since that's what they'll run on
+            auto &predicateCount = filterPredicateCounts[layer->sourceLayer];
+            predicateCount = layer->filter->assignPredicates(predicateCount, &predicateCount);
+        }
         layersBySource.insert(std::make_pair(layer->sourceLayer, layer));
     }
     layers.push_back(std::move(layer));
@@ -1007,10 +1015,11 @@ std::vector<VectorStyleImplRef> MapboxVectorStyleSetImpl::stylesForFeature(Platf
     std::vector<VectorStyleImplRef> styles;
 
     const auto range = layersBySource.equal_range(layerName);
+    const MapboxVectorFilterInput filterInput(attrs, filterKeys);
     for (auto i = range.first; i != range.second; ++i)
     {
         auto &layer = i->second;
-        if (!layer->filter || layer->filter->testFeature(attrs, tileID))
+        if (!layer->filter || layer->filter->testFeature(filterInput, tileID))
         {
             if (styles.empty())
             {
@@ -1039,6 +1048,53 @@ bool MapboxVectorStyleSetImpl::layerShouldDisplay(PlatformThreadInfo *inst,
     return false;
 }
 
+void MapboxVectorStyleSetImpl::prepareLayer(PlatformThreadInfo *inst,VectorTileLayerTable &layer,const QuadTreeIdentifier &tileID)
+{
+    // Translate the layer's keys into the IDs the filters were compiled with
+    layer.keyIDs.resize(layer.keys.size());
+    for (size_t ii = 0; ii < layer.keys.size(); ii++)
+    {
+        layer.keyIDs[ii] = layer.keys[ii].empty() ? -1 : filterKeys.find(layer.keys[ii]);
+    }
+    layer.keyIDOwner = &filterKeys;
+
+    const auto predicateIt = filterPredicateCounts.find(layer.layerName);
+    if (predicateIt == filterPredicateCounts.end() || predicateIt->second == 0)
+    {
+        return;
+    }
+
+    // Values are shared by all the features in a layer, so it's cheaper to run the
+    //  simple comparisons once per distinct value than once per feature.
+    // Collect the values each of the keys we care about actually takes on.
+    std::vector<std::vector<uint32_t>> valuesByKey(filterKeys.size());
+    for (size_t ii = 0; ii + 1 < layer.tags.size(); ii += 2)
+    {
+        const auto keyIndex = layer.tags[ii];
+        const auto valueIndex = layer.tags[ii + 1];
+        if (keyIndex < layer.keyIDs.size() && layer.keyIDs[keyIndex] >= 0 && valueIndex < layer.values.size())
+        {
+            valuesByKey[layer.keyIDs[keyIndex]].push_back(valueIndex);
+        }
+    }
+    for (auto &values : valuesByKey)
+    {
+        std::sort(values.begin(), values.end());
+        values.erase(std::unique(values.begin(), values.end()), values.end());
+    }
+
+    // Anything we miss here (odd tag counts, say) is evaluated the slow way when it comes up
+    layer.setupPredicates(&predicateIt->second, (uint32_t)predicateIt->second);
+    const auto range = layersBySource.equal_range(layer.layerName);
+    for (auto i = range.first; i != range.second; ++i)
+    {
+        if (const auto &filter = i->second->filter)
+        {
+            filter->evaluatePredicates(layer, valuesByKey, tileID);
+        }
+    }
+}
+
 /// Return the style associated with the given UUID.
 VectorStyleImplRef MapboxVectorStyleSetImpl::styleForUUID(PlatformThreadInfo *inst,long long uuid)
 {
@@ -585,7 +585,7 @@ void MapboxVectorLayerSymbol::buildObjects(PlatformThreadInfo *inst,
 
         if (vecType == VectorPointType)
         {
-            for (const VectorShapeRef &shape : vecObj->shapes)
+            for (const VectorShapeRef &shape : vecObj->getShapes())
             {
                 if (auto pts = dynamic_cast<VectorPoints*>(shape.get()))
                 {
@@ -646,19 +646,19 @@ void MapboxVectorLayerSymbol::buildObjects(PlatformThreadInfo *inst,
         else if (vecType == VectorLinearType)
         {
 #if DEBUG
-            if (vecObj->shapes.size() > 1)
+            if (vecObj->getShapes().size() > 1)
             {
                 static int warned = 0;
                 if (!warned++)
                 {
-                    wkLogLevel(Warn, "MapboxVectorLayerSymbol: Linear vector object contains %d shapes", vecObj->shapes.size());
+                    wkLogLevel(Warn, "MapboxVectorLayerSymbol: Linear vector object contains %d shapes", vecObj->getShapes().size());
                 }
             }
 #endif
-            for (const VectorShapeRef &shape : vecObj->shapes)
+            for (const VectorShapeRef &shape : vecObj->getShapes())
             {
                 // for each line in the shape set ... (we expect exactly one)
-                if (__unused auto line = dynamic_cast<VectorLinear*>(shape.get()))
+                if (dynamic_cast<VectorLinear*>(shape.get()))
                 {
                     if (!uuidMarkers)
                     {
@@ -728,19 +728,19 @@ void MapboxVectorLayerSymbol::buildObjects(PlatformThreadInfo *inst,
         else if (vecType == VectorArealType)
         {
 #if DEBUG
-            if (vecObj->shapes.size() > 1)
+            if (vecObj->getShapes().size() > 1)
             {
                 static int warned = 0;
                 if (!warned++)
                 {
-                    wkLogLevel(Warn, "MapboxVectorLayerSymbol: Areal vector object contains %d shapes", vecObj->shapes.size());
+                    wkLogLevel(Warn, "MapboxVectorLayerSymbol: Areal vector object contains %d shapes", vecObj->getShapes().size());
                 }
             }
 #endif
-            for (const auto &shape : vecObj->shapes)
+            for (const auto &shape : vecObj->getShapes())
             {
                 // each polygon in the shape set... (we expect exactly one)
-                if (__unused auto areal = dynamic_cast<VectorAreal*>(shape.get()))
+                if (dynamic_cast<VectorAreal*>(shape.get()))
                 {
                     if (!uuidMarkers)
                     {
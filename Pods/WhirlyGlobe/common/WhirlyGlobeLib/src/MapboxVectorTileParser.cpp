@@ -22,8 +22,11 @@
 #import "WhirlyKitLog.h"
 #import "DictionaryC.h"
 #import "VectorTilePBFParser.h"
+#import "RawDataCompression.h"
+#import "PerformanceTimer.h"
 
 #include <utility>
+#import <unordered_map>
 #import <vector>
 
 using namespace Eigen;
@@ -164,8 +167,27 @@ static inline double secondsSince(const std::chrono::steady_clock::time_point &t
     return (double)duration_cast<nanoseconds>(steady_clock::now() - t0).count() / 1.0e9;
 }
 
+static inline int64_t nanosSince(const std::chrono::steady_clock::time_point &t0)
+{
+    using namespace std::chrono;
+    return duration_cast<nanoseconds>(steady_clock::now() - t0).count();
+}
+
 static bool noCancel(PlatformThreadInfo*) { return false; }
 
+MapboxVectorTileParser::Stats MapboxVectorTileParser::getStats() const
+{
+    Stats stats;
+    stats.numTiles = numTiles;
+    stats.numCompressed = numCompressed;
+    stats.decompressTime = decompressNanos / 1.0e9;
+    stats.parseTime = parseNanos / 1.0e9;
+    stats.buildTime = buildNanos / 1.0e9;
+    stats.skippedLayerBytes = skippedLayerBytes;
+    stats.decodedLayerBytes = decodedLayerBytes;
+    return stats;
+}
+
 bool MapboxVectorTileParser::parse(PlatformThreadInfo *styleInst, RawData *rawData,
                                    VectorTileData *tileData, volatile bool *cancelBool)
 {
@@ -183,11 +205,39 @@ bool MapboxVectorTileParser::parse(PlatformThreadInfo *styleInst,
 //               tileData->ident.level, tileData->ident.x, tileData->ident.y);
 //#endif
     const auto t0 = std::chrono::steady_clock::now();
+    numTiles++;
+
+    // Compressed tiles get unpacked into a per-thread buffer first.
+    // Nothing refers to it once we're done parsing, so the next tile can reuse it.
+    MutableRawDataRef decompressed;
+    const auto compression = decompress ? RawDataCompression(rawData) : RawDataCompressionNone;
+    int64_t decompressTime = 0;
+    if (compression != RawDataCompressionNone)
+    {
+        TileLoadTracer::Span traceSpan(TileLoadStageDecompress, tileData->ident);
+        decompressed = RawDataDecompressBuffer();
+        if (!RawDataDecompress(rawData->getRawData(), rawData->getLen(), compression, *decompressed))
+        {
+            wkLogLevel(Warn, "MapboxVectorTileParser: Failed to decompress [%d/%d/%d]",
+                       tileData->ident.level, tileData->ident.x, tileData->ident.y);
+            return false;
+        }
+        rawData = decompressed.get();
+        numCompressed++;
+        decompressTime = nanosSince(t0);
+        decompressNanos += decompressTime;
+    }
+    const auto tParse = std::chrono::steady_clock::now();
 
     VectorTilePBFParser parser(tileData, &*styleDelegate, styleInst, filterName, filterValues,
                                tileData->vecObjsByStyle, localCoords, parseAll,
                                keepVectors ? &tileData->vecObjs : nullptr, cancelFn);
-    if (!parser.parse(rawData->getRawData(), rawData->getLen()))
+    bool parsed;
+    {
+        TileLoadTracer::Span traceSpan(TileLoadStageParse, tileData->ident);
+        parsed = parser.parse(rawData->getRawData(), rawData->getLen());
+    }
+    if (!parsed)
     {
         if (parser.getParseCancelled())
         {
@@ -219,15 +269,24 @@ bool MapboxVectorTileParser::parse(PlatformThreadInfo *styleInst,
         return false;
     }
 
+    const auto parseTime = nanosSince(tParse);
+    parseNanos += parseTime;
+    skippedLayerBytes += parser.getSkippedLayerBytes();
+    decodedLayerBytes += parser.getDecodedLayerBytes();
+
 #if DEBUG
     const auto duration = std::max(1e-9, secondsSince(t0));
-    wkLogLevel(Verbose, "MapboxVectorTileParser: Finished [%d/%d/%d] - %.2f MiB - %.4f s - %.4f MiB/s - %.1f features/s",
+    wkLogLevel(Verbose, "MapboxVectorTileParser: Finished [%d/%d/%d] - %.2f MiB (%.2f MiB skipped) - %.4f s (%.4f s decompress, %.4f s parse) - %.4f MiB/s - %.1f features/s",
                tileData->ident.level, tileData->ident.x, tileData->ident.y,
                rawData->getLen() / 1024.0 / 1024,
-               duration, rawData->getLen() / duration / 1024 / 1024,
+               parser.getSkippedLayerBytes() / 1024.0 / 1024,
+               duration, decompressTime / 1.0e9, parseTime / 1.0e9,
+               rawData->getLen() / duration / 1024 / 1024,
                parser.getFeatureCount() / duration);
 #endif
 
+    const auto tBuild = std::chrono::steady_clock::now();
+
     // TODO: Switch to stencils and get this working again
     // Call background
 //    if (const auto backgroundStyle = styleDelegate->backgroundStyle(styleInst)) {
@@ -239,40 +298,48 @@ bool MapboxVectorTileParser::parse(PlatformThreadInfo *styleInst,
 //    }
     
     // Run the styles over their assembled data
-    for (const auto &it : tileData->vecObjsByStyle)
+    if (buildPool && tileData->vecObjsByStyle.size() > 1)
     {
-        std::vector<VectorObjectRef> &vecs = *it.second;
+        if (!buildStylesParallel(styleInst, tileData, cancelFn))
+        {
+            buildNanos += nanosSince(tBuild);
+            return false;
+        }
+    }
+    else
+    {
+        for (const auto &it : tileData->vecObjsByStyle)
+        {
+            std::vector<VectorObjectRef> &vecs = *it.second;
 
-        auto styleData = std::make_shared<VectorTileData>(*tileData);
+            auto styleData = std::make_shared<VectorTileData>(*tileData);
 
-        // Ask the subclass to run the style and fill in the VectorTileData
-        buildForStyle(styleInst,it.first,vecs,styleData,cancelFn);
+            // Ask the subclass to run the style and fill in the VectorTileData
+            buildForStyle(styleInst,it.first,vecs,styleData,cancelFn);
 
-        // Sort the results into categories if needed
-        auto catIt = styleCategories.find(it.first);
-        if (catIt != styleCategories.end() && !styleData->compObjs.empty())
-        {
-            const std::string &category = catIt->second;
-            auto &compObjs = styleData->compObjs;
-            auto categoryIt = tileData->categories.find(category);
-            if (categoryIt != tileData->categories.end())
+            // Merge this into the general return data
+            mergeStyleData(tileData, it.first, styleData.get());
+
+            // The changes in `tileData` represent objects already tracked
+            // in the managers they must be merged or we'll have leaks, so
+            // we can't return between the build and the merge above.
+            if (cancelFn(styleInst))
             {
-                compObjs.insert(compObjs.end(), categoryIt->second.begin(), categoryIt->second.end());
+                buildNanos += nanosSince(tBuild);
+                return false;
             }
-            tileData->categories[category] = compObjs;
         }
-        
-        // Merge this into the general return data
-        tileData->mergeFrom(styleData.get());
-
-        // The changes in `tileData` represent objects already tracked
-        // in the managers they must be merged or we'll have leaks, so
-        // we can't return between the build and the merge above.
-        if (cancelFn(styleInst))
+    }
+
+    // Whoever asked to keep the vectors will expect the shapes to be there
+    if (keepVectors)
+    {
+        for (const auto &vecObj : tileData->vecObjs)
         {
-            return false;
+            vecObj->getShapes();
         }
     }
+    buildNanos += nanosSince(tBuild);
     
     // These are layered on top for debugging
 //    if(debugLabel || debugOutline) {
@@ -321,6 +388,110 @@ bool MapboxVectorTileParser::parse(PlatformThreadInfo *styleInst,
     return true;
 }
 
+void MapboxVectorTileParser::mergeStyleData(VectorTileData *tileData,long long styleID,VectorTileData *styleData)
+{
+    // Sort the results into categories if needed
+    auto catIt = styleCategories.find(styleID);
+    if (catIt != styleCategories.end() && !styleData->compObjs.empty())
+    {
+        const std::string &category = catIt->second;
+        auto &compObjs = styleData->compObjs;
+        auto categoryIt = tileData->categories.find(category);
+        if (categoryIt != tileData->categories.end())
+        {
+            compObjs.insert(compObjs.end(), categoryIt->second.begin(), categoryIt->second.end());
+        }
+        tileData->categories[category] = compObjs;
+    }
+
+    tileData->mergeFrom(styleData);
+}
+
+bool MapboxVectorTileParser::buildStylesParallel(PlatformThreadInfo *styleInst,
+                                                 VectorTileData *tileData,
+                                                 const CancelFunction &cancelFn)
+{
+    const auto &byStyle = tileData->vecObjsByStyle;
+    const size_t numStyles = byStyle.size();
+
+    // Styles that share a feature have to run on the same thread.
+    // They can modify its attributes and geometry is decoded on first use.
+    std::vector<size_t> groupOf(numStyles);
+    for (size_t ii=0;ii<numStyles;ii++)
+    {
+        groupOf[ii] = ii;
+    }
+    const auto findGroup = [&groupOf](size_t which)
+    {
+        while (groupOf[which] != which)
+        {
+            which = groupOf[which] = groupOf[groupOf[which]];
+        }
+        return which;
+    };
+
+    std::vector<std::pair<long long,const std::vector<VectorObjectRef> *>> styles;
+    styles.reserve(numStyles);
+    std::unordered_map<const VectorObject *,size_t> firstStyle;
+    for (const auto &it : byStyle)
+    {
+        const size_t which = styles.size();
+        styles.emplace_back(it.first, it.second);
+        for (const auto &vecObj : *it.second)
+        {
+            const auto res = firstStyle.insert(std::make_pair(vecObj.get(), which));
+            if (!res.second)
+            {
+                const size_t a = findGroup(res.first->second);
+                const size_t b = findGroup(which);
+                groupOf[std::max(a,b)] = std::min(a,b);
+            }
+        }
+    }
+
+    // Each group runs its styles in the original order
+    std::map<size_t,std::vector<size_t>> groups;
+    for (size_t ii=0;ii<numStyles;ii++)
+    {
+        groups[findGroup(ii)].push_back(ii);
+    }
+
+    std::vector<VectorTileDataRef> results(numStyles);
+    std::vector<WorkStealingPool::Task> tasks;
+    tasks.reserve(groups.size());
+    for (auto &group : groups)
+    {
+        const std::vector<size_t> *members = &group.second;
+        tasks.emplace_back([this,styleInst,tileData,members,&styles,&results,&cancelFn]()
+        {
+            for (const size_t which : *members)
+            {
+                if (cancelFn(styleInst))
+                {
+                    return;
+                }
+                auto styleData = std::make_shared<VectorTileData>(*tileData);
+                buildForStyle(styleInst,styles[which].first,*styles[which].second,styleData,cancelFn);
+                results[which] = styleData;
+            }
+        });
+    }
+    buildPool->run(tasks);
+
+    // Merge in style order, same as we would have sequentially, so the results don't
+    // depend on which thread finished first.  Anything that got built has to be merged
+    // even if we were cancelled, or the objects already in the managers will leak.
+    for (size_t ii=0;ii<numStyles;ii++)
+    {
+        if (results[ii])
+        {
+            mergeStyleData(tileData, styles[ii].first, results[ii].get());
+        }
+    }
+
+    return !cancelFn(styleInst);
+}
+
 void MapboxVectorTileParser::buildForStyle(PlatformThreadInfo *styleInst,
                                            long long styleID,
                                            const std::vector<VectorObjectRef> &vecObjs,
@@ -329,6 +500,7 @@ void MapboxVectorTileParser::buildForStyle(PlatformThreadInfo *styleInst,
     {
         if (auto style = styleDelegate->styleForUUID(styleInst,styleID))
         {
+            TileLoadTracer::Span traceSpan(TileLoadStageBuildStyle, data->ident);
             style->buildObjects(styleInst,vecObjs,data,nullptr,cancelFn);
         }
     }
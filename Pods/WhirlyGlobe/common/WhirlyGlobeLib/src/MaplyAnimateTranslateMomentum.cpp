@@ -60,6 +60,43 @@ bool AnimateTranslateMomentum::withinBounds(const Point3d &loc,MapView *testMapV
     return MaplyGestureWithinBounds(bounds,loc,renderer,testMapView,newCenter);
 }
 
+ViewPredictor AnimateTranslateMomentum::makePredictor(const Point2f &frameSize) const
+{
+    if (startDate == 0.0)
+    {
+        return ViewPredictor();
+    }
+
+    // Copy what we need, we may be gone (or changed) by the time this runs
+    const double theVelocity = velocity, theAcceleration = acceleration;
+    const double theMaxTime = maxTime;
+    const TimeInterval theStartDate = startDate;
+    const Point3d theOrg = org;
+    const Vector3d theDir = dir;
+    const Point2dVector theBounds = bounds;
+    return [=](View *view, TimeInterval when)
+    {
+        const auto mapView = dynamic_cast<MapView *>(view);
+        if (!mapView)
+        {
+            return false;
+        }
+
+        const double sinceStart = std::min(theMaxTime, std::max(0.0, when - theStartDate));
+        const double dist = (theVelocity + 0.5 * theAcceleration * sinceStart) * sinceStart;
+
+        // Same bounds check as the animation itself
+        Point3d newCenter;
+        MapView testMapView(*mapView);
+        if (!MaplyGestureWithinBounds(theBounds, theOrg + theDir * dist, frameSize, &testMapView, &newCenter))
+        {
+            return false;
+        }
+        mapView->setLoc(newCenter, false);
+        return true;
+    };
+}
+
 // Called by the view when it's time to update
 void AnimateTranslateMomentum::updateView(WhirlyKit::View *view)
 {
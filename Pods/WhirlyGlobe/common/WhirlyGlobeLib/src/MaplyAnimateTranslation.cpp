@@ -29,6 +29,15 @@ bool MaplyGestureWithinBounds(const Point2dVector &bounds,
                               SceneRenderer *sceneRender,
                               MapView *testMapView,
                               Point3d *newCenter)
+{
+    return MaplyGestureWithinBounds(bounds,loc,sceneRender->getFramebufferSize(),testMapView,newCenter);
+}
+
+bool MaplyGestureWithinBounds(const Point2dVector &bounds,
+                              const Point3d &loc,
+                              const Point2f &frameSize,
+                              MapView *testMapView,
+                              Point3d *newCenter)
 {
     if (newCenter)
         *newCenter = loc;
@@ -37,7 +46,6 @@ bool MaplyGestureWithinBounds(const Point2dVector &bounds,
         return true;
     
     // The corners of the view should be within the bounds
-    const Point2f frameSize = sceneRender->getFramebufferSize();
     const Point2f corners[4] = {
         { 0, 0 },
         { frameSize.x(), 0.0 },
@@ -18,6 +18,7 @@
 
 #import "Platform.h"
 #import "MaplyView.h"
+#import "SceneRenderer.h"
 
 using namespace Eigen;
 using namespace WhirlyKit;
@@ -290,8 +291,37 @@ ViewStateRef MapView::makeViewState(SceneRenderer *renderer)
     return std::make_shared<MapViewState>(this,renderer);
 }
 
+ViewStatePredictor MapView::makeViewStatePredictor(const Point2f &frameSize) const
+{
+    const auto theDelegate = delegate;
+    ViewPredictor predictor = theDelegate ? theDelegate->makePredictor(frameSize) : ViewPredictor();
+    if (!predictor)
+    {
+        return ViewStatePredictor();
+    }
+
+    // Work from a copy as we are now, without the animation or anyone watching.
+    // The copy doesn't want predictions, so the view states it makes won't have one.
+    const auto viewCopy = std::make_shared<MapView>(*this);
+    viewCopy->setDelegate(nullptr);
+    return [viewCopy,predictor,frameSize](TimeInterval when) -> ViewStateRef
+    {
+        MapView predictView(*viewCopy);
+        if (!predictor(&predictView, when))
+        {
+            return ViewStateRef();
+        }
+        return std::make_shared<MapViewState>(&predictView,frameSize);
+    };
+}
+
 MapViewState::MapViewState(MapView *mapView,SceneRenderer *renderer)
-: ViewState(mapView,renderer)
+: MapViewState(mapView,renderer->getFramebufferSize())
+{
+}
+
+MapViewState::MapViewState(MapView *mapView,const Point2f &frameSize)
+: ViewState(mapView,frameSize)
 {
     heightAboveSurface = mapView->getLoc().z();
 }
@@ -19,6 +19,7 @@
 #import <math.h>
 #import <vector>
 #import <algorithm>
+#import <thread>
 #import "WhirlyKitLog.h"
 #import "PerformanceTimer.h"
 #import "Platform.h"
@@ -60,6 +61,13 @@ static inline TimeInterval PerfTime()
     return (double)tp.tv_sec + tp.tv_nsec * (double)1e-9;
 }
 
+static inline int64_t PerfTimeNanos()
+{
+    struct timespec tp;
+    clock_gettime(CLOCK_MONOTONIC, &tp);
+    return (int64_t)tp.tv_sec * 1000000000 + tp.tv_nsec;
+}
+
 void PerformanceTimer::startTiming(const std::string &what)
 {
     actives[what] = PerfTime();
@@ -119,18 +127,14 @@ void PerformanceTimer::report(const std::string &what)
     wkLogLevel(Verbose,"Maply Performance: %s",what.c_str());
 }
 
-void PerformanceTimer::log(double min)
+// Sort the timings and write them out along with the counts
+static void LogEntries(std::vector<PerformanceTimer::TimeEntry> &timeEntries,
+                       const std::vector<PerformanceTimer::CountEntry> &countEntries,
+                       double min)
 {
-    std::vector<TimeEntry> sortedEntries;
-    sortedEntries.reserve(timeEntries.size());
-
-    for (const auto &timeEntry : timeEntries)
-    {
-        sortedEntries.push_back(timeEntry.second);
-    }
-    std::sort(sortedEntries.begin(),sortedEntries.end(),TimeEntryByMax);
+    std::sort(timeEntries.begin(),timeEntries.end(),TimeEntryByMax);
     char line[1024];
-    for (const auto &entry : sortedEntries)
+    for (const auto &entry : timeEntries)
     {
         if (entry.numRuns > 0 && entry.maxDur >= min)
         {
@@ -138,20 +142,518 @@ void PerformanceTimer::log(double min)
                      "%s: min, max, mean = (%.3f, %.3f, %.4f) ms, %d reports",
                      entry.name.c_str(),1000*entry.minDur,1000*entry.
                      maxDur,1000*entry.avgDur / entry.numRuns, entry.numRuns);
-            report(line);
+            wkLogLevel(Verbose,"Maply Performance: %s",line);
         }
     }
-    for (const auto &countEntry : countEntries)
+    for (const auto &entry : countEntries)
     {
-        const CountEntry &entry = countEntry.second;
         if (entry.numRuns > 0 && entry.maxCount > 0)
         {
             snprintf(line,sizeof(line),
                      "%s: min, max, mean (%d, %d, %.3f), %d reports",
                      entry.name.c_str(),entry.minCount,entry.maxCount,
                     (float)entry.avgCount / (float)entry.numRuns,entry.numRuns);
-            report(line);
+            wkLogLevel(Verbose,"Maply Performance: %s",line);
+        }
+    }
+}
+
+void PerformanceTimer::log(double min)
+{
+    std::vector<TimeEntry> sortedEntries;
+    sortedEntries.reserve(timeEntries.size());
+    for (const auto &timeEntry : timeEntries)
+    {
+        sortedEntries.push_back(timeEntry.second);
+    }
+    std::vector<CountEntry> counts;
+    counts.reserve(countEntries.size());
+    for (const auto &countEntry : countEntries)
+    {
+        counts.push_back(countEntry.second);
+    }
+    LogEntries(sortedEntries,counts,min);
+}
+
+// Timers a given thread has slots in.  Timer IDs are never reused, so
+//  entries for timers that have gone away just never match again.
+struct ConcurrentTimerThreadCache
+{
+    std::vector<std::pair<uint64_t,void *>> entries;
+};
+static thread_local ConcurrentTimerThreadCache concurrentTimerCache;
+
+ConcurrentPerformanceTimer::ConcurrentPerformanceTimer(int maxHandles) :
+    maxHandles(std::max(1,maxHandles)),
+    timerID([]{ static std::atomic<uint64_t> nextID = {1}; return nextID++; }())
+{
+}
+
+ConcurrentPerformanceTimer::~ConcurrentPerformanceTimer()
+{
+}
+
+ConcurrentPerformanceTimer::Handle ConcurrentPerformanceTimer::registerName(const std::string &name,bool count)
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+
+    const auto it = handlesByName.find(name);
+    if (it != handlesByName.end())
+    {
+        return it->second;
+    }
+    if (names.size() >= (size_t)maxHandles)
+    {
+        wkLogLevel(Warn,"ConcurrentPerformanceTimer: Out of handles for %s",name.c_str());
+        return InvalidHandle;
+    }
+
+    const Handle handle = (Handle)names.size();
+    names.push_back(name);
+    isCount.push_back(count);
+    handlesByName[name] = handle;
+    return handle;
+}
+
+ConcurrentPerformanceTimer::Handle ConcurrentPerformanceTimer::registerTiming(const std::string &name)
+{
+    return registerName(name,false);
+}
+
+ConcurrentPerformanceTimer::Handle ConcurrentPerformanceTimer::registerCount(const std::string &name)
+{
+    return registerName(name,true);
+}
+
+ConcurrentPerformanceTimer::Slot *ConcurrentPerformanceTimer::threadSlots()
+{
+    auto &cache = concurrentTimerCache.entries;
+    for (const auto &entry : cache)
+    {
+        if (entry.first == timerID)
+        {
+            return (Slot *)entry.second;
+        }
+    }
+
+    // First time this thread has been through here
+    Slot *slots = new Slot[maxHandles];
+    {
+        std::lock_guard<std::mutex> guardLock(lock);
+        allThreadSlots.emplace_back(slots);
+    }
+
+    // Threads that outlive lots of timers would otherwise collect stale entries
+    if (cache.size() >= 32)
+    {
+        cache.erase(cache.begin());
+    }
+    cache.emplace_back(timerID,slots);
+
+    return slots;
+}
+
+ConcurrentPerformanceTimer::Slot *ConcurrentPerformanceTimer::slotFor(Handle handle)
+{
+    if (handle < 0 || handle >= maxHandles)
+    {
+        return nullptr;
+    }
+
+    Slot *slot = &threadSlots()[handle];
+
+    // Anything from before a clear() is thrown out the next time we write
+    const uint32_t curGen = generation.load(std::memory_order_acquire);
+    if (slot->generation.load(std::memory_order_relaxed) != curGen)
+    {
+        slot->num.store(0,std::memory_order_relaxed);
+        slot->total.store(0,std::memory_order_relaxed);
+        slot->start = 0;
+        slot->generation.store(curGen,std::memory_order_release);
+    }
+
+    return slot;
+}
+
+void ConcurrentPerformanceTimer::addValue(Handle handle,int64_t val)
+{
+    Slot *slot = slotFor(handle);
+    if (!slot)
+    {
+        return;
+    }
+
+    // Only this thread writes the slot, so there's no need for read-modify-write
+    const int64_t num = slot->num.load(std::memory_order_relaxed);
+    if (num == 0)
+    {
+        slot->minVal.store(val,std::memory_order_relaxed);
+        slot->maxVal.store(val,std::memory_order_relaxed);
+    }
+    else
+    {
+        if (val < slot->minVal.load(std::memory_order_relaxed))
+            slot->minVal.store(val,std::memory_order_relaxed);
+        if (val > slot->maxVal.load(std::memory_order_relaxed))
+            slot->maxVal.store(val,std::memory_order_relaxed);
+    }
+    slot->total.store(slot->total.load(std::memory_order_relaxed) + val,std::memory_order_relaxed);
+    slot->num.store(num + 1,std::memory_order_release);
+}
+
+void ConcurrentPerformanceTimer::startTiming(Handle handle)
+{
+    if (Slot *slot = slotFor(handle))
+    {
+        slot->start = PerfTimeNanos();
+    }
+}
+
+void ConcurrentPerformanceTimer::stopTiming(Handle handle)
+{
+    const int64_t now = PerfTimeNanos();
+
+    Slot *slot = slotFor(handle);
+    if (!slot || slot->start == 0)
+    {
+        return;
+    }
+    const int64_t start = slot->start;
+    slot->start = 0;
+
+    addValue(handle,now - start);
+}
+
+void ConcurrentPerformanceTimer::addTime(Handle handle,TimeInterval dur)
+{
+    addValue(handle,(int64_t)(dur * 1e9));
+}
+
+void ConcurrentPerformanceTimer::addCount(Handle handle,int count)
+{
+    addValue(handle,count);
+}
+
+void ConcurrentPerformanceTimer::gather(Handle handle,int64_t &num,int64_t &total,int64_t &minVal,int64_t &maxVal) const
+{
+    num = 0;  total = 0;  minVal = 0;  maxVal = 0;
+    if (handle < 0 || handle >= maxHandles)
+    {
+        return;
+    }
+
+    const uint32_t curGen = generation.load(std::memory_order_acquire);
+    for (const auto &slots : allThreadSlots)
+    {
+        const Slot &slot = slots[handle];
+        if (slot.generation.load(std::memory_order_acquire) != curGen)
+        {
+            continue;
+        }
+        const int64_t slotNum = slot.num.load(std::memory_order_acquire);
+        if (slotNum == 0)
+        {
+            continue;
         }
+        const int64_t slotMin = slot.minVal.load(std::memory_order_relaxed);
+        const int64_t slotMax = slot.maxVal.load(std::memory_order_relaxed);
+        minVal = (num == 0) ? slotMin : std::min(minVal,slotMin);
+        maxVal = (num == 0) ? slotMax : std::max(maxVal,slotMax);
+        total += slot.total.load(std::memory_order_relaxed);
+        num += slotNum;
+    }
+}
+
+PerformanceTimer::TimeEntry ConcurrentPerformanceTimer::getTiming(Handle handle) const
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+
+    PerformanceTimer::TimeEntry entry;
+    if (handle < 0 || handle >= (Handle)names.size())
+    {
+        return entry;
+    }
+
+    int64_t num,total,minVal,maxVal;
+    gather(handle,num,total,minVal,maxVal);
+    entry.name = names[handle];
+    entry.numRuns = (int)num;
+    if (num > 0)
+    {
+        // avgDur is a running total, as in PerformanceTimer
+        entry.minDur = minVal * 1e-9;
+        entry.maxDur = maxVal * 1e-9;
+        entry.avgDur = total * 1e-9;
+    }
+    return entry;
+}
+
+PerformanceTimer::CountEntry ConcurrentPerformanceTimer::getCount(Handle handle) const
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+
+    PerformanceTimer::CountEntry entry;
+    if (handle < 0 || handle >= (Handle)names.size())
+    {
+        return entry;
+    }
+
+    int64_t num,total,minVal,maxVal;
+    gather(handle,num,total,minVal,maxVal);
+    entry.name = names[handle];
+    entry.numRuns = (int)num;
+    if (num > 0)
+    {
+        entry.minCount = (int)minVal;
+        entry.maxCount = (int)maxVal;
+        entry.avgCount = (int)total;
+    }
+    return entry;
+}
+
+void ConcurrentPerformanceTimer::clear()
+{
+    // Writers notice and reset their own slots
+    generation.fetch_add(1,std::memory_order_acq_rel);
+}
+
+void ConcurrentPerformanceTimer::log(double min) const
+{
+    std::vector<PerformanceTimer::TimeEntry> timeEntries;
+    std::vector<PerformanceTimer::CountEntry> countEntries;
+
+    std::vector<bool> counts;
+    {
+        std::lock_guard<std::mutex> guardLock(lock);
+        counts = isCount;
+    }
+    for (Handle handle = 0; handle < (Handle)counts.size(); handle++)
+    {
+        if (counts[handle])
+        {
+            countEntries.push_back(getCount(handle));
+        }
+        else
+        {
+            timeEntries.push_back(getTiming(handle));
+        }
+    }
+
+    LogEntries(timeEntries,countEntries,min);
+}
+    
+// Tile identifiers are packed into one word: level+1 (so -1 fits), then x and y
+static inline uint64_t PackIdent(const QuadTreeIdentifier &ident)
+{
+    return ((uint64_t)(ident.level + 1) & 0xff) << 56 |
+           ((uint64_t)ident.x & 0xfffffff) << 28 |
+           ((uint64_t)ident.y & 0xfffffff);
+}
+
+static inline QuadTreeIdentifier UnpackIdent(uint64_t packed)
+{
+    return QuadTreeIdentifier((int)((packed >> 28) & 0xfffffff),
+                              (int)(packed & 0xfffffff),
+                              (int)((packed >> 56) & 0xff) - 1);
+}
+
+// Small number for the current thread, easier to read in a trace than the real ID
+static int TracerThreadNumber()
+{
+    static std::atomic<int> nextThread = {1};
+    static thread_local const int thread = nextThread++;
+    return thread;
+}
+
+TileLoadTracer::TileLoadTracer(size_t inCapacity)
+{
+    capacity = 1;
+    while (capacity < std::max((size_t)2, inCapacity))
+    {
+        capacity <<= 1;
+    }
+    slots.reset(new Slot[capacity]);
+}
+
+TileLoadTracer &TileLoadTracer::shared()
+{
+    static TileLoadTracer tracer;
+    return tracer;
+}
+
+int64_t TileLoadTracer::now()
+{
+    return PerfTimeNanos();
+}
+
+void TileLoadTracer::record(TileLoadStage stage,const QuadTreeIdentifier &ident,int frame,int64_t startNanos,int64_t endNanos)
+{
+    const uint64_t which = next.fetch_add(1, std::memory_order_relaxed);
+    Slot &slot = slots[which & (capacity - 1)];
+
+    // Odd while we're writing, even once it's done, and unique to this pass through the buffer
+    slot.seq.store(2 * which + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    slot.ident.store(PackIdent(ident), std::memory_order_relaxed);
+    slot.info.store((uint64_t)(uint32_t)frame | (uint64_t)stage << 32 | (uint64_t)TracerThreadNumber() << 40,
+                    std::memory_order_relaxed);
+    slot.startNanos.store(startNanos, std::memory_order_relaxed);
+    slot.endNanos.store(endNanos, std::memory_order_relaxed);
+
+    slot.seq.store(2 * which + 2, std::memory_order_release);
+}
+
+std::vector<TileLoadTracer::Record> TileLoadTracer::getRecords() const
+{
+    const uint64_t end = next.load(std::memory_order_acquire);
+    const uint64_t begin = std::max(cleared.load(std::memory_order_relaxed),
+                                    (end > capacity) ? end - capacity : 0);
+
+    std::vector<Record> records;
+    records.reserve(end - std::min(begin, end));
+    for (uint64_t which = begin; which < end; which++)
+    {
+        const Slot &slot = slots[which & (capacity - 1)];
+
+        // Skip it if it's still being written or has already been overwritten
+        const uint64_t seq = slot.seq.load(std::memory_order_acquire);
+        if (seq != 2 * which + 2)
+        {
+            continue;
+        }
+
+        const uint64_t ident = slot.ident.load(std::memory_order_relaxed);
+        const uint64_t info = slot.info.load(std::memory_order_relaxed);
+        const int64_t startNanos = slot.startNanos.load(std::memory_order_relaxed);
+        const int64_t endNanos = slot.endNanos.load(std::memory_order_relaxed);
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.seq.load(std::memory_order_relaxed) != seq)
+        {
+            continue;
+        }
+
+        records.push_back(Record {
+            UnpackIdent(ident),
+            (int)(int32_t)(uint32_t)info,
+            (TileLoadStage)((info >> 32) & 0xff),
+            (int)(info >> 40),
+            startNanos,
+            endNanos
+        });
+    }
+
+    return records;
+}
+
+std::vector<TileLoadTracer::StageStats> TileLoadTracer::getStageStats() const
+{
+    std::vector<std::vector<TimeInterval>> durs(TileLoadStageMax);
+    for (const auto &rec : getRecords())
+    {
+        if (rec.stage < TileLoadStageMax)
+        {
+            durs[rec.stage].push_back((rec.endNanos - rec.startNanos) / 1.0e9);
+        }
+    }
+
+    std::vector<StageStats> allStats;
+    for (int ii=0;ii<TileLoadStageMax;ii++)
+    {
+        auto &stageDurs = durs[ii];
+        if (stageDurs.empty())
+        {
+            continue;
+        }
+        std::sort(stageDurs.begin(), stageDurs.end());
+
+        // Nearest rank
+        const auto percentile = [&](double frac)
+        {
+            const size_t rank = (size_t)std::ceil(frac * stageDurs.size());
+            return stageDurs[std::min(stageDurs.size(), std::max((size_t)1, rank)) - 1];
+        };
+
+        StageStats stats;
+        stats.stage = (TileLoadStage)ii;
+        stats.count = (int)stageDurs.size();
+        stats.p50 = percentile(0.50);
+        stats.p95 = percentile(0.95);
+        stats.p99 = percentile(0.99);
+        stats.maxDur = stageDurs.back();
+        for (const auto dur : stageDurs)
+        {
+            stats.avgDur += dur;
+        }
+        stats.avgDur /= stageDurs.size();
+        allStats.push_back(stats);
+    }
+
+    return allStats;
+}
+
+std::string TileLoadTracer::getChromeTrace() const
+{
+    const auto records = getRecords();
+    int64_t base = 0;
+    for (const auto &rec : records)
+    {
+        base = (base == 0) ? rec.startNanos : std::min(base, rec.startNanos);
+    }
+
+    std::string json = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    char event[512];
+    bool first = true;
+    for (const auto &rec : records)
+    {
+        // Complete events, with times in microseconds
+        int len = snprintf(event, sizeof(event),
+                           "%s{\"name\":\"%s\",\"cat\":\"tile\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%d",
+                           first ? "" : ",", stageName(rec.stage),
+                           (rec.startNanos - base) / 1000.0, (rec.endNanos - rec.startNanos) / 1000.0, rec.thread);
+        if (rec.ident.level >= 0)
+        {
+            len += snprintf(event + len, sizeof(event) - len,
+                            ",\"args\":{\"tile\":\"%d/%d/%d\",\"frame\":%d}",
+                            rec.ident.level, rec.ident.x, rec.ident.y, rec.frame);
+        }
+        snprintf(event + len, sizeof(event) - len, "}");
+        json += event;
+        first = false;
+    }
+    json += "]}";
+
+    return json;
+}
+
+void TileLoadTracer::log() const
+{
+    for (const auto &stats : getStageStats())
+    {
+        wkLogLevel(Verbose,"Maply Tile Loading: %s: p50, p95, p99, max = (%.3f, %.3f, %.3f, %.3f) ms, mean %.4f ms, %d records",
+                   stageName(stats.stage), 1000*stats.p50, 1000*stats.p95, 1000*stats.p99,
+                   1000*stats.maxDur, 1000*stats.avgDur, stats.count);
+    }
+}
+
+void TileLoadTracer::clear()
+{
+    cleared.store(next.load(std::memory_order_acquire), std::memory_order_relaxed);
+}
+
+const char *TileLoadTracer::stageName(TileLoadStage stage)
+{
+    switch (stage)
+    {
+        case TileLoadStageFetchQueue:   return "Fetch Queue";
+        case TileLoadStageFetch:        return "Fetch";
+        case TileLoadStageDecompress:   return "Decompress";
+        case TileLoadStageParse:        return "Parse";
+        case TileLoadStageBuildStyle:   return "Build Style";
+        case TileLoadStageMerge:        return "Merge";
+        case TileLoadStageSceneChanges: return "Scene Changes";
+        default:                        return "Unknown";
     }
 }
     
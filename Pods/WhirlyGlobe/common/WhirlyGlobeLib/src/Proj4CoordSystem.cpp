@@ -199,6 +199,93 @@ Point3d Proj4CoordSystem::geocentricToLocal(const Point3d &geocPt) const
     return {x,y,z};
 }
 
+namespace {
+// Coordinates for a whole array, laid out for pj_transform
+struct Proj4Batch
+{
+    Proj4Batch(size_t numPts) : x(numPts), y(numPts), z(numPts, 0.0) { }
+
+    // Run everything through proj.4 at once.
+    // With more than one point, proj.4 marks the ones it can't convert with HUGE_VAL and keeps going.
+    // If it gives up on the whole batch instead, we return false and the caller goes one at a time.
+    bool transform(void *src,void *dst)
+    {
+        if (x.empty())
+            return true;
+        const auto result = pj_transform(src, dst, (long)x.size(), 1, x.data(), y.data(), z.data());
+        return result == 0 || result == PJ_ERR_BOUNDS;
+    }
+
+    bool valid(size_t ii) const { return x[ii] != HUGE_VAL && y[ii] != HUGE_VAL; }
+
+    std::vector<double> x,y,z;
+};
+}
+
+void Proj4CoordSystem::localToGeographicArray(const Point3d *pts,Point2d *outPts,size_t numPts) const
+{
+    Proj4Batch batch(numPts);
+    for (size_t ii=0;ii<numPts;ii++)
+    {
+        batch.x[ii] = pts[ii].x();  batch.y[ii] = pts[ii].y();  batch.z[ii] = pts[ii].z();
+    }
+    if (!batch.transform(pj, pj_latlon))
+    {
+        CoordSystem::localToGeographicArray(pts, outPts, numPts);
+        return;
+    }
+    for (size_t ii=0;ii<numPts;ii++)
+        outPts[ii] = batch.valid(ii) ? Point2d(batch.x[ii],batch.y[ii]) : Point2d(0,0);
+}
+
+void Proj4CoordSystem::geographicToLocalArray(const Point2d *pts,Point3d *outPts,size_t numPts) const
+{
+    Proj4Batch batch(numPts);
+    for (size_t ii=0;ii<numPts;ii++)
+    {
+        batch.x[ii] = pts[ii].x();  batch.y[ii] = pts[ii].y();
+    }
+    if (!batch.transform(pj_latlon, pj))
+    {
+        CoordSystem::geographicToLocalArray(pts, outPts, numPts);
+        return;
+    }
+    for (size_t ii=0;ii<numPts;ii++)
+        outPts[ii] = batch.valid(ii) ? Point3d(batch.x[ii],batch.y[ii],batch.z[ii]) : Point3d(0,0,0);
+}
+
+void Proj4CoordSystem::localToGeocentricArray(const Point3d *pts,Point3d *outPts,size_t numPts) const
+{
+    Proj4Batch batch(numPts);
+    for (size_t ii=0;ii<numPts;ii++)
+    {
+        batch.x[ii] = pts[ii].x();  batch.y[ii] = pts[ii].y();  batch.z[ii] = pts[ii].z();
+    }
+    if (!batch.transform(pj, pj_geocentric))
+    {
+        CoordSystem::localToGeocentricArray(pts, outPts, numPts);
+        return;
+    }
+    for (size_t ii=0;ii<numPts;ii++)
+        outPts[ii] = batch.valid(ii) ? Point3d(batch.x[ii],batch.y[ii],batch.z[ii]) : Point3d(0,0,0);
+}
+
+void Proj4CoordSystem::geocentricToLocalArray(const Point3d *pts,Point3d *outPts,size_t numPts) const
+{
+    Proj4Batch batch(numPts);
+    for (size_t ii=0;ii<numPts;ii++)
+    {
+        batch.x[ii] = pts[ii].x();  batch.y[ii] = pts[ii].y();  batch.z[ii] = pts[ii].z();
+    }
+    if (!batch.transform(pj_geocentric, pj))
+    {
+        CoordSystem::geocentricToLocalArray(pts, outPts, numPts);
+        return;
+    }
+    for (size_t ii=0;ii<numPts;ii++)
+        outPts[ii] = batch.valid(ii) ? Point3d(batch.x[ii],batch.y[ii],batch.z[ii]) : Point3d(0,0,0);
+}
+
 bool Proj4CoordSystem::isSameAs(const CoordSystem *coordSys) const
 {
     const auto other = dynamic_cast<const Proj4CoordSystem *>(coordSys);
@@ -41,6 +41,9 @@ QuadDisplayControllerNew::QuadDisplayControllerNew(QuadDataStructure *dataStruct
     {
         zoomSlot = scene->retainZoomSlot();
     }
+
+    // We'll decide when the importance values are out of date
+    keepImportanceMemo = true;
 }
 
 Scene *QuadDisplayControllerNew::getScene() const
@@ -106,7 +109,43 @@ std::vector<int> QuadDisplayControllerNew::getLevelLoads() const
 
 void QuadDisplayControllerNew::setMBRScaling(double newScale)
 {
-    mbrScaling = newScale;
+    if (newScale != mbrScaling)
+    {
+        mbrScaling = newScale;
+        clearImportanceMemo();
+        importanceViewState.reset();
+    }
+}
+
+void QuadDisplayControllerNew::setImportanceHysteresis(double relative,double absolute)
+{
+    importanceChangeRelative = std::max(0.0, relative);
+    importanceChangeAbsolute = std::max(0.0, absolute);
+}
+
+void QuadDisplayControllerNew::setPrefetch(TimeInterval lookAhead,int newMaxTiles)
+{
+    prefetchTime = std::max(0.0, lookAhead);
+    prefetchMaxTiles = std::max(0, newMaxTiles);
+    updatePredictions();
+}
+
+void QuadDisplayControllerNew::updatePredictions()
+{
+    const bool wantPredictions = running && prefetchTime > 0.0 && prefetchMaxTiles > 0;
+    if (wantPredictions && !predictionView)
+    {
+        predictionView = renderer ? renderer->getView() : nullptr;
+        if (predictionView)
+        {
+            predictionView->retainPredictions();
+        }
+    }
+    else if (!wantPredictions && predictionView)
+    {
+        predictionView->releasePredictions();
+        predictionView = nullptr;
+    }
 }
 
 void QuadDisplayControllerNew::setLevelLoads(const std::vector<int> &newLoads)
@@ -155,11 +194,18 @@ void QuadDisplayControllerNew::start()
 {
     loader->setController(this);
     running = true;
+    updatePredictions();
 }
 
 void QuadDisplayControllerNew::stop(PlatformThreadInfo *threadInfo,ChangeSet &changes)
 {
     running = false;
+    updatePredictions();
+    if (lastPrefetchTiles > 0)
+    {
+        loader->quadLoaderPrefetch(threadInfo, QuadTreeNew::ImportantNodeSet());
+        lastPrefetchTiles = 0;
+    }
     scene->releaseZoomSlot(zoomSlot);
     loader->quadLoaderShutdown(threadInfo,changes);
     dataStructure = nullptr;
@@ -185,6 +231,23 @@ bool QuadDisplayControllerNew::viewUpdate(PlatformThreadInfo *threadInfo,const V
         return true;
     }
 
+    // Tile importance only depends on the view, so if it hasn't moved we can keep
+    //  the values from last time.  This happens when we're asked to check back.
+    // If it has moved, the data structure may know some that stay the same.
+    const Point2f frameSize = renderer->getFramebufferSize();
+    if (!importanceViewState || frameSize != importanceFrameSize || viewState->fullMatrices.empty() ||
+        importanceViewState->fullMatrices.size() != viewState->fullMatrices.size())
+    {
+        clearImportanceMemo();
+        importanceViewState = viewState;
+        importanceFrameSize = frameSize;
+    }
+    else if (!importanceViewState->isSameAs(viewState.get()))
+    {
+        keepUnchangedImportance(importanceViewState,frameSize);
+        importanceViewState = viewState;
+    }
+
     // We may want to force the min level in, always
     // Or we may vary that by height
     bool localKeepMinLevel = keepMinLevel;
@@ -227,54 +290,71 @@ bool QuadDisplayControllerNew::viewUpdate(PlatformThreadInfo *threadInfo,const V
 //        wkLogLevel(Debug," %d: (%d,%d), import = %f",node.level,node.x,node.y,node.importance);
 //    }
     
-    QuadTreeNew::ImportantNodeSet toAdd,toUpdate;
-    QuadTreeNew::NodeSet toRemove;
-    
-    // Need a version of new and old that has no importance values, since those change
-    QuadTreeNew::NodeSet testNewNodes;
-    for (const auto &node : newNodes)
-    {
-        testNewNodes.insert(node);
-    }
+    // Importance values change, so we're just comparing the nodes
+    const QuadTreeNew::CoverageSet newCoverage(newNodes);
 
-    QuadTreeNew::NodeSet testCurrentNodes;
-    for (const auto &node : currentNodes)
-    {
-        testCurrentNodes.insert(node);
-    }
-    
-    // Nodes to remove
-    for (const auto &node : currentNodes)
+    // If the view is animating somewhere predictable, get a head start on the tiles there.
+    // These are kept out of the coverage, so they're only fetched, not loaded or displayed.
+    QuadTreeNew::ImportantNodeSet prefetchNodes;
+    if (prefetchTime > 0.0 && prefetchMaxTiles > 0 && viewState->predictor)
     {
-        if (testNewNodes.find(node) == testNewNodes.end())
+        prefetchNodes = calcPrefetchNodes(newCoverage, localKeepMinLevel);
+        if (!running)
         {
-            toRemove.insert(node);
+            return false;
         }
     }
 
-    // Nodes to add and nodes to update importance for
-    for (const auto &node : newNodes)
+    QuadTreeNew::CoverageSet toAdd,toRemove,toKeep;
+    QuadTreeNew::CoverageSet::diff(currentNodes, newCoverage, toAdd, toRemove, toKeep);
+
+    // Only pass along the importance changes big enough to matter.
+    // For the rest we remember the old value, so small changes can add up.
+    QuadTreeNew::CoverageSet toUpdate,nextNodes;
+    toUpdate.reserve(toKeep.size());
+    nextNodes.reserve(newCoverage.size());
+    lastUpdatesSent = 0;
+    lastUpdatesSuppressed = 0;
+    for (const auto &node : toKeep)
     {
-        if (testCurrentNodes.find(node) == testCurrentNodes.end())
+        const QuadTreeNew::ImportantNode *oldNode = currentNodes.find(node);
+        const double oldImport = oldNode ? oldNode->importance : 0.0;
+        const double delta = std::abs(node.importance - oldImport);
+        if (!oldNode || (delta > importanceChangeAbsolute && delta > importanceChangeRelative * std::abs(oldImport)))
         {
-            toAdd.insert(node);
+            toUpdate.add(node);
+            nextNodes.add(node);
+            lastUpdatesSent++;
         }
-        else    // todo: test whether the importance value actually changed?
+        else
         {
-            toUpdate.insert(node);
+            nextNodes.add(*oldNode);
+            lastUpdatesSuppressed++;
         }
     }
+    for (const auto &node : toAdd)
+    {
+        nextNodes.add(node);
+    }
     
     const QuadTreeNew::NodeSet removesToKeep =
         loader->quadLoaderUpdate(threadInfo, toAdd, toRemove, toUpdate, targetLevel, changes);
 
+    // An empty set cancels the last one, once the view settles down
+    if (!prefetchNodes.empty() || lastPrefetchTiles > 0)
+    {
+        loader->quadLoaderPrefetch(threadInfo, prefetchNodes);
+    }
+    lastPrefetchTiles = (int)prefetchNodes.size();
+
     const bool needsDelayCheck = !removesToKeep.empty();
     
-    currentNodes = newNodes;
     for (const auto &node : removesToKeep)
     {
-        currentNodes.emplace(node,0.0);
+        nextNodes.add(QuadTreeNew::ImportantNode(node,0.0));
     }
+    nextNodes.finish();
+    currentNodes = std::move(nextNodes);
 
     // If we're at the max level, we may want to reach beyond
     int testTargetLevel = targetLevel;
@@ -313,6 +393,47 @@ bool QuadDisplayControllerNew::viewUpdate(PlatformThreadInfo *threadInfo,const V
     return needsDelayCheck;
 }
     
+QuadTreeNew::ImportantNodeSet QuadDisplayControllerNew::calcPrefetchNodes(const QuadTreeNew::CoverageSet &coverage,bool localKeepMinLevel)
+{
+    const ViewStateRef futureViewState = viewState->predictor(TimeGetCurrent() + prefetchTime);
+    if (!futureViewState)
+    {
+        return QuadTreeNew::ImportantNodeSet();
+    }
+
+    // Evaluate the tree from there, setting aside the importance values for the current view
+    const ViewStateRef curViewState = viewState;
+    std::unordered_map<int64_t,double> curImportance;
+    std::swap(curImportance, importanceMemo);
+    viewState = futureViewState;
+
+    QuadTreeNew::ImportantNodeSet futureNodes;
+    std::vector<double> maxRejectedImport(std::max(reportedMaxZoom, maxLevel) + 1,0.0);
+    if (singleLevel)
+    {
+        futureNodes = std::get<1>(calcCoverageVisible(minImportancePerLevel, maxTiles, levelLoads, localKeepMinLevel, maxRejectedImport));
+    }
+    else
+    {
+        futureNodes = calcCoverageImportance(minImportancePerLevel, maxTiles, true, maxRejectedImport);
+    }
+
+    viewState = curViewState;
+    std::swap(curImportance, importanceMemo);
+
+    // Take the most important ones we don't already have
+    QuadTreeNew::ImportantNodeSet prefetchNodes;
+    for (auto it = futureNodes.rbegin(); it != futureNodes.rend() && prefetchNodes.size() < prefetchMaxTiles; ++it)
+    {
+        if (!coverage.contains(*it))
+        {
+            prefetchNodes.insert(*it);
+        }
+    }
+
+    return prefetchNodes;
+}
+
 void QuadDisplayControllerNew::preSceneFlush(ChangeSet &changes)
 {
     loader->quadLoaderPreSceenFlush(changes);
@@ -321,7 +442,7 @@ void QuadDisplayControllerNew::preSceneFlush(ChangeSet &changes)
 // MARK: QuadTreeNew methods
     
 // Calculate importance for a given node
-double QuadDisplayControllerNew::importance(const Node &node)
+bool QuadDisplayControllerNew::importanceMbrForNode(const Node &node,Mbr &nodeMbr) const
 {
     MbrD nodeMbrD = generateMbrForNode(node);
 
@@ -329,9 +450,15 @@ double QuadDisplayControllerNew::importance(const Node &node)
     if (mbrScaling != 1.0)
         nodeMbrD.expandByFraction(mbrScaling-1.0);
 
-    const Mbr nodeMbr(nodeMbrD);
+    nodeMbr = Mbr(nodeMbrD);
     // Is this a valid tile?
-    if (!nodeMbr.inside(nodeMbr.mid())) {
+    return nodeMbr.inside(nodeMbr.mid());
+}
+
+double QuadDisplayControllerNew::importance(const Node &node)
+{
+    Mbr nodeMbr;
+    if (!importanceMbrForNode(node,nodeMbr)) {
         return -1.0;
     }
     
@@ -340,6 +467,83 @@ double QuadDisplayControllerNew::importance(const Node &node)
     return dataStructure->importanceForTile(ident, nodeMbr, viewState, renderer->getFramebufferSize());
 }
 
+void QuadDisplayControllerNew::importanceForNodes(const std::vector<Node> &nodes,std::vector<double> &results)
+{
+    results.resize(nodes.size());
+
+    // Invalid tiles are settled here, the rest go to the data structure together
+    std::vector<size_t> which;
+    std::vector<QuadTreeIdentifier> idents;
+    std::vector<Mbr> mbrs;
+    which.reserve(nodes.size());
+    idents.reserve(nodes.size());
+    mbrs.reserve(nodes.size());
+    for (size_t ii=0;ii<nodes.size();ii++)
+    {
+        const Node &node = nodes[ii];
+        Mbr nodeMbr;
+        if (!importanceMbrForNode(node,nodeMbr)) {
+            results[ii] = -1.0;
+            continue;
+        }
+
+        which.push_back(ii);
+        idents.emplace_back(node.x, node.y, node.level);
+        mbrs.push_back(nodeMbr);
+    }
+
+    if (which.empty())
+    {
+        return;
+    }
+
+    std::vector<double> tileImport;
+    dataStructure->importanceForTiles(idents, mbrs, viewState, renderer->getFramebufferSize(), tileImport);
+    for (size_t ii=0;ii<which.size();ii++)
+    {
+        results[which[ii]] = tileImport[ii];
+    }
+}
+
+void QuadDisplayControllerNew::keepUnchangedImportance(const ViewStateRef &oldViewState,const Point2f &frameSize)
+{
+    // Invalid tiles stay invalid, the rest are up to the data structure
+    std::vector<int64_t> nodeNums;
+    std::vector<QuadTreeIdentifier> idents;
+    std::vector<Mbr> mbrs;
+    nodeNums.reserve(importanceMemo.size());
+    idents.reserve(importanceMemo.size());
+    mbrs.reserve(importanceMemo.size());
+    for (const auto &it : importanceMemo)
+    {
+        if (it.second < 0.0)
+        {
+            continue;
+        }
+
+        const QuadTreeIdentifier ident = QuadTreeIdentifier::FromNodeNumber(it.first);
+        Mbr nodeMbr;
+        importanceMbrForNode(ident,nodeMbr);
+        nodeNums.push_back(it.first);
+        idents.push_back(ident);
+        mbrs.push_back(nodeMbr);
+    }
+    if (nodeNums.empty())
+    {
+        return;
+    }
+
+    std::vector<bool> unchanged;
+    dataStructure->importanceUnchanged(idents, mbrs, oldViewState, viewState, frameSize, unchanged);
+    for (size_t ii=0;ii<nodeNums.size();ii++)
+    {
+        if (!unchanged[ii])
+        {
+            importanceMemo.erase(nodeNums[ii]);
+        }
+    }
+}
+
 // Pure visibility check
 bool QuadDisplayControllerNew::visible(const Node &node) {
     MbrD nodeMbrD = generateMbrForNode(node);
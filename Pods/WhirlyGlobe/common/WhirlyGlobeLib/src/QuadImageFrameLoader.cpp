@@ -18,6 +18,7 @@
 
 #import "QuadImageFrameLoader.h"
 #import "BasicDrawableInstanceBuilder.h"
+#import "PerformanceTimer.h"
 #import "WhirlyKitLog.h"
 
 #import <array>
@@ -49,6 +50,10 @@ void QIFFrameAsset::clear(PlatformThreadInfo *threadInfo,QuadImageFrameLoader *l
     if (loadReturnRef)
     {
         loadReturnRef->cancel = true;
+        if (loader && loader->getDecodeQueue())
+        {
+            loader->getDecodeQueue()->cancel(loadReturnRef.get());
+        }
         loadReturnRef.reset();
     }
 
@@ -65,6 +70,12 @@ bool QIFFrameAsset::updateFetching(PlatformThreadInfo *threadInfo,QuadImageFrame
         return false;
     priority = newPriority;
     importance = newImportance;
+
+    // Might be waiting to be decoded too
+    if (loadReturnRef && loader && loader->getDecodeQueue())
+    {
+        loader->getDecodeQueue()->updatePriority(loadReturnRef.get(), priority, importance);
+    }
     
     return true;
 }
@@ -72,6 +83,16 @@ bool QIFFrameAsset::updateFetching(PlatformThreadInfo *threadInfo,QuadImageFrame
 void QIFFrameAsset::cancelFetch(PlatformThreadInfo *threadInfo,QuadImageFrameLoader *loader,QIFBatchOps *batchOps)
 {
     state = Empty;
+
+    // Data that's already come back shouldn't be decoded
+    if (loadReturnRef)
+    {
+        loadReturnRef->cancel = true;
+        if (loader && loader->getDecodeQueue())
+        {
+            loader->getDecodeQueue()->cancel(loadReturnRef.get());
+        }
+    }
 }
 
 void QIFFrameAsset::loadSuccess(PlatformThreadInfo *threadInfo,QuadImageFrameLoader *loader,const std::vector<Texture *> &texs)
@@ -277,7 +298,18 @@ void QIFTileAsset::setupContents(QuadImageFrameLoader *loader,
 
             // Make a drawable instance to shadow the geometry
             auto drawInst = loader->getController()->getRenderer()->makeBasicDrawableInstanceBuilder(label);
-            drawInst->setMasterID(di.drawID, BasicDrawableInstance::ReuseStyle);
+            if (di.templateID != EmptyIdentity)
+            {
+                // Instance the shared mesh directly and put it where the tile is
+                drawInst->setMasterID(di.templateID, BasicDrawableInstance::ReuseStyle);
+                drawInst->setMatrix(di.templateMatrix());
+                drawInst->setLocalMbr(di.localMbr);
+                drawInst->setDrawOrder(di.drawOrder);
+            }
+            else
+            {
+                drawInst->setMasterID(di.drawID, BasicDrawableInstance::ReuseStyle);
+            }
             drawInst->setTexId(0, EmptyIdentity);
             if (loader->getNumFrames() > 1)
                 drawInst->setTexId(1, EmptyIdentity);
@@ -804,6 +836,25 @@ int QuadImageFrameLoader::calcLoadPriority(const QuadTreeNew::ImportantNode &ide
     
     return restPriority;
 }
+
+int QuadImageFrameLoader::calcPrefetchPriority() const
+{
+    return std::max({0, topPriority, nearFramePriority, restPriority}) + 1;
+}
+
+bool QuadImageFrameLoader::calcDecodePriority(const QuadLoaderReturn *loadReturn,int &priority,double &importance)
+{
+    const auto it = tiles.find(QuadTreeNew::Node(loadReturn->ident));
+    if (it == tiles.end())
+    {
+        return false;
+    }
+
+    const auto &ident = it->second->ident;
+    priority = calcLoadPriority(ident, loadReturn->getFrameIndex());
+    importance = ident.importance;
+    return true;
+}
     
 void QuadImageFrameLoader::setColor(const RGBAColor &inColor,ChangeSet *changes)
 {
@@ -1080,6 +1131,11 @@ void QuadImageFrameLoader::removeTile(PlatformThreadInfo *threadInfo,const QuadT
     
 void QuadImageFrameLoader::mergeLoadedTile(PlatformThreadInfo *threadInfo,QuadLoaderReturn *loadReturn,ChangeSet &changes)
 {
+    TileLoadTracer::Span traceSpan(TileLoadStageMerge, loadReturn->ident, loadReturn->getFrameIndex());
+
+    // It's out of the decode stage now, which can move on to the next one
+    loadReturn->decodeSlot.reset();
+
     changesSinceLastFlush = true;
 
     if (debugMode)
@@ -1402,8 +1458,8 @@ void QuadImageFrameLoader::setBuilder(QuadTileBuilder *inBuilder,QuadDisplayCont
 /// Before we tell the delegate to unload tiles, see if they want to keep them around
 /// Returns the tiles we want to preserve after all
 QuadTreeNew::NodeSet QuadImageFrameLoader::builderUnloadCheck(QuadTileBuilder *inBuilder,
-        const WhirlyKit::QuadTreeNew::ImportantNodeSet &loadTiles,
-        const WhirlyKit::QuadTreeNew::NodeSet &unloadTiles,
+        const WhirlyKit::QuadTreeNew::CoverageSet &loadTiles,
+        const WhirlyKit::QuadTreeNew::CoverageSet &unloadTiles,
         int inTargetLevel)
 {
     QuadTreeNew::NodeSet toKeep;
@@ -1427,7 +1483,7 @@ QuadTreeNew::NodeSet QuadImageFrameLoader::builderUnloadCheck(QuadTileBuilder *i
         auto parent = node;
         while (parent.level > 0) {
             parent.level -= 1; parent.x /= 2;  parent.y /= 2;
-            if (unloadTiles.find(parent) != unloadTiles.end())
+            if (unloadTiles.contains(parent))
             {
                 auto it = tiles.find(parent);
                 // Nail down the parent that's loaded, but don't care otherwise
@@ -1482,8 +1538,7 @@ void QuadImageFrameLoader::builderLoad(PlatformThreadInfo *threadInfo,
     if (!this->builder)
         return;
     
-    // Only handling loads and unloads for now
-    if (updates.loadTiles.empty() && updates.unloadTiles.empty())
+    if (updates.loadTiles.empty() && updates.unloadTiles.empty() && updates.changeTiles.empty())
         return;
     
     bool somethingChanged = false;
@@ -1515,7 +1570,14 @@ void QuadImageFrameLoader::builderLoad(PlatformThreadInfo *threadInfo,
         somethingChanged = true;
     }
     
-    // Note: Not processing changes in importance
+    // Pass changes in importance along to anything still fetching or decoding
+    for (const auto& inTile: updates.changeTiles) {
+        const auto it = tiles.find(inTile);
+        if (it == tiles.end())
+            continue;
+        
+        it->second->setImportance(threadInfo, this, inTile.importance);
+    }
 
     builderLoadAdditional(threadInfo, inBuilder, updates, changes);
 
@@ -1685,6 +1747,11 @@ void QuadImageFrameLoader::cleanup(PlatformThreadInfo *threadInfo,ChangeSet &cha
 
     processBatchOps(threadInfo,batchOps);
     delete batchOps;
+
+    if (decodeQueue)
+    {
+        decodeQueue->shutdown();
+    }
     
     compManager.reset();
 }
@@ -0,0 +1,244 @@
+/*  QuadLoaderDecodeQueue.cpp
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#import "QuadLoaderDecodeQueue.h"
+#import "WhirlyKitLog.h"
+#import <algorithm>
+
+namespace WhirlyKit
+{
+
+bool QuadLoaderDecodeQueue::Entry::operator < (const Entry &that) const
+{
+    if (priority != that.priority)
+        return priority < that.priority;
+    if (importance != that.importance)
+        return importance > that.importance;
+    return order < that.order;
+}
+
+QuadLoaderDecodeQueue::QuadLoaderDecodeQueue(int numThreads,int maxQueued,int maxUnmerged) :
+    maxQueued(std::max(1,maxQueued)),
+    maxUnmerged(std::max(1,maxUnmerged)),
+    state(std::make_shared<State>()),
+    numCancelled(0)
+{
+    if (numThreads <= 0)
+    {
+        numThreads = std::max(1, (int)std::thread::hardware_concurrency() - 1);
+    }
+
+    workers.reserve(numThreads);
+    for (int ii=0;ii<numThreads;ii++)
+    {
+        workers.emplace_back(&QuadLoaderDecodeQueue::workerMain, this);
+    }
+}
+
+QuadLoaderDecodeQueue::~QuadLoaderDecodeQueue()
+{
+    shutdown();
+
+    for (auto &worker : workers)
+    {
+        // A task may have let go of the last reference to us
+        if (worker.get_id() == std::this_thread::get_id())
+        {
+            worker.detach();
+        }
+        else
+        {
+            worker.join();
+        }
+    }
+}
+
+void QuadLoaderDecodeQueue::addTask(const QuadLoaderReturnRef &loadReturn,int priority,double importance,Task task)
+{
+    if (!loadReturn || !task)
+    {
+        return;
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(state->lock);
+        state->spaceReady.wait(lock, [&]{ return state->stopping || state->waiting.size() < (size_t)maxQueued; });
+
+        if (!state->stopping)
+        {
+            Entry entry { loadReturn, priority, importance, state->nextOrder++, std::move(task) };
+            if (loadReturn->cancel)
+            {
+                state->cancelled.push_back(std::move(entry));
+            }
+            else
+            {
+                state->waiting.push_back(std::move(entry));
+            }
+            lock.unlock();
+            state->workReady.notify_one();
+            return;
+        }
+    }
+
+    // Shutting down, so it's not going anywhere
+    loadReturn->cancel = true;
+    task();
+}
+
+void QuadLoaderDecodeQueue::updatePriority(const QuadLoaderReturn *loadReturn,int priority,double importance)
+{
+    std::lock_guard<std::mutex> guardLock(state->lock);
+    for (auto &entry : state->waiting)
+    {
+        if (entry.loadReturn.get() == loadReturn)
+        {
+            entry.priority = priority;
+            entry.importance = importance;
+            break;
+        }
+    }
+}
+
+void QuadLoaderDecodeQueue::cancel(const QuadLoaderReturn *loadReturn)
+{
+    {
+        std::lock_guard<std::mutex> guardLock(state->lock);
+        const auto it = std::find_if(state->waiting.begin(), state->waiting.end(),
+                                     [&](const Entry &entry){ return entry.loadReturn.get() == loadReturn; });
+        if (it == state->waiting.end())
+        {
+            return;
+        }
+        state->cancelled.push_back(std::move(*it));
+        state->waiting.erase(it);
+    }
+    numCancelled++;
+    state->workReady.notify_one();
+    state->spaceReady.notify_one();
+}
+
+void QuadLoaderDecodeQueue::shutdown()
+{
+    size_t count = 0;
+    {
+        std::lock_guard<std::mutex> guardLock(state->lock);
+        if (state->stopping)
+        {
+            return;
+        }
+        state->stopping = true;
+
+        count = state->waiting.size();
+        for (auto &entry : state->waiting)
+        {
+            entry.loadReturn->cancel = true;
+            state->cancelled.push_back(std::move(entry));
+        }
+        state->waiting.clear();
+    }
+    numCancelled += count;
+    state->workReady.notify_all();
+    state->spaceReady.notify_all();
+}
+
+int QuadLoaderDecodeQueue::getNumQueued() const
+{
+    std::lock_guard<std::mutex> guardLock(state->lock);
+    return (int)(state->waiting.size() + state->cancelled.size());
+}
+
+int QuadLoaderDecodeQueue::getNumUnmerged() const
+{
+    std::lock_guard<std::mutex> guardLock(state->lock);
+    return state->numUnmerged;
+}
+
+void QuadLoaderDecodeQueue::workerMain()
+{
+    // Hold on to what we need, we might outlive the queue if it's destroyed by a task
+    const StateRef theState = state;
+    const int limit = maxUnmerged;
+
+    std::unique_lock<std::mutex> lock(theState->lock);
+    while (true)
+    {
+        theState->workReady.wait(lock, [&]{
+            return theState->stopping || !theState->cancelled.empty() ||
+                   (!theState->waiting.empty() && theState->numUnmerged < limit);
+        });
+
+        Entry entry;
+        bool takesSlot = false;
+        if (!theState->cancelled.empty())
+        {
+            // These just need to be passed along, so they don't count against the limit
+            entry = std::move(theState->cancelled.back());
+            theState->cancelled.pop_back();
+        }
+        else if (!theState->waiting.empty() && theState->numUnmerged < limit)
+        {
+            auto &waiting = theState->waiting;
+            const auto it = std::min_element(waiting.begin(), waiting.end());
+            entry = std::move(*it);
+            *it = std::move(waiting.back());
+            waiting.pop_back();
+
+            // Count it as unmerged until the return lets go of the slot
+            theState->numUnmerged++;
+            takesSlot = true;
+        }
+        else
+        {
+            // Nothing left to run and we've been told to stop
+            break;
+        }
+
+        lock.unlock();
+        theState->spaceReady.notify_one();
+
+        if (takesSlot)
+        {
+            entry.loadReturn->decodeSlot = std::shared_ptr<void>(nullptr, [theState](void *) {
+                {
+                    std::lock_guard<std::mutex> guardLock(theState->lock);
+                    theState->numUnmerged--;
+                }
+                theState->workReady.notify_one();
+            });
+        }
+
+        try
+        {
+            entry.task();
+        }
+        catch (const std::exception &ex)
+        {
+            wkLogLevel(Error, "Exception in QuadLoaderDecodeQueue task: %s", ex.what());
+        }
+        catch (...)
+        {
+            wkLogLevel(Error, "Exception in QuadLoaderDecodeQueue task");
+        }
+
+        // Let go of our references before we wait again
+        entry = Entry();
+        lock.lock();
+    }
+}
+
+}
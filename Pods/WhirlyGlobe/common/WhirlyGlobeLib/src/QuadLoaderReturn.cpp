@@ -43,6 +43,7 @@ void QuadLoaderReturn::clear()
     images.clear();
     compObjs.clear();
     ovlCompObjs.clear();
+    decodeSlot.reset();
     
     // Note: changes are not cleared, they have to be deleted and should be handled elsewhere
 }
@@ -22,6 +22,25 @@
 namespace WhirlyKit
 {
 
+// Keep at least this many display solids around, regardless of the tile limit
+static constexpr size_t DisplaySolidCacheMinSize = 1024;
+
+// One pool for all the samplers evaluating in parallel, kept while any of them are using it
+static WorkStealingPoolRef getCoveragePool()
+{
+    static std::mutex poolLock;
+    static std::weak_ptr<WorkStealingPool> sharedPool;
+
+    std::lock_guard<std::mutex> guardLock(poolLock);
+    auto pool = sharedPool.lock();
+    if (!pool)
+    {
+        pool = std::make_shared<WorkStealingPool>();
+        sharedPool = pool;
+    }
+    return pool;
+}
+
 void QuadSamplingController::start(const SamplingParams &inParams,Scene *inScene,SceneRenderer *inRenderer)
 {
     params = inParams;
@@ -33,6 +52,7 @@ void QuadSamplingController::start(const SamplingParams &inParams,Scene *inScene
     builder->setCoverPoles(params.coverPoles);
     builder->setEdgeMatching(params.edgeMatching);
     builder->setSingleLevel(params.singleLevel);
+    builder->setTemplateMeshes(params.templateMeshes);
     
     displayControl = std::make_shared<QuadDisplayControllerNew>(this,builder.get(),renderer);
     displayControl->setSingleLevel(params.singleLevel);
@@ -55,6 +75,16 @@ void QuadSamplingController::start(const SamplingParams &inParams,Scene *inScene
     displayControl->setMinImportancePerLevel(importance);
     displayControl->setMBRScaling(params.boundsScale);
     displayControl->setMaxTiles(params.maxTiles);
+    displayControl->setImportanceHysteresis(params.importanceChangeRelative,params.importanceChangeAbsolute);
+    displayControl->setPrefetch(params.prefetchTime,params.prefetchMaxTiles);
+
+    // Our importance and visibility checks are safe to run in parallel
+    coveragePool = params.parallelCoverage ? getCoveragePool() : nullptr;
+    displayControl->setEvalPool(coveragePool);
+
+    // The tile bounds depend on the parameters, so the solids we had may not match
+    displaySolids.clear();
+    displaySolids.setMaxEntries(std::max(DisplaySolidCacheMinSize, (size_t)params.maxTiles * 8));
 
     valid = true;
 }
@@ -70,6 +100,7 @@ void QuadSamplingController::stop()
     builderStarted = false;
     builder = nullptr;
     displayControl = nullptr;
+    coveragePool = nullptr;
     builderDelegates.clear();
 }
 
@@ -165,8 +196,88 @@ double QuadSamplingController::importanceForTile(const QuadTreeIdentifier &ident
         clippedMbr = mbr.intersect(params.clipBounds);
     }
     
+    DisplaySolidRef dispSolid = displaySolids.getSolid(ident, clippedMbr, params.coordSys.get(), coordAdapter);
     return ScreenImportance(viewState.get(), frameSize, viewState->eyeVec, 1,
-                 params.coordSys.get(), coordAdapter, clippedMbr, ident);
+                 params.coordSys.get(), coordAdapter, clippedMbr, ident, dispSolid);
+}
+
+void QuadSamplingController::importanceForTiles(const std::vector<QuadTreeIdentifier> &idents,
+                                                const std::vector<Mbr> &mbrs,
+                                                const ViewStateRef &viewState,
+                                                const Point2f &frameSize,
+                                                std::vector<double> &importance)
+{
+    const auto coordAdapter = scene->getCoordAdapter();
+    if (!coordAdapter)
+    {
+        importance.assign(idents.size(), MAXFLOAT);
+        return;
+    }
+
+    // Coverage may be running on several threads, each gets its own
+    static thread_local DisplaySolidBatch batch;
+    batch.clear();
+    for (size_t ii=0;ii<idents.size();ii++)
+    {
+        const QuadTreeIdentifier &ident = idents[ii];
+        // World spanning level 0 nodes sometimes have problems evaluating
+        if (params.minImportanceTop == 0.0 && ident.level == 0)
+        {
+            batch.addSolid(nullptr);
+            continue;
+        }
+
+        const Mbr clippedMbr = params.useClipBoundsForImportance ? mbrs[ii].intersect(params.clipBounds) : mbrs[ii];
+        batch.addSolid(displaySolids.getSolid(ident, clippedMbr, params.coordSys.get(), coordAdapter));
+    }
+
+    batch.importanceForViewState(viewState.get(), frameSize, importance);
+
+    for (size_t ii=0;ii<idents.size();ii++)
+    {
+        if (params.minImportanceTop == 0.0 && idents[ii].level == 0)
+        {
+            importance[ii] = MAXFLOAT;
+        }
+    }
+}
+
+void QuadSamplingController::importanceUnchanged(const std::vector<QuadTreeIdentifier> &idents,
+                                                 const std::vector<Mbr> &mbrs,
+                                                 const ViewStateRef &oldViewState,
+                                                 const ViewStateRef &newViewState,
+                                                 const Point2f &frameSize,
+                                                 std::vector<bool> &unchanged)
+{
+    unchanged.assign(idents.size(), false);
+
+    const auto coordAdapter = scene->getCoordAdapter();
+    if (!coordAdapter)
+    {
+        return;
+    }
+
+    const bool sameScale = ScreenScaleUnchanged(oldViewState.get(), newViewState.get());
+    for (size_t ii=0;ii<idents.size();ii++)
+    {
+        const QuadTreeIdentifier &ident = idents[ii];
+        // These don't depend on the view at all
+        if (params.minImportanceTop == 0.0 && ident.level == 0)
+        {
+            unchanged[ii] = true;
+            continue;
+        }
+        if (!sameScale)
+        {
+            continue;
+        }
+
+        const Mbr clippedMbr = params.useClipBoundsForImportance ? mbrs[ii].intersect(params.clipBounds) : mbrs[ii];
+        const DisplaySolidRef dispSolid = displaySolids.getSolid(ident, clippedMbr, params.coordSys.get(), coordAdapter);
+        unchanged[ii] = dispSolid && dispSolid->valid &&
+                        dispSolid->isEntirelyOnScreenForViewState(oldViewState.get()) &&
+                        dispSolid->isEntirelyOnScreenForViewState(newViewState.get());
+    }
 }
 
 void QuadSamplingController::newViewState(ViewStateRef viewState)
@@ -181,9 +292,10 @@ bool QuadSamplingController::visibilityForTile(const QuadTreeIdentifier &ident,
     if (ident.level == 0)
         return true;
     
-    DisplaySolidRef dispSolid;
+    const auto coordAdapter = scene->getCoordAdapter();
+    DisplaySolidRef dispSolid = displaySolids.getSolid(ident, mbr, params.coordSys.get(), coordAdapter);
     return TileIsOnScreen(viewState.get(), frameSize,  params.coordSys.get(),
-                          scene->getCoordAdapter(), mbr, ident, dispSolid);
+                          coordAdapter, mbr, ident, dispSolid);
 }
     
 /// **** QuadTileBuilderDelegate methods ****
@@ -207,8 +319,8 @@ void QuadSamplingController::setBuilder(QuadTileBuilder *inBuilder, QuadDisplayC
 }
     
 QuadTreeNew::NodeSet QuadSamplingController::builderUnloadCheck(QuadTileBuilder *inBuilder,
-                                        const WhirlyKit::QuadTreeNew::ImportantNodeSet &loadTiles,
-                                        const WhirlyKit::QuadTreeNew::NodeSet &unloadTiles,
+                                        const WhirlyKit::QuadTreeNew::CoverageSet &loadTiles,
+                                        const WhirlyKit::QuadTreeNew::CoverageSet &unloadTiles,
                                         int targetLevel)
 {
     QuadTreeNew::NodeSet toKeep;
@@ -254,6 +366,22 @@ void QuadSamplingController::builderLoad(PlatformThreadInfo *threadInfo,
     }
 }
     
+void QuadSamplingController::builderPrefetch(PlatformThreadInfo *threadInfo,
+                                             QuadTileBuilder *inBuilder,
+                                             const WhirlyKit::QuadTreeNew::ImportantNodeSet &tiles)
+{
+    std::vector<QuadTileBuilderDelegateRef> delegates;
+    {
+        std::lock_guard<std::mutex> guardLock(lock);
+        delegates = builderDelegates;
+    }
+
+    for (const auto& delegate : delegates)
+    {
+        delegate->builderPrefetch(threadInfo, inBuilder, tiles);
+    }
+}
+
 void QuadSamplingController::builderPreSceneFlush(QuadTileBuilder *inBuilder, ChangeSet &changes)
 {
     std::vector<QuadTileBuilderDelegateRef> delegates;
@@ -59,6 +59,12 @@ bool SamplingParams::operator == (const SamplingParams &that) const
         clipBounds == that.clipBounds &&
         useClipBoundsForImportance == that.useClipBoundsForImportance &&
         generateGeom == that.generateGeom &&
+        importanceChangeRelative == that.importanceChangeRelative &&
+        importanceChangeAbsolute == that.importanceChangeAbsolute &&
+        prefetchTime == that.prefetchTime &&
+        prefetchMaxTiles == that.prefetchMaxTiles &&
+        parallelCoverage == that.parallelCoverage &&
+        templateMeshes == that.templateMeshes &&
         levelLoads == that.levelLoads &&
         importancePerLevel == that.importancePerLevel;
 }
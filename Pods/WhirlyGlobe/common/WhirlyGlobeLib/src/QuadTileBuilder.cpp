@@ -103,6 +103,16 @@ bool QuadTileBuilder::getSingleLevel() const
 {
     return geomSettings.singleLevel;
 }
+
+void QuadTileBuilder::setTemplateMeshes(bool templateMeshes)
+{
+    geomSettings.useTemplateMeshes = templateMeshes;
+}
+
+bool QuadTileBuilder::getTemplateMeshes() const
+{
+    return geomSettings.useTemplateMeshes;
+}
     
 void QuadTileBuilder::setColor(const RGBAColor &color)
 {
@@ -153,9 +163,9 @@ void QuadTileBuilder::setController(QuadDisplayControllerNew *inControl)
 /// Load some tiles, unload others, and the rest had their importance values change
 /// Return the nodes we wanted to keep rather than delete
 QuadTreeNew::NodeSet QuadTileBuilder::quadLoaderUpdate(PlatformThreadInfo *threadInfo,
-                                                       const QuadTreeNew::ImportantNodeSet &loadTiles,
-                                                       const QuadTreeNew::NodeSet &unloadTiles,
-                                                       const QuadTreeNew::ImportantNodeSet &updateTiles,
+                                                       const QuadTreeNew::CoverageSet &loadTiles,
+                                                       const QuadTreeNew::CoverageSet &unloadTiles,
+                                                       const QuadTreeNew::CoverageSet &updateTiles,
                                                        int targetLevel, ChangeSet &changes)
 {
     TileBuilderDelegateInfo info;
@@ -166,11 +176,23 @@ QuadTreeNew::NodeSet QuadTileBuilder::quadLoaderUpdate(PlatformThreadInfo *threa
     if (!unloadTiles.empty())
     {
         toKeep = delegate->builderUnloadCheck(this,loadTiles,unloadTiles,targetLevel);
-        // Remove the keep nodes and add them to update with very little importance
-        for (const QuadTreeNew::Node &node: toKeep)
+        if (!toKeep.empty())
         {
-            info.unloadTiles.erase(node);
-            info.changeTiles.emplace(node,0.0);
+            // Remove the keep nodes and add them to update with very little importance
+            info.unloadTiles.clear();
+            for (const auto &node : unloadTiles)
+            {
+                if (toKeep.find(node) == toKeep.end())
+                {
+                    info.unloadTiles.add(node);
+                }
+            }
+            info.unloadTiles.finish();
+            for (const QuadTreeNew::Node &node: toKeep)
+            {
+                info.changeTiles.add(QuadTreeNew::ImportantNode(node,0.0));
+            }
+            info.changeTiles.finish();
         }
     }
     
@@ -216,6 +238,12 @@ QuadTreeNew::NodeSet QuadTileBuilder::quadLoaderUpdate(PlatformThreadInfo *threa
     return toKeep;
 }
 
+void QuadTileBuilder::quadLoaderPrefetch(PlatformThreadInfo *threadInfo,
+                                         const QuadTreeNew::ImportantNodeSet &tiles)
+{
+    delegate->builderPrefetch(threadInfo,this,tiles);
+}
+
 /// Called right before the layer thread flushes its change requests
 void QuadTileBuilder::quadLoaderPreSceenFlush(ChangeSet &changes)
 {
@@ -19,6 +19,7 @@
 #import "QuadTreeNew.h"
 #import <WhirlyKitLog.h>
 #include <Expect.h>
+#import <algorithm>
 
 static constexpr int maxMaxLevel = 24;
 
@@ -92,26 +93,180 @@ bool QuadTreeNew::ImportantNode::operator==(const WhirlyKit::QuadTreeNew::Import
     return true;
 }
 
+QuadTreeNew::CoverageSet::CoverageSet(const ImportantNodeSet &nodeSet)
+{
+    nodes.reserve(nodeSet.size());
+    for (const auto &node : nodeSet)
+    {
+        nodes.push_back(node);
+    }
+    finish();
+}
+
+QuadTreeNew::CoverageSet::CoverageSet(const NodeSet &nodeSet)
+{
+    // Already in the right order
+    nodes.reserve(nodeSet.size());
+    for (const auto &node : nodeSet)
+    {
+        nodes.emplace_back(node, 0.0);
+    }
+}
+
+void QuadTreeNew::CoverageSet::finish()
+{
+    std::sort(nodes.begin(), nodes.end(), [](const ImportantNode &a, const ImportantNode &b)
+    {
+        return a.Node::operator<(b) || (a.Node::operator==(b) && a.importance > b.importance);
+    });
+    nodes.erase(std::unique(nodes.begin(), nodes.end(), [](const ImportantNode &a, const ImportantNode &b)
+    {
+        return a.Node::operator==(b);
+    }), nodes.end());
+}
+
+const QuadTreeNew::ImportantNode *QuadTreeNew::CoverageSet::find(const Node &node) const
+{
+    const auto it = std::lower_bound(nodes.begin(), nodes.end(), node, [](const ImportantNode &a, const Node &b)
+    {
+        return a.Node::operator<(b);
+    });
+    return (it != nodes.end() && it->Node::operator==(node)) ? &*it : nullptr;
+}
+
+std::vector<QuadTreeNew::ImportantNode> QuadTreeNew::CoverageSet::byImportance() const
+{
+    std::vector<ImportantNode> sorted(nodes);
+    std::sort(sorted.begin(), sorted.end());
+    return sorted;
+}
+
+QuadTreeNew::ImportantNodeSet QuadTreeNew::CoverageSet::toImportantNodeSet() const
+{
+    return ImportantNodeSet(nodes.begin(), nodes.end());
+}
+
+QuadTreeNew::NodeSet QuadTreeNew::CoverageSet::toNodeSet() const
+{
+    NodeSet nodeSet;
+    for (const auto &node : nodes)
+    {
+        // In order, so each one goes at the end
+        nodeSet.insert(nodeSet.end(), node);
+    }
+    return nodeSet;
+}
+
+void QuadTreeNew::CoverageSet::diff(const CoverageSet &oldNodes,const CoverageSet &newNodes,
+                                    CoverageSet &added,CoverageSet &removed,CoverageSet &kept)
+{
+    // Both are sorted, so walk them together
+    auto oldIt = oldNodes.nodes.begin();
+    auto newIt = newNodes.nodes.begin();
+    while (oldIt != oldNodes.nodes.end() || newIt != newNodes.nodes.end())
+    {
+        if (newIt == newNodes.nodes.end() ||
+            (oldIt != oldNodes.nodes.end() && oldIt->Node::operator<(*newIt)))
+        {
+            removed.nodes.push_back(*oldIt++);
+        }
+        else if (oldIt == oldNodes.nodes.end() || newIt->Node::operator<(*oldIt))
+        {
+            added.nodes.push_back(*newIt++);
+        }
+        else
+        {
+            kept.nodes.push_back(*newIt++);
+            oldIt++;
+        }
+    }
+}
+
 QuadTreeNew::QuadTreeNew(const MbrD &mbr,int minLevel,int maxLevel)
     : mbr(mbr), minLevel(minLevel), maxLevel(std::min(maxLevel, maxMaxLevel))
 {
 }
 
+double QuadTreeNew::memoImportance(const Node &node,ImportanceMemo *localMemo)
+{
+    if (localMemo)
+    {
+        const auto it = importanceMemo.find(node.NodeNumber());
+        if (it != importanceMemo.end())
+        {
+            return it->second;
+        }
+    }
+
+    auto &memo = localMemo ? *localMemo : importanceMemo;
+    const auto res = memo.insert(std::make_pair(node.NodeNumber(), 0.0));
+    if (res.second)
+    {
+        res.first->second = importance(node);
+    }
+    return res.first->second;
+}
+
+void QuadTreeNew::memoImportance(const std::vector<ImportantNode> &nodes,ImportanceMemo *localMemo)
+{
+    std::vector<Node> toEval;
+    toEval.reserve(nodes.size());
+    for (const auto &node : nodes)
+    {
+        const auto nodeNum = node.NodeNumber();
+        if (node.level >= minLevel && node.level <= maxLevel &&
+            importanceMemo.find(nodeNum) == importanceMemo.end() &&
+            (!localMemo || localMemo->find(nodeNum) == localMemo->end()))
+        {
+            toEval.push_back(node);
+        }
+    }
+    if (toEval.empty())
+    {
+        return;
+    }
+
+    std::vector<double> results;
+    importanceForNodes(toEval,results);
+
+    auto &memo = localMemo ? *localMemo : importanceMemo;
+    for (size_t ii=0;ii<toEval.size();ii++)
+    {
+        memo[toEval[ii].NodeNumber()] = results[ii];
+    }
+}
+
+void QuadTreeNew::importanceForNodes(const std::vector<Node> &nodes,std::vector<double> &results)
+{
+    results.resize(nodes.size());
+    for (size_t ii=0;ii<nodes.size();ii++)
+    {
+        results[ii] = importance(nodes[ii]);
+    }
+}
+
 QuadTreeNew::ImportantNodeSet QuadTreeNew::calcCoverageImportance(const std::vector<double> &minImportance,int maxNodes,bool siblingNodes,std::vector<double> &maxRejectedImport)
 {
+    if (!keepImportanceMemo)
+    {
+        importanceMemo.clear();
+    }
+
     ImportantNodeSet sortedNodes;
 
     // Start at the lowest level and work our way to higher resolution
     const int numX = 1<<minLevel;
     const int numY = 1<<minLevel;
+    std::vector<ImportantNode> topNodes;
+    topNodes.reserve(numX*numY);
     for (int iy=0;iy<numY;iy++)
     {
         for (int ix=0;ix<numX;ix++)
         {
-            ImportantNode node(ix,iy,minLevel);
-            evalNodeImportance(node,minImportance,sortedNodes,maxRejectedImport);
+            topNodes.emplace_back(ix,iy,minLevel);
         }
     }
+    evalNodes(topNodes,minImportance,sortedNodes,maxRejectedImport);
 
     // Add the most important nodes first until we run out
     ImportantNodeSet retNodes;
@@ -150,6 +305,12 @@ QuadTreeNew::ImportantNodeSet QuadTreeNew::calcCoverageImportance(const std::vec
 
 void QuadTreeNew::evalNodeImportance(ImportantNode &node,const std::vector<double> &minImportance,
                                      ImportantNodeSet &importSet,std::vector<double> &maxRejectedImport)
+{
+    evalSubtree(node,minImportance,importSet,maxRejectedImport,nullptr);
+}
+
+void QuadTreeNew::evalSubtree(ImportantNode &node,const std::vector<double> &minImportance,ImportantNodeSet &importSet,
+                              std::vector<double> &maxRejectedImport,ImportanceMemo *localMemo)
 {
     // Stop recursing if we get a shutdown signal
     if (UNLIKELY(shutdown) || node.level > maxLevel)
@@ -157,19 +318,8 @@ void QuadTreeNew::evalNodeImportance(ImportantNode &node,const std::vector<doubl
         return;
     }
 
-    node.importance = (node.level >= minLevel) ? importance(node) : 0;
-
-    //wkLogLevel(Verbose,"tree %llx node %d:(%d,%d) importance=%f",this,node.level,node.x,node.y,node.importance);
-    assert(node.level < minImportance.size() && node.level < maxRejectedImport.size());
-
-    const auto levelMinImport = minImportance[node.level];
-    if (node.importance < levelMinImport && levelMinImport != MAXFLOAT)
+    if (!evalNode(node,minImportance,maxRejectedImport,localMemo))
     {
-        const double ratio = (levelMinImport > 0.0) ? (node.importance / levelMinImport) : 1.0;
-        if (ratio > 0)
-        {
-            maxRejectedImport[node.level] = std::max(ratio, maxRejectedImport[node.level]);
-        }
         return;
     }
 
@@ -180,19 +330,128 @@ void QuadTreeNew::evalNodeImportance(ImportantNode &node,const std::vector<doubl
 
     if (node.level < maxLevel)
     {
-        // Add the children
+        // Add the children, evaluating them together
+        std::vector<ImportantNode> children;
+        children.reserve(4);
         for (int iy=0;iy<2;iy++)
         {
             const int indY = 2*node.y + iy;
             for (int ix=0;ix<2;ix++)
             {
-                ImportantNode childNode(2*node.x + ix, indY,node.level + 1);
-                evalNodeImportance(childNode,minImportance,importSet,maxRejectedImport);
+                children.emplace_back(2*node.x + ix, indY,node.level + 1);
             }
         }
+        memoImportance(children,localMemo);
+        for (auto &childNode : children)
+        {
+            evalSubtree(childNode,minImportance,importSet,maxRejectedImport,localMemo);
+        }
     }
 }
-    
+
+void QuadTreeNew::evalNodes(const std::vector<ImportantNode> &nodes,const std::vector<double> &minImportance,
+                            ImportantNodeSet &importSet,std::vector<double> &maxRejectedImport)
+{
+    memoImportance(nodes);
+
+    const int numThreads = evalPool ? evalPool->getNumThreads() : 0;
+    if (numThreads < 1)
+    {
+        for (auto node : nodes)
+        {
+            evalNodeImportance(node,minImportance,importSet,maxRejectedImport);
+        }
+        return;
+    }
+
+    // Work down a level at a time until there are enough subtrees to keep everyone busy
+    const size_t targetTasks = (size_t)numThreads * 4;
+    std::vector<ImportantNode> subtrees = nodes;
+    while (!subtrees.empty() && subtrees.size() < targetTasks && !UNLIKELY(shutdown))
+    {
+        std::vector<ImportantNode> children;
+        children.reserve(subtrees.size() * 4);
+        memoImportance(subtrees);
+        for (auto &node : subtrees)
+        {
+            if (node.level > maxLevel || !evalNode(node,minImportance,maxRejectedImport))
+            {
+                continue;
+            }
+            if (node.level >= minLevel)
+            {
+                importSet.insert(node);
+            }
+            if (node.level < maxLevel)
+            {
+                for (int iy=0;iy<2;iy++)
+                {
+                    for (int ix=0;ix<2;ix++)
+                    {
+                        children.emplace_back(2*node.x + ix,2*node.y + iy,node.level + 1);
+                    }
+                }
+            }
+        }
+        subtrees.swap(children);
+    }
+
+    // Each subtree gets its own results, which we merge afterward.
+    // The shared memo isn't touched until then, so it's safe to read.
+    struct Results
+    {
+        ImportantNodeSet nodes;
+        std::vector<double> maxRejectedImport;
+        ImportanceMemo memo;
+    };
+    std::vector<Results> results(subtrees.size());
+    std::vector<WorkStealingPool::Task> tasks;
+    tasks.reserve(subtrees.size());
+    for (size_t ii=0;ii<subtrees.size();ii++)
+    {
+        tasks.emplace_back([&,ii]()
+        {
+            auto &res = results[ii];
+            res.maxRejectedImport.resize(maxRejectedImport.size(),0.0);
+            ImportantNode node = subtrees[ii];
+            evalSubtree(node,minImportance,res.nodes,res.maxRejectedImport,&res.memo);
+        });
+    }
+    evalPool->run(tasks);
+
+    for (auto &res : results)
+    {
+        importSet.insert(res.nodes.begin(),res.nodes.end());
+        for (size_t ii=0;ii<res.maxRejectedImport.size();ii++)
+        {
+            maxRejectedImport[ii] = std::max(maxRejectedImport[ii],res.maxRejectedImport[ii]);
+        }
+        importanceMemo.insert(res.memo.begin(),res.memo.end());
+    }
+}
+
+bool QuadTreeNew::evalNode(ImportantNode &node,const std::vector<double> &minImportance,
+                           std::vector<double> &maxRejectedImport,ImportanceMemo *localMemo)
+{
+    node.importance = (node.level >= minLevel) ? memoImportance(node,localMemo) : 0;
+
+    //wkLogLevel(Verbose,"tree %llx node %d:(%d,%d) importance=%f",this,node.level,node.x,node.y,node.importance);
+    assert(node.level < minImportance.size() && node.level < maxRejectedImport.size());
+
+    const auto levelMinImport = minImportance[node.level];
+    if (node.importance < levelMinImport && levelMinImport != MAXFLOAT)
+    {
+        const double ratio = (levelMinImport > 0.0) ? (node.importance / levelMinImport) : 1.0;
+        if (ratio > 0)
+        {
+            maxRejectedImport[node.level] = std::max(ratio, maxRejectedImport[node.level]);
+        }
+        return false;
+    }
+
+    return true;
+}
+
 bool QuadTreeNew::evalNodeVisible(ImportantNode node, const std::vector<double> &minImportance, int maxNodes,
                                   const std::set<int> &levelsToLoad, int inMaxLevel, ImportantNodeSet &visibleSet)
 {
@@ -202,8 +461,9 @@ bool QuadTreeNew::evalNodeVisible(ImportantNode node, const std::vector<double>
         return true;
     }
 
-    // These are used for sorting elsewhere, so let's keep 'em around
-    node.importance = importance(node);
+    // These are used for sorting elsewhere, so let's keep 'em around.
+    // We'll see the same nodes on every pass through the levels, so they're memoized.
+    node.importance = memoImportance(node);
 
     if (node.level == minLevel && node.importance < minImportance[node.level])
         return true;
@@ -241,11 +501,16 @@ std::tuple<int,QuadTreeNew::ImportantNodeSet> QuadTreeNew::calcCoverageVisible(
         int maxNodes,const std::vector<int> &levelLoads,
         bool keepMinLevel,std::vector<double> &maxRejectedImport)
 {
+    if (!keepImportanceMemo)
+    {
+        importanceMemo.clear();
+    }
+
     ImportantNodeSet sortedNodes;
 
     // Start at the lowest level and work our way to higher resolution
     ImportantNode node(0,0,0);
-    evalNodeImportance(node,minImportance,sortedNodes,maxRejectedImport);
+    evalNodes({node},minImportance,sortedNodes,maxRejectedImport);
 
     if (shutdown)
     {
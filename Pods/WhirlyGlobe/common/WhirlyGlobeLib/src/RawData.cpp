@@ -58,6 +58,166 @@ RawDataWrapper::~RawDataWrapper()
     data = nullptr;
 }
 
+PooledRawData::PooledRawData(std::vector<unsigned char> &&inBuf,unsigned long len,const RawDataPoolRef &inPool) :
+    buf(std::move(inBuf)),
+    len(len),
+    pool(inPool)
+{
+    if (buf.size() < len)
+    {
+        buf.resize(len);
+    }
+}
+
+PooledRawData::~PooledRawData()
+{
+    if (const auto thePool = pool.lock())
+    {
+        thePool->returnBuffer(std::move(buf));
+    }
+}
+
+void PooledRawData::setLen(unsigned long newLen)
+{
+    if (buf.size() < newLen)
+    {
+        buf.resize(newLen);
+    }
+    len = newLen;
+}
+
+// The single allocation allocate_shared makes for each PooledRawData is always the same size,
+// so we keep the released ones in a free list rather than going back to the heap.
+struct RawDataPool::WrapperCache
+{
+    WrapperCache(int maxBlocks) : maxBlocks(maxBlocks) { }
+    ~WrapperCache()
+    {
+        for (void *block : blocks)
+        {
+            ::operator delete(block);
+        }
+    }
+
+    void *allocate(size_t size)
+    {
+        {
+            std::lock_guard<std::mutex> guardLock(lock);
+            if (size == blockSize && !blocks.empty())
+            {
+                void *block = blocks.back();
+                blocks.pop_back();
+                return block;
+            }
+        }
+        return ::operator new(size);
+    }
+
+    void deallocate(void *block,size_t size)
+    {
+        {
+            std::lock_guard<std::mutex> guardLock(lock);
+            if (blockSize == 0)
+            {
+                blockSize = size;
+            }
+            if (size == blockSize && blocks.size() < maxBlocks)
+            {
+                blocks.push_back(block);
+                return;
+            }
+        }
+        ::operator delete(block);
+    }
+
+    std::mutex lock;
+    std::vector<void *> blocks;
+    size_t blockSize = 0;
+    size_t maxBlocks;
+};
+
+// Allocator for allocate_shared that draws from a WrapperCache.
+// The control block keeps a copy, so the cache outlives any outstanding data.
+template <typename T>
+struct PooledRawDataAllocator
+{
+    typedef T value_type;
+
+    PooledRawDataAllocator(const std::shared_ptr<RawDataPool::WrapperCache> &cache) : cache(cache) { }
+    template <typename U>
+    PooledRawDataAllocator(const PooledRawDataAllocator<U> &that) : cache(that.cache) { }
+
+    T *allocate(size_t n) { return (T *)cache->allocate(n * sizeof(T)); }
+    void deallocate(T *ptr,size_t n) { cache->deallocate(ptr,n * sizeof(T)); }
+
+    template <typename U>
+    bool operator == (const PooledRawDataAllocator<U> &that) const { return cache == that.cache; }
+    template <typename U>
+    bool operator != (const PooledRawDataAllocator<U> &that) const { return cache != that.cache; }
+
+    std::shared_ptr<RawDataPool::WrapperCache> cache;
+};
+
+RawDataPool::RawDataPool(int maxBuffers,unsigned long maxBufferSize) :
+    wrappers(std::make_shared<WrapperCache>(maxBuffers)),
+    maxBuffers(maxBuffers),
+    maxBufferSize(maxBufferSize),
+    numAllocated(0),
+    numReused(0)
+{
+}
+
+PooledRawDataRef RawDataPool::getBuffer(unsigned long len)
+{
+    std::vector<unsigned char> buf;
+    {
+        std::lock_guard<std::mutex> guardLock(lock);
+        // Prefer the smallest buffer that's big enough, otherwise grow the biggest one
+        int best = -1;
+        for (int ii=0;ii<buffers.size();ii++)
+        {
+            const auto size = buffers[ii].size();
+            if (best < 0)
+            {
+                best = ii;
+                continue;
+            }
+            const auto bestSize = buffers[best].size();
+            if ((size >= len && (bestSize < len || size < bestSize)) ||
+                (size < len && bestSize < len && size > bestSize))
+            {
+                best = ii;
+            }
+        }
+        if (best >= 0)
+        {
+            std::swap(buffers[best],buffers.back());
+            buf = std::move(buffers.back());
+            buffers.pop_back();
+        }
+    }
+
+    if (buf.size() >= len && !buf.empty())
+        numReused++;
+    else
+        numAllocated++;
+
+    return std::allocate_shared<PooledRawData>(PooledRawDataAllocator<PooledRawData>(wrappers),
+                                               std::move(buf),len,shared_from_this());
+}
+
+void RawDataPool::returnBuffer(std::vector<unsigned char> &&buf)
+{
+    if (buf.empty() || (maxBufferSize > 0 && buf.size() > maxBufferSize))
+        return;
+
+    std::lock_guard<std::mutex> guardLock(lock);
+    if (buffers.size() < maxBuffers)
+    {
+        buffers.push_back(std::move(buf));
+    }
+}
+
 #if !MAPLY_MINIMAL
 
 RawDataReader::RawDataReader(const RawData *rawData) :
@@ -0,0 +1,211 @@
+/*  RawDataCompression.cpp
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#import <zlib.h>
+#import "RawDataCompression.h"
+#import "WhirlyKitLog.h"
+
+#if WK_USE_ZSTD
+# import <zstd.h>
+#endif
+
+namespace WhirlyKit
+{
+
+// Don't keep a huge buffer around on every thread just because of one outsized tile
+static constexpr unsigned long MaxRetainedBufferSize = 16 * 1024 * 1024;
+
+RawDataCompressionType RawDataCompression(const unsigned char *bytes,unsigned long len)
+{
+    static constexpr unsigned long smallest_zlib_output = 8;    // gzip is 23
+    if (!bytes || len < smallest_zlib_output)
+    {
+        return RawDataCompressionNone;
+    }
+    switch (bytes[0])
+    {
+        case 0x1f:
+            return (bytes[1] == 0x8b) ? RawDataCompressionGZip : RawDataCompressionNone;
+        case 0x78:
+            switch (bytes[1])
+            {
+                case 0x01:  // Compression levels 0-1 (none,fast)
+                case 0x5e:  // Compression levels 2-5
+                case 0x9c:  // Compression level  6   (default)
+                case 0xda:  // Compression levels 7-9 (best)
+                    return RawDataCompressionZLib;
+                default:
+                    return RawDataCompressionNone;
+            }
+        case 0x28:
+            return (bytes[1] == 0xb5 && bytes[2] == 0x2f && bytes[3] == 0xfd) ? RawDataCompressionZStd : RawDataCompressionNone;
+        default:
+            return RawDataCompressionNone;
+    }
+}
+
+RawDataCompressionType RawDataCompression(const RawData *rawData)
+{
+    return rawData ? RawDataCompression(rawData->getRawData(),rawData->getLen()) : RawDataCompressionNone;
+}
+
+static bool inflateData(const unsigned char *data,unsigned long len,bool gzip,MutableRawData &outData)
+{
+    // A single-member gzip stream ends with the uncompressed size (mod 2^32), use it as a hint
+    unsigned long sizeHint = len * 4;
+    if (gzip)
+    {
+        const unsigned char *tail = data + len - 4;
+        const unsigned long isize = tail[0] | (tail[1] << 8) | (tail[2] << 16) | ((unsigned long)tail[3] << 24);
+        // Deflate can't do better than about 1032:1, anything more means a multi-member or corrupt stream
+        if (isize > 0 && isize <= len * 1032)
+        {
+            sizeHint = isize;
+        }
+    }
+    outData.resize(std::max(sizeHint,(unsigned long)1024));
+
+    z_stream strm = {};
+    strm.next_in = (Bytef *)data;
+    strm.avail_in = (uInt)len;
+    // 15 bits of window, +32 for automatic zlib/gzip header detection
+    if (inflateInit2(&strm, 15+32) != Z_OK)
+    {
+        return false;
+    }
+
+    int status = Z_OK;
+    while (status == Z_OK)
+    {
+        if (strm.total_out >= outData.getLen())
+        {
+            outData.resize(outData.getLen() * 2);
+        }
+        strm.next_out = outData.getMutableRawData() + strm.total_out;
+        strm.avail_out = (uInt)(outData.getLen() - strm.total_out);
+
+        status = inflate(&strm, Z_SYNC_FLUSH);
+    }
+    const auto totalOut = strm.total_out;
+    inflateEnd(&strm);
+
+    if (status != Z_STREAM_END)
+    {
+        wkLogLevel(Warn, "Failed to inflate %s data (%d): %s", gzip ? "gzip" : "zlib", status, strm.msg ? strm.msg : "?");
+        outData.resize(0);
+        return false;
+    }
+
+    outData.resize(totalOut);
+    return true;
+}
+
+#if WK_USE_ZSTD
+static bool zstdDecompress(const unsigned char *data,unsigned long len,MutableRawData &outData)
+{
+    const auto frameSize = ZSTD_getFrameContentSize(data, len);
+    if (frameSize == ZSTD_CONTENTSIZE_ERROR)
+    {
+        return false;
+    }
+
+    // One context per thread, they're not cheap to set up
+    static thread_local std::unique_ptr<ZSTD_DCtx,size_t(*)(ZSTD_DCtx*)> dctx(ZSTD_createDCtx(), &ZSTD_freeDCtx);
+
+    if (frameSize != ZSTD_CONTENTSIZE_UNKNOWN)
+    {
+        outData.resize(frameSize);
+        const auto res = ZSTD_decompressDCtx(dctx.get(), outData.getMutableRawData(), frameSize, data, len);
+        if (ZSTD_isError(res))
+        {
+            wkLogLevel(Warn, "Failed to decompress zstd data: %s", ZSTD_getErrorName(res));
+            outData.resize(0);
+            return false;
+        }
+        outData.resize(res);
+        return true;
+    }
+
+    // Size wasn't recorded, stream it
+    ZSTD_DCtx_reset(dctx.get(), ZSTD_reset_session_only);
+    outData.resize(std::max(len * 4, (unsigned long)ZSTD_DStreamOutSize()));
+    ZSTD_inBuffer in = { data, len, 0 };
+    size_t outPos = 0;
+    while (true)
+    {
+        if (outPos >= outData.getLen())
+        {
+            outData.resize(outData.getLen() * 2);
+        }
+        ZSTD_outBuffer out = { outData.getMutableRawData(), outData.getLen(), outPos };
+        const auto res = ZSTD_decompressStream(dctx.get(), &out, &in);
+        outPos = out.pos;
+        if (ZSTD_isError(res))
+        {
+            wkLogLevel(Warn, "Failed to decompress zstd data: %s", ZSTD_getErrorName(res));
+            outData.resize(0);
+            return false;
+        }
+        if (res == 0)
+        {
+            break;
+        }
+        if (in.pos >= in.size && out.pos < out.size)
+        {
+            // Ran out of input mid-frame
+            outData.resize(0);
+            return false;
+        }
+    }
+    outData.resize(outPos);
+    return true;
+}
+#endif
+
+bool RawDataDecompress(const unsigned char *data,unsigned long len,
+                       RawDataCompressionType type,MutableRawData &outData)
+{
+    switch (type)
+    {
+        case RawDataCompressionGZip:
+        case RawDataCompressionZLib:
+            return inflateData(data,len,type == RawDataCompressionGZip,outData);
+        case RawDataCompressionZStd:
+#if WK_USE_ZSTD
+            return zstdDecompress(data,len,outData);
+#else
+            wkLogLevel(Warn, "zstd compressed data, but zstd support is not enabled (WK_USE_ZSTD)");
+            return false;
+#endif
+        case RawDataCompressionNone:
+        default:
+            return false;
+    }
+}
+
+const MutableRawDataRef &RawDataDecompressBuffer()
+{
+    static thread_local MutableRawDataRef buffer;
+    // Someone is still using the last one, leave it to them
+    if (!buffer || buffer.use_count() > 1 || buffer->getLen() > MaxRetainedBufferSize)
+    {
+        buffer = std::make_shared<MutableRawData>();
+    }
+    return buffer;
+}
+
+}
@@ -38,7 +38,10 @@
 
 #import <stdlib.h>
 #import <string>
+#import <cstring>
+#import <vector>
 #import <arpa/inet.h>
+#import <zlib.h>
 
 #if defined __APPLE__
 #import <libkern/OSByteOrder.h>
@@ -46,7 +49,6 @@
 
 // Use zlib's crc32
 #if defined __APPLE__
-# import <zlib.h>
 unsigned lodepng_crc32(const unsigned char* buffer, size_t length)
 {
     return crc32_z(crc32(0L, Z_NULL, 0), buffer, length);
@@ -59,6 +61,14 @@ unsigned lodepng_crc32(const unsigned char* buffer, size_t length)
 namespace WhirlyKit
 {
 
+// Error codes of our own, lodepng uses the small positive ones
+static constexpr unsigned ErrUnknown = (unsigned)-1;
+static constexpr unsigned ErrUnsupported = (unsigned)-2;
+static constexpr unsigned ErrException = (unsigned)-3;
+static constexpr unsigned ErrUnknownException = (unsigned)-4;
+static constexpr unsigned ErrBufferSize = (unsigned)-5;
+static constexpr unsigned ErrCorrupt = (unsigned)-6;
+
 static int getChannelCount(LodePNGColorType type)
 {
     switch (type)
@@ -71,92 +81,543 @@ static int getChannelCount(LodePNGColorType type)
     }
 }
 
-unsigned char *RawPNGImageLoaderInterpreter(unsigned int &width, unsigned int &height,
-                                            const unsigned char * const data, const size_t length,
-                                            const int valueMap[256],
-                                            unsigned *outDepth, unsigned *outChannels,
-                                            unsigned int *outErr, std::string* errStr)
+// Samples per pixel as stored in the file, which includes palette indices
+static int getSampleCount(LodePNGColorType type)
 {
-    unsigned char *outData = nullptr;
-    unsigned depth = 0, channels = 0, err = (unsigned)-1;
-    try
+    return (type == LCT_PALETTE) ? 1 : getChannelCount(type);
+}
+
+static void getOutputLayout(RawPNGPixelFormat format,const LodePNGColorMode &color,unsigned &depth,unsigned &channels)
+{
+    switch (format)
     {
-        LodePNGState pngState;
-        lodepng_state_init(&pngState);
-        err = lodepng_inspect(&width, &height, &pngState, data, length);
-        if (!err)
+        case RawPNGNative:
+            depth = color.bitdepth;
+            channels = getChannelCount(color.colortype);
+            break;
+        case RawPNGSingle8:
+            depth = 8;
+            channels = 1;
+            break;
+        case RawPNGRGBA8:
+            depth = 8;
+            channels = 4;
+            break;
+        case RawPNGRGB565:
+        case RawPNGRGBA4444:
+            depth = 16;
+            channels = 1;
+            break;
+    }
+}
+
+static size_t getOutputSize(unsigned width,unsigned height,unsigned depth,unsigned channels)
+{
+    return ((size_t)width * height * channels * depth + 7) / 8;
+}
+
+static void setError(std::string *errStr,const char *str)
+{
+    if (errStr)
+    {
+        *errStr = str;
+    }
+}
+
+// Remap single channel 8 bit values in place
+static void applyValueMap(uint8_t *p,size_t count,const int valueMap[256])
+{
+    for (size_t ii=0;ii<count;ii++,p++)
+    {
+        const int newVal = valueMap[*p];
+        if (newVal >= 0)
         {
-            channels = getChannelCount(pngState.info_png.color.colortype);
-            depth = pngState.info_png.color.bitdepth;
-            if (channels < 1)
+            *p = newVal;
+        }
+    }
+}
+
+// Pack a row of RGBA8 pixels into the output format
+static void packRGBARow(const uint8_t *rgba,unsigned width,RawPNGPixelFormat format,
+                        const int *valueMap,uint8_t *out)
+{
+    switch (format)
+    {
+        case RawPNGNative:
+        case RawPNGRGBA8:
+            memcpy(out,rgba,(size_t)width*4);
+            break;
+        case RawPNGSingle8:
+            for (unsigned ii=0;ii<width;ii++,rgba+=4)
+            {
+                out[ii] = (uint8_t)(((int)rgba[0] + (int)rgba[1] + (int)rgba[2])/3);
+            }
+            if (valueMap)
+            {
+                applyValueMap(out,width,valueMap);
+            }
+            break;
+        case RawPNGRGB565:
+            for (unsigned ii=0;ii<width;ii++,rgba+=4,out+=2)
+            {
+                const uint16_t pix = ((rgba[0] >> 3) << 11) | ((rgba[1] >> 2) << 5) | (rgba[2] >> 3);
+                memcpy(out,&pix,2);
+            }
+            break;
+        case RawPNGRGBA4444:
+            for (unsigned ii=0;ii<width;ii++,rgba+=4,out+=2)
+            {
+                const uint16_t pix = ((rgba[0] >> 4) << 12) | ((rgba[1] >> 4) << 8) | ((rgba[2] >> 4) << 4) | (rgba[3] >> 4);
+                memcpy(out,&pix,2);
+            }
+            break;
+    }
+}
+
+// Expand a row of unfiltered samples to RGBA8, following lodepng's own conversion
+static void expandRowToRGBA(const uint8_t *row,unsigned width,const LodePNGColorMode &color,uint8_t *rgba)
+{
+    const unsigned depth = color.bitdepth;
+    switch (color.colortype)
+    {
+        case LCT_GREY:
+        case LCT_PALETTE:
+            if (depth == 16)
+            {
+                for (unsigned ii=0;ii<width;ii++,rgba+=4)
+                {
+                    const unsigned val = (row[2*ii] << 8) | row[2*ii+1];
+                    rgba[0] = rgba[1] = rgba[2] = row[2*ii];
+                    rgba[3] = (color.key_defined && val == color.key_r) ? 0 : 255;
+                }
+            }
+            else
+            {
+                const unsigned mask = (1u << depth) - 1;
+                for (unsigned ii=0;ii<width;ii++,rgba+=4)
+                {
+                    const size_t bit = (size_t)ii * depth;
+                    const unsigned val = (row[bit/8] >> (8 - depth - bit%8)) & mask;
+                    if (color.colortype == LCT_PALETTE)
+                    {
+                        memcpy(rgba,&color.palette[4*val],4);
+                    }
+                    else
+                    {
+                        rgba[0] = rgba[1] = rgba[2] = (uint8_t)(val * 255 / mask);
+                        rgba[3] = (color.key_defined && val == color.key_r) ? 0 : 255;
+                    }
+                }
+            }
+            break;
+        case LCT_RGB:
+            if (depth == 16)
+            {
+                for (unsigned ii=0;ii<width;ii++,rgba+=4,row+=6)
+                {
+                    rgba[0] = row[0];  rgba[1] = row[2];  rgba[2] = row[4];
+                    const bool isKey = color.key_defined &&
+                            (unsigned)((row[0] << 8) | row[1]) == color.key_r &&
+                            (unsigned)((row[2] << 8) | row[3]) == color.key_g &&
+                            (unsigned)((row[4] << 8) | row[5]) == color.key_b;
+                    rgba[3] = isKey ? 0 : 255;
+                }
+            }
+            else
             {
-                if (errStr)
+                for (unsigned ii=0;ii<width;ii++,rgba+=4,row+=3)
                 {
-                    *errStr = "Unsupported image type";
+                    rgba[0] = row[0];  rgba[1] = row[1];  rgba[2] = row[2];
+                    const bool isKey = color.key_defined &&
+                            row[0] == color.key_r && row[1] == color.key_g && row[2] == color.key_b;
+                    rgba[3] = isKey ? 0 : 255;
                 }
-                err = (unsigned)-2;
+            }
+            break;
+        case LCT_GREY_ALPHA:
+        {
+            const unsigned step = depth / 8;
+            for (unsigned ii=0;ii<width;ii++,rgba+=4,row+=2*step)
+            {
+                rgba[0] = rgba[1] = rgba[2] = row[0];
+                rgba[3] = row[step];
             }
         }
-        if (!err)
+            break;
+        case LCT_RGBA:
         {
-            LodePNGState state;
-            lodepng_state_init(&state);
-            state.decoder.color_convert = 0;
-            state.info_raw.colortype = pngState.info_png.color.colortype;
-            state.info_raw.bitdepth = depth;
-            err = lodepng_decode(&outData, &width, &height, &state, data, length);
-            lodepng_state_cleanup(&state);
+            const unsigned step = depth / 8;
+            for (unsigned ii=0;ii<width;ii++,rgba+=4,row+=4*step)
+            {
+                rgba[0] = row[0];  rgba[1] = row[step];  rgba[2] = row[2*step];  rgba[3] = row[3*step];
+            }
         }
+            break;
+        default:
+            break;
     }
-    catch (const std::exception &ex)
+}
+
+static uint8_t paethPredictor(int a,int b,int c)
+{
+    const int p = a + b - c;
+    const int pa = std::abs(p - a), pb = std::abs(p - b), pc = std::abs(p - c);
+    return (pa <= pb && pa <= pc) ? a : ((pb <= pc) ? b : c);
+}
+
+// Undo the filter on one scanline in place, given the previous (already unfiltered) one
+static bool unfilterRow(uint8_t *row,const uint8_t *prev,size_t rowLen,unsigned filterType,size_t bpp)
+{
+    switch (filterType)
     {
-        wkLogLevel(Error, "Exception in MaplyQuadImageLoader::dataForTile: %s", ex.what());
-        if (errStr)
+        case 0:
+            break;
+        case 1:
+            for (size_t ii=bpp;ii<rowLen;ii++)
+                row[ii] += row[ii-bpp];
+            break;
+        case 2:
+            for (size_t ii=0;ii<rowLen;ii++)
+                row[ii] += prev[ii];
+            break;
+        case 3:
+            for (size_t ii=0;ii<rowLen;ii++)
+                row[ii] += ((ii >= bpp ? row[ii-bpp] : 0) + prev[ii]) / 2;
+            break;
+        case 4:
+            for (size_t ii=0;ii<rowLen;ii++)
+            {
+                const int a = ii >= bpp ? row[ii-bpp] : 0;
+                const int c = ii >= bpp ? prev[ii-bpp] : 0;
+                row[ii] += paethPredictor(a,prev[ii],c);
+            }
+            break;
+        default:
+            return false;
+    }
+    return true;
+}
+
+// Inflater and scanline space for one thread, kept around between images
+struct PNGRowContext
+{
+    PNGRowContext()
+    {
+        memset(&strm,0,sizeof(strm));
+        valid = (inflateInit(&strm) == Z_OK);
+    }
+    ~PNGRowContext()
+    {
+        if (valid)
         {
-            *errStr = ex.what();
+            inflateEnd(&strm);
         }
-        err = (unsigned)-3;
     }
-    catch (...)
+
+    z_stream strm;
+    bool valid;
+    // Previous and current scanline, plus a row of RGBA for conversions
+    std::vector<uint8_t> prevRow,curRow,rgbaRow;
+};
+
+// Convert one unfiltered row into the output
+static void convertRow(const uint8_t *row,size_t rowLen,unsigned width,const LodePNGColorMode &color,
+                       RawPNGPixelFormat format,const int *valueMap,std::vector<uint8_t> &rgbaRow,uint8_t *out)
+{
+    if (format == RawPNGNative)
     {
-        wkLogLevel(Error, "Exception in MaplyQuadImageLoader::dataForTile");
-        if (errStr)
+        if (color.bitdepth == 16)
         {
-            *errStr = "Unknown exception";
+            // PNG is big-endian, hand back native order
+            for (size_t ii=0;ii<rowLen;ii+=2)
+            {
+                const uint16_t val = (row[ii] << 8) | row[ii+1];
+                memcpy(out+ii,&val,2);
+            }
         }
-        err = (unsigned)-4;
+        else
+        {
+            memcpy(out,row,rowLen);
+            if (color.bitdepth == 8 && color.colortype == LCT_GREY && valueMap)
+            {
+                applyValueMap(out,width,valueMap);
+            }
+        }
+        return;
     }
 
-#if defined(LODEPNG_COMPILE_ERROR_TEXT)
-    if ((int)err > 0 && errStr)
+    expandRowToRGBA(row,width,color,&rgbaRow[0]);
+    packRGBARow(&rgbaRow[0],width,format,
+                (color.bitdepth == 8 && color.colortype == LCT_GREY) ? valueMap : nullptr,out);
+}
+
+// Walk the chunks, inflating and converting a row at a time
+static unsigned decodeRows(const unsigned char *data,size_t length,LodePNGState &state,
+                           unsigned width,unsigned height,RawPNGPixelFormat format,
+                           const int *valueMap,unsigned char *outData,size_t outRowLen,std::string *errStr)
+{
+    static thread_local PNGRowContext context;
+    if (!context.valid || inflateReset(&context.strm) != Z_OK)
     {
-        *errStr = lodepng_error_text(err);
+        setError(errStr,"Failed to set up inflate");
+        return ErrUnknown;
+    }
+
+    const LodePNGColorMode &color = state.info_png.color;
+    const unsigned bitsPerPixel = getSampleCount(color.colortype) * color.bitdepth;
+    const size_t rowLen = ((size_t)width * bitsPerPixel + 7) / 8;
+    const size_t bpp = std::max(1u,bitsPerPixel / 8);
+    // The filter type byte leads each scanline
+    const size_t fullRowLen = rowLen + 1;
+
+    context.prevRow.assign(fullRowLen,0);
+    context.curRow.resize(fullRowLen);
+    if (format != RawPNGNative)
+    {
+        context.rgbaRow.resize((size_t)width * 4);
+    }
+
+    z_stream &strm = context.strm;
+    unsigned row = 0;
+    size_t filled = 0;
+    bool streamDone = false;
+
+    const unsigned char *end = data + length;
+    // Skip the signature and IHDR, which lodepng_inspect has already checked
+    for (const unsigned char *chunk = data + 33;
+         chunk + 12 <= end && row < height && !streamDone;
+         chunk = lodepng_chunk_next_const(chunk,end))
+    {
+        const unsigned chunkLen = lodepng_chunk_length(chunk);
+        if (chunkLen > (size_t)(end - chunk) - 12)
+        {
+            setError(errStr,"Truncated image data");
+            return ErrCorrupt;
+        }
+        if (lodepng_chunk_type_equals(chunk,"IEND"))
+        {
+            break;
+        }
+        if (!lodepng_chunk_type_equals(chunk,"IDAT"))
+        {
+            // Picks up the palette and transparency, ignores everything else
+            if (const unsigned err = lodepng_inspect_chunk(&state,chunk - data,data,length))
+            {
+                return err;
+            }
+            continue;
+        }
+        // The palette has to come before the image data, and we'd index into nothing without it
+        if (color.colortype == LCT_PALETTE && !color.palette)
+        {
+            return 106;
+        }
+        if (lodepng_chunk_check_crc(chunk))
+        {
+            setError(errStr,"Invalid chunk CRC");
+            return 57;
+        }
+
+        strm.next_in = (Bytef *)lodepng_chunk_data_const(chunk);
+        strm.avail_in = chunkLen;
+        while (strm.avail_in > 0 && row < height)
+        {
+            strm.next_out = &context.curRow[filled];
+            strm.avail_out = (uInt)(fullRowLen - filled);
+            const int ret = inflate(&strm,Z_NO_FLUSH);
+            filled = fullRowLen - strm.avail_out;
+            if (filled == fullRowLen)
+            {
+                uint8_t *rowData = &context.curRow[1];
+                if (!unfilterRow(rowData,&context.prevRow[1],rowLen,context.curRow[0],bpp))
+                {
+                    setError(errStr,"Invalid scanline filter");
+                    return ErrCorrupt;
+                }
+                convertRow(rowData,rowLen,width,color,format,valueMap,context.rgbaRow,outData + row * outRowLen);
+                std::swap(context.prevRow,context.curRow);
+                filled = 0;
+                row++;
+            }
+            if (ret == Z_STREAM_END)
+            {
+                streamDone = true;
+                break;
+            }
+            if (ret != Z_OK && ret != Z_BUF_ERROR)
+            {
+                setError(errStr,"Invalid compressed data");
+                return ErrCorrupt;
+            }
+        }
+    }
+
+    if (row < height)
+    {
+        setError(errStr,"Truncated image data");
+        return ErrCorrupt;
+    }
+
+    return 0;
+}
+
+// Decode the whole image with lodepng and copy it in, for the cases we don't stream
+static unsigned decodeWhole(const unsigned char *data,size_t length,const LodePNGState &pngState,
+                            unsigned &width,unsigned &height,RawPNGPixelFormat format,
+                            const int *valueMap,unsigned char *outData,size_t outRowLen)
+{
+    const LodePNGColorMode &color = pngState.info_png.color;
+
+    LodePNGState state;
+    lodepng_state_init(&state);
+    if (format == RawPNGNative)
+    {
+        state.decoder.color_convert = 0;
+        state.info_raw.colortype = color.colortype;
+        state.info_raw.bitdepth = color.bitdepth;
+    }
+    else
+    {
+        state.info_raw.colortype = LCT_RGBA;
+        state.info_raw.bitdepth = 8;
     }
-#endif
 
-    // Remap data values
-    if (depth == 8 && channels == 1 && valueMap && outData)
+    unsigned char *decoded = nullptr;
+    unsigned err = lodepng_decode(&decoded,&width,&height,&state,data,length);
+    lodepng_state_cleanup(&state);
+    if (err)
     {
-        auto *p = (uint8_t*)outData;
-        for (unsigned int ii=0;ii<width*height;ii++,p++)
+        free(decoded);
+        return err;
+    }
+
+    if (format == RawPNGNative)
+    {
+        const size_t outSize = getOutputSize(width,height,color.bitdepth,getChannelCount(color.colortype));
+        if (color.bitdepth == 16)
+        {
+            const auto *p = decoded;
+            for (size_t ii=0;ii<outSize;ii+=2,p+=2)
+            {
+                const uint16_t val = (p[0] << 8) | p[1];
+                memcpy(outData+ii,&val,2);
+            }
+        }
+        else
         {
-            const int newVal = valueMap[*p];
-            if (newVal >= 0)
+            memcpy(outData,decoded,outSize);
+            if (color.bitdepth == 8 && color.colortype == LCT_GREY && valueMap)
             {
-                *p = newVal;
+                applyValueMap(outData,outSize,valueMap);
             }
         }
     }
-    // PNG is big-endian
-    constexpr bool needSwap = (ntohs(1) != 1);
-    if (needSwap && depth == 16 && outData)   //NOLINT
+    else
+    {
+        const bool useMap = color.bitdepth == 8 && color.colortype == LCT_GREY;
+        for (unsigned row=0;row<height;row++)
+        {
+            packRGBARow(decoded + (size_t)row * width * 4,width,format,
+                        useMap ? valueMap : nullptr,outData + row * outRowLen);
+        }
+    }
+
+    free(decoded);
+    return 0;
+}
+
+// Check the header and work out what we'd produce
+static unsigned inspectImage(const unsigned char *data,size_t length,RawPNGPixelFormat format,
+                             LodePNGState &state,unsigned &width,unsigned &height,
+                             unsigned &depth,unsigned &channels,std::string *errStr)
+{
+    if (const unsigned err = lodepng_inspect(&width,&height,&state,data,length))
+    {
+        return err;
+    }
+    getOutputLayout(format,state.info_png.color,depth,channels);
+    if (channels < 1)
+    {
+        setError(errStr,"Unsupported image type");
+        return ErrUnsupported;
+    }
+    return 0;
+}
+
+size_t RawPNGImageDecodedSize(const unsigned char *data,size_t length,RawPNGPixelFormat format,
+                              unsigned int *outWidth,unsigned int *outHeight)
+{
+    unsigned width = 0, height = 0, depth = 0, channels = 0;
+    LodePNGState state;
+    lodepng_state_init(&state);
+    const unsigned err = inspectImage(data,length,format,state,width,height,depth,channels,nullptr);
+    lodepng_state_cleanup(&state);
+    if (err)
+    {
+        return 0;
+    }
+    if (outWidth)
+    {
+        *outWidth = width;
+    }
+    if (outHeight)
+    {
+        *outHeight = height;
+    }
+    return getOutputSize(width,height,depth,channels);
+}
+
+unsigned RawPNGImageDecodeInto(const unsigned char *data,size_t length,RawPNGPixelFormat format,
+                               const int valueMap[256],unsigned char *outData,size_t outLength,
+                               unsigned int &width,unsigned int &height,
+                               unsigned *outDepth,unsigned *outChannels,std::string *errStr)
+{
+    unsigned depth = 0, channels = 0, err = ErrUnknown;
+    try
     {
-        auto *p = (uint16_t *)outData;
-        for (int i = 0; i < width * height * channels; ++i, ++p)
+        LodePNGState state;
+        lodepng_state_init(&state);
+        err = inspectImage(data,length,format,state,width,height,depth,channels,errStr);
+        if (!err && outLength < getOutputSize(width,height,depth,channels))
         {
-            *p = ntohs(*p);
+            setError(errStr,"Output buffer too small");
+            err = ErrBufferSize;
+        }
+        if (!err)
+        {
+            const size_t outRowLen = ((size_t)width * depth * channels) / 8;
+            // Rows that don't end on a byte boundary run together in the native layout
+            const bool rowsAligned = ((size_t)width * depth * channels) % 8 == 0;
+            if (state.info_png.interlace_method == 0 && rowsAligned)
+            {
+                err = decodeRows(data,length,state,width,height,format,valueMap,outData,outRowLen,errStr);
+            }
+            else
+            {
+                err = decodeWhole(data,length,state,width,height,format,valueMap,outData,outRowLen);
+            }
         }
+        lodepng_state_cleanup(&state);
     }
+    catch (const std::exception &ex)
+    {
+        wkLogLevel(Error, "Exception in RawPNGImageDecodeInto: %s", ex.what());
+        setError(errStr,ex.what());
+        err = ErrException;
+    }
+    catch (...)
+    {
+        wkLogLevel(Error, "Exception in RawPNGImageDecodeInto");
+        setError(errStr,"Unknown exception");
+        err = ErrUnknownException;
+    }
+
+#if defined(LODEPNG_COMPILE_ERROR_TEXT)
+    if ((int)err > 0 && errStr)
+    {
+        *errStr = lodepng_error_text(err);
+    }
+#endif
 
     if (outDepth)
     {
@@ -166,6 +627,61 @@ unsigned char *RawPNGImageLoaderInterpreter(unsigned int &width, unsigned int &h
     {
         *outChannels = channels;
     }
+
+    return err;
+}
+
+PooledRawDataRef RawPNGImageDecodeToPool(const RawDataPoolRef &pool,
+                                         const unsigned char *data,size_t length,
+                                         RawPNGPixelFormat format,const int valueMap[256],
+                                         unsigned int &width,unsigned int &height,
+                                         unsigned *outDepth,unsigned *outChannels,
+                                         unsigned int *outErr,std::string *errStr)
+{
+    const size_t size = RawPNGImageDecodedSize(data,length,format,nullptr,nullptr);
+    PooledRawDataRef outData;
+    unsigned err = ErrUnknown;
+    if (size > 0)
+    {
+        outData = pool ? pool->getBuffer(size) :
+                         std::make_shared<PooledRawData>(std::vector<unsigned char>(),size,RawDataPoolRef());
+        err = RawPNGImageDecodeInto(data,length,format,valueMap,outData->getMutableData(),size,
+                                    width,height,outDepth,outChannels,errStr);
+        if (err)
+        {
+            outData.reset();
+        }
+    }
+    else
+    {
+        // Run the full decode to get the error
+        err = RawPNGImageDecodeInto(data,length,format,valueMap,nullptr,0,
+                                    width,height,outDepth,outChannels,errStr);
+    }
+
+    if (outErr)
+    {
+        *outErr = err;
+    }
+
+    return outData;
+}
+
+unsigned char *RawPNGImageLoaderInterpreter(unsigned int &width, unsigned int &height,
+                                            const unsigned char * const data, const size_t length,
+                                            const int valueMap[256],
+                                            unsigned *outDepth, unsigned *outChannels,
+                                            unsigned int *outErr, std::string* errStr)
+{
+    const size_t size = RawPNGImageDecodedSize(data,length,RawPNGNative,nullptr,nullptr);
+    auto *outData = size ? (unsigned char *)malloc(size) : nullptr;
+    const unsigned err = RawPNGImageDecodeInto(data,length,RawPNGNative,valueMap,outData,outData ? size : 0,
+                                               width,height,outDepth,outChannels,errStr);
+    if (err)
+    {
+        free(outData);
+        outData = nullptr;
+    }
     if (outErr)
     {
         *outErr = err;
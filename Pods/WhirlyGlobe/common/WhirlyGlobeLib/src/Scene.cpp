@@ -22,6 +22,7 @@
 #import "GlobeMath.h"
 #import "TextureAtlas.h"
 #import "Platform.h"
+#import "PerformanceTimer.h"
 
 #if !MAPLY_MINIMAL
 # import "FontTextureManager.h"
@@ -477,13 +478,17 @@ int Scene::processChanges(WhirlyKit::View *view,SceneRenderer *renderer,TimeInte
         localChanges.swap(changeRequests);
     }
 
-    for (auto &req : localChanges)
+    if (!localChanges.empty())
     {
-        if (req)
+        TileLoadTracer::Span traceSpan(TileLoadStageSceneChanges);
+        for (auto &req : localChanges)
         {
-            req->execute(this,renderer,view);
-            delete req;
-            req = nullptr;
+            if (req)
+            {
+                req->execute(this,renderer,view);
+                delete req;
+                req = nullptr;
+            }
         }
     }
 
@@ -120,6 +120,15 @@ void SceneRenderer::init()
     clearColor = RGBAColor(0,0,0,0);
     framebufferTex = nullptr;
 
+    perfHandles.renderFrame = perfTimer.registerTiming("Render Frame");
+    perfHandles.renderSetup = perfTimer.registerTiming("Render Setup");
+    perfHandles.scenePreprocess = perfTimer.registerTiming("Scene preprocessing");
+    perfHandles.preprocessChanges = perfTimer.registerCount("Preprocess Changes");
+    perfHandles.activeModelRuns = perfTimer.registerTiming("Active Model Runs");
+    perfHandles.activeModels = perfTimer.registerCount("Active Models");
+    perfHandles.sceneChanges = perfTimer.registerCount("Scene changes");
+    perfHandles.sceneProcessing = perfTimer.registerTiming("Scene processing");
+
     // Add a simple default light
     DirectionalLight light;
     light.setPos(Vector3f(0.75, 0.5, -1.0));
@@ -21,8 +21,17 @@
 #import "GlobeMath.h"
 #import "VectorData.h"
 #import "SceneRenderer.h"
+#import <algorithm>
 #import <array>
 
+#if defined(__SSE2__)
+#import <emmintrin.h>
+#define WK_SOLID_BATCH_SSE2 1
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#import <arm_neon.h>
+#define WK_SOLID_BATCH_NEON 1
+#endif
+
 using namespace Eigen;
 using namespace WhirlyKit;
 
@@ -148,67 +157,84 @@ DisplaySolid::DisplaySolid(const QuadTreeIdentifier &nodeIdent,
     valid = true;
 }
 
-double PolyImportance(const Point3dVector &poly,const Point3d &norm,ViewState *viewState,const WhirlyKit::Point2f &frameSize)
+// Run a polygon through the model and projection matrices into clip space
+static void PolyToClipSpace(const Point3dVector &poly,ViewState *viewState,unsigned int offi,Vector4dVector &pts)
 {
-    double import = 0.0;
-    const double origArea = std::abs(PolygonArea(poly,norm));
+    pts.reserve(poly.size());
+    for (const auto &pt : poly)
+    {
+        // Run through the model transform
+        const Vector4d modPt = viewState->fullMatrices[offi] * Vector4d(pt.x(),pt.y(),pt.z(),1.0);
+        // And then the projection matrix.  Now we're in clip space
+        pts.emplace_back(viewState->projMatrix * modPt);
+    }
+}
 
-    for (unsigned int offi=0;offi<viewState->viewMatrices.size();offi++)
+// How much of the original polygon made it out to the screen, given what's left of it in clip space
+static double ClippedAreaScale(const Vector4dVector &clipSpacePts,const Point3d &norm,double origArea,
+                               ViewState *viewState,unsigned int offi)
+{
+    // Project the clipped points back into model space
+    Point3dVector backPts;
+    backPts.reserve(clipSpacePts.size());
+    for (const auto &clipPt : clipSpacePts)
     {
-        Vector4dVector pts;
-        pts.reserve(poly.size());
-        for (const auto &pt : poly)
-        {
-            // Run through the model transform
-            const Vector4d modPt = viewState->fullMatrices[offi] * Vector4d(pt.x(),pt.y(),pt.z(),1.0);
-            // And then the projection matrix.  Now we're in clip space
-            pts.emplace_back(viewState->projMatrix * modPt);
-        }
-        
-        // The points are in clip space, so clip!
-        Vector4dVector clipSpacePts;
-        clipSpacePts.reserve(2*pts.size());
-        ClipHomogeneousPolygon(std::move(pts),clipSpacePts);
-        
-        // Outside the viewing frustum, so ignore it
-        if (clipSpacePts.empty())
-            continue;
-        
-        // Project to the screen
-        Point2dVector screenPts;
-        screenPts.reserve(clipSpacePts.size());
+        const Vector4d modelPt = viewState->invProjMatrix * clipPt;
+        const Vector4d backPt = viewState->invFullMatrices[offi] * modelPt;
+        backPts.emplace_back(backPt.x(),backPt.y(),backPt.z());
+    }
 
-        const Point2d halfFrameSize(frameSize.x()/2.0,frameSize.y()/2.0);
-        for (auto &outPt : clipSpacePts)
-        {
-            screenPts.emplace_back(outPt.x()/outPt.w() * halfFrameSize.x() + halfFrameSize.x(),
-                                   outPt.y()/outPt.w() * halfFrameSize.y() + halfFrameSize.y());
-        }
-        
-        const double screenArea = CalcLoopArea(screenPts);
-        // The polygon came out backwards, so toss it
-        if (!std::isfinite(screenArea) || screenArea <= 0.0)
-            continue;
-        
-        // Now project the screen points back into model space
-        Point3dVector backPts;
-        backPts.reserve(screenPts.size());
-        for (unsigned int ii=0;ii<screenPts.size();ii++)
-        {
-            const Vector4d modelPt = viewState->invProjMatrix * clipSpacePts[ii];
-            const Vector4d backPt = viewState->invFullMatrices[offi] * modelPt;
-            backPts.emplace_back(backPt.x(),backPt.y(),backPt.z());
-        }
+    // Then calculate the area
+    const double backArea = std::abs(PolygonArea(backPts,norm));
+
+    // We can scale the importance by how much of the polygon is left.
+    // This gets rid of small slices of big tiles not getting loaded
+    return (backArea == 0.0) ? 1.0 : origArea / backArea;
+}
 
-        // Then calculate the area
-        const double backArea = std::abs(PolygonArea(backPts,norm));
+// Importance of a single polygon for one of the view matrices
+static double PolyImportanceForView(const Point3dVector &poly,const Point3d &norm,double origArea,
+                                    ViewState *viewState,unsigned int offi,const WhirlyKit::Point2f &frameSize)
+{
+    Vector4dVector pts;
+    PolyToClipSpace(poly,viewState,offi,pts);
+    
+    // The points are in clip space, so clip!
+    Vector4dVector clipSpacePts;
+    clipSpacePts.reserve(2*pts.size());
+    ClipHomogeneousPolygon(std::move(pts),clipSpacePts);
+    
+    // Outside the viewing frustum, so ignore it
+    if (clipSpacePts.empty())
+        return 0.0;
+    
+    // Project to the screen
+    Point2dVector screenPts;
+    screenPts.reserve(clipSpacePts.size());
+
+    const Point2d halfFrameSize(frameSize.x()/2.0,frameSize.y()/2.0);
+    for (auto &outPt : clipSpacePts)
+    {
+        screenPts.emplace_back(outPt.x()/outPt.w() * halfFrameSize.x() + halfFrameSize.x(),
+                               outPt.y()/outPt.w() * halfFrameSize.y() + halfFrameSize.y());
+    }
+    
+    const double screenArea = CalcLoopArea(screenPts);
+    // The polygon came out backwards, so toss it
+    if (!std::isfinite(screenArea) || screenArea <= 0.0)
+        return 0.0;
+    
+    return std::abs(screenArea) * ClippedAreaScale(clipSpacePts,norm,origArea,viewState,offi);
+}
 
-        // Now we know how much of the original polygon made it out to the screen
-        // We can scale its importance accordingly.
-        // This gets rid of small slices of big tiles not getting loaded
-        const double scale = (backArea == 0.0) ? 1.0 : origArea / backArea;
+double PolyImportance(const Point3dVector &poly,const Point3d &norm,ViewState *viewState,const WhirlyKit::Point2f &frameSize)
+{
+    double import = 0.0;
+    const double origArea = std::abs(PolygonArea(poly,norm));
 
-        const double newImport =  std::abs(screenArea) * scale;
+    for (unsigned int offi=0;offi<viewState->viewMatrices.size();offi++)
+    {
+        const double newImport = PolyImportanceForView(poly, norm, origArea, viewState, offi, frameSize);
         if (newImport > import)
         {
             import = newImport;
@@ -218,6 +244,20 @@ double PolyImportance(const Point3dVector &poly,const Point3d &norm,ViewState *v
     return import;
 }
 
+// See if any part of a polygon is inside the viewing frustum for one of the view matrices
+static bool PolyOnScreenForView(const Point3dVector &poly,ViewState *viewState,unsigned int offi)
+{
+    Vector4dVector pts;
+    PolyToClipSpace(poly,viewState,offi,pts);
+    
+    // The points are in clip space, so clip!
+    Vector4dVector clipSpacePts;
+    clipSpacePts.reserve(2*pts.size());
+    ClipHomogeneousPolygon(std::move(pts),clipSpacePts);
+
+    return !clipSpacePts.empty();
+}
+
 bool DisplaySolid::isInside(const Point3d &pt)
 {
     return bbox0.x() <= pt.x() &&
@@ -268,31 +308,10 @@ bool DisplaySolid::isOnScreenForViewState(ViewState *viewState,const Point2f &fr
     
     for (unsigned int offi=0;offi<viewState->viewMatrices.size();offi++)
     {
-        for (unsigned int ii=0;ii<polys.size();ii++)
+        for (const auto &poly : polys)
         {
-            const Point3dVector &poly = polys[ii];
-            //double origArea = PolygonArea(poly,normals[ii]);
-            //origArea = std::abs(origArea);
-            
-            Vector4dVector pts;
-            pts.reserve(poly.size());
-            for (unsigned int ii=0;ii<poly.size();ii++)
-            {
-                const Point3d &pt = poly[ii];
-                // Run through the model transform
-                Vector4d modPt = viewState->fullMatrices[offi] * Vector4d(pt.x(),pt.y(),pt.z(),1.0);
-                // And then the projection matrix.  Now we're in clip space
-                Vector4d projPt = viewState->projMatrix * modPt;
-                pts.push_back(projPt);
-            }
-            
-            // The points are in clip space, so clip!
-            Vector4dVector clipSpacePts;
-            clipSpacePts.reserve(2*pts.size());
-            ClipHomogeneousPolygon(std::move(pts),clipSpacePts);
-
             // Got something inside the viewing frustum.  Good enough.
-            if (!clipSpacePts.empty())
+            if (PolyOnScreenForView(poly, viewState, offi))
                 return true;
         }
     }
@@ -300,6 +319,487 @@ bool DisplaySolid::isOnScreenForViewState(ViewState *viewState,const Point2f &fr
     return false;
 }
 
+// Clip planes a corner can be outside of, as in ClipHomogeneousPolygon
+enum {
+    ClipOutLeft = 1<<0, ClipOutRight = 1<<1,
+    ClipOutBottom = 1<<2, ClipOutTop = 1<<3,
+    ClipOutNear = 1<<4, ClipOutFar = 1<<5
+};
+
+// Which clip planes a clip space point is outside of.  NaNs are outside all of them.
+static inline uint8_t ClipOutside(double x,double y,double z,double w)
+{
+    return (x >= -w ? 0 : ClipOutLeft) | (x <= w ? 0 : ClipOutRight) |
+           (y >= -w ? 0 : ClipOutBottom) | (y <= w ? 0 : ClipOutTop) |
+           (z >= -w ? 0 : ClipOutNear) | (z <= w ? 0 : ClipOutFar);
+}
+
+bool DisplaySolid::isEntirelyOnScreenForViewState(ViewState *viewState)
+{
+    for (unsigned int offi=0;offi<viewState->fullMatrices.size();offi++)
+    {
+        const Eigen::Matrix4d clipMat = viewState->projMatrix * viewState->fullMatrices[offi];
+        bool inside = true;
+        for (const auto &poly : polys)
+        {
+            for (const auto &pt : poly)
+            {
+                const Vector4d clipPt = clipMat * Vector4d(pt.x(),pt.y(),pt.z(),1.0);
+                if (clipPt.w() <= 0.0 || ClipOutside(clipPt.x(),clipPt.y(),clipPt.z(),clipPt.w()))
+                {
+                    inside = false;
+                    break;
+                }
+            }
+            if (!inside)
+                break;
+        }
+        if (inside)
+            return true;
+    }
+
+    return false;
+}
+
+bool ScreenScaleUnchanged(ViewState *oldViewState,ViewState *newViewState)
+{
+    // Only flat maps, where the surface normals all point the same way
+    if (!oldViewState->coordAdapter || !oldViewState->coordAdapter->isFlat() ||
+        oldViewState->coordAdapter != newViewState->coordAdapter ||
+        (oldViewState->eyePos.z() >= 0.0) != (newViewState->eyePos.z() >= 0.0))
+        return false;
+
+    if (oldViewState->projMatrix != newViewState->projMatrix ||
+        oldViewState->fullMatrices.size() != newViewState->fullMatrices.size())
+        return false;
+
+    for (unsigned int offi=0;offi<oldViewState->fullMatrices.size();offi++)
+    {
+        const Eigen::Matrix4d oldMat = oldViewState->projMatrix * oldViewState->fullMatrices[offi];
+        const Eigen::Matrix4d newMat = newViewState->projMatrix * newViewState->fullMatrices[offi];
+
+        // If w doesn't vary across the plane, we're looking straight down at it and
+        //  the projection onto the screen is just a scale and an offset
+        if (oldMat(3,0) != 0.0 || oldMat(3,1) != 0.0 || oldMat.row(3) != newMat.row(3))
+            return false;
+
+        // Same scale and rotation within the plane, so only the offset changed
+        if (oldMat.block<2,2>(0,0) != newMat.block<2,2>(0,0))
+            return false;
+    }
+
+    return true;
+}
+
+#if WK_SOLID_BATCH_SSE2 || WK_SOLID_BATCH_NEON
+// Put together the outside flags for one lane from the per-plane "inside" lane masks
+static inline uint8_t ClipOutsideLane(int lane,int inLeft,int inRight,int inBottom,int inTop,int inNear,int inFar)
+{
+    return ((inLeft >> lane) & 1 ? 0 : ClipOutLeft) | ((inRight >> lane) & 1 ? 0 : ClipOutRight) |
+           ((inBottom >> lane) & 1 ? 0 : ClipOutBottom) | ((inTop >> lane) & 1 ? 0 : ClipOutTop) |
+           ((inNear >> lane) & 1 ? 0 : ClipOutNear) | ((inFar >> lane) & 1 ? 0 : ClipOutFar);
+}
+#endif
+
+#if WK_SOLID_BATCH_NEON
+static inline int LaneMask(uint64x2_t mask)
+{
+    return (vgetq_lane_u64(mask, 0) ? 1 : 0) | (vgetq_lane_u64(mask, 1) ? 2 : 0);
+}
+#endif
+
+/* Run points through the combined view and projection matrix.
+   For each one we note the clip planes it's outside of and where it would land on screen.
+   Two points at a time with SSE2 or NEON, one at a time otherwise.
+  */
+static void ProjectPoints(const Matrix4d &mat,const Point2d &halfFrameSize,
+                          const double *x,const double *y,const double *z,size_t numPts,
+                          uint8_t *outside,double *screenX,double *screenY)
+{
+    size_t ii = 0;
+
+#if WK_SOLID_BATCH_SSE2
+    __m128d m[4][4];
+    for (int r=0;r<4;r++)
+        for (int c=0;c<4;c++)
+            m[r][c] = _mm_set1_pd(mat(r,c));
+    const __m128d halfX = _mm_set1_pd(halfFrameSize.x());
+    const __m128d halfY = _mm_set1_pd(halfFrameSize.y());
+    const __m128d zero = _mm_setzero_pd();
+
+    for (;ii+2<=numPts;ii+=2)
+    {
+        const __m128d px = _mm_loadu_pd(x+ii);
+        const __m128d py = _mm_loadu_pd(y+ii);
+        const __m128d pz = _mm_loadu_pd(z+ii);
+        __m128d c[4];
+        for (int r=0;r<4;r++)
+        {
+            c[r] = _mm_add_pd(_mm_add_pd(_mm_mul_pd(m[r][0],px),_mm_mul_pd(m[r][1],py)),
+                              _mm_add_pd(_mm_mul_pd(m[r][2],pz),m[r][3]));
+        }
+
+        const __m128d negW = _mm_sub_pd(zero,c[3]);
+        const int inLeft = _mm_movemask_pd(_mm_cmpge_pd(c[0],negW));
+        const int inRight = _mm_movemask_pd(_mm_cmple_pd(c[0],c[3]));
+        const int inBottom = _mm_movemask_pd(_mm_cmpge_pd(c[1],negW));
+        const int inTop = _mm_movemask_pd(_mm_cmple_pd(c[1],c[3]));
+        const int inNear = _mm_movemask_pd(_mm_cmpge_pd(c[2],negW));
+        const int inFar = _mm_movemask_pd(_mm_cmple_pd(c[2],c[3]));
+        outside[ii] = ClipOutsideLane(0,inLeft,inRight,inBottom,inTop,inNear,inFar);
+        outside[ii+1] = ClipOutsideLane(1,inLeft,inRight,inBottom,inTop,inNear,inFar);
+
+        _mm_storeu_pd(screenX+ii,_mm_add_pd(_mm_mul_pd(_mm_div_pd(c[0],c[3]),halfX),halfX));
+        _mm_storeu_pd(screenY+ii,_mm_add_pd(_mm_mul_pd(_mm_div_pd(c[1],c[3]),halfY),halfY));
+    }
+#elif WK_SOLID_BATCH_NEON
+    float64x2_t m[4][4];
+    for (int r=0;r<4;r++)
+        for (int c=0;c<4;c++)
+            m[r][c] = vdupq_n_f64(mat(r,c));
+    const float64x2_t halfX = vdupq_n_f64(halfFrameSize.x());
+    const float64x2_t halfY = vdupq_n_f64(halfFrameSize.y());
+
+    for (;ii+2<=numPts;ii+=2)
+    {
+        const float64x2_t px = vld1q_f64(x+ii);
+        const float64x2_t py = vld1q_f64(y+ii);
+        const float64x2_t pz = vld1q_f64(z+ii);
+        float64x2_t c[4];
+        for (int r=0;r<4;r++)
+        {
+            // Separate multiplies and adds, fused ones would round differently from the scalar version
+            c[r] = vaddq_f64(vaddq_f64(vmulq_f64(m[r][0],px),vmulq_f64(m[r][1],py)),
+                             vaddq_f64(vmulq_f64(m[r][2],pz),m[r][3]));
+        }
+
+        const float64x2_t negW = vnegq_f64(c[3]);
+        const int inLeft = LaneMask(vcgeq_f64(c[0],negW));
+        const int inRight = LaneMask(vcleq_f64(c[0],c[3]));
+        const int inBottom = LaneMask(vcgeq_f64(c[1],negW));
+        const int inTop = LaneMask(vcleq_f64(c[1],c[3]));
+        const int inNear = LaneMask(vcgeq_f64(c[2],negW));
+        const int inFar = LaneMask(vcleq_f64(c[2],c[3]));
+        outside[ii] = ClipOutsideLane(0,inLeft,inRight,inBottom,inTop,inNear,inFar);
+        outside[ii+1] = ClipOutsideLane(1,inLeft,inRight,inBottom,inTop,inNear,inFar);
+
+        vst1q_f64(screenX+ii,vaddq_f64(vmulq_f64(vdivq_f64(c[0],c[3]),halfX),halfX));
+        vst1q_f64(screenY+ii,vaddq_f64(vmulq_f64(vdivq_f64(c[1],c[3]),halfY),halfY));
+    }
+#endif
+
+    // Whatever's left, or all of them without SIMD
+    for (;ii<numPts;ii++)
+    {
+        double c[4];
+        for (int r=0;r<4;r++)
+        {
+            c[r] = (mat(r,0)*x[ii] + mat(r,1)*y[ii]) + (mat(r,2)*z[ii] + mat(r,3));
+        }
+        outside[ii] = ClipOutside(c[0],c[1],c[2],c[3]);
+        screenX[ii] = c[0]/c[3] * halfFrameSize.x() + halfFrameSize.x();
+        screenY[ii] = c[1]/c[3] * halfFrameSize.y() + halfFrameSize.y();
+    }
+}
+
+int DisplaySolidBatch::addSolid(const DisplaySolidRef &dispSolid)
+{
+    Entry entry { dispSolid, (int)polyEntry.size(), 0, false };
+
+    // We can do quads with normals, which is what the constructor makes
+    if (dispSolid && dispSolid->valid && dispSolid->normals.size() >= dispSolid->polys.size())
+    {
+        entry.batched = std::all_of(dispSolid->polys.begin(), dispSolid->polys.end(),
+                                    [](const Point3dVector &poly) { return poly.size() == 4; });
+    }
+
+    if (entry.batched)
+    {
+        const int which = (int)entries.size();
+        entry.numPolys = (int)dispSolid->polys.size();
+        for (int ii=0;ii<entry.numPolys;ii++)
+        {
+            for (const auto &pt : dispSolid->polys[ii])
+            {
+                cornerX.push_back(pt.x());
+                cornerY.push_back(pt.y());
+                cornerZ.push_back(pt.z());
+            }
+            const Point3d &norm = dispSolid->normals[ii];
+            normX.push_back(norm.x());
+            normY.push_back(norm.y());
+            normZ.push_back(norm.z());
+            polyArea.push_back(std::abs(PolygonArea(dispSolid->polys[ii],norm)));
+            polyEntry.push_back(which);
+        }
+    }
+
+    entries.push_back(std::move(entry));
+    return (int)entries.size() - 1;
+}
+
+void DisplaySolidBatch::clear()
+{
+    entries.clear();
+    polyEntry.clear();
+    cornerX.clear();  cornerY.clear();  cornerZ.clear();
+    normX.clear();  normY.clear();  normZ.clear();
+    polyArea.clear();
+}
+
+void DisplaySolidBatch::projectCorners(ViewState *viewState,int offi,const Point2f &frameSize)
+{
+    const size_t numCorners = cornerX.size();
+    cornerOutside.resize(numCorners);
+    screenX.resize(numCorners);
+    screenY.resize(numCorners);
+
+    const Matrix4d mat = viewState->projMatrix * viewState->fullMatrices[offi];
+    const Point2d halfFrameSize(frameSize.x()/2.0,frameSize.y()/2.0);
+    ProjectPoints(mat, halfFrameSize, cornerX.data(), cornerY.data(), cornerZ.data(), numCorners,
+                  cornerOutside.data(), screenX.data(), screenY.data());
+}
+
+void DisplaySolidBatch::importanceForViewState(ViewState *viewState,const Point2f &frameSize,std::vector<double> &importance)
+{
+    importance.assign(entries.size(), 0.0);
+
+    const Point3d &eyePos = viewState->eyePos;
+    const size_t numPolys = polyEntry.size();
+    polyImport.assign(numPolys, 0.0);
+
+    // Polygons facing away are skipped, as in DisplaySolid::importanceForViewState
+    for (size_t pi=0;pi<numPolys;pi++)
+    {
+        if (normX[pi]*eyePos.x() + normY[pi]*eyePos.y() + normZ[pi]*eyePos.z() < 0.0)
+        {
+            polyImport[pi] = -1.0;
+        }
+    }
+
+    for (unsigned int offi=0;offi<viewState->viewMatrices.size();offi++)
+    {
+        projectCorners(viewState, offi, frameSize);
+
+        for (size_t pi=0;pi<numPolys;pi++)
+        {
+            if (polyImport[pi] < 0.0)
+            {
+                continue;
+            }
+
+            const size_t ci = 4*pi;
+            const uint8_t *out = &cornerOutside[ci];
+            // All the corners are outside the same plane, so clipping leaves nothing
+            if (out[0] & out[1] & out[2] & out[3])
+            {
+                continue;
+            }
+
+            const Entry &entry = entries[polyEntry[pi]];
+            const int polyIdx = (int)pi - entry.polyStart;
+            const Point3dVector &poly = entry.dispSolid->polys[polyIdx];
+            const Point3d &norm = entry.dispSolid->normals[polyIdx];
+
+            double import;
+            if ((out[0] | out[1] | out[2] | out[3]) == 0)
+            {
+                // Entirely inside, so clipping wouldn't change it and the screen area is all of it.
+                // Same sum as CalcLoopArea, with the same intermediate precision.
+                typedef detail::TDefaultIntermediate TInt;
+                const double *sx = &screenX[ci];
+                const double *sy = &screenY[ci];
+                TInt area = 0.0;
+                for (int ii=0;ii<4;ii++)
+                {
+                    const int next = (ii+1) & 3;
+                    area += (TInt)sx[ii] * (TInt)sy[next];
+                    area -= (TInt)sy[ii] * (TInt)sx[next];
+                }
+                import = (double)area;
+                // The polygon came out backwards, so toss it
+                if (!std::isfinite(import) || import <= 0.0)
+                {
+                    continue;
+                }
+                // Clipping leaves the corners as they were, so scale by them as the clipping path does
+                clipCorners.clear();
+                PolyToClipSpace(poly, viewState, offi, clipCorners);
+                import *= ClippedAreaScale(clipCorners, norm, polyArea[pi], viewState, offi);
+            }
+            else
+            {
+                // Crosses the frustum, so it needs the full treatment
+                import = PolyImportanceForView(poly, norm, polyArea[pi], viewState, offi, frameSize);
+            }
+
+            polyImport[pi] = std::max(polyImport[pi], import);
+        }
+    }
+
+    const bool isFlat = viewState->coordAdapter->isFlat();
+    for (size_t ei=0;ei<entries.size();ei++)
+    {
+        const Entry &entry = entries[ei];
+        if (!entry.batched)
+        {
+            importance[ei] = entry.dispSolid ? entry.dispSolid->importanceForViewState(viewState, frameSize) : 0.0;
+            continue;
+        }
+
+        // If the viewer is inside the bounds, the node is maximally important
+        if (!isFlat && entry.dispSolid->isInside(eyePos))
+        {
+            importance[ei] = MAXFLOAT;
+            continue;
+        }
+
+        double totalImport = 0.0;
+        for (int pi=entry.polyStart;pi<entry.polyStart+entry.numPolys;pi++)
+        {
+            if (polyImport[pi] > 0.0)
+            {
+                totalImport += polyImport[pi];
+            }
+        }
+
+        // The flat map case is optimized to only evaluate one poly, since there's no curvature
+        importance[ei] = totalImport * (entry.numPolys > 1 ? 0.5 : 1.0);
+    }
+}
+
+void DisplaySolidBatch::isOnScreenForViewState(ViewState *viewState,const Point2f &frameSize,std::vector<bool> &onScreen)
+{
+    onScreen.assign(entries.size(), false);
+
+    const bool isFlat = viewState->coordAdapter->isFlat();
+    for (size_t ei=0;ei<entries.size();ei++)
+    {
+        const Entry &entry = entries[ei];
+        if (!entry.batched)
+        {
+            onScreen[ei] = entry.dispSolid && entry.dispSolid->isOnScreenForViewState(viewState, frameSize);
+        }
+        else if (!isFlat && entry.dispSolid->isInside(viewState->eyePos))
+        {
+            onScreen[ei] = true;
+        }
+    }
+
+    const size_t numPolys = polyEntry.size();
+    for (unsigned int offi=0;offi<viewState->viewMatrices.size();offi++)
+    {
+        projectCorners(viewState, offi, frameSize);
+
+        for (size_t pi=0;pi<numPolys;pi++)
+        {
+            const int ei = polyEntry[pi];
+            if (onScreen[ei])
+            {
+                continue;
+            }
+
+            const uint8_t *out = &cornerOutside[4*pi];
+            if (out[0] & out[1] & out[2] & out[3])
+            {
+                continue;
+            }
+            if ((out[0] | out[1] | out[2] | out[3]) == 0)
+            {
+                onScreen[ei] = true;
+            }
+            else
+            {
+                const Entry &entry = entries[ei];
+                onScreen[ei] = PolyOnScreenForView(entry.dispSolid->polys[pi - entry.polyStart], viewState, offi);
+            }
+        }
+    }
+}
+
+DisplaySolidCache::DisplaySolidCache(size_t maxEntries) :
+    maxEntries(std::max((size_t)1, maxEntries))
+{
+}
+
+bool DisplaySolidCache::Key::operator == (const Key &that) const
+{
+    return nodeNumber == that.nodeNumber && ll == that.ll && ur == that.ur &&
+           srcSystem == that.srcSystem && coordAdapter == that.coordAdapter;
+}
+
+size_t DisplaySolidCache::KeyHash::operator () (const Key &key) const
+{
+    // The node number is nearly always enough, the rest is to be sure
+    size_t hash = std::hash<int64_t>()(key.nodeNumber);
+    hash ^= std::hash<const void *>()(key.srcSystem) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+    hash ^= std::hash<const void *>()(key.coordAdapter) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+    return hash;
+}
+
+DisplaySolidRef DisplaySolidCache::getSolid(const QuadTreeIdentifier &nodeIdent,const Mbr &nodeMbr,
+                                            const CoordSystem *srcSystem,const CoordSystemDisplayAdapter *coordAdapter)
+{
+    const Key key { nodeIdent.NodeNumber(), nodeMbr.ll(), nodeMbr.ur(), srcSystem, coordAdapter };
+
+    {
+        std::lock_guard<std::mutex> guardLock(lock);
+        const auto it = entriesByKey.find(key);
+        if (it != entriesByKey.end())
+        {
+            entries.splice(entries.begin(), entries, it->second);
+            hits++;
+            return it->second->second;
+        }
+    }
+
+    // Build it outside the lock, it's the slow part
+    auto dispSolid = std::make_shared<DisplaySolid>(nodeIdent,nodeMbr,0.0,0.0,srcSystem,coordAdapter);
+    misses++;
+
+    std::lock_guard<std::mutex> guardLock(lock);
+    const auto res = entriesByKey.insert(std::make_pair(key, entries.end()));
+    if (!res.second)
+    {
+        // Someone else got there first
+        return res.first->second->second;
+    }
+    entries.emplace_front(key, dispSolid);
+    res.first->second = entries.begin();
+
+    while (entries.size() > maxEntries)
+    {
+        entriesByKey.erase(entries.back().first);
+        entries.pop_back();
+    }
+
+    return dispSolid;
+}
+
+void DisplaySolidCache::clear()
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+    entriesByKey.clear();
+    entries.clear();
+}
+
+void DisplaySolidCache::setMaxEntries(size_t newMaxEntries)
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+    maxEntries = std::max((size_t)1, newMaxEntries);
+    while (entries.size() > maxEntries)
+    {
+        entriesByKey.erase(entries.back().first);
+        entries.pop_back();
+    }
+}
+
+size_t DisplaySolidCache::getNumEntries() const
+{
+    std::lock_guard<std::mutex> guardLock(lock);
+    return entries.size();
+}
+
 bool TileIsOnScreen(ViewState *viewState,const WhirlyKit::Point2f &frameSize,WhirlyKit::CoordSystem *srcSystem,WhirlyKit::CoordSystemDisplayAdapter *coordAdapter,const WhirlyKit::Mbr &nodeMbr,const WhirlyKit::QuadTreeIdentifier &nodeIdent,DisplaySolidRef &dispSolid)
 {
     if (!dispSolid)
@@ -135,6 +135,48 @@ Point3d SphericalMercatorCoordSystem::geocentricToLocal(const Point3d &geocPt) c
     return {localPt.x(),localPt.y(),geoCoordPlus.z()};
 }
 
+void SphericalMercatorCoordSystem::localToGeographicArray(const Point3d *pts,Point2d *outPts,size_t numPts) const
+{
+    for (size_t ii=0;ii<numPts;ii++)
+    {
+        const Point3d &pt = pts[ii];
+        outPts[ii] = Point2d(pt.x() + originLon, atan(sinh(pt.y())));
+    }
+}
+
+void SphericalMercatorCoordSystem::geographicToLocalArray(const Point2d *pts,Point3d *outPts,size_t numPts) const
+{
+    for (size_t ii=0;ii<numPts;ii++)
+    {
+        const Point2d &geo = pts[ii];
+        const double lat = std::min(PoleLimit, std::max(-PoleLimit, geo.y()));
+        outPts[ii] = Point3d(geo.x() - originLon, std::log((1.0 + std::sin(lat)) / std::cos(lat)), 0.0);
+    }
+}
+
+void SphericalMercatorCoordSystem::localToGeocentricArray(const Point3d *pts,Point3d *outPts,size_t numPts) const
+{
+    // Go to geographic in place, then hand the whole array to proj.4
+    for (size_t ii=0;ii<numPts;ii++)
+    {
+        const Point3d &pt = pts[ii];
+        outPts[ii] = Point3d(pt.x() + originLon, atan(sinh(pt.y())), pt.z());
+    }
+    GeoCoordSystem::LocalToGeocentric(outPts,outPts,numPts);
+}
+
+void SphericalMercatorCoordSystem::geocentricToLocalArray(const Point3d *pts,Point3d *outPts,size_t numPts) const
+{
+    GeoCoordSystem::GeocentricToLocal(pts,outPts,numPts);
+    for (size_t ii=0;ii<numPts;ii++)
+    {
+        // Round through GeoCoord like the single point version so the results agree
+        const Point3d &geoCoordPlus = outPts[ii];
+        const Point3d localPt = SphericalMercatorCoordSystem::geographicToLocal3d(GeoCoord((float)geoCoordPlus.x(), (float)geoCoordPlus.y()));
+        outPts[ii] = Point3d(localPt.x(),localPt.y(),geoCoordPlus.z());
+    }
+}
+
 bool SphericalMercatorCoordSystem::isSameAs(const CoordSystem *coordSys) const
 {
     const auto other = dynamic_cast<const SphericalMercatorCoordSystem *>(coordSys);
@@ -203,4 +245,18 @@ WhirlyKit::Point3d SphericalMercatorDisplayAdapter::displayToLocal(const WhirlyK
     return dispPt + Point3d(org.x(),org.y(),0.0);
 }
 
+void SphericalMercatorDisplayAdapter::localToDisplayArray(const Point3d *pts,Point3d *outPts,size_t numPts) const
+{
+    const Point3d off(org.x(),org.y(),0.0);
+    for (size_t ii=0;ii<numPts;ii++)
+        outPts[ii] = pts[ii] - off;
+}
+
+void SphericalMercatorDisplayAdapter::displayToLocalArray(const Point3d *pts,Point3d *outPts,size_t numPts) const
+{
+    const Point3d off(org.x(),org.y(),0.0);
+    for (size_t ii=0;ii<numPts;ii++)
+        outPts[ii] = pts[ii] + off;
+}
+
 }
@@ -265,8 +265,15 @@ RawDataRef Texture::processData()
     {
     default:
     case TexTypeUnsignedByte: return texData;
-    case TexTypeShort565:     return ConvertRGBATo565(texData);
-    case TexTypeShort4444:    return ConvertRGBATo4444(texData);
+    case TexTypeShort565:
+        // May have been packed already, e.g. by the PNG decoder
+        if (texData->getLen() == width * height * 2)
+            return texData;
+        return ConvertRGBATo565(texData);
+    case TexTypeShort4444:
+        if (texData->getLen() == width * height * 2)
+            return texData;
+        return ConvertRGBATo4444(texData);
     case TexTypeShort5551:    return ConvertRGBATo5551(texData);
     case TexTypeSingleChannel:
         if (texData->getLen() == width * height)
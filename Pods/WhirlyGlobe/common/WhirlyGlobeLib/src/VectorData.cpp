@@ -307,17 +307,24 @@ void SubdivideEdgesToSurfaceGC(const VectorRing &inPts,Point3dVector &outPts,boo
         return;
     }
 
+    // Take all the points to display space at once, rather than twice each along the way
+    Point2dVector geoPts(inPts.size());
+    for (size_t ii=0;ii<inPts.size();ii++)
+        geoPts[ii] = inPts[ii].cast<double>();
+    Point3dVector dispPts(inPts.size());
+    coordSys->geographicToLocalArray(geoPts.data(), dispPts.data(), dispPts.size());
+    adapter->localToDisplayArray(dispPts.data(), dispPts.data(), dispPts.size());
+    if (!adapter->isFlat())
+    {
+        for (auto &dp : dispPts)
+           dp = dp.normalized() * (1.0 + surfOffset);
+    }
+
     const auto eps2 = (double)eps * eps;
     for (int ii=0;ii<(closed ? inPts.size() : inPts.size()-1);ii++)
     {
-        const Point2f &p0 = inPts[ii];
-        const Point2f &p1 = inPts[(ii+1)%inPts.size()];
-        Point3d dp0 = adapter->localToDisplay(coordSys->geographicToLocal3d(GeoCoord(p0.x(),p0.y())));
-        if (!adapter->isFlat())
-           dp0 = dp0.normalized() * (1.0 + surfOffset);
-        Point3d dp1 = adapter->localToDisplay(coordSys->geographicToLocal3d(GeoCoord(p1.x(),p1.y())));
-        if (!adapter->isFlat())
-           dp1 = dp1.normalized() * (1.0 + surfOffset);
+        const Point3d &dp0 = dispPts[ii];
+        const Point3d &dp1 = dispPts[(ii+1)%inPts.size()];
         outPts.push_back(dp0);
         subdivideToSurfaceRecurseGC(dp0,dp1,outPts,adapter,eps2,surfOffset,minPts);
     }
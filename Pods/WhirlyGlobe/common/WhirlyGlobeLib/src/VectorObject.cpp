@@ -107,13 +107,41 @@ bool VectorObject::fromShapeFile(const std::string &fileName)
     return true;
 }
 
+void VectorShapeSource::resolve(ShapeSet &shapes)
+{
+    std::call_once(once, [&]{
+        buildShapes(shapes);
+        resolved = true;
+    });
+}
+
+void VectorObject::setShapeSource(VectorShapeSourceRef source)
+{
+    shapeSource = std::move(source);
+}
+
+void VectorObject::ensureShapes() const
+{
+    if (shapeSource && !shapeSource->isResolved())
+    {
+        // Logically, the shapes were always there
+        shapeSource->resolve(const_cast<ShapeSet &>(shapes));
+    }
+}
+
 MutableDictionaryRef VectorObject::getAttributes() const
 {
+    // Don't build the shapes just to get at the attributes
+    if (shapesPending())
+    {
+        return shapeSource->getAttributes();
+    }
     return shapes.empty() ? MutableDictionaryRef() : (*shapes.begin())->getAttrDict();
 }
 
 void VectorObject::setAttributes(const MutableDictionaryRef &newDict)
 {
+    ensureShapes();
     for (const auto &shape : shapes)
     {
         shape->setAttrDict(newDict);
@@ -122,12 +150,15 @@ void VectorObject::setAttributes(const MutableDictionaryRef &newDict)
 
 void VectorObject::mergeVectorsFrom(const VectorObject &otherVec)
 {
+    ensureShapes();
+    otherVec.ensureShapes();
     shapes.reserve(otherVec.shapes.size());
     shapes.insert(otherVec.shapes.begin(),otherVec.shapes.end());
 }
 
 void VectorObject::splitVectors(std::vector<VectorObject *> &vecs)
 {
+    ensureShapes();
     vecs.reserve(vecs.size() + shapes.size());
     for (const auto &shape : shapes)
     {
@@ -139,6 +170,7 @@ void VectorObject::splitVectors(std::vector<VectorObject *> &vecs)
 
 bool VectorObject::center(Point2d &center) const
 {
+    ensureShapes();
     Mbr mbr;
     for (const auto &shape : shapes)
     {
@@ -161,6 +193,7 @@ bool VectorObject::center(Point2d &center) const
 
 bool VectorObject::centroid(Point2d &centroid) const
 {
+    ensureShapes();
     // Find the loop with the largest area
     float bigArea = 0.0;
     const VectorRing *bigLoop = nullptr;
@@ -216,6 +249,7 @@ bool VectorObject::centroid(Point2d &centroid) const
 
 bool VectorObject::largestLoopCenter(Point2d &center,Point2d &ll,Point2d &ur) const
 {
+    ensureShapes();
     // Find the loop with the largest area
     double bigArea = -1.0;
     const VectorRing *bigLoop = nullptr;
@@ -259,6 +293,7 @@ bool VectorObject::largestLoopCenter(Point2d &center,Point2d &ll,Point2d &ur) co
 
 bool VectorObject::linearMiddle(Point2d &middle,double &rot) const
 {
+    ensureShapes();
     if (shapes.empty())
         return false;
     
@@ -341,6 +376,7 @@ bool VectorObject::linearMiddle(Point2d &middle,double &rot) const
     
 bool VectorObject::linearMiddle(Point2d &middle,double &rot,CoordSystem *coordSys) const
 {
+    ensureShapes();
     if (shapes.empty())
         return false;
 
@@ -451,6 +487,7 @@ bool VectorObject::linearMiddle(Point2d &middle,double &rot,CoordSystem *coordSy
     
 bool VectorObject::middleCoordinate(Point2d &middle) const
 {
+    ensureShapes();
     if (shapes.empty())
         return false;
     
@@ -475,6 +512,7 @@ bool VectorObject::middleCoordinate(Point2d &middle) const
     
 bool VectorObject::pointInside(const Point2d &pt) const
 {
+    ensureShapes();
     for (const auto &shape : shapes)
     {
         if (const auto areal = dynamic_cast<VectorAreal*>(shape.get()))
@@ -604,6 +642,7 @@ static inline bool checkBounds(const Point2f &screenCoord, const GeoCoord &geoCo
 bool VectorObject::pointNearLinear(const Point2d &coord,float maxDistance,
                                    const ViewStateRef &viewState,const Point2f &frameSize) const
 {
+    ensureShapes();
     CoordSystemDisplayAdapter *coordAdapter = viewState->coordAdapter;
    
     const auto globeView = dynamic_cast<WhirlyGlobe::GlobeViewState*>(viewState.get());
@@ -756,6 +795,7 @@ bool VectorObject::pointNearLinear(const Point2d &coord,float maxDistance,
 
 double VectorObject::areaOfOuterLoops() const
 {
+    ensureShapes();
     double area = 0.0;
     for (const auto& shape : shapes)
     {
@@ -771,6 +811,7 @@ double VectorObject::areaOfOuterLoops() const
 
 bool VectorObject::boundingBox(Point2d &ll,Point2d &ur) const
 {
+    ensureShapes();
     Mbr mbr;
     for (const auto &shape : shapes)
     {
@@ -795,6 +836,7 @@ bool VectorObject::boundingBox(Point2d &ll,Point2d &ur) const
 
 void VectorObject::addHole(const VectorRing &hole)
 {
+    ensureShapes();
     if (shapes.empty())
     {
         return;
@@ -808,6 +850,7 @@ void VectorObject::addHole(const VectorRing &hole)
 
 VectorObjectRef VectorObject::deepCopy() const
 {
+    ensureShapes();
     auto newVecObj = std::make_shared<VectorObject>();
     newVecObj->shapes.reserve(shapes.size());
 
@@ -855,6 +898,11 @@ VectorObjectRef VectorObject::deepCopy() const
 
 VectorObjectType VectorObject::getVectorType() const
 {
+    // Don't build the shapes just to find out what they'll be
+    if (shapesPending())
+    {
+        return shapeSource->getVectorType();
+    }
     if (shapes.empty())
         return VectorMultiType;
 
@@ -906,6 +954,7 @@ std::string to_string(T value)
 
 std::string VectorObject::log() const
 {
+    ensureShapes();
     std::string outStr;
     
     for (const auto &shapeRef : shapes)
@@ -956,44 +1005,56 @@ std::string VectorObject::log() const
     return outStr;
 }
     
+// Convert 2D points between coordinate systems a whole array at a time
+static void ReprojectPoints(const CoordSystem *inSystem,double scale,const CoordSystem *outSystem,double outScale,
+                            Point2f *pts,size_t numPts,Point3dVector &scratch)
+{
+    scratch.resize(numPts);
+    for (size_t ii=0;ii<numPts;ii++)
+        scratch[ii] = Point3d(pts[ii].x()*scale,pts[ii].y()*scale,0.0);
+    CoordSystemConvert3d(inSystem, outSystem, scratch.data(), scratch.data(), numPts);
+    for (size_t ii=0;ii<numPts;ii++)
+        pts[ii] = Point2f(scratch[ii].x()*outScale,scratch[ii].y()*outScale);
+}
+
 void VectorObject::reproject(CoordSystem *inSystem,double scale,CoordSystem *outSystem)
 {
+    ensureShapes();
+    Point3dVector scratch;
     for (const auto &shapeRef : shapes)
     {
         const auto shape = shapeRef.get();
         if (const auto points = dynamic_cast<VectorPoints*>(shape))
         {
-            for (Point2f &pt : points->pts)
-            {
-                const Point3f outPt = CoordSystemConvert(inSystem, outSystem, Point3f(pt.x()*scale,pt.y()*scale,0.0));
-                pt.x() = outPt.x();  pt.y() = outPt.y();
-            }
+            ReprojectPoints(inSystem, scale, outSystem, 1.0, points->pts.data(), points->pts.size(), scratch);
             points->calcGeoMbr();
         } else if (const auto lin = dynamic_cast<VectorLinear*>(shape)) {
-            for (Point2f &pt : lin->pts)
-            {
-                const Point3f outPt = CoordSystemConvert(inSystem, outSystem, Point3f(pt.x()*scale,pt.y()*scale,0.0));
-                pt.x() = outPt.x();  pt.y() = outPt.y();
-            }
+            ReprojectPoints(inSystem, scale, outSystem, 1.0, lin->pts.data(), lin->pts.size(), scratch);
             lin->calcGeoMbr();
         } else if (const auto lin3d = dynamic_cast<VectorLinear3d*>(shape)) {
             for (Point3d &pt : lin3d->pts)
             {
-                const Point3d outPt = CoordSystemConvert3d(inSystem, outSystem, pt * scale);
-                pt = outPt;
+                pt *= scale;
             }
+            CoordSystemConvert3d(inSystem, outSystem, lin3d->pts.data(), lin3d->pts.data(), lin3d->pts.size());
             lin3d->calcGeoMbr();
         } else if (const auto ar = dynamic_cast<VectorAreal*>(shape)) {
             for (auto &loop : ar->loops)
-                for (Point2f &pt : loop) {
-                    const Point3f outPt = CoordSystemConvert(inSystem, outSystem, Point3f(pt.x()*scale,pt.y()*scale,0.0));
-                    pt.x() = outPt.x() * 180 / M_PI;  pt.y() = outPt.y() * 180 / M_PI;
-                }
+            {
+                ReprojectPoints(inSystem, scale, outSystem, 180 / M_PI, loop.data(), loop.size(), scratch);
+            }
             ar->calcGeoMbr();
         } else if (const auto tri = dynamic_cast<VectorTriangles*>(shape)) {
-            for (Point3f &pt : tri->pts)
+            scratch.resize(tri->pts.size());
+            for (size_t ii=0;ii<tri->pts.size();ii++)
+            {
+                const Point3f &pt = tri->pts[ii];
+                scratch[ii] = Point3d(pt.x()*scale,pt.y()*scale,pt.z());
+            }
+            CoordSystemConvert3d(inSystem, outSystem, scratch.data(), scratch.data(), scratch.size());
+            for (size_t ii=0;ii<tri->pts.size();ii++)
             {
-                pt = CoordSystemConvert(inSystem, outSystem, Point3f(pt.x()*scale,pt.y()*scale,pt.z()));
+                tri->pts[ii] = scratch[ii].cast<float>();
             }
             tri->calcGeoMbr();
         }
@@ -1002,6 +1063,7 @@ void VectorObject::reproject(CoordSystem *inSystem,double scale,CoordSystem *out
     
 void VectorObject::subdivideToGlobe(float epsilon)
 {
+    ensureShapes();
     FakeGeocentricDisplayAdapter adapter;
     
     VectorRing outPts;
@@ -1299,6 +1361,7 @@ static void SubdivideGeoLib(const VectorRing3d &inPts, VectorRing3d &outPts, dou
 
 void VectorObject::subdivideToInternal(float epsilon,WhirlyKit::CoordSystemDisplayAdapter *adapter,bool useGeoLib,bool edgeMode)
 {
+    ensureShapes();
     CoordSystem *coordSys = adapter->getCoordSystem();
 
     const auto geoDist = useGeoLib ? epsilon * GEOC_EARTH_RAD : 0.0;
@@ -1385,6 +1448,7 @@ void VectorObject::subdivideToFlatGreatCirclePrecise(float epsilon)
 
 VectorObjectRef VectorObject::linearsToAreals() const
 {
+    ensureShapes();
     auto newVec = std::make_shared<VectorObject>();
     newVec->shapes.reserve(shapes.size());
 
@@ -1408,6 +1472,7 @@ VectorObjectRef VectorObject::linearsToAreals() const
 
 VectorObjectRef VectorObject::arealsToLinears() const
 {
+    ensureShapes();
     auto newVec = std::make_shared<VectorObject>();
     newVec->shapes.reserve(shapes.size());
 
@@ -1441,16 +1506,19 @@ static int count(TIter beg, TIter end)
 
 int VectorObject::countLinears() const
 {
+    ensureShapes();
     return count<VectorLinear>(shapes.cbegin(), shapes.cend());
 }
 
 int VectorObject::countAreals() const
 {
+    ensureShapes();
     return count<VectorAreal>(shapes.cbegin(), shapes.cend());
 }
 
 void VectorObject::reverseAreals()
 {
+    ensureShapes();
     for (auto& shape : shapes)
     {
         if (auto areal = dynamic_cast<VectorAreal*>(shape.get()))
@@ -1465,6 +1533,7 @@ void VectorObject::reverseAreals()
 
 VectorObjectRef VectorObject::reversedAreals() const
 {
+    ensureShapes();
     auto newVec = std::make_shared<VectorObject>();
     newVec->shapes.reserve(shapes.size());
 
@@ -1492,6 +1561,7 @@ VectorObjectRef VectorObject::reversedAreals() const
 
 int VectorObject::countClosedLoops() const
 {
+    ensureShapes();
     int n = 0;
     for (auto& shape : shapes)
     {
@@ -1511,6 +1581,7 @@ int VectorObject::countClosedLoops() const
 
 int VectorObject::countUnClosedLoops() const
 {
+    ensureShapes();
     int n = 0;
     for (auto& shape : shapes)
     {
@@ -1530,6 +1601,7 @@ int VectorObject::countUnClosedLoops() const
 
 void VectorObject::closeLoops()
 {
+    ensureShapes();
     for (auto& shape : shapes)
     {
         if (auto areal = dynamic_cast<VectorAreal*>(shape.get()))
@@ -1557,6 +1629,7 @@ VectorObjectRef VectorObject::closedLoops() const
 
 void VectorObject::unCloseLoops()
 {
+    ensureShapes();
     for (auto& shape : shapes)
     {
         if (auto areal = dynamic_cast<VectorAreal*>(shape.get()))
@@ -1584,6 +1657,7 @@ VectorObjectRef VectorObject::unClosedLoops() const
 
 bool VectorObject::anyIntersections() const
 {
+    ensureShapes();
     for (const auto &shape : shapes)
     {
         if (const auto ln = dynamic_cast<const VectorLinear*>(shape.get()))
@@ -1609,6 +1683,7 @@ bool VectorObject::anyIntersections() const
 
 VectorObjectRef VectorObject::filterClippedEdges() const
 {
+    ensureShapes();
     auto newVec = std::make_shared<VectorObject>();
     newVec->shapes.reserve(shapes.size());
 
@@ -1664,6 +1739,7 @@ VectorObjectRef VectorObject::filterClippedEdges() const
     
 VectorObjectRef VectorObject::tesselate() const
 {
+    ensureShapes();
     auto newVec = std::make_shared<VectorObject>();
     newVec->shapes.reserve(shapes.size());
 
@@ -1684,6 +1760,7 @@ VectorObjectRef VectorObject::tesselate() const
     
 VectorObjectRef VectorObject::clipToGrid(const Point2d &gridSize)
 {
+    ensureShapes();
     auto newVec = std::make_shared<VectorObject>();
     newVec->shapes.reserve(shapes.size());
 
@@ -1710,6 +1787,7 @@ VectorObjectRef VectorObject::clipToGrid(const Point2d &gridSize)
 
 VectorObjectRef VectorObject::clipToMbr(const Point2d &ll,const Point2d &ur)
 {
+    ensureShapes();
     auto newVec = std::make_shared<VectorObject>();
     newVec->shapes.reserve(shapes.size());
 
@@ -0,0 +1,549 @@
+/*  VectorTileAttributes.cpp
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#import "VectorTileAttributes.h"
+#import "WhirlyKitLog.h"
+
+namespace WhirlyKit
+{
+
+// From DictionaryC.cpp
+extern RGBAColor ARGBtoRGBAColor(uint32_t v);
+extern RGBAColor parseColor(const char* p, RGBAColor ret);
+
+namespace {
+    // Fields every feature gets from its layer
+    const std::string layerNameKey("layer_name");       //NOLINT
+    const std::string geometryTypeKey("geometry_type"); //NOLINT
+    const std::string layerOrderKey("layer_order");     //NOLINT
+
+    VectorTileValue makeIntValue(int64_t v)
+    {
+        VectorTileValue val;
+        val.intValue = v;
+        val.type = VectorTileValue::ValInt;
+        return val;
+    }
+}
+
+DictionaryType VectorTileValue::dictType() const
+{
+    switch (type)
+    {
+        case ValString: return DictTypeString;
+        case ValFloat:
+        case ValDouble: return DictTypeDouble;
+        case ValInt:
+        case ValUInt:
+        case ValSInt:
+        case ValBool:   return DictTypeInt;
+        case ValNone:
+        default:        return DictTypeNone;
+    }
+}
+
+int64_t VectorTileValue::getInt64() const
+{
+    switch (type)
+    {
+        case ValInt:    return intValue;
+        case ValUInt:   return (int64_t)uintValue;
+        case ValSInt:   return sintValue;
+        case ValBool:   return boolValue ? 1 : 0;
+        case ValFloat:  return (int64_t)floatValue;
+        case ValDouble: return (int64_t)doubleValue;
+        default:        return 0;
+    }
+}
+
+double VectorTileValue::getDouble() const
+{
+    switch (type)
+    {
+        case ValFloat:  return floatValue;
+        case ValDouble: return doubleValue;
+        default:        return (double)getInt64();
+    }
+}
+
+DictionaryEntryRef VectorTileValue::makeEntry() const
+{
+    switch (dictType())
+    {
+        case DictTypeString: return std::make_shared<DictionaryEntryCString>(std::string(stringValue));
+        case DictTypeDouble: return std::make_shared<DictionaryEntryCBasic>(getDouble());
+        case DictTypeInt:    return std::make_shared<DictionaryEntryCBasic>((int)getInt64());
+        default:             return DictionaryEntryRef();
+    }
+}
+
+void VectorTileLayerTable::copyStrings()
+{
+    size_t total = 0;
+    for (const auto &key : keys)
+    {
+        total += key.size();
+    }
+    for (const auto &value : values)
+    {
+        if (value.type == VectorTileValue::ValString)
+        {
+            total += value.stringValue.size();
+        }
+    }
+
+    strings.resize(total);
+    char *pos = strings.data();
+    const auto copyView = [&pos](std::string_view &view)
+    {
+        if (!view.empty())
+        {
+            memcpy(pos, view.data(), view.size());
+            view = std::string_view(pos, view.size());
+            pos += view.size();
+        }
+    };
+    for (auto &key : keys)
+    {
+        copyView(key);
+    }
+    for (auto &value : values)
+    {
+        if (value.type == VectorTileValue::ValString)
+        {
+            copyView(value.stringValue);
+        }
+    }
+}
+
+void VectorTileLayerTable::setupPredicates(const void *group,uint32_t count)
+{
+    const size_t stride = (values.size() + 63) / 64;
+    predicateBits.assign((size_t)count * 2 * stride, 0);
+    predicateCount = count;
+    predicateGroup = group;
+}
+
+void VectorTileLayerTable::setPredicate(uint32_t which,uint32_t valueIndex,bool result)
+{
+    const size_t stride = (values.size() + 63) / 64;
+    const size_t word = (size_t)which * 2 * stride + valueIndex / 64;
+    const uint64_t bit = (uint64_t)1 << (valueIndex % 64);
+    predicateBits[word] |= bit;
+    if (result)
+    {
+        predicateBits[word + stride] |= bit;
+    }
+}
+
+VectorTileAttributes::VectorTileAttributes(const VectorTileLayerTable *layer,uint32_t tagStart,uint32_t tagEnd,int geomType)
+    : layer(layer), tagStart(tagStart), tagEnd(tagStart + ((tagEnd - tagStart) & ~1U)), geomType(geomType)
+{
+}
+
+bool VectorTileAttributes::findValue(const std::string &name,VectorTileValue &val) const
+{
+    if (overlay)
+    {
+        return false;
+    }
+
+    // Scan backwards so that a repeated key gets the last value, as if they'd been set in order
+    const auto &tags = layer->tags;
+    for (uint32_t ii = tagEnd; ii > tagStart; ii -= 2)
+    {
+        const auto keyIndex = tags[ii - 2];
+        const auto valueIndex = tags[ii - 1];
+        if (keyIndex >= layer->keys.size() || valueIndex >= layer->values.size())
+        {
+            continue;
+        }
+        const auto &key = layer->keys[keyIndex];
+        if (key.empty() || key.size() != name.size() || key != name)
+        {
+            continue;
+        }
+        const auto &value = layer->values[valueIndex];
+        if (value.type == VectorTileValue::ValNone)
+        {
+            continue;
+        }
+        val = value;
+        return true;
+    }
+
+    if (name == layerNameKey)
+    {
+        val.stringValue = layer->layerName;
+        val.type = VectorTileValue::ValString;
+        return true;
+    }
+    if (name == geometryTypeKey)
+    {
+        val = makeIntValue(geomType);
+        return true;
+    }
+    if (name == layerOrderKey)
+    {
+        val = makeIntValue(layer->layerOrder);
+        return true;
+    }
+
+    return false;
+}
+
+const VectorTileValue *VectorTileAttributes::findValue(int keyID) const
+{
+    if (overlay || keyID < 0)
+    {
+        return nullptr;
+    }
+
+    const auto &tags = layer->tags;
+    const auto &keyIDs = layer->keyIDs;
+    for (uint32_t ii = tagEnd; ii > tagStart; ii -= 2)
+    {
+        const auto keyIndex = tags[ii - 2];
+        const auto valueIndex = tags[ii - 1];
+        if (keyIndex >= keyIDs.size() || keyIDs[keyIndex] != keyID || valueIndex >= layer->values.size())
+        {
+            continue;
+        }
+        const auto &value = layer->values[valueIndex];
+        if (value.type != VectorTileValue::ValNone)
+        {
+            return &value;
+        }
+    }
+    return nullptr;
+}
+
+bool VectorTileAttributes::isLayerField(const std::string &name)
+{
+    return name == layerNameKey || name == geometryTypeKey || name == layerOrderKey;
+}
+
+void VectorTileAttributes::copyInto(MutableDictionaryC &dict) const
+{
+    dict.setString(layerNameKey, layer->layerName);
+    dict.setInt(geometryTypeKey, geomType);
+    dict.setInt(layerOrderKey, layer->layerOrder);
+
+    const auto &tags = layer->tags;
+    for (uint32_t ii = tagStart; ii < tagEnd; ii += 2)
+    {
+        const auto keyIndex = tags[ii];
+        const auto valueIndex = tags[ii + 1];
+        if (keyIndex >= layer->keys.size() || valueIndex >= layer->values.size() ||
+            layer->keys[keyIndex].empty())
+        {
+            continue;
+        }
+
+        const auto key = std::string(layer->keys[keyIndex]);
+        const auto &value = layer->values[valueIndex];
+        switch (value.type)
+        {
+            case VectorTileValue::ValString: dict.setString(key, std::string(value.stringValue)); break;
+            case VectorTileValue::ValFloat:
+            case VectorTileValue::ValDouble: dict.setDouble(key, value.getDouble()); break;
+            case VectorTileValue::ValInt:
+            case VectorTileValue::ValUInt:
+            case VectorTileValue::ValSInt:
+            case VectorTileValue::ValBool:   dict.setInt(key, (int)value.getInt64()); break;
+            case VectorTileValue::ValNone:
+            default:
+                break;
+        }
+    }
+}
+
+MutableDictionaryC &VectorTileAttributes::makeMutable()
+{
+    if (!overlay)
+    {
+        auto dict = std::make_shared<MutableDictionaryC>();
+        copyInto(*dict);
+        overlay = std::move(dict);
+    }
+    return *overlay;
+}
+
+MutableDictionaryRef VectorTileAttributes::copy() const
+{
+    if (overlay)
+    {
+        return overlay->copy();
+    }
+    auto dict = std::make_shared<MutableDictionaryC>();
+    copyInto(*dict);
+    return dict;
+}
+
+int VectorTileAttributes::count() const
+{
+    return overlay ? overlay->count() : (int)getKeys().size();
+}
+
+bool VectorTileAttributes::hasField(const std::string &name) const
+{
+    if (overlay)
+    {
+        return overlay->hasField(name);
+    }
+    VectorTileValue val;
+    return findValue(name, val);
+}
+
+DictionaryType VectorTileAttributes::getType(const std::string &name) const
+{
+    if (overlay)
+    {
+        return overlay->getType(name);
+    }
+    VectorTileValue val;
+    return findValue(name, val) ? val.dictType() : DictTypeNone;
+}
+
+int VectorTileAttributes::getInt(const std::string &name,int defVal) const
+{
+    return (int)getInt64(name, defVal);
+}
+
+int64_t VectorTileAttributes::getInt64(const std::string &name,int64_t defVal) const
+{
+    if (overlay)
+    {
+        return overlay->getInt64(name, defVal);
+    }
+    VectorTileValue val;
+    if (!findValue(name, val))
+    {
+        return defVal;
+    }
+    if (val.type == VectorTileValue::ValString)
+    {
+        wkLogLevel(Warn, "Unsupported conversion from type %d to int", DictTypeString);
+        return defVal;
+    }
+    return val.getInt64();
+}
+
+SimpleIdentity VectorTileAttributes::getIdentity(const std::string &name) const
+{
+    return (SimpleIdentity)getInt64(name, EmptyIdentity);
+}
+
+bool VectorTileAttributes::getBool(const std::string &name,bool defVal) const
+{
+    if (overlay)
+    {
+        return overlay->getBool(name, defVal);
+    }
+    VectorTileValue val;
+    if (!findValue(name, val))
+    {
+        return defVal;
+    }
+    if (val.dictType() != DictTypeInt)
+    {
+        wkLogLevel(Warn, "Unsupported conversion from type %d to bool", val.dictType());
+        return defVal;
+    }
+    return val.getInt64() != 0;
+}
+
+RGBAColor VectorTileAttributes::getColor(const std::string &name,const RGBAColor &defVal) const
+{
+    if (overlay)
+    {
+        return overlay->getColor(name, defVal);
+    }
+    VectorTileValue val;
+    if (!findValue(name, val))
+    {
+        return defVal;
+    }
+    switch (val.dictType())
+    {
+        case DictTypeString:
+        {
+            // We're looking for #RRGGBBAA, #RRGGBB, #RGBA, or #RGB
+            if (val.stringValue.length() < 4 || val.stringValue[0] != '#')
+            {
+                return defVal;
+            }
+            // The tile data isn't null-terminated
+            const std::string str(val.stringValue);
+            return parseColor(&str.c_str()[1], defVal);
+        }
+        case DictTypeInt:
+            return ARGBtoRGBAColor((uint32_t)val.getInt64());
+        default:
+            wkLogLevel(Warn, "Unsupported conversion from type %d to color", val.dictType());
+            return defVal;
+    }
+}
+
+double VectorTileAttributes::getDouble(const std::string &name,double defVal) const
+{
+    if (overlay)
+    {
+        return overlay->getDouble(name, defVal);
+    }
+    VectorTileValue val;
+    if (!findValue(name, val))
+    {
+        return defVal;
+    }
+    if (val.type == VectorTileValue::ValString)
+    {
+        wkLogLevel(Warn, "Unsupported conversion from type %d to double", DictTypeString);
+        return defVal;
+    }
+    return val.getDouble();
+}
+
+std::string VectorTileAttributes::getString(const std::string &name) const
+{
+    return getString(name, std::string());
+}
+
+std::string VectorTileAttributes::getString(const std::string &name,const std::string &defVal) const
+{
+    if (overlay)
+    {
+        return overlay->getString(name, defVal);
+    }
+    VectorTileValue val;
+    if (!findValue(name, val))
+    {
+        return defVal;
+    }
+    switch (val.dictType())
+    {
+        case DictTypeString: return std::string(val.stringValue);
+        case DictTypeDouble: return std::to_string(val.getDouble());
+        case DictTypeInt:    return std::to_string((int)val.getInt64());
+        default:             return defVal;
+    }
+}
+
+DictionaryRef VectorTileAttributes::getDict(const std::string &name) const
+{
+    // Tile values are never dictionaries
+    return overlay ? overlay->getDict(name) : DictionaryRef();
+}
+
+DictionaryEntryRef VectorTileAttributes::getEntry(const std::string &name) const
+{
+    if (overlay)
+    {
+        return overlay->getEntry(name);
+    }
+    VectorTileValue val;
+    return findValue(name, val) ? val.makeEntry() : DictionaryEntryRef();
+}
+
+std::vector<DictionaryEntryRef> VectorTileAttributes::getArray(const std::string &name) const
+{
+    return overlay ? overlay->getArray(name) : std::vector<DictionaryEntryRef>();
+}
+
+std::vector<std::string> VectorTileAttributes::getKeys() const
+{
+    if (overlay)
+    {
+        return overlay->getKeys();
+    }
+
+    std::vector<std::string> keys { layerNameKey, geometryTypeKey, layerOrderKey };
+    keys.reserve(keys.size() + (tagEnd - tagStart) / 2);
+
+    const auto &tags = layer->tags;
+    for (uint32_t ii = tagStart; ii < tagEnd; ii += 2)
+    {
+        const auto keyIndex = tags[ii];
+        const auto valueIndex = tags[ii + 1];
+        if (keyIndex >= layer->keys.size() || valueIndex >= layer->values.size() ||
+            layer->keys[keyIndex].empty() || layer->values[valueIndex].type == VectorTileValue::ValNone)
+        {
+            continue;
+        }
+        const auto &key = layer->keys[keyIndex];
+        if (std::find(keys.begin(), keys.end(), key) == keys.end())
+        {
+            keys.emplace_back(key);
+        }
+    }
+    return keys;
+}
+
+void VectorTileAttributes::clear()
+{
+    makeMutable().clear();
+}
+
+void VectorTileAttributes::removeField(const std::string &name)
+{
+    makeMutable().removeField(name);
+}
+
+void VectorTileAttributes::setInt(const std::string &name,int val)
+{
+    makeMutable().setInt(name, val);
+}
+
+void VectorTileAttributes::setInt64(const std::string &name,int64_t val)
+{
+    makeMutable().setInt64(name, val);
+}
+
+void VectorTileAttributes::setIdentifiable(const std::string &name,SimpleIdentity val)
+{
+    makeMutable().setIdentifiable(name, val);
+}
+
+void VectorTileAttributes::setDouble(const std::string &name,double val)
+{
+    makeMutable().setDouble(name, val);
+}
+
+void VectorTileAttributes::setString(const std::string &name,const std::string &val)
+{
+    makeMutable().setString(name, val);
+}
+
+void VectorTileAttributes::addEntries(const Dictionary *other)
+{
+    makeMutable().addEntries(other);
+}
+
+VectorTileLayerTable &VectorTileAttributeArena::addLayer()
+{
+    layers.emplace_back();
+    return layers.back();
+}
+
+MutableDictionaryRef VectorTileAttributeArena::addFeature(const VectorTileLayerTable *layer,uint32_t tagStart,uint32_t tagEnd,int geomType)
+{
+    features.emplace_back(layer, tagStart, tagEnd, geomType);
+    // Share ownership of the arena rather than allocating a control block for each one
+    return MutableDictionaryRef(shared_from_this(), &features.back());
+}
+
+}
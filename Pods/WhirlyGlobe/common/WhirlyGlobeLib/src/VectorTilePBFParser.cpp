@@ -22,7 +22,7 @@
 #import "MaplyVectorStyleC.h"
 #import "VectorObject.h"
 #import "WhirlyKitLog.h"
-#import "DictionaryC.h"
+#import "VectorTileAttributes.h"
 
 #import "vector_tile.pb.h"
 #import "maply_pb_decode.h"
@@ -33,13 +33,6 @@
 namespace WhirlyKit
 {
 
-namespace {
-    // Fixed strings to avoid allocations on every call to, e.g., Dictionary::setString
-    const std::string layerNameKey("layer_name");       //NOLINT
-    const std::string geometryTypeKey("geometry_type"); //NOLINT
-    const std::string layerOrderKey("layer_order");     //NOLINT
-}
-
 const vector_tile_Tile_Layer VectorTilePBFParser::_defaultLayer = {
     /* name       */ { { &VectorTilePBFParser::stringDecode },    nullptr },
     /* features   */ { { &VectorTilePBFParser::featureDecode },   nullptr },
@@ -111,6 +104,8 @@ VectorTilePBFParser::VectorTilePBFParser(
 
 bool VectorTilePBFParser::parse(const uint8_t* data, size_t length)
 {
+    _attrArena = std::make_shared<VectorTileAttributeArena>();
+
     _vector_tile_Tile tile = {
         /* layer     */ { { layerDecode }, this },
         /*extensions */ nullptr,
@@ -126,6 +121,59 @@ bool VectorTilePBFParser::parse(const uint8_t* data, size_t length)
     return true;
 }
 
+// Find the name of a layer without decoding (or consuming) any of it
+bool VectorTilePBFParser::peekLayerName(const pb_istream_t *stream, std::string_view &name)
+{
+    // Buffer streams keep their position in the structure, so a copy reads independently
+    pb_istream_t peek = *stream;
+
+    pb_wire_type_t wireType;
+    uint32_t tag;
+    bool eof;
+    while (pb_decode_tag(&peek, &wireType, &tag, &eof))
+    {
+        if (tag == vector_tile_Tile_Layer_name_tag && wireType == PB_WT_STRING)
+        {
+            uint32_t len;
+            if (!pb_decode_varint32(&peek, &len) || len > peek.bytes_left)
+            {
+                return false;
+            }
+            name = std::string_view((const char *)peek.state, len);
+            return true;
+        }
+        // Features are length-delimited, so this hops over them
+        if (!pb_skip_field(&peek, wireType))
+        {
+            return false;
+        }
+    }
+    return false;
+}
+
+// Check if any style wants the layer, possibly under a lowercase version of its name
+bool VectorTilePBFParser::layerWanted(std::string &layerName)
+{
+    if (_styleDelegate->layerShouldDisplay(_styleInst, layerName, _tileData->ident))
+    {
+        return true;
+    }
+
+    // Try a lowercase version
+    // TODO: This doesn't handle non-ASCII well
+    std::string lowerLayerName = layerName;
+    std::transform(lowerLayerName.begin(), lowerLayerName.end(), lowerLayerName.begin(),
+                               [](unsigned char c){ return std::tolower(c); });
+
+    if (lowerLayerName != layerName &&
+        _styleDelegate->layerShouldDisplay(_styleInst, lowerLayerName, _tileData->ident))
+    {
+        layerName = std::move(lowerLayerName);
+        return true;
+    }
+    return false;
+}
+
 // Tile contains a collection of Layers
 bool VectorTilePBFParser::layerDecode(pb_istream_t *stream, const pb_field_iter_t *field, void **arg)
 {
@@ -140,6 +188,24 @@ bool VectorTilePBFParser::layerDecode(pb_istream_t *stream, const pb_field_iter_
         return false;
     }
 
+    const auto layerBytes = (uint32_t)stream->bytes_left;
+
+    // Look for the name first, so we can jump over layers no style wants without decoding any of the features
+    std::string_view peekName;
+    std::string layerName;
+    bool found = false;
+    if (peekLayerName(stream, peekName))
+    {
+        layerName = std::string(peekName);
+        found = layerWanted(layerName);
+        if (!found)
+        {
+            _skippedLayerCount += 1;
+            _skippedLayerBytes += layerBytes;
+            return pb_read(stream, nullptr, stream->bytes_left);
+        }
+    }
+
     vector_tile_Tile_Layer layer = _defaultLayer;
     std::string_view layerNameView;
 
@@ -148,7 +214,6 @@ bool VectorTilePBFParser::layerDecode(pb_istream_t *stream, const pb_field_iter_
     layer.keys.arg = &_layerKeys;
     layer.values.arg = &_layerValues;
 
-    const auto layerBytes = (uint32_t)stream->bytes_left;
     _layerKeys.clear();
     _layerKeys.reserve(layerKeyHeuristic(layerBytes));
     _layerValues.clear();
@@ -164,8 +229,12 @@ bool VectorTilePBFParser::layerDecode(pb_istream_t *stream, const pb_field_iter_
     {
         return false;
     }
+    _decodedLayerBytes += layerBytes;
 
-    auto layerName = std::string(layerNameView);
+    if (!found)
+    {
+        layerName = std::string(layerNameView);
+    }
 
     // When `has_extent` is false, nanopb sets the default in `extent`
     _layerScale = (double)layer.extent / TileSize;
@@ -179,29 +248,34 @@ bool VectorTilePBFParser::layerDecode(pb_istream_t *stream, const pb_field_iter_
         return true;
     }
 
-    // if we don't have any styles for a layer, don't bother parsing the features
-    bool found = false;
-    if (_styleDelegate->layerShouldDisplay(_styleInst, layerName, _tileData->ident))
-        found = true;
-    else {
-        // Try a lowercase version
-        // TODO: This doesn't handle non-ASCII well
-        std::string lowerLayerName = layerName;
-        std::transform(lowerLayerName.begin(), lowerLayerName.end(), lowerLayerName.begin(),
-                                   [](unsigned char c){ return std::tolower(c); });
-        
-        if (lowerLayerName != layerName)
-            if (_styleDelegate->layerShouldDisplay(_styleInst, lowerLayerName, _tileData->ident)) {
-                found = true;
-                layerName = lowerLayerName;
-            }
-    }
-    
-    if (!found) {
+    // We couldn't find the name ahead of time, so check now
+    if (!found && !layerWanted(layerName))
+    {
         _skippedLayerCount += 1;
         return true;
     }
 
+    // Hand the tables over to the arena, where the feature attributes can refer to them
+    auto &layerTable = _attrArena->addLayer();
+    layerTable.layerName = layerName;
+    layerTable.layerOrder = (int)_layerCount;
+    layerTable.keys = std::move(_layerKeys);
+    layerTable.values = std::move(_layerValues);
+    layerTable.tags = std::move(_featureTags);
+    layerTable.geometry = std::move(_featureGeometry);
+    // The tile data is only ours for the duration of the parse
+    layerTable.copyStrings();
+    // Let the style work out what it can from the keys and values before we get to the features
+    _styleDelegate->prepareLayer(_styleInst, layerTable, _tileData->ident);
+    _layerKeys.clear();
+    _layerValues.clear();
+    _featureTags.clear();
+    _featureGeometry.clear();
+
+    const VectorTileShapeSource::Transform transform = {
+        _layerScale, _tileOriginX, _tileOriginY, _sx, _sy, _localCoords
+    };
+
     size_t prevTagIndex = 0;
     size_t prevGeomIndex = 0;
     for (auto const &feature : _features)
@@ -212,13 +286,8 @@ bool VectorTilePBFParser::layerDecode(pb_istream_t *stream, const pb_field_iter_
             return false;
         }
 
-        auto attributes = std::make_shared<MutableDictionaryC>();
-        attributes->setString(layerNameKey, layerName);
-        attributes->setInt(geometryTypeKey, (int)feature.geomType);
-        attributes->setInt(layerOrderKey, (int)_layerCount);
-
-        const bool tagsOk = processTags(attributes, prevTagIndex, prevGeomIndex, feature);
-        //const auto curTagIndex = prevTagIndex;
+        const bool tagsOk = processTags(layerTable, prevTagIndex, feature);
+        const auto curTagIndex = prevTagIndex;
         const auto curGeomIndex = prevGeomIndex;
         const auto curGeomCount = feature.geomIndex - prevGeomIndex;
         prevTagIndex = feature.tagIndex;
@@ -230,70 +299,41 @@ bool VectorTilePBFParser::layerDecode(pb_istream_t *stream, const pb_field_iter_
             continue;
         }
 
+        // Only features we're keeping take up space in the arena
+        const VectorTileAttributes checkAttrs(&layerTable, curTagIndex, feature.tagIndex, (int)feature.geomType);
+
         SimpleIDUSet styleIDs(featureStyleHeuristic());
-        if (!checkStyles(styleIDs, attributes, layerName))
+        if (!checkStyles(styleIDs, checkAttrs, layerName))
         {
             // Skip this feature
             _skippedFeatureCount += 1;
             continue;
         }
 
-        _featureCount += 1;
-
-        auto vecObj = std::make_shared<VectorObject>();
-
-        // Parse geometry
-        try
+        switch (feature.geomType)
         {
-            switch (feature.geomType)
-            {
-                case GeomTypeLineString:
-                    parseLineString(&_featureGeometry[curGeomIndex], curGeomCount, vecObj->shapes);
-                    break;
-                case GeomTypePolygon:
-                {
-                    auto shape = VectorAreal::createAreal();
-                    if (parsePolygon(&_featureGeometry[curGeomIndex], curGeomCount, *shape))
-                    {
-                        vecObj->shapes.insert(shape);
-                    }
-                    break;
-                }
-                case GeomTypePoint:
-                {
-                    auto shape = VectorPoints::createPoints();
-                    if (parsePoints(&_featureGeometry[curGeomIndex], curGeomCount, *shape))
-                    {
-                        vecObj->shapes.insert(shape);
-                    }
-                    break;
-                }
-                default:
-                case GeomTypeUnknown:
+            case GeomTypeLineString:
+            case GeomTypePolygon:
+            case GeomTypePoint:
+                break;
+            default:
+            case GeomTypeUnknown:
 #if DEBUG
-                    wkLogLevel(Warn, "VectorTilePBFParser: Unknown geometry type %d", feature.geomType);
+                wkLogLevel(Warn, "VectorTilePBFParser: Unknown geometry type %d", feature.geomType);
 #endif
-                    _unknownGeomTypes += 1;
-                    break;
-            }
-        }
-        catch (const std::exception &ex)
-        {
-            wkLogLevel(Error, "VectorTilePBFParser: Vector Parsing Error: %s", ex.what());
-            _parseErrors += 1;
-            vecObj.reset();
-        }
-        catch (...)
-        {
-            wkLogLevel(Error, "VectorTilePBFParser: Vector Parsing Error: ?");   // Bad, don't throw non-exceptions!
-            _parseErrors += 1;
-            vecObj.reset();
+                _unknownGeomTypes += 1;
+                _skippedFeatureCount += 1;
+                continue;
         }
 
-        for (const auto &shape: vecObj->shapes)
-        {
-            shape->setAttrDict(attributes);
-        }
+        _featureCount += 1;
+
+        // Geometry is decoded when (and if) a style gets around to using it
+        const auto attributes = _attrArena->addFeature(&layerTable, curTagIndex, feature.tagIndex, (int)feature.geomType);
+        auto vecObj = std::make_shared<VectorObject>();
+        vecObj->setShapeSource(std::make_shared<VectorTileShapeSource>(attributes,
+                                                                       layerTable.geometry.data() + curGeomIndex,
+                                                                       curGeomCount, feature.geomType, transform));
 
         addFeature(vecObj, styleIDs);
     }
@@ -304,14 +344,14 @@ bool VectorTilePBFParser::layerDecode(pb_istream_t *stream, const pb_field_iter_
 
 /// https://github.com/mapbox/vector-tile-spec/tree/master/2.1/#432-parameter-integers
 /// A ParameterInteger is zigzag encoded so that small negative and positive values are both encoded as small integers.
-int32_t VectorTilePBFParser::decodeParamInt(int32_t p) {
+int32_t VectorTileShapeSource::decodeParamInt(int32_t p) {
     return ((p >> 1U) ^ (-(p & 1U)));       //NOLINT these are right out of the spec
 }
 
 /// https://github.com/mapbox/vector-tile-spec/tree/master/2.1/#431-command-integers
 /// A command ID is encoded as an unsigned integer in the least significant 3 bits of the CommandInteger, and is in the range 0 through 7, inclusive.
 /// A command count is encoded as an unsigned integer in the remaining 29 bits of a CommandInteger, and is in the range 0 through pow(2, 29) - 1, inclusive.
-std::pair<uint8_t, int32_t> VectorTilePBFParser::decodeCommand(int32_t c) {
+std::pair<uint8_t, int32_t> VectorTileShapeSource::decodeCommand(int32_t c) {
     return std::make_pair(c & ((1 << CmdBits) - 1), c >> CmdBits);  //NOLINT these are right out of the spec
 }
 
@@ -338,7 +378,8 @@ bool VectorTilePBFParser::featureDecode(pb_istream_t *stream, const pb_field_ite
     return true;
 }
 
-bool VectorTilePBFParser::processTags(const MutableDictionaryCRef &attributes, size_t tagIdx, size_t geomIdx, const Feature &feature)
+// Check the feature's tags against the layer tables.  The attributes look the values up later.
+bool VectorTilePBFParser::processTags(const VectorTileLayerTable &layer, size_t tagIdx, const Feature &feature)
 {
     const auto tagCount = feature.tagIndex - tagIdx;
     if (tagCount % 2 != 0)
@@ -348,44 +389,30 @@ bool VectorTilePBFParser::processTags(const MutableDictionaryCRef &attributes, s
 
     for (size_t m = tagIdx; m + 1 < feature.tagIndex; m += 2)
     {
-        const auto keyIndex = _featureTags[m];
-        const auto valueIndex = _featureTags[m + 1];
+        const auto keyIndex = layer.tags[m];
+        const auto valueIndex = layer.tags[m + 1];
 
-        if (keyIndex >= _layerKeys.size() || valueIndex >= _layerValues.size()) {
-            wkLogLevel(Warn, "VectorTilePBFParser: Invalid feature tag %d/%d (%d/%d)", keyIndex, valueIndex, (int)_layerKeys.size(), (int)_layerValues.size());
+        if (keyIndex >= layer.keys.size() || valueIndex >= layer.values.size()) {
+            wkLogLevel(Warn, "VectorTilePBFParser: Invalid feature tag %d/%d (%d/%d)", keyIndex, valueIndex, (int)layer.keys.size(), (int)layer.values.size());
             _badAttributes += 1;
             continue;
         }
 
-        const auto &key = _layerKeys[keyIndex];
-        if (key.empty()) {
+        if (layer.keys[keyIndex].empty()) {
             continue;
         }
 
-        // TODO: We don't really need transient string allocations here
-        const auto skey = std::string(key);
-
-        const auto &value = _layerValues[valueIndex];
-        switch (value.type) {
-            case SmallValue::SmallValString: attributes->setString(skey, std::string(value.stringValue)); break;
-            case SmallValue::SmallValFloat:  attributes->setDouble(skey, value.floatValue); break;
-            case SmallValue::SmallValDouble: attributes->setDouble(skey, value.doubleValue); break;
-            case SmallValue::SmallValInt:    attributes->setInt(skey, value.intValue); break;
-            case SmallValue::SmallValUInt:   attributes->setInt(skey, (int)value.uintValue); break;
-            case SmallValue::SmallValSInt:   attributes->setInt(skey, (int)value.sintValue); break;
-            case SmallValue::SmallValBool:   attributes->setInt(skey, (int)value.boolValue); break;
-            default:
-            case SmallValue::SmallValNone:
-                _unknownValueTypes += 1;
-                wkLogLevel(Warn, "VectorTilePBFParser: Invalid Value Type %d", value.type);
-                break;
+        const auto &value = layer.values[valueIndex];
+        if (value.type == VectorTileValue::ValNone) {
+            _unknownValueTypes += 1;
+            wkLogLevel(Warn, "VectorTilePBFParser: Invalid Value Type %d", value.type);
         }
     }
     
     return true;
 }
 
-bool VectorTilePBFParser::checkStyles(SimpleIDUSet& styleIDs, const MutableDictionaryCRef &attributes, const std::string &layerName)
+bool VectorTilePBFParser::checkStyles(SimpleIDUSet& styleIDs, const Dictionary &attributes, const std::string &layerName)
 {
     // Ask for the styles that correspond to this feature
     // If there are none, we can skip this.
@@ -393,7 +420,7 @@ bool VectorTilePBFParser::checkStyles(SimpleIDUSet& styleIDs, const MutableDicti
     // Do a quick inclusion check
     if (!_uuidName.empty())
     {
-        std::string uuidVal = attributes->getString(_uuidName); // TODO: extra string copy
+        std::string uuidVal = attributes.getString(_uuidName); // TODO: extra string copy
         if (_uuidValues.find(uuidVal) == _uuidValues.end())
         {
             // Skip this feature
@@ -402,7 +429,7 @@ bool VectorTilePBFParser::checkStyles(SimpleIDUSet& styleIDs, const MutableDicti
     }
     
     // TODO: populate a reused vector?
-    const auto styles = _styleDelegate->stylesForFeature(_styleInst, *attributes, _tileData->ident, layerName);
+    const auto styles = _styleDelegate->stylesForFeature(_styleInst, attributes, _tileData->ident, layerName);
     for (const auto &style : styles)
     {
         styleIDs.insert(style->getUuid(_styleInst));
@@ -411,7 +438,80 @@ bool VectorTilePBFParser::checkStyles(SimpleIDUSet& styleIDs, const MutableDicti
     return (!styleIDs.empty() || _parseAll);
 }
 
-void VectorTilePBFParser::parseLineString(const uint32_t *geometry, size_t geomCount, ShapeSet& shapes) const
+VectorTileShapeSource::VectorTileShapeSource(MutableDictionaryRef attributes,
+                                             const uint32_t *geometry,
+                                             size_t geomCount,
+                                             MapnikGeometryType geomType,
+                                             const Transform &transform)
+    : attributes (std::move(attributes))
+    , geometry   (geometry)
+    , geomCount  (geomCount)
+    , geomType   (geomType)
+    , transform  (transform)
+{
+}
+
+VectorObjectType VectorTileShapeSource::getVectorType() const
+{
+    switch (geomType)
+    {
+        case GeomTypePoint:      return VectorPointType;
+        case GeomTypeLineString: return VectorLinearType;
+        case GeomTypePolygon:    return VectorArealType;
+        default:                 return VectorNoneType;
+    }
+}
+
+void VectorTileShapeSource::buildShapes(ShapeSet &shapes)
+{
+    try
+    {
+        switch (geomType)
+        {
+            case GeomTypeLineString:
+                parseLineString(shapes);
+                break;
+            case GeomTypePolygon:
+            {
+                auto shape = VectorAreal::createAreal();
+                if (parsePolygon(*shape))
+                {
+                    shapes.insert(shape);
+                }
+                break;
+            }
+            case GeomTypePoint:
+            {
+                auto shape = VectorPoints::createPoints();
+                if (parsePoints(*shape))
+                {
+                    shapes.insert(shape);
+                }
+                break;
+            }
+            default:
+            case GeomTypeUnknown:
+                break;
+        }
+    }
+    catch (const std::exception &ex)
+    {
+        wkLogLevel(Error, "VectorTilePBFParser: Vector Parsing Error: %s", ex.what());
+        shapes.clear();
+    }
+    catch (...)
+    {
+        wkLogLevel(Error, "VectorTilePBFParser: Vector Parsing Error: ?");   // Bad, don't throw non-exceptions!
+        shapes.clear();
+    }
+
+    for (const auto &shape: shapes)
+    {
+        shape->setAttrDict(attributes);
+    }
+}
+
+void VectorTileShapeSource::parseLineString(ShapeSet& shapes) const
 {
     double x = 0;
     double y = 0;
@@ -436,14 +536,14 @@ void VectorTilePBFParser::parseLineString(const uint32_t *geometry, size_t geomC
                 const auto dx = decodeParamInt(geometry[k++]);
                 const auto dy = decodeParamInt(geometry[k++]);
                 
-                x += (static_cast<double>(dx) / _layerScale);
-                y += (static_cast<double>(dy) / _layerScale);
+                x += (static_cast<double>(dx) / transform.layerScale);
+                y += (static_cast<double>(dy) / transform.layerScale);
                 
                 // At this point x/y is a coord encoded in tile coord space, from 0 to TILE_SIZE
                 // Convert to epsg:3785, then to degrees, then to radians
-                point = Point2f((_tileOriginX + x / _sx),(_tileOriginY - y / _sy));
+                point = Point2f((transform.tileOriginX + x / transform.sx),(transform.tileOriginY - y / transform.sy));
                 
-                if (!_localCoords) {
+                if (!transform.localCoords) {
                     point.x() = DegToRad(point.x() / MAX_EXTENT * 180.0);
                     point.y() = 2 * atan(exp(DegToRad(point.y() / MAX_EXTENT * 180.0))) - M_PI_2;
                 }
@@ -494,7 +594,7 @@ void VectorTilePBFParser::parseLineString(const uint32_t *geometry, size_t geomC
     }
 }
 
-bool VectorTilePBFParser::parsePolygon(const uint32_t *geometry, size_t geomCount, VectorAreal& shape)
+bool VectorTileShapeSource::parsePolygon(VectorAreal& shape) const
 {
     double x = 0;
     double y = 0;
@@ -502,7 +602,7 @@ bool VectorTilePBFParser::parsePolygon(const uint32_t *geometry, size_t geomCoun
     int length = 0;
     Point2f firstCoord(0, 0);
 
-    tempRing.clear();
+    VectorRing tempRing;
     tempRing.reserve(geomCount+1);
     
     for (int k = 0; k < geomCount; )
@@ -520,15 +620,15 @@ bool VectorTilePBFParser::parsePolygon(const uint32_t *geometry, size_t geomCoun
                 const auto dx = decodeParamInt(geometry[k++]);
                 const auto dy = decodeParamInt(geometry[k++]);
                 
-                x += (static_cast<double>(dx) / _layerScale);
-                y += (static_cast<double>(dy) / _layerScale);
+                x += (static_cast<double>(dx) / transform.layerScale);
+                y += (static_cast<double>(dy) / transform.layerScale);
                 
                 // At this point x/y is a coord is encoded in tile coord space, from 0 to TILE_SIZE
                 // Convert to epsg:3785, then to degrees, then to radians
-                double fx = _tileOriginX + x / _sx;
-                double fy = _tileOriginY - y / _sy;
+                double fx = transform.tileOriginX + x / transform.sx;
+                double fy = transform.tileOriginY - y / transform.sy;
                 
-                if (!_localCoords)
+                if (!transform.localCoords)
                 {
                     fx = DegToRad((fx / MAX_EXTENT) * 180.0);
                     fy = 2 * atan(exp(DegToRad((fy / MAX_EXTENT) * 180.0))) - M_PI_2;
@@ -551,10 +651,12 @@ bool VectorTilePBFParser::parsePolygon(const uint32_t *geometry, size_t geomCoun
                     tempRing.clear(); //reuse the ring
                 }
             }
+#if DEBUG
             else
             {
-                _unknownCommands += 1;
+                wkLogLevel(Warn, "VectorTilePBFParser: Unknown command %d", cmd);
             }
+#endif
         }
     }
     
@@ -574,7 +676,7 @@ bool VectorTilePBFParser::parsePolygon(const uint32_t *geometry, size_t geomCoun
     return false;
 }
 
-bool VectorTilePBFParser::parsePoints(const uint32_t *geometry, size_t geomCount, VectorPoints& shape)
+bool VectorTileShapeSource::parsePoints(VectorPoints& shape) const
 {
     double x = 0;
     double y = 0;
@@ -596,17 +698,17 @@ bool VectorTilePBFParser::parsePoints(const uint32_t *geometry, size_t geomCount
                 const auto dx = decodeParamInt(geometry[k++]);
                 const auto dy = decodeParamInt(geometry[k++]);
                 
-                x += (static_cast<double>(dx) / _layerScale);
-                y += (static_cast<double>(dy) / _layerScale);
+                x += (static_cast<double>(dx) / transform.layerScale);
+                y += (static_cast<double>(dy) / transform.layerScale);
                 
                 // At this point x/y is a coord is encoded in tile coord space, from 0 to TILE_SIZE
                 // Covert to epsg:3785, then to degrees, then to radians
                 if (x > 0 && x < TileSize && y > 0 && y < TileSize)
                 {
-                    double fx = _tileOriginX + x / _sx;
-                    double fy = _tileOriginY - y / _sy;
+                    double fx = transform.tileOriginX + x / transform.sx;
+                    double fy = transform.tileOriginY - y / transform.sy;
                     
-                    if (!_localCoords)
+                    if (!transform.localCoords)
                     {
                         fx = DegToRad((fx / MAX_EXTENT) * 180.0);
                         fy = 2 * atan(exp(DegToRad((fy / MAX_EXTENT) * 180.0))) - M_PI_2;
@@ -620,10 +722,12 @@ bool VectorTilePBFParser::parsePoints(const uint32_t *geometry, size_t geomCount
                 wkLogLevel(Warn, "VectorTilePBFParser: Close point feature?");
 #endif
             }
+#if DEBUG
             else
             {
-                _unknownCommands += 1;
+                wkLogLevel(Warn, "VectorTilePBFParser: Unknown command %d", cmd);
             }
+#endif
         }
     }
     
@@ -637,11 +741,6 @@ bool VectorTilePBFParser::parsePoints(const uint32_t *geometry, size_t geomCount
 
 void VectorTilePBFParser::addFeature(const VectorObjectRef &vecObj, const SimpleIDUSet &styleIDs)
 {
-    if (vecObj->shapes.empty())
-    {
-        return;
-    }
-    
     if (_keepVectors)
     {
         _keepVectors->push_back(vecObj);
@@ -667,7 +766,7 @@ void VectorTilePBFParser::addFeature(const VectorObjectRef &vecObj, const Simple
     
 // Layer contains a collection of Values
 bool VectorTilePBFParser::valueVecDecode(pb_istream_t *stream, const pb_field_iter_t *field, void **arg) {
-    auto &vec = **(std::vector<SmallValue>**)arg;
+    auto &vec = **(std::vector<VectorTileValue>**)arg;
     
     std::string_view string;
     vector_tile_Tile_Value value = vector_tile_Tile_Value_init_zero;
@@ -679,13 +778,14 @@ bool VectorTilePBFParser::valueVecDecode(pb_istream_t *stream, const pb_field_it
         return false;
     }
 
-         if (value.has_float_value)  vec.push_back({{.floatValue  = value.float_value},  SmallValue::SmallValFloat});
-    else if (value.has_double_value) vec.push_back({{.doubleValue = value.double_value}, SmallValue::SmallValDouble});  //NOLINT
-    else if (value.has_int_value)    vec.push_back({{.intValue    = value.int_value},    SmallValue::SmallValInt});     //NOLINT
-    else if (value.has_uint_value)   vec.push_back({{.uintValue   = value.uint_value},   SmallValue::SmallValUInt});    //NOLINT
-    else if (value.has_sint_value)   vec.push_back({{.sintValue   = value.sint_value},   SmallValue::SmallValSInt});    //NOLINT
-    else if (value.has_bool_value)   vec.push_back({{.boolValue   = value.bool_value},   SmallValue::SmallValBool});    //NOLINT
-    else                             vec.push_back({{.stringValue = string},             SmallValue::SmallValString});  //NOLINT
+    auto &val = vec.emplace_back();
+         if (value.has_float_value)  { val.floatValue  = value.float_value;  val.type = VectorTileValue::ValFloat;  }
+    else if (value.has_double_value) { val.doubleValue = value.double_value; val.type = VectorTileValue::ValDouble; }  //NOLINT
+    else if (value.has_int_value)    { val.intValue    = value.int_value;    val.type = VectorTileValue::ValInt;    }  //NOLINT
+    else if (value.has_uint_value)   { val.uintValue   = value.uint_value;   val.type = VectorTileValue::ValUInt;   }  //NOLINT
+    else if (value.has_sint_value)   { val.sintValue   = value.sint_value;   val.type = VectorTileValue::ValSInt;   }  //NOLINT
+    else if (value.has_bool_value)   { val.boolValue   = value.bool_value;   val.type = VectorTileValue::ValBool;   }  //NOLINT
+    else                             { val.stringValue = string;             val.type = VectorTileValue::ValString; }  //NOLINT
 
     return true;
 }
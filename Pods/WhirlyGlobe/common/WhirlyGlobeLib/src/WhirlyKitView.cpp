@@ -282,6 +282,11 @@ void View::runViewUpdates()
 }
 
 ViewState::ViewState(WhirlyKit::View *view,SceneRenderer *renderer) :
+    ViewState(view,renderer->getFramebufferSize())
+{
+}
+
+ViewState::ViewState(WhirlyKit::View *view,const Point2f &frameSize) :
     near(0),
     far(0)
 {
@@ -289,7 +294,6 @@ ViewState::ViewState(WhirlyKit::View *view,SceneRenderer *renderer) :
     invModelMatrix = modelMatrix.inverse();
     
     Matrix4dVector offMatrices;
-    Point2f frameSize = renderer->getFramebufferSize();
     view->getOffsetMatrices(offMatrices, frameSize, 0.0);
     viewMatrices.resize(offMatrices.size());
     invViewMatrices.resize(offMatrices.size());
@@ -297,7 +301,7 @@ ViewState::ViewState(WhirlyKit::View *view,SceneRenderer *renderer) :
     invFullMatrices.resize(offMatrices.size());
     fullNormalMatrices.resize(offMatrices.size());
     
-    projMatrix = view->calcProjectionMatrix(renderer->getFramebufferSize(),0.0);
+    projMatrix = view->calcProjectionMatrix(frameSize,0.0);
     invProjMatrix = projMatrix.inverse();
     Eigen::Matrix4d baseViewMatrix = view->calcViewMatrix();
     for (unsigned int ii=0;ii<offMatrices.size();ii++)
@@ -327,6 +331,12 @@ ViewState::ViewState(WhirlyKit::View *view,SceneRenderer *renderer) :
     ll.x() = ur.x() = 0.0;
     
     coordAdapter = view->coordAdapter;
+
+    // Only bother working out where we're going if someone's going to look
+    if (view->wantsPredictions())
+    {
+        predictor = view->makeViewStatePredictor(frameSize);
+    }
 }
 
 void ViewState::calcFrustumWidth(unsigned int frameWidth,unsigned int frameHeight)
@@ -0,0 +1,192 @@
+/*  WorkStealingPool.cpp
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2022 mousebird consulting
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#import "WorkStealingPool.h"
+#import "WhirlyKitLog.h"
+#import <algorithm>
+
+namespace WhirlyKit
+{
+
+WorkStealingPool::WorkStealingPool(int numThreads,TaskRunner inRunner) :
+    runner(std::move(inRunner))
+{
+    if (numThreads <= 0)
+    {
+        numThreads = std::max(1, (int)std::thread::hardware_concurrency() - 1);
+    }
+
+    queues.reserve(numThreads);
+    for (int ii=0;ii<numThreads;ii++)
+    {
+        queues.push_back(std::make_unique<Queue>());
+    }
+    workers.reserve(numThreads);
+    for (int ii=0;ii<numThreads;ii++)
+    {
+        workers.emplace_back(&WorkStealingPool::workerMain, this, (size_t)ii);
+    }
+}
+
+WorkStealingPool::~WorkStealingPool()
+{
+    {
+        std::lock_guard<std::mutex> guardLock(lock);
+        shutdown = true;
+    }
+    wake.notify_all();
+
+    for (auto &worker : workers)
+    {
+        worker.join();
+    }
+}
+
+namespace {
+    // Tracks one call to run()
+    struct Batch
+    {
+        std::mutex lock;
+        std::condition_variable done;
+        size_t remaining = 0;
+    };
+}
+
+void WorkStealingPool::run(std::vector<Task> &tasks)
+{
+    if (tasks.empty())
+    {
+        return;
+    }
+
+    auto batch = std::make_shared<Batch>();
+    batch->remaining = tasks.size();
+
+    // Count them before they go in, so nobody sees the count go negative
+    size_t which;
+    {
+        std::lock_guard<std::mutex> guardLock(lock);
+        which = nextQueue;
+        nextQueue = (nextQueue + tasks.size()) % queues.size();
+        queued += tasks.size();
+    }
+
+    // Deal the tasks out across the workers
+    for (auto &task : tasks)
+    {
+        auto &queue = *queues[which];
+        which = (which + 1) % queues.size();
+
+        std::lock_guard<std::mutex> guardLock(queue.lock);
+        queue.tasks.emplace_back([this,batch,task=std::move(task)]()
+        {
+            try
+            {
+                if (runner)
+                {
+                    runner(task);
+                }
+                else
+                {
+                    task();
+                }
+            }
+            catch (const std::exception &ex)
+            {
+                wkLogLevel(Warn, "WorkStealingPool: Task failed: %s", ex.what());
+            }
+            catch (...)
+            {
+                wkLogLevel(Warn, "WorkStealingPool: Task failed");
+            }
+
+            std::lock_guard<std::mutex> batchLock(batch->lock);
+            if (--batch->remaining == 0)
+            {
+                batch->done.notify_all();
+            }
+        });
+    }
+    tasks.clear();
+    wake.notify_all();
+
+    // Help out until there's nothing left to take, then wait for the stragglers
+    while (runOne(which))
+    {
+    }
+
+    std::unique_lock<std::mutex> batchLock(batch->lock);
+    batch->done.wait(batchLock, [&batch]{ return batch->remaining == 0; });
+}
+
+bool WorkStealingPool::runOne(size_t which)
+{
+    Task task;
+
+    // Our own queue first, newest first, then the oldest from everyone else
+    for (size_t ii=0;ii<queues.size() && !task;ii++)
+    {
+        auto &queue = *queues[(which + ii) % queues.size()];
+        std::lock_guard<std::mutex> guardLock(queue.lock);
+        if (!queue.tasks.empty())
+        {
+            if (ii == 0)
+            {
+                task = std::move(queue.tasks.back());
+                queue.tasks.pop_back();
+            }
+            else
+            {
+                task = std::move(queue.tasks.front());
+                queue.tasks.pop_front();
+            }
+        }
+    }
+
+    if (!task)
+    {
+        return false;
+    }
+
+    {
+        std::lock_guard<std::mutex> guardLock(lock);
+        queued--;
+    }
+
+    task();
+    return true;
+}
+
+void WorkStealingPool::workerMain(size_t which)
+{
+    while (true)
+    {
+        if (runOne(which))
+        {
+            continue;
+        }
+
+        std::unique_lock<std::mutex> guardLock(lock);
+        wake.wait(guardLock, [this]{ return queued > 0 || shutdown; });
+        if (shutdown && queued == 0)
+        {
+            return;
+        }
+    }
+}
+
+}
@@ -37,6 +37,20 @@
 - (nullable instancetype)initWithMBTiles:(NSString *__nonnull)fileName
                                cacheSize:(int)cacheSize;
 
+/// Initialize with the name of the local MBTiles file, cache size in bytes, and the number
+/// of read-only connections to keep open.  Zero connections picks a default for the device.
+- (nullable instancetype)initWithMBTiles:(NSString *__nonnull)fileName
+                               cacheSize:(int)cacheSize
+                             connections:(int)numConnections;
+
+/// Initialize as above, additionally reading up to mmapSize bytes of the file through a memory map.
+/// When mapped, tiles are read into reused buffers rather than a new allocation for each.
+/// Zero disables mapping.
+- (nullable instancetype)initWithMBTiles:(NSString *__nonnull)fileName
+                               cacheSize:(int)cacheSize
+                             connections:(int)numConnections
+                                mmapSize:(int64_t)mmapSize;
+
 // Coordinate system (probably Spherical Mercator)
 - (MaplyCoordinateSystem * __nonnull)coordSys;
 
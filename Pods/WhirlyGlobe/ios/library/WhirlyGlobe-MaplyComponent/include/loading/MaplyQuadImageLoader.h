@@ -104,6 +104,8 @@
 /**
  This loader interpreter treats input image data objects as PNGs containing raw data.
  The difference is we'll use a direct PNG reader to tease it out, rather than UIImage.
+ For the 565, 4444 and single byte RGB image formats the PNG is decoded straight
+ into that layout, a row at a time, into reused buffers.
  */
 @interface MaplyRawPNGImageLoaderInterpreter : MaplyImageLoaderInterpreter
 
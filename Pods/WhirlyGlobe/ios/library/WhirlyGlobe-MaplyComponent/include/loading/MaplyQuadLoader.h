@@ -123,6 +123,7 @@ typedef void (__strong ^InitCompletionBlock)(void);
 
 /// Number of simultaneous tiles we'll parse
 /// This is really just a limit on the number of tiles we'll parse concurrently to keep memory use under control
+/// Without a queue, it also bounds the number of tiles waiting to be parsed and parsed tiles waiting to be merged
 @property (nonatomic) unsigned int numSimultaneousTiles;
 
 /// Label for tracking
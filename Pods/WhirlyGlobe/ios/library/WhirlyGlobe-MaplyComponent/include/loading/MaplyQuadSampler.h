@@ -83,6 +83,27 @@
 /// If set, we'll try to load a single level
 @property (nonatomic) bool singleLevel;
 
+/// If set, tiles on flat maps share a mesh for each tessellation rather than building their own.
+/// Has no effect on the globe.  Off by default.
+@property (nonatomic) bool templateMeshes;
+
+/// Tiles we already have only get an importance update if it has changed by more than both of these.
+/// The relative one is a fraction of the last value sent.  Both default to 0, which sends every change.
+@property (nonatomic) double importanceChangeRelative;
+@property (nonatomic) double importanceChangeAbsolute;
+
+/// If set, we'll look this far ahead (in seconds) along the current view animation
+/// and fetch the tiles we'll need there at the lowest priority.
+/// Off (0) by default.
+@property (nonatomic) double prefetchTime;
+
+/// Maximum number of tiles to fetch ahead when `prefetchTime` is set.  Defaults to 32.
+@property (nonatomic) int prefetchMaxTiles;
+
+/// If set, the quad tree is evaluated on a pool of threads shared by all the samplers.
+/// Off by default.
+@property (nonatomic) bool parallelCoverage;
+
 /// If set, the tiles are clipped to this boundary
 @property (nonatomic) MaplyBoundingBoxD clipBounds;
 @property (nonatomic,readonly) bool hasClipBounds;
@@ -20,6 +20,8 @@
 
 #import <WhirlyGlobe/MaplyTileSourceNew.h>
 
+@class MaplySimpleTileFetchInfo;
+
 /** Simple Tile Fetcher is meant for sub classing.
  
     Some data sources aren't all that complex.  You read from a local source,
@@ -61,6 +63,18 @@
   */
 - (id __nullable)dataForTile:(id __nonnull)fetchInfo tileID:(MaplyTileID)tileID;
 
+/** Override dataForTiles: if you can fetch several tiles at once more cheaply than one at a time.
+ 
+    Return one entry per fetchInfo, in the same order, using NSNull for any tile
+    that isn't there.  The default calls dataForTile:tileID: for each one.
+ 
+    You'll be called on the dispatch queue with up to batchSize tiles, most important first.
+  */
+- (NSArray * __nonnull)dataForTiles:(NSArray<MaplySimpleTileFetchInfo *> * __nonnull)fetchInfos;
+
+/// Maximum number of tiles to fetch at once with dataForTiles:.  Defaults to 1.
+@property (nonatomic) int batchSize;
+
 /** Override the shutdown method.
  
     Call the superclass shutdown method *first* and then run your own shutdown.
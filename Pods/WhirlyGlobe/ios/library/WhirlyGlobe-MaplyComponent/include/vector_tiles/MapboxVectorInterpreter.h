@@ -62,4 +62,13 @@
  */
 - (void)setUUIDName:(NSString * __nonnull)uuidName uuidValues:(NSArray<NSString *> * __nonnull)uuids;
 
+/**
+ Build the styles for each tile on a shared pool of threads rather than one after another.
+ 
+ Styles that use the same features are still run together, and the results come out
+ in the same order.  Only turn this on if your styles can be built from more than one
+ thread at once.  Off by default.
+ */
+@property (nonatomic) bool parallelStyles;
+
 @end
@@ -902,8 +902,8 @@ static inline bool dictBool(const NSDictionary *dict, const NSString *key, bool
         wgMarker->layoutImportance = marker.layoutImportance;
         
         // Assemble the geometry to lay out a marker along
-        if (marker.layoutVec && !marker.layoutVec->vObj->shapes.empty()) {
-            for (auto shape: marker.layoutVec->vObj->shapes) {
+        if (marker.layoutVec && !marker.layoutVec->vObj->getShapes().empty()) {
+            for (auto shape: marker.layoutVec->vObj->getShapes()) {
                 auto shapeLin = std::dynamic_pointer_cast<VectorLinear>(shape);
                 if (shapeLin) {
                     wgMarker->layoutShape = shapeLin->pts;
@@ -1447,8 +1447,8 @@ static inline bool dictBool(const NSDictionary *dict, const NSString *key, bool
             wgLabel->endTime = now + movingLabel.duration;
         }
         
-        if (label.layoutVec && !label.layoutVec->vObj->shapes.empty()) {
-            for (auto shape: label.layoutVec->vObj->shapes) {
+        if (label.layoutVec && !label.layoutVec->vObj->getShapes().empty()) {
+            for (auto shape: label.layoutVec->vObj->getShapes()) {
                 auto shapeLin = std::dynamic_pointer_cast<VectorLinear>(shape);
                 if (shapeLin) {
                     wgLabel->layoutShape = shapeLin->pts;
@@ -1685,7 +1685,7 @@ static inline bool dictBool(const NSDictionary *dict, const NSString *key, bool
     size_t shapeCount = 0;
     for (const MaplyVectorObject *vecObj in vectors)
     {
-        shapeCount += vecObj->vObj->shapes.size();
+        shapeCount += vecObj->vObj->getShapes().size();
     }
 
     ShapeSet shapes(shapeCount);
@@ -1720,12 +1720,12 @@ static inline bool dictBool(const NSDictionary *dict, const NSString *key, bool
                 [newVecObj subdivideToGlobe:eps];
             }
 
-            shapes.insert(newVecObj->vObj->shapes.begin(),newVecObj->vObj->shapes.end());
+            shapes.insert(newVecObj->vObj->getShapes().begin(),newVecObj->vObj->getShapes().end());
         }
         else
         {
             // We'll just reference it
-            shapes.insert(vecObj->vObj->shapes.begin(),vecObj->vObj->shapes.end());
+            shapes.insert(vecObj->vObj->getShapes().begin(),vecObj->vObj->getShapes().end());
         }
     }
 
@@ -1817,7 +1817,7 @@ static inline bool dictBool(const NSDictionary *dict, const NSString *key, bool
     std::vector<VectorShapeRef> shapes;
     for (const MaplyVectorObject *vecObj in vectors)
     {
-        for (const auto &shape: vecObj->vObj->shapes)
+        for (const auto &shape: vecObj->vObj->getShapes())
         {
             if (auto dict = dynamic_cast<const iosMutableDictionary*>(shape->getAttrDictRef().get()))
             {
@@ -1854,12 +1854,12 @@ static inline bool dictBool(const NSDictionary *dict, const NSString *key, bool
                 [newVecObj subdivideToGlobe:eps];
             }
             
-            shapes.insert(shapes.end(),newVecObj->vObj->shapes.begin(),newVecObj->vObj->shapes.end());
+            shapes.insert(shapes.end(),newVecObj->vObj->getShapes().begin(),newVecObj->vObj->getShapes().end());
         }
         else
         {
             // We'll just reference it
-            shapes.insert(shapes.end(),vecObj->vObj->shapes.begin(),vecObj->vObj->shapes.end());
+            shapes.insert(shapes.end(),vecObj->vObj->getShapes().begin(),vecObj->vObj->getShapes().end());
         }
     }
 
@@ -2886,7 +2886,7 @@ typedef std::set<GeomModelInstances *,struct GeomModelInstancesCmp> GeomModelIns
     ShapeSet shapes;
     for (MaplyVectorObject *vecObj in vectors)
     {
-        shapes.insert(vecObj->vObj->shapes.begin(),vecObj->vObj->shapes.end());
+        shapes.insert(vecObj->vObj->getShapes().begin(),vecObj->vObj->getShapes().end());
     }
 
     ChangeSet changes;
@@ -19,17 +19,29 @@
 #import "data_sources/MaplyMBTileFetcher.h"
 #import "MaplyCoordinateSystem_private.h"
 #import "WhirlyGlobeLib.h"
-#import "sqlhelpers.h"
+#import "MBTilesReader.h"
 
 using namespace WhirlyKit;
 
+// Tiles read from the file at once, one range query per level
+static const int MBTileFetchBatchSize = 8;
+
+// Hang on to the tile data until the NSData is released rather than copying it.
+// Taken by value, since a block only copies the shared pointer if it's a local, not a reference.
+static NSData *WrapTileData(RawDataRef tileData)
+{
+    return [[NSData alloc] initWithBytesNoCopy:(void *)tileData->getRawData()
+                                        length:tileData->getLen()
+                                   deallocator:^(void *bytes, NSUInteger length) {
+        (void)tileData;
+    }];
+}
+
 @implementation MaplyMBTileFetcher
 {
-    bool tilesStyles;
-    int minZoom,maxZoom;
     Mbr mbr;
     GeoMbr geoMbr;
-    sqlite3 *sqlDb;
+    MBTilesReaderRef reader;
     MaplyCoordinateSystem *coordSys;
 }
 
@@ -40,6 +52,21 @@ using namespace WhirlyKit;
 
 - (nullable instancetype)initWithMBTiles:(NSString *__nonnull)mbTilesName
                                cacheSize:(int)cacheSize
+{
+    return [self initWithMBTiles:mbTilesName cacheSize:cacheSize connections:0];
+}
+
+- (nullable instancetype)initWithMBTiles:(NSString *__nonnull)mbTilesName
+                               cacheSize:(int)cacheSize
+                             connections:(int)numConnections
+{
+    return [self initWithMBTiles:mbTilesName cacheSize:cacheSize connections:numConnections mmapSize:0];
+}
+
+- (nullable instancetype)initWithMBTiles:(NSString *__nonnull)mbTilesName
+                               cacheSize:(int)cacheSize
+                             connections:(int)numConnections
+                                mmapSize:(int64_t)mmapSize
 {
     NSString *infoPath = nil;
     
@@ -77,157 +104,30 @@ using namespace WhirlyKit;
         return nil;
     }
 
-    // Open the sqlite DB
-    sqlite3 *db = nil;
-    // Disable writes, eliminating the need for locking.
-    const int flags = SQLITE_OPEN_READONLY |
-                      SQLITE_OPEN_NOMUTEX;
-                      //| SQLITE_OPEN_EXRESCODE;    // extended error codes on failure - available in later versions
-    const int openRes = sqlite3_open_v2(nameStr, &db, flags, nullptr);
-    if (openRes != SQLITE_OK)
+    // Open the sqlite DB and read the metadata
+    const auto newReader = std::make_shared<MBTilesReader>(nameStr, numConnections, cacheSize, mmapSize);
+    if (!newReader->isValid())
     {
-        const char* const err = sqlite3_errstr(openRes);
-        wkLogLevel(Error, "SQLite failed to open '%s' - %d: %s", nameStr, openRes, err ? err : "?");
         return nil;
     }
 
     const auto cs = [[MaplySphericalMercator alloc] initWebStandard];
 
-    if (cacheSize >= 0)
-    {
-        try
-        {
-            sqlhelpers::StatementRead pageStmt(db, "PRAGMA page_size", false);
-            const int pageSize = pageStmt.stepRow() ? pageStmt.getInt() : 0;
-            if (pageSize > 0)
-            {
-                const int cachePages = (cacheSize + pageSize - 1) / pageSize;
-                const auto sql = "PRAGMA cache_size=" + std::to_string(cachePages);
-                sqlhelpers::StatementRead configStmt(db, sql.c_str(), true);
-
-                sqlhelpers::StatementRead cacheStmt(db, "PRAGMA cache_size", false);
-                if (cacheStmt.stepRow())
-                {
-                    const int actualCachePages = cacheStmt.getInt();
-                    wkLogLevel(Info, "SQLite cache size set to %d pages = %d bytes",
-                               actualCachePages, actualCachePages * pageSize);
-                }
-            }
-        }
-        catch (const std::exception &e)
-        {
-            wkLogLevel(Warn, "Failed to set SQLite cache (%s)", e.what());
-        }
-        catch (int e)
-        {
-            const char* const str = sqlite3_errstr(e);
-            wkLogLevel(Warn, "Failed to set SQLite cache (%d): %s", e, str ? str : "?");
-        }
-        catch (...)
-        {
-            const int e = sqlite3_errcode(db);
-            const char* const str = sqlite3_errmsg(db);
-            wkLogLevel(Warn, "Failed to set SQLite cache (%d): %s", e, str ? str : "?");
-        }
-    }
+    // And let's convert that over to spherical mercator
+    const GeoMbr &gmbr = newReader->getGeoMbr();
+    const Point3f ll = [cs getCoordSystem]->geographicToLocal(gmbr.ll());
+    const Point3f ur = [cs getCoordSystem]->geographicToLocal(gmbr.ur());
 
-    // Look at the metadata
-    GeoMbr gmbr;
-    bool failed = false;
-    try
+    if ((self = [super initWithName:mbTilesName minZoom:newReader->getMinZoom() maxZoom:newReader->getMaxZoom()]))
     {
-        sqlhelpers::StatementRead readStmt(db,@"select value from metadata where name='bounds';");
-        if (readStmt.stepRow())
-        {
-            NSString *bounds = readStmt.getString();
-            NSScanner *scan = [NSScanner scannerWithString:bounds];
-            NSMutableCharacterSet *charSet = [[NSMutableCharacterSet alloc] init];
-            [charSet addCharactersInString:@", "];
-            [scan setCharactersToBeSkipped:charSet];
-            double ll_lat,ll_lon,ur_lat,ur_lon;
-            if (![scan scanDouble:&ll_lon] ||
-                ![scan scanDouble:&ll_lat] ||
-                ![scan scanDouble:&ur_lon] ||
-                ![scan scanDouble:&ur_lat])
-            {
-                return nil;
-            }
-            gmbr.ll() = GeoCoord::CoordFromDegrees(ll_lon,ll_lat);
-            gmbr.ur() = GeoCoord::CoordFromDegrees(ur_lon,ur_lat);
-        } else {
-            // No bounds implies it covers the whole earth
-            gmbr.ll() = GeoCoord::CoordFromDegrees(-180, -85.0511);
-            gmbr.ur() = GeoCoord::CoordFromDegrees(180, 85.0511);
-        }
-        
-        // And let's convert that over to spherical mercator
-        const Point3f ll = [cs getCoordSystem]->geographicToLocal(gmbr.ll());
         mbr.ll() = Point2f(ll.x(),ll.y());
-        const Point3f ur = [cs getCoordSystem]->geographicToLocal(gmbr.ur());
         mbr.ur() = Point2f(ur.x(),ur.y());
-
-        minZoom = 0;  maxZoom = 8;
-        sqlhelpers::StatementRead readStmt2(db,@"select value from metadata where name='minzoom';");
-        if (readStmt2.stepRow())
-            minZoom = [readStmt2.getString() intValue];
-        else {
-            // Read it the hard way
-            sqlhelpers::StatementRead readStmt3(db,@"select min(zoom_level) from tiles;");
-            if (readStmt3.stepRow())
-                minZoom = [readStmt3.getString() intValue];
-        }
-        sqlhelpers::StatementRead readStmt3(db,@"select value from metadata where name='maxzoom';");
-        if (readStmt3.stepRow())
-            maxZoom = [readStmt3.getString() intValue];
-        else {
-            // Read it the hard way
-            sqlhelpers::StatementRead readStmt3(db,@"select max(zoom_level) from tiles;");
-            if (readStmt3.stepRow())
-                maxZoom = [readStmt3.getString() intValue];
-        }
-        
-        sqlhelpers::StatementRead readStmt4(db,"select value from metadata where name='format';");
-        if (readStmt4.stepRow())
-            _format = readStmt4.getString();
-        
-        // See if there's a tiles table or it's the older(?) style
-        sqlhelpers::StatementRead testStmt(db,@"SELECT name FROM sqlite_master WHERE type='table' AND name='tiles';");
-        if (testStmt.stepRow())
-            tilesStyles = true;
-    }
-    catch (const std::exception &e)
-    {
-        wkLogLevel(Error, "Exception fetching MBTiles metadata (%s)", e.what());
-        failed = true;
-    }
-    catch (int e)
-    {
-        const char* const str = sqlite3_errstr(e);
-        wkLogLevel(Error, "Exception fetching MBTiles metadata (%d): %s", e, str ? str : "?");
-        failed = true;
-    }
-    catch (...)
-    {
-        const int e = sqlite3_errcode(db);
-        const char* const str = sqlite3_errmsg(db);
-        wkLogLevel(Error, "Exception fetching MBTiles metadata (%d): %s", e, str ? str : "?");
-        failed = true;
-    }
-
-    if (failed)
-    {
-        if (db)
-        {
-            sqlite3_close(db);
-        }
-        return nil;
-    }
-
-    if ((self = [super initWithName:mbTilesName minZoom:minZoom maxZoom:maxZoom]))
-    {
         geoMbr = gmbr;
         coordSys = cs;
-        sqlDb = db;
+        reader = newReader;
+        self.batchSize = MBTileFetchBatchSize;
+        if (!newReader->getFormat().empty())
+            _format = [NSString stringWithUTF8String:newReader->getFormat().c_str()];
     }
     
     return self;
@@ -240,41 +140,63 @@ using namespace WhirlyKit;
 
 - (id)dataForTile:(id)fetchInfo tileID:(MaplyTileID)tileID;
 {
-    NSData *imageData = nil;
-    
-    @synchronized(self)
+    const MBTilesReaderRef theReader = reader;
+    if (!theReader)
+        return nil;
+
+    // The reader has its own connection pool, no need to lock here
+    RawDataRef tileData;
+    try {
+        tileData = theReader->fetchTile(QuadTreeIdentifier(tileID.x,tileID.y,tileID.level));
+    } catch (const std::exception &e) {
+        wkLogLevel(Warn, "Exception in [MaplyMBTileFetcher dataForTile:] (%s)", e.what());
+    } catch (...) {
+        wkLogLevel(Warn, "Exception in [MaplyMBTileFetcher dataForTile:]");
+    }
+    if (!tileData)
+        return nil;
+
+    return WrapTileData(tileData);
+}
+
+- (NSArray *)dataForTiles:(NSArray<MaplySimpleTileFetchInfo *> *)fetchInfos
+{
+    NSMutableArray *ret = [NSMutableArray arrayWithCapacity:fetchInfos.count];
+
+    const MBTilesReaderRef theReader = reader;
+    RawDataRefVec allTileData;
+    if (theReader)
     {
+        std::vector<QuadTreeIdentifier> idents;
+        idents.reserve(fetchInfos.count);
+        for (MaplySimpleTileFetchInfo *fetchInfo in fetchInfos)
+            idents.emplace_back(fetchInfo.x,fetchInfo.y,fetchInfo.level);
+
         try {
-            if (tilesStyles)
-            {
-                sqlhelpers::StatementRead readStmt(sqlDb,[NSString stringWithFormat:@"SELECT tile_data from tiles where zoom_level='%d' AND tile_column='%d' AND tile_row='%d';",tileID.level,tileID.x,tileID.y]);
-                if (readStmt.stepRow())
-                    imageData = readStmt.getBlob();
-            } else {
-                sqlhelpers::StatementRead readStmt(sqlDb,[NSString stringWithFormat:@"SELECT tile_id from map where zoom_level='%d' AND tile_column='%d' AND tile_row='%d';",tileID.level,tileID.x,tileID.y]);
-                if (readStmt.stepRow())
-                {
-                    NSString *tile_id = readStmt.getString();
-                    sqlhelpers::StatementRead readStmt2(sqlDb,[NSString stringWithFormat:@"SELECT tile_data from images where tile_id='%@';",tile_id]);
-                    if (readStmt2.stepRow())
-                        imageData = readStmt2.getBlob();
-                }
-            }
-        } catch (int e) {
-            NSLog(@"Exception in [MaplyMBTileSouce imageForTile:]");
+            allTileData = theReader->fetchTiles(idents);
+        } catch (const std::exception &e) {
+            wkLogLevel(Warn, "Exception in [MaplyMBTileFetcher dataForTiles:] (%s)", e.what());
+        } catch (...) {
+            wkLogLevel(Warn, "Exception in [MaplyMBTileFetcher dataForTiles:]");
         }
     }
-    
-    return imageData;
+
+    for (unsigned int ii=0;ii<fetchInfos.count;ii++)
+    {
+        const RawDataRef tileData = ii < allTileData.size() ? allTileData[ii] : RawDataRef();
+        [ret addObject:tileData ? WrapTileData(tileData) : [NSNull null]];
+    }
+
+    return ret;
 }
 
 - (void)shutdown
 {
     [super shutdown];
     
-    if (sqlDb) {
-        sqlite3_close(sqlDb);
-        sqlDb = nullptr;
+    if (reader) {
+        reader->close();
+        reader.reset();
     }
 }
 
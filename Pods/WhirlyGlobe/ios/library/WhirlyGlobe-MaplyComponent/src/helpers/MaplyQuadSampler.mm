@@ -174,6 +174,66 @@ using namespace WhirlyKit;
     params.singleLevel = singleLevel;
 }
 
+- (bool)templateMeshes
+{
+    return params.templateMeshes;
+}
+
+- (void)setTemplateMeshes:(bool)templateMeshes
+{
+    params.templateMeshes = templateMeshes;
+}
+
+- (double)importanceChangeRelative
+{
+    return params.importanceChangeRelative;
+}
+
+- (void)setImportanceChangeRelative:(double)importanceChangeRelative
+{
+    params.importanceChangeRelative = importanceChangeRelative;
+}
+
+- (double)importanceChangeAbsolute
+{
+    return params.importanceChangeAbsolute;
+}
+
+- (void)setImportanceChangeAbsolute:(double)importanceChangeAbsolute
+{
+    params.importanceChangeAbsolute = importanceChangeAbsolute;
+}
+
+- (double)prefetchTime
+{
+    return params.prefetchTime;
+}
+
+- (void)setPrefetchTime:(double)prefetchTime
+{
+    params.prefetchTime = prefetchTime;
+}
+
+- (int)prefetchMaxTiles
+{
+    return params.prefetchMaxTiles;
+}
+
+- (void)setPrefetchMaxTiles:(int)prefetchMaxTiles
+{
+    params.prefetchMaxTiles = prefetchMaxTiles;
+}
+
+- (bool)parallelCoverage
+{
+    return params.parallelCoverage;
+}
+
+- (void)setParallelCoverage:(bool)parallelCoverage
+{
+    params.parallelCoverage = parallelCoverage;
+}
+
 - (void)setForceMinLevel:(bool)forceMinLevel
 {
     params.forceMinLevel = forceMinLevel;
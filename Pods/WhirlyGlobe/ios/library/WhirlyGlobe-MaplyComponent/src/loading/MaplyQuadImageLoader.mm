@@ -213,6 +213,17 @@ using namespace WhirlyKit;
 @implementation MaplyRawPNGImageLoaderInterpreter
 {
     std::vector<int> valueMap;
+    // Decoded tiles go into buffers from here and come back when the texture is done with them
+    RawDataPoolRef pool;
+}
+
+- (instancetype)init
+{
+    if ((self = [super init]))
+    {
+        pool = std::make_shared<RawDataPool>(16);
+    }
+    return self;
 }
 
 - (void)addMappingFrom:(int)inVal to:(int)outVal
@@ -223,9 +234,32 @@ using namespace WhirlyKit;
         valueMap[inVal] = outVal;
 }
 
+// Decode straight to what the texture wants where we can, rather than converting later
+static RawPNGPixelFormat DecodeFormatForLoader(MaplyQuadLoaderBase *loader)
+{
+    if (![loader isKindOfClass:[MaplyQuadImageLoaderBase class]])
+    {
+        return RawPNGNative;
+    }
+    switch (((MaplyQuadImageLoaderBase *)loader).imageFormat)
+    {
+#if TARGET_OS_MACCATALYST || TARGET_OS_SIMULATOR
+        // These use RGBA textures here
+        case MaplyImageUShort565:   return RawPNGRGBA8;
+        case MaplyImageUShort4444:  return RawPNGRGBA8;
+#else
+        case MaplyImageUShort565:   return RawPNGRGB565;
+        case MaplyImageUShort4444:  return RawPNGRGBA4444;
+#endif
+        case MaplyImageUByteRGB:    return RawPNGSingle8;
+        default:                    return RawPNGNative;
+    }
+}
+
 - (void)dataForTile:(MaplyImageLoaderReturn *)loadReturn loader:(MaplyQuadLoaderBase *)loader
 {
     const auto __strong vc = loader.viewC;
+    const RawPNGPixelFormat decodeFormat = DecodeFormatForLoader(loader);
     NSArray<id> *tileData = [loadReturn getTileData];
     for (unsigned int ii=0;ii<[tileData count];ii++)
     {
@@ -250,8 +284,8 @@ using namespace WhirlyKit;
         unsigned width = 0, height = 0, err = 0, depth = 0, channels = 0;
         std::string errStr;
         const auto *valPtr = (valueMap.size() >= 256) ? &valueMap[0] : nullptr;
-        const auto outData = RawPNGImageLoaderInterpreter(width, height, bytes, length, valPtr,
-                                                          &depth, &channels, &err, &errStr);
+        const auto outData = RawPNGImageDecodeToPool(pool, bytes, length, decodeFormat, valPtr,
+                                                     width, height, &depth, &channels, &err, &errStr);
 
         if (err != 0 || !outData)
         {
@@ -261,11 +295,12 @@ using namespace WhirlyKit;
             continue;
         }
 
-        const auto dataSize = width * height * channels * depth / 8;
-
-        if (NSData *retData = [[NSData alloc] initWithBytesNoCopy:outData
-                                                           length:dataSize
-                                                     freeWhenDone:YES])
+        // The deallocator holds on to the pooled buffer until the NSData goes away
+        if (NSData *retData = [[NSData alloc] initWithBytesNoCopy:outData->getMutableData()
+                                                           length:outData->getLen()
+                                                      deallocator:^(void *, NSUInteger) {
+                                                          (void)outData;
+                                                      }])
         {
             // Build a wrapper around the data and pass it on
             if (MaplyImageTile *tileData = [[MaplyImageTile alloc] initWithRawImage:retData
@@ -283,11 +318,6 @@ using namespace WhirlyKit;
                 loadReturn->loadReturn->images.push_back(tileData->imageTile);
             }
         }
-        else
-        {
-            // NSData won't free the data, so we need to.
-            free(outData);
-        }
     }
 }
 
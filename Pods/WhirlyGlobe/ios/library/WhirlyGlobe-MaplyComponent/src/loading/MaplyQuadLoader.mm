@@ -531,6 +531,9 @@ using namespace WhirlyKit;
         delete change;
     }
     loadReturn->loadReturn->changes.clear();
+
+    // Not going to be merged, so let the decoders move on
+    loadReturn->loadReturn->decodeSlot.reset();
 }
 
 // Called on the SamplingLayer.LayerThread
@@ -552,6 +555,14 @@ using namespace WhirlyKit;
         serialQueue = dispatch_queue_create("Quad Loader Serial", DISPATCH_QUEUE_SERIAL);
         serialSemaphore = dispatch_semaphore_create(_numSimultaneousTiles);
     }
+    // Unless we've been given a queue, decoding goes through the loader's own workers
+    if (!_queue && serialQueue && !loader->getDecodeQueue()) {
+        const int numThreads = std::min((int)_numSimultaneousTiles,
+                                        std::max(1, (int)NSProcessInfo.processInfo.activeProcessorCount - 1));
+        loader->setDecodeQueue(std::make_shared<QuadLoaderDecodeQueue>(numThreads,
+                                                                       4 * (int)_numSimultaneousTiles,
+                                                                       2 * (int)_numSimultaneousTiles));
+    }
     
     QuadTreeIdentifier tileID = loadReturn->loadReturn->ident;
     // Don't actually want this one
@@ -593,51 +604,67 @@ using namespace WhirlyKit;
         // Hold on to these till the task runs
         NSObject<MaplyLoaderInterpreter> *theLoadInterp = self->loadInterp;
 
-        dispatch_async(theQueue, ^{
+        auto loadAndMerge = ^{
             if (!self->valid || !self->_viewC)
             {
                 [self cleanupLoadedData:loadReturn];
                 return;
             }
 
-            auto loadAndMerge = ^{
-                // No load interpreter means the fetcher created the objects.  Hopefully.
-                if (theLoadInterp && !loadReturn->loadReturn->cancel)
-                    [theLoadInterp dataForTile:loadReturn loader:self];
-                
-                // Merge in the results on the sampling layer thread.
-                // If the load was canceled, or we're shutting down and the thread no
-                // longer exists, then we need to clean up the results to avoid leaks.
-                const auto __strong thread = self->samplingLayer.layerThread;
-                if (!thread || [thread isCancelled])
-                {
-                    [self cleanupLoadedData:loadReturn];
-                }
-                else
+            // No load interpreter means the fetcher created the objects.  Hopefully.
+            if (theLoadInterp && !loadReturn->loadReturn->cancel)
+                [theLoadInterp dataForTile:loadReturn loader:self];
+            
+            // Merge in the results on the sampling layer thread.
+            // If the load was canceled, or we're shutting down and the thread no
+            // longer exists, then we need to clean up the results to avoid leaks.
+            const auto __strong thread = self->samplingLayer.layerThread;
+            if (!thread || [thread isCancelled])
+            {
+                [self cleanupLoadedData:loadReturn];
+            }
+            else
+            {
+                // Objects in this LoaderReturn have already been added to the base controller.
+                // If the layer thread is stopped between now and when the perform occurs, those
+                // objects will not be cleaned up by mergeLoadedTile(), and need to be cleaned up
+                // in shutdown() instead.
                 {
-                    // Objects in this LoaderReturn have already been added to the base controller.
-                    // If the layer thread is stopped between now and when the perform occurs, those
-                    // objects will not be cleaned up by mergeLoadedTile(), and need to be cleaned up
-                    // in shutdown() instead.
+                    std::lock_guard<std::mutex> lock(self->pendingReturnsLock);
+                    if (self->valid)
                     {
-                        std::lock_guard<std::mutex> lock(self->pendingReturnsLock);
-                        if (self->valid)
-                        {
-                            [self->pendingReturns addObject:loadReturn];
-                        }
-                        else
-                        {
-                            // Shutdown already started, newly added objects may not be cleaned up.
-                            [self cleanupLoadedData:loadReturn];
-                        }
+                        [self->pendingReturns addObject:loadReturn];
                     }
-                    if (self->valid)
+                    else
                     {
-                        [self performSelector:@selector(mergeLoadedTile:) onThread:thread withObject:loadReturn waitUntilDone:NO];
+                        // Shutdown already started, newly added objects may not be cleaned up.
+                        [self cleanupLoadedData:loadReturn];
                     }
                 }
-            };
-            
+                if (self->valid)
+                {
+                    [self performSelector:@selector(mergeLoadedTile:) onThread:thread withObject:loadReturn waitUntilDone:NO];
+                }
+            }
+        };
+
+        if (const auto decodeQueue = _queue ? QuadLoaderDecodeQueueRef() : loader->getDecodeQueue())
+        {
+            // Decode in the same order we'd fetch in
+            int priority = 0;
+            double importance = 0.0;
+            loader->calcDecodePriority(loadReturn->loadReturn.get(), priority, importance);
+            const auto loadReturnRef = loadReturn->loadReturn;
+
+            // Adding waits if the decoders are backed up, which the layer thread shouldn't do.
+            // The decoders are plain threads with no autorelease pool of their own.
+            dispatch_async(theQueue, ^{
+                decodeQueue->addTask(loadReturnRef, priority, importance, [loadAndMerge]{ @autoreleasepool { loadAndMerge(); } });
+            });
+            return;
+        }
+
+        dispatch_async(theQueue, ^{
             if (theSemaphore) {
                 // Need to limit the number of simultaneous loader return parses
                 dispatch_semaphore_wait(theSemaphore, DISPATCH_TIME_FOREVER);
@@ -66,7 +66,7 @@ using namespace WhirlyKit;
 class TileInfo
 {
 public:
-    TileInfo() : priority(0), importance(0.0), request(nil), fetchInfo(nil) { }
+    TileInfo() : priority(0), importance(0.0), request(nil), fetchInfo(nil), queuedNanos(0) { }
     
     /// Comparison based on importance, tile source, then x,y,level
     bool operator < (const TileInfo &that) const
@@ -91,6 +91,9 @@ public:
     
     // Specific fetchInfo from the fetch request.
     MaplySimpleTileFetchInfo *fetchInfo;
+
+    // When the request went into the queue, for the tile load tracer
+    int64_t queuedNanos;
 };
 
 typedef std::shared_ptr<TileInfo> TileInfoRef;
@@ -122,6 +125,7 @@ typedef std::map<MaplyTileFetchRequest *,TileInfoRef> TileFetchMap;
     minZoom = inMinZoom;
     maxZoom = inMaxZoom;
     _neverFail = true;
+    _batchSize = 1;
     
     tileInfo = [[MaplySimpleTileInfo alloc] initWithMinZoom:minZoom maxZoom:maxZoom];
     _queue = dispatch_queue_create([_name cStringUsingEncoding:NSASCIIStringEncoding], DISPATCH_QUEUE_SERIAL);
@@ -152,6 +156,21 @@ typedef std::map<MaplyTileFetchRequest *,TileInfoRef> TileFetchMap;
     return nil;
 }
 
+- (NSArray *)dataForTiles:(NSArray<MaplySimpleTileFetchInfo *> *)fetchInfos
+{
+    NSMutableArray *ret = [NSMutableArray arrayWithCapacity:fetchInfos.count];
+    for (MaplySimpleTileFetchInfo *fetchInfo in fetchInfos)
+    {
+        MaplyTileID tileID;
+        tileID.level = fetchInfo.level;
+        tileID.x = fetchInfo.x;    tileID.y = fetchInfo.y;
+        id tileData = [self dataForTile:fetchInfo tileID:tileID];
+        [ret addObject:tileData ? tileData : [NSNull null]];
+    }
+    
+    return ret;
+}
+
 - (void)updateLoading
 {
     loadScheduled = false;
@@ -162,18 +181,37 @@ typedef std::map<MaplyTileFetchRequest *,TileInfoRef> TileFetchMap;
     if (toLoad.empty())
         return;
     
-    // Take the first one off the stack
-    auto it = toLoad.rbegin();
-    TileInfoRef tile = *it;
-    
+    // Take the most important ones off the stack
+    std::vector<TileInfoRef> tiles;
+    const int maxTiles = std::max(1,_batchSize);
+    for (auto it = toLoad.rbegin(); it != toLoad.rend() && (int)tiles.size() < maxTiles; ++it)
+        tiles.push_back(*it);
+
+    TileLoadTracer &tracer = TileLoadTracer::shared();
+    if (tracer.isEnabled())
+    {
+        const int64_t nowNanos = TileLoadTracer::now();
+        for (const auto &tile : tiles)
+            if (tile->queuedNanos)
+                tracer.record(TileLoadStageFetchQueue, QuadTreeIdentifier(tile->fetchInfo.x,tile->fetchInfo.y,tile->fetchInfo.level), -1,
+                              tile->queuedNanos, nowNanos);
+    }
+
     // The actual data fetch.  Woo.
-    MaplyTileID tileID;
-    tileID.level = tile->fetchInfo.level;
-    tileID.x = tile->fetchInfo.x;    tileID.y = tile->fetchInfo.y;
-    id tileData = [self dataForTile:tile->fetchInfo tileID:tileID];
-    NSError *error = nil;
-    if (!tileData) {
-        error = [[NSError alloc] initWithDomain:@"MaplySimpleTileFetcher" code:0 userInfo:@{NSLocalizedDescriptionKey: @"Failed to fetch tile from sqlite file"}];
+    NSArray *allTileData = nil;
+    if (tiles.size() == 1)
+    {
+        const auto &tile = tiles[0];
+        MaplyTileID tileID;
+        tileID.level = tile->fetchInfo.level;
+        tileID.x = tile->fetchInfo.x;    tileID.y = tile->fetchInfo.y;
+        id tileData = [self dataForTile:tile->fetchInfo tileID:tileID];
+        allTileData = @[tileData ? tileData : [NSNull null]];
+    } else {
+        NSMutableArray *fetchInfos = [NSMutableArray arrayWithCapacity:tiles.size()];
+        for (const auto &tile : tiles)
+            [fetchInfos addObject:tile->fetchInfo];
+        allTileData = [self dataForTiles:fetchInfos];
     }
     
     MaplySimpleTileFetcher * __weak weakSelf = self;
@@ -181,11 +219,19 @@ typedef std::map<MaplyTileFetchRequest *,TileInfoRef> TileFetchMap;
     // Because the parsing might take a while
     dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0),
                    ^{
-                       // We assume the parsing is going to take some time
-                       if (tileData || self.neverFail) {
-                           tile->request.success(tile->request,tileData);
-                       } else {
-                           tile->request.failure(tile->request, error);
+                       for (unsigned int ii=0;ii<tiles.size();ii++) {
+                           const auto &tile = tiles[ii];
+                           id tileData = ii < allTileData.count ? allTileData[ii] : nil;
+                           if (tileData == [NSNull null])
+                               tileData = nil;
+
+                           // We assume the parsing is going to take some time
+                           if (tileData || self.neverFail) {
+                               tile->request.success(tile->request,tileData);
+                           } else {
+                               NSError *error = [[NSError alloc] initWithDomain:@"MaplySimpleTileFetcher" code:0 userInfo:@{NSLocalizedDescriptionKey: @"Failed to fetch tile from sqlite file"}];
+                               tile->request.failure(tile->request, error);
+                           }
                        }
                        
                        dispatch_queue_t theQueue = weakSelf.queue;
@@ -196,7 +242,8 @@ typedef std::map<MaplyTileFetchRequest *,TileInfoRef> TileFetchMap;
                                           });
                    });
     
-    [weakSelf finishTile:tile];
+    for (const auto &tile : tiles)
+        [weakSelf finishTile:tile];
 }
 
 - (void)finishTile:(TileInfoRef)tile
@@ -241,6 +288,7 @@ typedef std::map<MaplyTileFetchRequest *,TileInfoRef> TileFetchMap;
             tile->priority = request.priority;
             tile->request = request;
             tile->fetchInfo = request.fetchInfo;
+            tile->queuedNanos = TileLoadTracer::now();
             self->tilesByFetchRequest[request] = tile;
             self->toLoad.insert(tile);
         }
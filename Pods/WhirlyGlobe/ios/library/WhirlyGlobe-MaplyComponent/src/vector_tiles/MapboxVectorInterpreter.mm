@@ -139,6 +139,43 @@ static int BackImageWidth = 16, BackImageHeight = 16;
     }
 }
 
+// One pool for all the interpreters building styles in parallel, kept while any of them are using it
+static WorkStealingPoolRef SharedStyleBuildPool()
+{
+    static std::mutex poolLock;
+    static std::weak_ptr<WorkStealingPool> sharedPool;
+
+    std::lock_guard<std::mutex> guardLock(poolLock);
+    auto pool = sharedPool.lock();
+    if (!pool)
+    {
+        // The styles may autorelease things, and these threads stick around
+        pool = std::make_shared<WorkStealingPool>(0, [](const WorkStealingPool::Task &task) {
+            @autoreleasepool {
+                task();
+            }
+        });
+        sharedPool = pool;
+    }
+    return pool;
+}
+
+- (void)setParallelStyles:(bool)parallelStyles
+{
+    _parallelStyles = parallelStyles;
+
+    // We pass no thread info to the parsers, so the styles can be built on any thread
+    const WorkStealingPoolRef pool = parallelStyles ? SharedStyleBuildPool() : WorkStealingPoolRef();
+    if (imageTileParser)
+    {
+        imageTileParser->setBuildPool(pool);
+    }
+    if (vecTileParser)
+    {
+        vecTileParser->setBuildPool(pool);
+    }
+}
+
 - (void)setLoader:(MaplyQuadLoaderBase *)inLoader
 {
     if ([inLoader isKindOfClass:[MaplyQuadImageLoaderBase class]]) {
@@ -719,6 +719,8 @@ VectorStyleDelegateWrapper::stylesForFeature(PlatformThreadInfo *inst,
         dict = dictRef->dict;
     } else if (const auto dictRef = dynamic_cast<const MutableDictionaryC*>(&attrs)) {
         dict = [NSMutableDictionary fromDictionaryCPointer:dictRef];
+    } else if (const auto dictRef = dynamic_cast<const VectorTileAttributes*>(&attrs)) {
+        dict = [NSMutableDictionary fromDictionaryCPointer:dictRef];
     } else if (dict) {
         wkLogLevel(Warn, "unsupported dictionary implementation");
         return std::vector<VectorStyleImplRef>();
@@ -814,6 +816,8 @@ void VectorStyleWrapper::buildObjects(PlatformThreadInfo *inst,
         {
             if (auto mVecObj = [[MaplyVectorObject alloc] init])
             {
+                // MaplyVectorObject works on the shapes directly, so they have to be there
+                vecObj->getShapes();
                 mVecObj->vObj = vecObj;
                 [vecArray addObject:mVecObj];
             }
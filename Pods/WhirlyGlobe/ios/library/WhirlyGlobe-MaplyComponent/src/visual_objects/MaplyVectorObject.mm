@@ -339,10 +339,10 @@ using namespace WhirlyGlobe;
     if (attrCache)
         return attrCache;
     
-    if (vObj->shapes.empty())
+    if (vObj->getShapes().empty())
         return nil;
 
-    const VectorShapeRef &vec = *(vObj->shapes.begin());
+    const VectorShapeRef &vec = *(vObj->getShapes().begin());
 
     // If it's a wrapper around an NSDictionary, return that
     iosMutableDictionaryRef dict = std::dynamic_pointer_cast<iosMutableDictionary>(vec->getAttrDict());
@@ -371,7 +371,7 @@ using namespace WhirlyGlobe;
 /// Add a hole to an existing areal feature
 - (void)addHole:(const MaplyCoordinate *)coords numCoords:(int)numCoords
 {
-    if (vObj->shapes.size() != 1)
+    if (vObj->getShapes().size() != 1)
         return;
     
     VectorRing pts;
@@ -622,12 +622,12 @@ using namespace WhirlyGlobe;
 
 - (NSArray *)asCLLocationArrays
 {
-    if (vObj->shapes.size() < 1)
+    if (vObj->getShapes().size() < 1)
         return nil;
 
     NSMutableArray *loops = [NSMutableArray array];
     
-    ShapeSet::iterator it = vObj->shapes.begin();
+    ShapeSet::iterator it = vObj->getShapes().begin();
     VectorArealRef ar = std::dynamic_pointer_cast<VectorAreal>(*it);
     if (ar)
     {
@@ -678,12 +678,12 @@ using namespace WhirlyGlobe;
 
 - (NSArray *)asNumbers
 {
-    if (vObj->shapes.size() < 1)
+    if (vObj->getShapes().size() < 1)
         return nil;
     
     NSMutableArray *outPts = [NSMutableArray array];
     
-    ShapeSet::iterator it = vObj->shapes.begin();
+    ShapeSet::iterator it = vObj->getShapes().begin();
     VectorLinearRef lin = std::dynamic_pointer_cast<VectorLinear>(*it);
     if (lin)
     {
@@ -714,7 +714,7 @@ using namespace WhirlyGlobe;
 - (NSArray *)splitVectors
 {
     // If the split will amount to a copy, just return this one
-    if (vObj->shapes.size() < 2) {
+    if (vObj->getShapes().size() < 2) {
         return @[self];
     }
 
@@ -823,7 +823,7 @@ using namespace WhirlyGlobe;
 
 - (void)addShape:(WhirlyKit::VectorShapeRef)shape
 {
-    vObj->shapes.insert(std::move(shape));
+    vObj->getShapes().insert(std::move(shape));
 }
 
 
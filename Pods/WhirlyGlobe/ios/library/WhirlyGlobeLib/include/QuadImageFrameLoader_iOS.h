@@ -18,6 +18,7 @@
 
 #import "QuadImageFrameLoader.h"
 #import "loading/MaplyTileSourceNew.h"
+#import <mutex>
 
 // These are implemented by the layer on top of the loader
 @protocol QuadImageFrameLoaderLayer
@@ -60,6 +61,9 @@ public:
     // Clear out the texture and reset
     virtual void clear(PlatformThreadInfo *threadInfo,QuadImageFrameLoader *loader,QIFBatchOps *batchOps,ChangeSet &changes) override;
     
+    // Take over a fetch that's already under way, rather than starting our own
+    void adoptFetch(MaplyTileFetchRequest *inRequest) { request = inRequest; }
+
     // Update priority for an existing fetch request
     virtual bool updateFetching(PlatformThreadInfo *threadInfo,QuadImageFrameLoader *loader,int newPriority,double newImportance) override;
 
@@ -103,6 +107,41 @@ protected:
                                             QuadImageFrameLoader *loader) override;
 };
     
+// One frame of a tile fetched ahead of when we need it.
+// The data waits here until the tile loads for real, or goes to the layer
+//  when it arrives if the tile turned real while the fetch was still out.
+class QIFPrefetch_ios
+{
+public:
+    QIFPrefetch_ios(MaplyTileFetchRequest *request,MaplyTileID tileID,int frameIndex);
+
+    // Fetch callbacks, on a random dispatch queue
+    void fetchSuccess(id data);
+    void fetchFail(NSError *error);
+
+    // Hand the data to the layer as the real load, now or when it arrives.
+    // Returns false if the fetch failed and the caller should fetch again.
+    bool adopt(NSObject<QuadImageFrameLoaderLayer> *layer,MaplyTileFetchRequest *realRequest);
+
+    // Held by the fetcher until it's done, so this is nil after that
+    MaplyTileFetchRequest * __weak request;
+    // The source it came from, in case the sources change
+    NSObject<MaplyTileInfoNew> * __weak tileSource;
+    MaplyTileID tileID;
+    int frameIndex;
+
+protected:
+    std::mutex lock;
+    bool done,failed;
+    id data;
+
+    // Set once a real load takes this over
+    bool adopted;
+    NSObject<QuadImageFrameLoaderLayer> * __weak layer;
+    MaplyTileFetchRequest *realRequest;
+};
+typedef std::shared_ptr<QIFPrefetch_ios> QIFPrefetch_iosRef;
+
 // iOS version of the QuadFrameLoader
 // Mostly just builds the right objects and tweaks things here and there
 class QuadImageFrameLoader_ios : public QuadImageFrameLoader
@@ -140,6 +179,20 @@ public:
     
     // Change the tile sources for upcoming loads
     virtual void setTileInfos(NSArray<NSObject<MaplyTileInfoNew> *> *tileInfos);
+
+    // Fetch data for tiles we'll probably need soon and hold on to it
+    virtual void builderPrefetch(PlatformThreadInfo *threadInfo,
+                                 QuadTileBuilder *inBuilder,
+                                 const QuadTreeNew::ImportantNodeSet &tiles) override;
+
+    // Use the fetch ahead for this tile and frame, if there is one, instead of fetching it again.
+    // Returns true if the frame asset is taken care of.
+    bool adoptPrefetch(const QuadTreeNew::Node &node,NSObject<MaplyTileInfoNew> *frameInfo,
+                       const QuadFrameInfoRef &frame,QIFFrameAsset_ios *frameAsset,MaplyTileFetchRequest *request);
+
+    // Anything we fetched ahead may be out of date, so drop it too
+    using QuadImageFrameLoader::reload;
+    virtual void reload(PlatformThreadInfo *threadInfo,int frame,const Mbr *bound,int boundCount,ChangeSet &changes) override;
     
 protected:
     // Convenience routine used to set up C++ version of frames
@@ -147,6 +200,13 @@ protected:
 
     // Make an iOS specific tile/frame assets
     virtual QIFTileAssetRef makeTileAsset(PlatformThreadInfo *threadInfo,const QuadTreeNew::ImportantNode &ident) override;
+
+    // Cancel and drop everything we fetched ahead
+    void clearPrefetches();
+
+    // Fetches ahead, outstanding or done, by tile.
+    // Only touched on the layer thread.
+    std::map<QuadTreeNew::Node,std::vector<QIFPrefetch_iosRef>> prefetches;
 };
     
 typedef std::shared_ptr<QuadImageFrameLoader_ios> QuadImageFrameLoader_iosRef;
@@ -168,6 +168,8 @@ void QIFTileAsset_ios::startFetching(PlatformThreadInfo *threadInfo,
                         // This means there's no data fetch.  Interpreter does all the work.
                         if ([fetchInfo isKindOfClass:[NSNull class]]) {
                             [loader->layer fetchRequestSuccess:request tileID:tileID frame:frame->frameIndex data:nil];
+                        } else if (loader->adoptPrefetch(ident,frameInfo,frame,frameAsset.get(),request)) {
+                            // We fetched it ahead of time
                         } else {
                             NSObject<QuadImageFrameLoaderLayer> * __weak layer = loader->layer;
                             request.success = ^(MaplyTileFetchRequest *request, id data) {
@@ -197,6 +199,68 @@ void QIFTileAsset_ios::startFetching(PlatformThreadInfo *threadInfo,
     }
 }
 
+QIFPrefetch_ios::QIFPrefetch_ios(MaplyTileFetchRequest *request,MaplyTileID tileID,int frameIndex)
+: request(request), tileSource(request.tileSource), tileID(tileID), frameIndex(frameIndex),
+  done(false), failed(false), data(nil), adopted(false), layer(nil), realRequest(nil)
+{
+}
+
+void QIFPrefetch_ios::fetchSuccess(id inData)
+{
+    NSObject<QuadImageFrameLoaderLayer> *theLayer = nil;
+    MaplyTileFetchRequest *theRequest = nil;
+    {
+        std::lock_guard<std::mutex> guardLock(lock);
+        done = true;
+        if (!adopted) {
+            data = inData;
+            return;
+        }
+        theLayer = layer;
+        theRequest = realRequest;
+    }
+
+    [theLayer fetchRequestSuccess:theRequest tileID:tileID frame:frameIndex data:inData];
+}
+
+void QIFPrefetch_ios::fetchFail(NSError *error)
+{
+    NSObject<QuadImageFrameLoaderLayer> *theLayer = nil;
+    MaplyTileFetchRequest *theRequest = nil;
+    {
+        std::lock_guard<std::mutex> guardLock(lock);
+        failed = true;
+        if (!adopted)
+            return;
+        theLayer = layer;
+        theRequest = realRequest;
+    }
+
+    [theLayer fetchRequestFail:theRequest tileID:tileID frame:frameIndex error:error];
+}
+
+bool QIFPrefetch_ios::adopt(NSObject<QuadImageFrameLoaderLayer> *inLayer,MaplyTileFetchRequest *inRequest)
+{
+    id theData = nil;
+    {
+        std::lock_guard<std::mutex> guardLock(lock);
+        if (failed)
+            return false;
+        if (!done) {
+            // Pass it along when it gets here
+            adopted = true;
+            layer = inLayer;
+            realRequest = inRequest;
+            return true;
+        }
+        theData = data;
+        data = nil;
+    }
+
+    [inLayer fetchRequestSuccess:inRequest tileID:tileID frame:frameIndex data:theData];
+    return true;
+}
+
 QuadImageFrameLoader_ios::QuadImageFrameLoader_ios(const SamplingParams &params,
                                                    NSObject<MaplyTileInfoNew> *inTileInfo,
                                                    Mode mode,
@@ -230,6 +294,144 @@ void QuadImageFrameLoader_ios::setupFrames()
     }
 }
 
+void QuadImageFrameLoader_ios::builderPrefetch(PlatformThreadInfo *threadInfo,
+                                               QuadTileBuilder *inBuilder,
+                                               const QuadTreeNew::ImportantNodeSet &prefetchTiles)
+{
+    NSObject<MaplyTileFetcher> *theFetcher = tileFetcher;
+    if (!theFetcher || !frameInfos)
+        return;
+
+    std::map<QuadTreeNew::Node,std::vector<QIFPrefetch_iosRef>> newPrefetches;
+    NSMutableArray *toStart = [NSMutableArray array];
+    const int priority = calcPrefetchPriority();
+    for (const auto &tile : prefetchTiles) {
+        // Already loading this one for real
+        if (tiles.find(tile) != tiles.end())
+            continue;
+
+        // Still working on it from last time, or holding the results
+        const auto it = prefetches.find(tile);
+        if (it != prefetches.end()) {
+            newPrefetches[tile] = std::move(it->second);
+            prefetches.erase(it);
+            continue;
+        }
+
+        MaplyTileID tileID;  tileID.level = tile.level;  tileID.x = tile.x;  tileID.y = tile.y;
+        std::vector<QIFPrefetch_iosRef> tilePrefetches;
+        int whichFrame = 0;
+        for (NSObject<MaplyTileInfoNew> *frameInfo in frameInfos) {
+            if (frameShouldLoad(whichFrame) && frameInfo.minZoom <= tileID.level && tileID.level <= frameInfo.maxZoom) {
+                // No data fetch means nothing to get ahead on
+                id fetchInfo = [frameInfo fetchInfoForTile:tileID flipY:getFlipY()];
+                if (fetchInfo && ![fetchInfo isKindOfClass:[NSNull class]]) {
+                    MaplyTileFetchRequest *request = [[MaplyTileFetchRequest alloc] init];
+                    request.tileID = tileID;
+                    request.fetchInfo = fetchInfo;
+                    request.tileSource = frameInfo;
+                    request.priority = priority;
+                    request.importance = tile.importance;
+                    // The request only holds the prefetch, not the other way around
+                    const auto prefetch = std::make_shared<QIFPrefetch_ios>(request,tileID,whichFrame);
+                    request.success = ^(MaplyTileFetchRequest *request, id data) {
+                        prefetch->fetchSuccess(data);
+                    };
+                    request.failure = ^(MaplyTileFetchRequest *request, NSError *error) {
+                        prefetch->fetchFail(error);
+                    };
+                    tilePrefetches.push_back(prefetch);
+                    [toStart addObject:request];
+                }
+            }
+            whichFrame++;
+        }
+        if (!tilePrefetches.empty()) {
+            newPrefetches[tile] = std::move(tilePrefetches);
+        }
+    }
+
+    // Cancel the ones we don't expect to need now.
+    // Real tiles may still want the frames they haven't loaded yet.
+    NSMutableArray *toCancel = [NSMutableArray array];
+    for (auto &it : prefetches) {
+        if (tiles.find(it.first) != tiles.end()) {
+            newPrefetches[it.first] = std::move(it.second);
+            continue;
+        }
+        for (const auto &prefetch : it.second) {
+            if (MaplyTileFetchRequest *request = prefetch->request)
+                [toCancel addObject:request];
+        }
+    }
+    prefetches = std::move(newPrefetches);
+
+    [theFetcher cancelTileFetches:toCancel];
+    [theFetcher startTileFetches:toStart];
+}
+
+bool QuadImageFrameLoader_ios::adoptPrefetch(const QuadTreeNew::Node &node,NSObject<MaplyTileInfoNew> *frameInfo,
+                                             const QuadFrameInfoRef &frame,QIFFrameAsset_ios *frameAsset,
+                                             MaplyTileFetchRequest *request)
+{
+    const auto it = prefetches.find(node);
+    if (it == prefetches.end())
+        return false;
+    auto &tilePrefetches = it->second;
+    const auto pit = std::find_if(tilePrefetches.begin(), tilePrefetches.end(),
+                                  [&](const auto &prefetch){ return prefetch->frameIndex == frame->frameIndex; });
+    if (pit == tilePrefetches.end())
+        return false;
+
+    // Either way, we're done with it here
+    const QIFPrefetch_iosRef prefetch = *pit;
+    tilePrefetches.erase(pit);
+    if (tilePrefetches.empty())
+        prefetches.erase(it);
+
+    // Held strongly so it doesn't go away between here and the fetcher
+    MaplyTileFetchRequest *outstanding = prefetch->request;
+
+    // Sources changed since we fetched it
+    if (prefetch->tileSource != frameInfo) {
+        if (outstanding)
+            [tileFetcher cancelTileFetches:@[outstanding]];
+        return false;
+    }
+
+    if (!prefetch->adopt(layer,request))
+        return false;
+
+    // Still coming, so cancels and priority changes for the frame go to the fetch ahead
+    if (outstanding) {
+        frameAsset->adoptFetch(outstanding);
+        [tileFetcher updateTileFetch:outstanding priority:request.priority importance:request.importance];
+    }
+
+    return true;
+}
+
+void QuadImageFrameLoader_ios::clearPrefetches()
+{
+    NSMutableArray *toCancel = [NSMutableArray array];
+    for (const auto &it : prefetches) {
+        for (const auto &prefetch : it.second) {
+            if (MaplyTileFetchRequest *request = prefetch->request)
+                [toCancel addObject:request];
+        }
+    }
+    prefetches.clear();
+
+    [tileFetcher cancelTileFetches:toCancel];
+}
+
+void QuadImageFrameLoader_ios::reload(PlatformThreadInfo *threadInfo,int frame,const Mbr *bound,int boundCount,ChangeSet &changes)
+{
+    clearPrefetches();
+
+    QuadImageFrameLoader::reload(threadInfo,frame,bound,boundCount,changes);
+}
+
 QIFTileAssetRef QuadImageFrameLoader_ios::makeTileAsset(PlatformThreadInfo *threadInfo,const QuadTreeNew::ImportantNode &ident)
 {
     auto tileAsset = std::make_shared<QIFTileAsset_ios>(ident);
@@ -25,6 +25,7 @@
 #import "RenderTargetMTL.h"
 #import "DynamicTextureAtlasMTL.h"
 #import "MaplyView.h"
+#import "LayoutManager.h"
 #import "WhirlyKitLog.h"
 #import "DefaultShadersMTL.h"
 #import "RawData_NSData.h"
@@ -600,10 +601,10 @@ void SceneRendererMTL::render(TimeInterval duration, RenderInfo *renderInfo)
     lastDraw = now;
     
     if (perfInterval > 0)
-        perfTimer.startTiming("Render Frame");
+        perfTimer.startTiming(perfHandles.renderFrame);
     
     if (perfInterval > 0)
-        perfTimer.startTiming("Render Setup");
+        perfTimer.startTiming(perfHandles.renderSetup);
 
     // See if we're dealing with a globe or map view
     Maply::MapView *mapView = dynamic_cast<Maply::MapView *>(theView);
@@ -634,7 +635,7 @@ void SceneRendererMTL::render(TimeInterval duration, RenderInfo *renderInfo)
     Eigen::Matrix4f modelAndViewNormalMat = Matrix4dToMatrix4f(modelAndViewNormalMat4d);
 
     if (perfInterval > 0)
-        perfTimer.stopTiming("Render Setup");
+        perfTimer.stopTiming(perfHandles.renderSetup);
 
     RenderTargetMTL *defaultTarget = (RenderTargetMTL *)renderTargets.back().get();
     if (renderPassDesc)
@@ -709,7 +710,7 @@ void SceneRendererMTL::render(TimeInterval duration, RenderInfo *renderInfo)
         baseFrameInfo.eyePos = Vector3d(eyeVec4d.x(),eyeVec4d.y(),eyeVec4d.z()) * (1.0+baseFrameInfo.heightAboveSurface);
     
     if (perfInterval > 0)
-        perfTimer.startTiming("Scene preprocessing");
+        perfTimer.startTiming(perfHandles.scenePreprocess);
     
     const auto frameTeardownInfo = std::make_shared<RenderTeardownInfoMTL>();
     teardownInfo = frameTeardownInfo;
@@ -718,13 +719,13 @@ void SceneRendererMTL::render(TimeInterval duration, RenderInfo *renderInfo)
     int numPreProcessChanges = preProcessScene(now);;
     
     if (perfInterval > 0)
-        perfTimer.addCount("Preprocess Changes", numPreProcessChanges);
+        perfTimer.addCount(perfHandles.preprocessChanges, numPreProcessChanges);
     
     if (perfInterval > 0)
-        perfTimer.stopTiming("Scene preprocessing");
+        perfTimer.stopTiming(perfHandles.scenePreprocess);
     
     if (perfInterval > 0)
-        perfTimer.startTiming("Active Model Runs");
+        perfTimer.startTiming(perfHandles.activeModelRuns);
     
     // Let the active models to their thing
     // That thing had better not take too long
@@ -733,16 +734,16 @@ void SceneRendererMTL::render(TimeInterval duration, RenderInfo *renderInfo)
         activeModel->updateForFrame(&baseFrameInfo);
     }
     if (perfInterval > 0)
-        perfTimer.addCount("Active Models", (int)activeModels.size());
+        perfTimer.addCount(perfHandles.activeModels, (int)activeModels.size());
     
     if (perfInterval > 0)
-        perfTimer.stopTiming("Active Model Runs");
+        perfTimer.stopTiming(perfHandles.activeModelRuns);
     
     if (perfInterval > 0)
-        perfTimer.addCount("Scene changes", scene->getNumChangeRequests());
+        perfTimer.addCount(perfHandles.sceneChanges, scene->getNumChangeRequests());
     
     if (perfInterval > 0)
-        perfTimer.startTiming("Scene processing");
+        perfTimer.startTiming(perfHandles.sceneProcessing);
     
     // Merge any outstanding changes into the scenegraph
     processScene(now);
@@ -751,7 +752,7 @@ void SceneRendererMTL::render(TimeInterval duration, RenderInfo *renderInfo)
     updateWorkGroups(&baseFrameInfo,baseFrameInfo.offsetMatrices.size());
     
     if (perfInterval > 0)
-        perfTimer.stopTiming("Scene processing");
+        perfTimer.stopTiming(perfHandles.sceneProcessing);
     
     // Work through the available offset matrices (only 1 if we're not wrapping)
     const Matrix4dVector &offsetMats = baseFrameInfo.offsetMatrices;
@@ -802,7 +803,11 @@ void SceneRendererMTL::render(TimeInterval duration, RenderInfo *renderInfo)
         ++workGroupIndex;
 
         if (perfInterval > 0)
-            perfTimer.startTiming("Work Group: " + workGroup->name);
+        {
+            if (workGroup->perfHandle < 0)
+                workGroup->perfHandle = perfTimer.registerTiming("Work Group: " + workGroup->name);
+            perfTimer.startTiming(workGroup->perfHandle);
+        }
 
         int targetContainerIndex = -1;
         for (auto &targetContainer : workGroup->renderTargetContainers) {
@@ -1152,7 +1157,7 @@ void SceneRendererMTL::render(TimeInterval duration, RenderInfo *renderInfo)
         }
                 
         if (perfInterval > 0)
-            perfTimer.stopTiming("Work Group: " + workGroup->name);
+            perfTimer.stopTiming(workGroup->perfHandle);
     }
     
     // Notify anyone waiting that this frame is complete
@@ -1178,7 +1183,7 @@ void SceneRendererMTL::render(TimeInterval duration, RenderInfo *renderInfo)
 #endif
 
     if (perfInterval > 0)
-        perfTimer.stopTiming("Render Frame");
+        perfTimer.stopTiming(perfHandles.renderFrame);
     
     // Update the frames per sec
     if (perfInterval > 0 && frameCount > perfInterval)
@@ -1193,6 +1198,20 @@ void SceneRendererMTL::render(TimeInterval duration, RenderInfo *renderInfo)
         wkLogLevel(Verbose," Frames per sec = %.2f",framesPerSec);
         perfTimer.log();
         perfTimer.clear();
+
+        // Layout runs on its own thread, but its timer is safe to read from here
+        if (const auto layoutManager = scene->getManager<LayoutManager>(kWKLayoutManager))
+        {
+            layoutManager->getPerfTimer().log();
+            layoutManager->getPerfTimer().clear();
+        }
+
+        TileLoadTracer &tileTracer = TileLoadTracer::shared();
+        if (tileTracer.isEnabled())
+        {
+            tileTracer.log();
+            tileTracer.clear();
+        }
     }
     
     // Mark any programs that changed as now caught up
@@ -203,9 +203,21 @@ RawDataRef TextureMTL::convertData()
             //}
             return texData;
 #else
+            if (texData && texData->getLen() == width * height * 2)
+            {
+                // Already packed, e.g. by the PNG decoder
+                return texData;
+            }
             return ConvertRGBA8888toRGB565(texData,width,height);
 #endif
     case TexTypeShort4444:
+#if !TARGET_OS_MACCATALYST && !TARGET_OS_SIMULATOR
+        if (texData && texData->getLen() == width * height * 2)
+        {
+            // Already packed, we just can't convert it ourselves
+            return texData;
+        }
+#endif
         wkLogLevel(Warn, "TextureMTL: 4444 image format with data not supported on Metal.");
         break;
     case TexTypeShort5551: